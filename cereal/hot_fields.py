@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# Generates direct-offset accessors for a whitelist of hot message fields
+# (gen/cpp/hot_fields.h, see SConscript).
+#
+# capnp readers bounds-check every accessor call. Consumers that read the
+# same few scalars out of a big message every frame (e.g. the UI pulling
+# ~25 carState fields at 20Hz) can instead validate the struct's data
+# section once per message with bind() and read each field as a raw load.
+# Offsets and default-value XOR masks come straight from the schema, so the
+# output follows log.capnp/car.capnp automatically.
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+from cereal import car, log
+
+# generated struct name -> (schema, event payload type, hot fields)
+HOT_STRUCTS = [
+  ("CarState", "cereal::CarState", car.CarState, [
+    "vEgo", "aEgo", "vEgoRaw", "yawRate", "standstill",
+    "steeringAngleDeg", "steeringRateDeg", "steeringTorque", "steeringPressed",
+    "gasPressed", "brakePressed", "brakeLights", "brakeHold",
+    "leftBlinker", "rightBlinker", "leftBlindspot", "rightBlindspot",
+    "tpmsPressureFl", "tpmsPressureFr", "tpmsPressureRl", "tpmsPressureRr",
+    "radarDistance", "standStill", "vSetDis", "cruiseAccStatus", "cruiseGapSet",
+    "electGearStep", "currentGear", "steerWarning",
+  ]),
+  ("ControlsState", "cereal::ControlsState", log.ControlsState, [
+    "enabled", "active", "vCruise", "curvature", "forceDecel",
+  ]),
+]
+
+# capnp type -> (c++ type, raw load type, size in bytes)
+TYPES = {
+  "int8": ("int8_t", "uint8_t", 1),
+  "uint8": ("uint8_t", "uint8_t", 1),
+  "int16": ("int16_t", "uint16_t", 2),
+  "uint16": ("uint16_t", "uint16_t", 2),
+  "int32": ("int32_t", "uint32_t", 4),
+  "uint32": ("uint32_t", "uint32_t", 4),
+  "int64": ("int64_t", "uint64_t", 8),
+  "uint64": ("uint64_t", "uint64_t", 8),
+  "float32": ("float", "uint32_t", 4),
+  "float64": ("double", "uint64_t", 8),
+}
+
+
+def default_mask(which, value):
+  # fields are stored XORed with their default
+  if not value:
+    return 0
+  if which == "float32":
+    return struct.unpack("<I", struct.pack("<f", value))[0]
+  if which == "float64":
+    return struct.unpack("<Q", struct.pack("<d", value))[0]
+  return int(value) & ((1 << (TYPES[which][2] * 8)) - 1)
+
+
+def emit_struct(name, reader_type, schema, field_names):
+  print(f"struct {name} : HotStruct {{")
+  print(f"  inline void bind({reader_type}::Reader r) {{ HotStruct::bind(r); }}")
+  for fld in field_names:
+    proto = schema.schema.fields[fld].proto
+    which = str(proto.slot.type.which())
+    dv = proto.slot.defaultValue
+    default = getattr(dv, str(dv.which()))
+    if which == "bool":
+      print(f"  inline bool {fld}() const {{ return loadBit({proto.slot.offset}, {'true' if default else 'false'}); }}")
+    else:
+      cpp, raw, size = TYPES[which]
+      off = proto.slot.offset * size
+      mask = default_mask(which, default)
+      print(f"  inline {cpp} {fld}() const {{ return load<{cpp}, {raw}>({off}, {hex(mask)}); }}")
+  print("};")
+  print("")
+
+
+print("""/* THIS IS AN AUTOGENERATED FILE, PLEASE EDIT cereal/hot_fields.py */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <capnp/any.h>
+
+#include "cereal/gen/cpp/car.capnp.h"
+#include "cereal/gen/cpp/log.capnp.h"
+
+namespace cereal_hot {
+
+// Validated once per message: bind() grabs the struct's data section, after
+// which every accessor is a raw load against one cached bound. Fields beyond
+// the bound (messages from an older schema) read as their default, exactly
+// like capnp.
+class HotStruct {
+public:
+  template <typename T, typename U>
+  inline T load(size_t off, U mask) const {
+    U v = 0;
+    if (off + sizeof(U) <= size_) memcpy(&v, data_ + off, sizeof(U));
+    v ^= mask;
+    T out;
+    memcpy(&out, &v, sizeof(T));
+    return out;
+  }
+  inline bool loadBit(size_t bit, bool def) const {
+    const bool v = (bit / 8 < size_) && ((data_[bit / 8] >> (bit % 8)) & 1);
+    return v != def;
+  }
+
+protected:
+  template <typename R>
+  inline void bind(R r) {
+    auto d = capnp::toAny(r).getDataSection();
+    data_ = d.begin();
+    size_ = d.size();
+  }
+
+  const capnp::byte *data_ = nullptr;
+  size_t size_ = 0;
+};
+""")
+
+for name, reader_type, schema, field_names in HOT_STRUCTS:
+  emit_struct(name, reader_type, schema, field_names)
+
+print("}  // namespace cereal_hot")
@@ -0,0 +1,45 @@
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include "cereal/messaging/msgq.h"
+#include "selfdrive/common/benchmark.h"
+
+// send/recv cost of the raw msgq ring for typical openpilot message sizes,
+// bypassing the capnp and SubSocket layers so queue overhead is measured alone
+
+static void bench_size(msgq_queue_t *pub, msgq_queue_t *sub, size_t size, int iterations) {
+  std::vector<char> data(size, 'x');
+  char name[64];
+  snprintf(name, sizeof(name), "msgq_send_recv_%zu", size);
+  benchmark_run(name, iterations, [&]() {
+    msgq_msg_t msg;
+    msgq_msg_init_data(&msg, data.data(), data.size());
+    msgq_msg_send(&msg, pub);
+    msgq_msg_close(&msg);
+
+    msgq_msg_t rmsg;
+    int r = msgq_msg_recv(&rmsg, sub);
+    assert(r > 0);
+    msgq_msg_close(&rmsg);
+  });
+}
+
+int main() {
+  msgq_queue_t pub = {}, sub = {};
+  int r = msgq_new_queue(&pub, "bench_msgq", 1024 * 1024);
+  assert(r == 0);
+  r = msgq_new_queue(&sub, "bench_msgq", 1024 * 1024);
+  assert(r == 0);
+  msgq_init_publisher(&pub);
+  msgq_init_subscriber(&sub);
+
+  // carState-sized, modelV2-sized and camera-frame-metadata-sized payloads
+  for (size_t size : {64, 1024, 16 * 1024, 256 * 1024}) {
+    bench_size(&pub, &sub, size, 100000);
+  }
+
+  msgq_close_queue(&pub);
+  msgq_close_queue(&sub);
+  return 0;
+}
@@ -1,14 +1,21 @@
 #include <algorithm>
 #include <cassert>
 #include <csignal>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 
-typedef void (*sighandler_t)(int sig);
+#include <capnp/dynamic.h>
+#include <capnp/serialize.h>
+
+#include "json11.hpp"
 
 #include "impl_msgq.h"
 #include "impl_zmq.h"
+#include "messaging.h"
 #include "services.h"
 
 void sigpipe_handler(int sig) {
@@ -16,12 +23,96 @@ void sigpipe_handler(int sig) {
   std::cout << "SIGPIPE received" << std::endl;
 }
 
-static std::vector<std::string> get_services(std::string whitelist_str, bool zmq_to_msgq) {
+// High-rate topics where only the newest message matters on a bench link;
+// these are bridged with a conflating subscription
+static bool conflate_service(const std::string &name) {
+  return name == "can" || name == "sensorEvents";
+}
+
+// Relay configuration for bench links: which services to forward, how hard to
+// decimate them, and which fields to strip before they hit the wire. Example:
+//   {
+//     "include": ["can", "controlsState", "carState"],
+//     "exclude": ["roadCameraState"],
+//     "decimation": {"modelV2": 4},
+//     "trim": {"modelV2": ["rawPredictions"]}
+//   }
+// An empty include list forwards everything not excluded; decimation forwards
+// every Nth message; trim clears the named fields of the event payload.
+struct RelayConfig {
+  std::vector<std::string> include;
+  std::vector<std::string> exclude;
+  std::map<std::string, int> decimation;
+  std::map<std::string, std::vector<std::string>> trim;
+
+  static RelayConfig parse(const std::string &path) {
+    RelayConfig cfg;
+    std::ifstream f(path);
+    if (!f) {
+      std::cerr << "bridge: can't open relay config " << path << std::endl;
+      exit(1);
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::string err;
+    json11::Json json = json11::Json::parse(ss.str(), err);
+    if (!err.empty()) {
+      std::cerr << "bridge: bad relay config: " << err << std::endl;
+      exit(1);
+    }
+    for (const auto &s : json["include"].array_items()) cfg.include.push_back(s.string_value());
+    for (const auto &s : json["exclude"].array_items()) cfg.exclude.push_back(s.string_value());
+    for (const auto &[name, n] : json["decimation"].object_items()) {
+      cfg.decimation[name] = std::max(n.int_value(), 1);
+    }
+    for (const auto &[name, fields] : json["trim"].object_items()) {
+      for (const auto &fld : fields.array_items()) cfg.trim[name].push_back(fld.string_value());
+    }
+    return cfg;
+  }
+
+  bool allows(const std::string &name) const {
+    if (std::find(exclude.begin(), exclude.end(), name) != exclude.end()) return false;
+    return include.empty() || std::find(include.begin(), include.end(), name) != include.end();
+  }
+};
+
+// Per-forwarded-service relay state
+struct RelayState {
+  int decimation = 1;
+  uint64_t seq = 0;
+  const std::vector<std::string> *trim_fields = nullptr;
+};
+
+// Re-serialize an event with the configured fields of its payload cleared,
+// e.g. modelV2 without rawPredictions. Fields resolve through the schema at
+// runtime, so any service/field pair works without generated trim tables.
+static kj::Array<capnp::word> trim_event(Message *msg, const std::vector<std::string> &fields,
+                                         AlignedBuffer &aligned_buf) {
+  capnp::FlatArrayMessageReader reader(aligned_buf.align(msg));
+  capnp::MallocMessageBuilder builder;
+  builder.setRoot(reader.getRoot<cereal::Event>());
+
+  capnp::DynamicStruct::Builder event = capnp::toDynamic(builder.getRoot<cereal::Event>());
+  KJ_IF_MAYBE(payload_field, event.which()) {
+    if (payload_field->getType().isStruct()) {
+      capnp::DynamicStruct::Builder payload = event.get(*payload_field).as<capnp::DynamicStruct>();
+      for (const std::string &name : fields) {
+        KJ_IF_MAYBE(f, payload.getSchema().findFieldByName(name)) {
+          payload.clear(*f);
+        }
+      }
+    }
+  }
+  return capnp::messageToFlatArray(builder);
+}
+
+static std::vector<std::string> get_services(const RelayConfig &cfg, std::string whitelist_str, bool zmq_to_msgq) {
   std::vector<std::string> service_list;
   for (const auto& it : services) {
     std::string name = it.name;
     bool in_whitelist = whitelist_str.find(name) != std::string::npos;
-    if (name == "plusFrame" || name == "uiLayoutState" || (zmq_to_msgq && !in_whitelist)) {
+    if (name == "plusFrame" || name == "uiLayoutState" || (zmq_to_msgq && !in_whitelist) || !cfg.allows(name)) {
       continue;
     }
     service_list.push_back(name);
@@ -32,6 +123,14 @@ static std::vector<std::string> get_services(std::string whitelist_str, bool zmq
 int main(int argc, char** argv) {
   signal(SIGPIPE, (sighandler_t)sigpipe_handler);
 
+  // usage: bridge [-c relay_config.json] [ip whitelist]
+  RelayConfig cfg;
+  if (argc > 2 && std::string(argv[1]) == "-c") {
+    cfg = RelayConfig::parse(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+
   bool zmq_to_msgq = argc > 2;
   std::string ip = zmq_to_msgq ? argv[1] : "127.0.0.1";
   std::string whitelist_str = zmq_to_msgq ? std::string(argv[2]) : "";
@@ -50,7 +149,9 @@ int main(int argc, char** argv) {
   }
 
   std::map<SubSocket*, PubSocket*> sub2pub;
-  for (auto endpoint: get_services(whitelist_str, zmq_to_msgq)) {
+  std::map<SubSocket*, bool> conflated;
+  std::map<SubSocket*, RelayState> relay_state;
+  for (auto endpoint: get_services(cfg, whitelist_str, zmq_to_msgq)) {
     PubSocket * pub_sock;
     SubSocket * sub_sock;
     if (zmq_to_msgq) {
@@ -60,19 +161,66 @@ int main(int argc, char** argv) {
       pub_sock = new ZMQPubSocket();
       sub_sock = new MSGQSubSocket();
     }
+    bool conflate = conflate_service(endpoint);
     pub_sock->connect(pub_context, endpoint);
-    sub_sock->connect(sub_context, endpoint, ip, false);
+    sub_sock->connect(sub_context, endpoint, ip, conflate);
 
     poller->registerSocket(sub_sock);
     sub2pub[sub_sock] = pub_sock;
+    conflated[sub_sock] = conflate;
+
+    RelayState &rs = relay_state[sub_sock];
+    auto dec = cfg.decimation.find(endpoint);
+    if (dec != cfg.decimation.end()) rs.decimation = dec->second;
+    auto trim = cfg.trim.find(endpoint);
+    if (trim != cfg.trim.end()) rs.trim_fields = &trim->second;
   }
 
+  AlignedBuffer aligned_buf;
   while (true) {
     for (auto sub_sock : poller->poll(100)) {
-      Message * msg = sub_sock->receive();
-      if (msg == NULL) continue;
-      sub2pub[sub_sock]->sendMessage(msg);
-      delete msg;
+      PubSocket *pub_sock = sub2pub[sub_sock];
+      RelayState &rs = relay_state[sub_sock];
+
+      if (conflated[sub_sock]) {
+        // The subscription already skips to the newest message
+        Message *msg = sub_sock->receive();
+        if (msg == NULL) continue;
+        if ((rs.seq++ % rs.decimation) == 0) {
+          if (rs.trim_fields) {
+            auto trimmed = trim_event(msg, *rs.trim_fields, aligned_buf).asBytes();
+            pub_sock->send((char *)trimmed.begin(), trimmed.size());
+          } else {
+            pub_sock->sendMessage(msg);
+          }
+        }
+        delete msg;
+        continue;
+      }
+
+      // Drain the whole backlog in one pass and forward it as a single
+      // multipart message when the destination is zmq. Decimated or trimmed
+      // services go message by message instead, since parts can be dropped
+      // or rewritten in the middle of the batch.
+      std::vector<Message *> msgs = sub_sock->receive_all();
+      const bool plain = (rs.decimation == 1 && rs.trim_fields == nullptr);
+      for (size_t i = 0; i < msgs.size(); i++) {
+        if (!plain) {
+          if ((rs.seq++ % rs.decimation) == 0) {
+            if (rs.trim_fields) {
+              auto trimmed = trim_event(msgs[i], *rs.trim_fields, aligned_buf).asBytes();
+              pub_sock->send((char *)trimmed.begin(), trimmed.size());
+            } else {
+              pub_sock->sendMessage(msgs[i]);
+            }
+          }
+        } else if (zmq_to_msgq) {
+          pub_sock->sendMessage(msgs[i]);
+        } else {
+          static_cast<ZMQPubSocket *>(pub_sock)->sendPart(msgs[i], i + 1 < msgs.size());
+        }
+        delete msgs[i];
+      }
     }
   }
   return 0;
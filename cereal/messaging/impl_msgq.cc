@@ -58,8 +58,16 @@ void MSGQMessage::takeOwnership(char * d, size_t sz) {
   data = d;
 }
 
+// Wrap a borrowed buffer (e.g. a zero-copy view into the msgq ring) without
+// taking ownership. close() won't free it.
+void MSGQMessage::initRef(char * d, size_t sz) {
+  size = sz;
+  data = d;
+  owner = false;
+}
+
 void MSGQMessage::close() {
-  if (size > 0){
+  if (size > 0 && owner){
     delete[] data;
   }
   size = 0;
@@ -98,6 +106,9 @@ int MSGQSubSocket::connect(Context *context, std::string endpoint, std::string a
 Message * MSGQSubSocket::receive(bool non_blocking){
   msgq_do_exit = 0;
 
+  // Invalidate any zero-copy views handed out by a previous receive_all
+  msgq_msg_release_zero_copy(q);
+
   void (*prev_handler_sigint)(int);
   void (*prev_handler_sigterm)(int);
   if (!non_blocking){
@@ -151,10 +162,31 @@ Message * MSGQSubSocket::receive(bool non_blocking){
   return (Message*)r;
 }
 
+std::vector<Message *> MSGQSubSocket::receive_all(){
+  // Release the batch handed out on the previous call before claiming a new one
+  msgq_msg_release_zero_copy(q);
+
+  std::vector<Message *> r;
+
+  msgq_msg_t msgs[MSGQ_RECV_BATCH_SIZE];
+  int n = msgq_msg_recv_batch(msgs, MSGQ_RECV_BATCH_SIZE, q);
+  for (int i = 0; i < n; i++){
+    MSGQMessage *m = new MSGQMessage;
+    m->initRef(msgs[i].data, msgs[i].size);
+    r.push_back(m);
+  }
+
+  return r;
+}
+
 void MSGQSubSocket::setTimeout(int t){
   timeout = t;
 }
 
+void MSGQSubSocket::setPriority(int priority){
+  msgq_set_reader_priority(q, priority);
+}
+
 MSGQSubSocket::~MSGQSubSocket(){
   if (q != NULL){
     msgq_close_queue(q);
@@ -200,6 +232,10 @@ bool MSGQPubSocket::all_readers_updated() {
   return msgq_all_readers_updated(q);
 }
 
+uint64_t MSGQPubSocket::getDropCount() {
+  return msgq_get_drop_count(q);
+}
+
 MSGQPubSocket::~MSGQPubSocket(){
   if (q != NULL){
     msgq_close_queue(q);
@@ -5,6 +5,7 @@
 #include <string>
 
 #define MAX_POLLERS 128
+#define MSGQ_RECV_BATCH_SIZE 512
 
 class MSGQContext : public Context {
 private:
@@ -19,10 +20,12 @@ class MSGQMessage : public Message {
 private:
   char * data;
   size_t size;
+  bool owner = true;
 public:
   void init(size_t size);
   void init(char *data, size_t size);
   void takeOwnership(char *data, size_t size);
+  void initRef(char *data, size_t size);
   size_t getSize(){return size;}
   char * getData(){return data;}
   void close();
@@ -36,8 +39,10 @@ private:
 public:
   int connect(Context *context, std::string endpoint, std::string address, bool conflate=false, bool check_endpoint=true);
   void setTimeout(int timeout);
+  void setPriority(int priority);
   void * getRawSocket() {return (void*)q;}
   Message *receive(bool non_blocking=false);
+  std::vector<Message *> receive_all();
   ~MSGQSubSocket();
 };
 
@@ -49,6 +54,7 @@ public:
   int sendMessage(Message *message);
   int send(char *data, size_t size);
   bool all_readers_updated();
+  uint64_t getDropCount();
   ~MSGQPubSocket();
 };
 
@@ -0,0 +1,217 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "services.h"
+#include "impl_udp.h"
+
+#define UDP_MSG_MAGIC 0x50434d55  // "UMCP"
+// payload limit: max UDP datagram minus IP/UDP/our header, rounded down
+#define UDP_MAX_PAYLOAD (65507 - sizeof(UDPMsgHeader))
+
+static int get_port(std::string endpoint) {
+  int port = -1;
+  for (const auto& it : services) {
+    std::string name = it.name;
+    if (name == endpoint) {
+      port = it.port;
+      break;
+    }
+  }
+
+  assert(port >= 0);
+  return port;
+}
+
+static std::string get_group(const std::string &address) {
+  // the address argument is a host for the tcp transports; only take it as
+  // the group when it actually names a multicast address
+  if (!address.empty()) {
+    struct in_addr a;
+    if (inet_aton(address.c_str(), &a) != 0 && IN_MULTICAST(ntohl(a.s_addr))) {
+      return address;
+    }
+  }
+  const char *env_group = std::getenv("UDP_MCAST_GROUP");
+  return env_group ? env_group : "239.255.76.80";
+}
+
+void UDPMessage::init(size_t sz) {
+  size = sz;
+  data = new char[size];
+}
+
+void UDPMessage::init(char * d, size_t sz) {
+  size = sz;
+  data = new char[size];
+  memcpy(data, d, size);
+}
+
+void UDPMessage::takeOwnership(char * d, size_t sz) {
+  size = sz;
+  data = d;
+}
+
+void UDPMessage::close() {
+  if (size > 0) {
+    delete[] data;
+  }
+  size = 0;
+}
+
+UDPMessage::~UDPMessage() {
+  this->close();
+}
+
+
+int UDPSubSocket::connect(Context *context, std::string endpoint, std::string address, bool conflate, bool check_endpoint){
+  endpoint_name = endpoint;
+
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(check_endpoint ? get_port(endpoint) : atoi(endpoint.c_str()));
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    ::close(fd);
+    fd = -1;
+    return -1;
+  }
+
+  struct ip_mreq mreq = {};
+  inet_aton(get_group(address).c_str(), &mreq.imr_multiaddr);
+  mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+    ::close(fd);
+    fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+Message * UDPSubSocket::receive(bool non_blocking){
+  char buf[sizeof(UDPMsgHeader) + UDP_MAX_PAYLOAD];
+  ssize_t sz = recv(fd, buf, sizeof(buf), non_blocking ? MSG_DONTWAIT : 0);
+  if (sz < (ssize_t)sizeof(UDPMsgHeader)) {
+    return NULL;
+  }
+
+  UDPMsgHeader hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.magic != UDP_MSG_MAGIC) {
+    return NULL;
+  }
+
+  // per-message sequence numbers: count the gap so loss is visible to the
+  // consumer's logs instead of silently missing frames
+  if (next_seq != 0 && hdr.seq > next_seq) {
+    dropped += hdr.seq - next_seq;
+    fprintf(stderr, "%s: %lu udp messages dropped (%lu total)\n",
+            endpoint_name.c_str(), (unsigned long)(hdr.seq - next_seq), (unsigned long)dropped);
+  }
+  next_seq = hdr.seq + 1;
+
+  UDPMessage *r = new UDPMessage;
+  r->init(buf + sizeof(hdr), sz - sizeof(hdr));
+  return r;
+}
+
+void UDPSubSocket::setTimeout(int timeout){
+  struct timeval tv = {timeout / 1000, (timeout % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+UDPSubSocket::~UDPSubSocket(){
+  if (fd >= 0) ::close(fd);
+}
+
+
+int UDPPubSocket::connect(Context *context, std::string endpoint, bool check_endpoint){
+  endpoint_name = endpoint;
+
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+
+  unsigned char ttl = 1;
+  const char *env_ttl = std::getenv("UDP_MCAST_TTL");
+  if (env_ttl) ttl = atoi(env_ttl);
+  setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  inet_aton(get_group("").c_str(), &addr.sin_addr);
+  addr.sin_port = htons(check_endpoint ? get_port(endpoint) : atoi(endpoint.c_str()));
+  if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    ::close(fd);
+    fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+int UDPPubSocket::sendMessage(Message *message){
+  return send(message->getData(), message->getSize());
+}
+
+int UDPPubSocket::send(char *data, size_t size){
+  if (size > UDP_MAX_PAYLOAD) {
+    fprintf(stderr, "%s: message of %zu bytes exceeds the udp datagram limit, dropped\n",
+            endpoint_name.c_str(), size);
+    return -1;
+  }
+
+  struct iovec iov[2];
+  UDPMsgHeader hdr = {UDP_MSG_MAGIC, 0, seq++};
+  iov[0] = {&hdr, sizeof(hdr)};
+  iov[1] = {data, size};
+  struct msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+
+  ssize_t sz = sendmsg(fd, &msg, 0);
+  return sz < 0 ? -1 : (int)(sz - sizeof(hdr));
+}
+
+UDPPubSocket::~UDPPubSocket(){
+  if (fd >= 0) ::close(fd);
+}
+
+
+void UDPPoller::registerSocket(SubSocket * socket){
+  assert(sockets.size() < UDP_MAX_POLLERS);
+  sockets.push_back(socket);
+}
+
+std::vector<SubSocket*> UDPPoller::poll(int timeout){
+  std::vector<SubSocket*> r;
+
+  struct pollfd polls[UDP_MAX_POLLERS];
+  for (size_t i = 0; i < sockets.size(); i++){
+    polls[i].fd = (int)(intptr_t)sockets[i]->getRawSocket();
+    polls[i].events = POLLIN;
+    polls[i].revents = 0;
+  }
+
+  int rc = ::poll(polls, sockets.size(), timeout);
+  if (rc < 0) return r;
+
+  for (size_t i = 0; i < sockets.size(); i++){
+    if (polls[i].revents & POLLIN) {
+      r.push_back(sockets[i]);
+    }
+  }
+  return r;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "messaging.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define UDP_MAX_POLLERS 128
+
+// UDP multicast transport for loss-tolerant one-to-many streaming: one
+// uplink datagram per publish reaches every subscriber on the network,
+// instead of one TCP stream per subscriber as with zmq. Selected with the
+// UDP env var. Each service maps to its registered port on one multicast
+// group (UDP_MCAST_GROUP, default 239.255.76.80; the SubSocket address
+// argument overrides it when it names a multicast group).
+//
+// Every datagram carries a sequence number; subscribers count gaps and log
+// them so consumers can report loss. Messages that don't fit in a single
+// datagram are dropped on send with a warning — this transport is meant for
+// bench streaming of high-rate services, not for reliable delivery.
+
+struct UDPMsgHeader {
+  uint32_t magic;
+  uint32_t pad;
+  uint64_t seq;
+};
+
+class UDPContext : public Context {
+public:
+  void * getRawContext() {return NULL;}
+};
+
+class UDPMessage : public Message {
+private:
+  char * data;
+  size_t size;
+public:
+  void init(size_t size);
+  void init(char *data, size_t size);
+  void takeOwnership(char *data, size_t size);
+  size_t getSize(){return size;}
+  char * getData(){return data;}
+  void close();
+  ~UDPMessage();
+};
+
+class UDPSubSocket : public SubSocket {
+private:
+  int fd = -1;
+  uint64_t next_seq = 0;
+  uint64_t dropped = 0;
+  std::string endpoint_name;
+public:
+  int connect(Context *context, std::string endpoint, std::string address, bool conflate=false, bool check_endpoint=true);
+  void setTimeout(int timeout);
+  void * getRawSocket() {return (void*)(intptr_t)fd;}
+  Message *receive(bool non_blocking=false);
+  ~UDPSubSocket();
+};
+
+class UDPPubSocket : public PubSocket {
+private:
+  int fd = -1;
+  uint64_t seq = 0;
+  std::string endpoint_name;
+public:
+  int connect(Context *context, std::string endpoint, bool check_endpoint=true);
+  int sendMessage(Message *message);
+  int send(char *data, size_t size);
+  bool all_readers_updated() {return true;}
+  ~UDPPubSocket();
+};
+
+class UDPPoller : public Poller {
+private:
+  std::vector<SubSocket*> sockets;
+public:
+  void registerSocket(SubSocket *socket);
+  std::vector<SubSocket*> poll(int timeout);
+  ~UDPPoller(){};
+};
@@ -32,21 +32,26 @@ ZMQContext::~ZMQContext() {
 }
 
 void ZMQMessage::init(size_t sz) {
-  size = sz;
-  data = new char[size];
+  assert(zmq_msg_init_size(&msg, sz) == 0);
+  initialized = true;
 }
 
 void ZMQMessage::init(char * d, size_t sz) {
-  size = sz;
-  data = new char[size];
-  memcpy(data, d, size);
+  init(sz);
+  memcpy(zmq_msg_data(&msg), d, sz);
+}
+
+zmq_msg_t *ZMQMessage::initRecv() {
+  assert(zmq_msg_init(&msg) == 0);
+  initialized = true;
+  return &msg;
 }
 
 void ZMQMessage::close() {
-  if (size > 0){
-    delete[] data;
+  if (initialized){
+    zmq_msg_close(&msg);
   }
-  size = 0;
+  initialized = false;
 }
 
 ZMQMessage::~ZMQMessage() {
@@ -82,20 +87,17 @@ int ZMQSubSocket::connect(Context *context, std::string endpoint, std::string ad
 
 
 Message * ZMQSubSocket::receive(bool non_blocking){
-  zmq_msg_t msg;
-  assert(zmq_msg_init(&msg) == 0);
+  // Receive straight into the message the caller gets back: the returned
+  // ZMQMessage keeps the zmq_msg_t (and its refcounted buffer) alive until
+  // it is deleted, so no copy is made on this side
+  ZMQMessage *r = new ZMQMessage;
 
   int flags = non_blocking ? ZMQ_DONTWAIT : 0;
-  int rc = zmq_msg_recv(&msg, sock, flags);
-  Message *r = NULL;
-
-  if (rc >= 0){
-    // Make a copy to ensure the data is aligned
-    r = new ZMQMessage;
-    r->init((char*)zmq_msg_data(&msg), zmq_msg_size(&msg));
+  int rc = zmq_msg_recv(r->initRecv(), sock, flags);
+  if (rc < 0){
+    delete r;
+    return NULL;
   }
-
-  zmq_msg_close(&msg);
   return r;
 }
 
@@ -127,6 +129,10 @@ int ZMQPubSocket::sendMessage(Message *message){
   return zmq_send(sock, message->getData(), message->getSize(), ZMQ_DONTWAIT);
 }
 
+int ZMQPubSocket::sendPart(Message *message, bool more){
+  return zmq_send(sock, message->getData(), message->getSize(), ZMQ_DONTWAIT | (more ? ZMQ_SNDMORE : 0));
+}
+
 int ZMQPubSocket::send(char *data, size_t size){
   return zmq_send(sock, data, size, ZMQ_DONTWAIT);
 }
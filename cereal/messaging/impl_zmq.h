@@ -14,15 +14,21 @@ public:
   ~ZMQContext();
 };
 
+// Owns a zmq_msg_t directly, so received data is handed out by reference
+// instead of being copied into a fresh allocation. zmq's buffers are not
+// word aligned in general; consumers go through AlignedBuffer before
+// handing the bytes to capnp, same as for every other transport.
 class ZMQMessage : public Message {
 private:
-  char * data;
-  size_t size;
+  zmq_msg_t msg;
+  bool initialized = false;
 public:
   void init(size_t size);
   void init(char *data, size_t size);
-  size_t getSize(){return size;}
-  char * getData(){return data;}
+  // Initialize empty and expose the raw message for zmq_msg_recv to fill
+  zmq_msg_t *initRecv();
+  size_t getSize(){return initialized ? zmq_msg_size(&msg) : 0;}
+  char * getData(){return initialized ? (char *)zmq_msg_data(&msg) : NULL;}
   void close();
   ~ZMQMessage();
 };
@@ -46,6 +52,8 @@ private:
 public:
   int connect(Context *context, std::string endpoint, bool check_endpoint=true);
   int sendMessage(Message *message);
+  // Send one part of a multipart message; pass more=true for all but the last part
+  int sendPart(Message *message, bool more);
   int send(char *data, size_t size);
   bool all_readers_updated();
   ~ZMQPubSocket();
@@ -0,0 +1,44 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "latency_stats.h"
+
+// Dump the per-service latency histograms recorded by a process running with
+// MSG_LATENCY_STATS=1. Usage: latency_dump msg_latency_<pid>
+
+static void print_hist(const char *label, const uint64_t *hist) {
+  uint64_t total = 0;
+  for (int i = 0; i < LATENCY_STATS_NUM_BUCKETS; i++) total += hist[i];
+  if (total == 0) return;
+
+  printf("  %s (n=%" PRIu64 "):\n", label, total);
+  uint64_t cum = 0;
+  for (int i = 0; i < LATENCY_STATS_NUM_BUCKETS; i++) {
+    if (hist[i] == 0) continue;
+    cum += hist[i];
+    printf("    <= %8" PRIu64 " us: %8" PRIu64 "  (%5.1f%%)\n",
+           (uint64_t)2 << i, hist[i], 100.0 * cum / total);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <shm name, e.g. msg_latency_1234>\n", argv[0]);
+    return 1;
+  }
+
+  latency_stats_page_t *page = latency_stats_open(argv[1], false);
+  if (page == NULL) {
+    fprintf(stderr, "could not open /dev/shm/%s\n", argv[1]);
+    return 1;
+  }
+
+  for (uint64_t i = 0; i < page->num_records; i++) {
+    latency_stats_record_t *r = &page->records[i];
+    printf("%s: %" PRIu64 " msgs\n", r->name, r->count);
+    print_hist("publish-to-receive", r->latency_hist);
+    print_hist("inter-arrival", r->interarrival_hist);
+  }
+  return 0;
+}
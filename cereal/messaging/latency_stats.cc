@@ -0,0 +1,65 @@
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "latency_stats.h"
+
+latency_stats_page_t *latency_stats_open(const char *name, bool create) {
+  char full_path[1024];
+  snprintf(full_path, sizeof(full_path), "/dev/shm/%s", name);
+
+  int flags = create ? (O_RDWR | O_CREAT) : O_RDWR;
+  int fd = open(full_path, flags, 0664);
+  if (fd < 0) return NULL;
+
+  if (create && ftruncate(fd, sizeof(latency_stats_page_t)) < 0) {
+    close(fd);
+    return NULL;
+  }
+
+  void *mem = mmap(NULL, sizeof(latency_stats_page_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) return NULL;
+
+  latency_stats_page_t *page = (latency_stats_page_t *)mem;
+  if (create) {
+    memset(page, 0, sizeof(latency_stats_page_t));
+  }
+  return page;
+}
+
+latency_stats_record_t *latency_stats_get_record(latency_stats_page_t *page, const char *service) {
+  for (uint64_t i = 0; i < page->num_records; i++) {
+    if (strncmp(page->records[i].name, service, LATENCY_STATS_NAME_LEN) == 0) {
+      return &page->records[i];
+    }
+  }
+  if (page->num_records >= LATENCY_STATS_MAX_SERVICES) return NULL;
+
+  latency_stats_record_t *r = &page->records[page->num_records];
+  strncpy(r->name, service, LATENCY_STATS_NAME_LEN - 1);
+  page->num_records++;
+  return r;
+}
+
+static inline int latency_stats_bucket(uint64_t ns) {
+  uint64_t us = ns / 1000;
+  int b = 0;
+  while (us > 1 && b < LATENCY_STATS_NUM_BUCKETS - 1) {
+    us >>= 1;
+    b++;
+  }
+  return b;
+}
+
+void latency_stats_sample(latency_stats_record_t *r, uint64_t latency_ns, uint64_t rcv_time_ns) {
+  r->latency_hist[latency_stats_bucket(latency_ns)]++;
+  if (r->last_rcv_time != 0 && rcv_time_ns > r->last_rcv_time) {
+    r->interarrival_hist[latency_stats_bucket(rcv_time_ns - r->last_rcv_time)]++;
+  }
+  r->last_rcv_time = rcv_time_ns;
+  r->count++;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+#define LATENCY_STATS_MAX_SERVICES 64
+#define LATENCY_STATS_NUM_BUCKETS 32
+#define LATENCY_STATS_NAME_LEN 32
+
+// Per-service receive statistics kept in a shared-memory page so a dump tool
+// (messaging/latency_dump) can read them while the process runs. Histograms
+// are HDR-style: bucket i counts samples with log2(microseconds) == i.
+struct latency_stats_record_t {
+  char name[LATENCY_STATS_NAME_LEN];
+  uint64_t count;
+  uint64_t last_rcv_time;
+  uint64_t latency_hist[LATENCY_STATS_NUM_BUCKETS];
+  uint64_t interarrival_hist[LATENCY_STATS_NUM_BUCKETS];
+};
+
+struct latency_stats_page_t {
+  uint64_t num_records;
+  latency_stats_record_t records[LATENCY_STATS_MAX_SERVICES];
+};
+
+// Map (and for writers create) a stats page at /dev/shm/<name>. Returns NULL on failure.
+latency_stats_page_t *latency_stats_open(const char *name, bool create);
+
+// Find or register the record for a service. Returns NULL when the page is full.
+latency_stats_record_t *latency_stats_get_record(latency_stats_page_t *page, const char *service);
+
+// Record one received message. latency is publish-to-receive time in ns.
+void latency_stats_sample(latency_stats_record_t *r, uint64_t latency_ns, uint64_t rcv_time_ns);
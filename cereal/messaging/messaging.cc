@@ -1,6 +1,7 @@
 #include "messaging.h"
 #include "impl_zmq.h"
 #include "impl_msgq.h"
+#include "impl_udp.h"
 
 #ifdef __APPLE__
 const bool MUST_USE_ZMQ = true;
@@ -12,9 +13,16 @@ bool messaging_use_zmq(){
   return std::getenv("ZMQ") || MUST_USE_ZMQ;
 }
 
+// loss-tolerant multicast for one-to-many bench streaming, see impl_udp.h
+static bool messaging_use_udp(){
+  return std::getenv("UDP") != NULL;
+}
+
 Context * Context::create(){
   Context * c;
-  if (messaging_use_zmq()){
+  if (messaging_use_udp()){
+    c = new UDPContext();
+  } else if (messaging_use_zmq()){
     c = new ZMQContext();
   } else {
     c = new MSGQContext();
@@ -22,9 +30,19 @@ Context * Context::create(){
   return c;
 }
 
+std::vector<Message *> SubSocket::receive_all(){
+  std::vector<Message *> msgs;
+  while (Message *msg = receive(true)) {
+    msgs.push_back(msg);
+  }
+  return msgs;
+}
+
 SubSocket * SubSocket::create(){
   SubSocket * s;
-  if (messaging_use_zmq()){
+  if (messaging_use_udp()){
+    s = new UDPSubSocket();
+  } else if (messaging_use_zmq()){
     s = new ZMQSubSocket();
   } else {
     s = new MSGQSubSocket();
@@ -46,7 +64,9 @@ SubSocket * SubSocket::create(Context * context, std::string endpoint, std::stri
 
 PubSocket * PubSocket::create(){
   PubSocket * s;
-  if (messaging_use_zmq()){
+  if (messaging_use_udp()){
+    s = new UDPPubSocket();
+  } else if (messaging_use_zmq()){
     s = new ZMQPubSocket();
   } else {
     s = new MSGQPubSocket();
@@ -68,7 +88,9 @@ PubSocket * PubSocket::create(Context * context, std::string endpoint, bool chec
 
 Poller * Poller::create(){
   Poller * p;
-  if (messaging_use_zmq()){
+  if (messaging_use_udp()){
+    p = new UDPPoller();
+  } else if (messaging_use_zmq()){
     p = new ZMQPoller();
   } else {
     p = new MSGQPoller();
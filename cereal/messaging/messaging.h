@@ -1,7 +1,12 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <capnp/serialize.h>
 #include "../gen/cpp/log.capnp.h"
@@ -32,11 +37,25 @@ public:
 };
 
 
+// Subscriber priority classes for the msgq transport: high-priority readers
+// are signaled first on every publish, droppable readers get skipped to the
+// newest message when they fall behind. No-op over zmq.
+enum SubscriberPriority {
+  SUB_PRIO_DROPPABLE = 0,
+  SUB_PRIO_DEFAULT = 1,
+  SUB_PRIO_HIGH = 2,
+};
+
 class SubSocket {
 public:
   virtual int connect(Context *context, std::string endpoint, std::string address, bool conflate=false, bool check_endpoint=true) = 0;
   virtual void setTimeout(int timeout) = 0;
+  virtual void setPriority(int priority) {}
   virtual Message *receive(bool non_blocking=false) = 0;
+  // Drain all pending messages in one call. The msgq implementation claims the
+  // whole batch in a single pass of the read cursor and returns zero-copy views
+  // that stay valid until the next receive/receive_all call on this socket.
+  virtual std::vector<Message *> receive_all();
   virtual void * getRawSocket() = 0;
   static SubSocket * create();
   static SubSocket * create(Context * context, std::string endpoint, std::string address="127.0.0.1", bool conflate=false, bool check_endpoint=true);
@@ -49,6 +68,8 @@ public:
   virtual int sendMessage(Message *message) = 0;
   virtual int send(char *data, size_t size) = 0;
   virtual bool all_readers_updated() = 0;
+  // Cumulative count of droppable readers skipped ahead under backlog
+  virtual uint64_t getDropCount() { return 0; }
   static PubSocket * create();
   static PubSocket * create(Context * context, std::string endpoint, bool check_endpoint=true);
   static PubSocket * create(Context * context, std::string endpoint, int port, bool check_endpoint=true);
@@ -66,13 +87,30 @@ public:
 
 class SubMaster {
 public:
+  // Sockets are conflating ("latest-only") by default: slow consumers skip to
+  // the newest message instead of draining a backlog. Services listed in
+  // keep_all_list get every message.
   SubMaster(const std::vector<const char *> &service_list,
-            const char *address = nullptr, const std::vector<const char *> &ignore_alive = {});
+            const char *address = nullptr, const std::vector<const char *> &ignore_alive = {},
+            const std::vector<const char *> &keep_all_list = {});
   void update(int timeout = 1000);
   void update_msgs(uint64_t current_time, const std::vector<std::pair<std::string, cereal::Event::Reader>> &messages);
+  // Receive and parse on a background thread. update() then only swaps in the
+  // newest parsed message per service (a few pointer writes), so bursts of
+  // message handling never stall the calling thread, e.g. the UI paint loop.
+  // The readers handed out by operator[] stay owned by the caller's thread:
+  // they are only replaced inside update(), never by the worker.
+  void startAsyncRecv();
   inline bool allAlive(const std::vector<const char *> &service_list = {}) { return all_(service_list, false, true); }
   inline bool allValid(const std::vector<const char *> &service_list = {}) { return all_(service_list, true, false); }
   inline bool allAliveAndValid(const std::vector<const char *> &service_list = {}) { return all_(service_list, true, true); }
+  // Correlated read: true when the newest messages of all listed services were
+  // sent within tolerance_ns of each other, i.e. the readers from operator[]
+  // describe the same instant. max_skew_ns optionally reports the spread so
+  // callers can track staleness. False until every listed service has been
+  // received at least once.
+  bool allConsistent(const std::vector<const char *> &service_list, uint64_t tolerance_ns, uint64_t *max_skew_ns = nullptr) const;
+  uint64_t log_mono_time(const char *name) const;
   void drain();
   ~SubMaster();
 
@@ -86,15 +124,30 @@ public:
 
 private:
   bool all_(const std::vector<const char *> &service_list, bool valid, bool alive);
+  void asyncRecvThread();
   Poller *poller_ = nullptr;
   struct SubMessage;
-  std::map<SubSocket *, SubMessage *> messages_;
-  std::map<std::string, SubMessage *> services_;
+  struct MsgSlot;
+  SubMessage *at_(const char *name) const;
+  // async receive mode
+  std::thread recv_thread_;
+  std::atomic<bool> recv_exit_ = false;
+  bool async_recv_ = false;
+  bool async_ready_ = false;
+  std::mutex async_lock_;
+  std::condition_variable async_cv_;
+  // subscribed messages in registration order, and a dense table indexed by
+  // the compile-time service id from services.h
+  std::vector<std::pair<SubSocket *, SubMessage *>> messages_;
+  std::vector<SubMessage *> services_;
 };
 
 class MessageBuilder : public capnp::MallocMessageBuilder {
 public:
   MessageBuilder() = default;
+  // Build on top of a caller-owned (zeroed) scratch segment, e.g. one rented
+  // from PubMaster's builder pool
+  explicit MessageBuilder(kj::ArrayPtr<capnp::word> scratch) : capnp::MallocMessageBuilder(scratch) {}
 
   cereal::Event::Builder initEvent(bool valid = true) {
     cereal::Event::Builder event = initRoot<cereal::Event>();
@@ -111,6 +164,36 @@ public:
     return heapArray_.asBytes();
   }
 
+  // Serialize the flat array into a caller-owned scratch buffer instead of a
+  // fresh heap allocation, growing it only when the message doesn't fit
+  kj::ArrayPtr<capnp::byte> toBytes(kj::Array<capnp::word> &scratch) {
+    auto segments = getSegmentsForOutput();
+    const size_t table_words = (segments.size() + 2) / 2;
+    size_t total_words = table_words;
+    for (auto &s : segments) total_words += s.size();
+
+    if (scratch.size() < total_words) {
+      scratch = kj::heapArray<capnp::word>(total_words < 512 ? 512 : total_words);
+    }
+
+    // Segment table: segment count - 1, then the size of each segment, zero padded
+    uint32_t *table = reinterpret_cast<uint32_t *>(scratch.begin());
+    table[0] = segments.size() - 1;
+    for (size_t i = 0; i < segments.size(); i++) {
+      table[1 + i] = segments[i].size();
+    }
+    if ((segments.size() % 2) == 0) {
+      table[1 + segments.size()] = 0;
+    }
+
+    capnp::word *p = scratch.begin() + table_words;
+    for (auto &s : segments) {
+      memcpy(p, s.begin(), s.size() * sizeof(capnp::word));
+      p += s.size();
+    }
+    return scratch.slice(0, total_words).asBytes();
+  }
+
 private:
   kj::Array<capnp::word> heapArray_;
 };
@@ -118,12 +201,30 @@ private:
 class PubMaster {
 public:
   PubMaster(const std::vector<const char *> &service_list);
-  inline int send(const char *name, capnp::byte *data, size_t size) { return sockets_.at(name)->send((char *)data, size); }
+  int send(const char *name, capnp::byte *data, size_t size);
   int send(const char *name, MessageBuilder &msg);
+  // Rent a MessageBuilder whose first segment comes from a per-service pool of
+  // recycled, pre-sized segments. Sized by the largest message seen on the
+  // service, so steady-state publishing does no heap allocation.
+  std::unique_ptr<MessageBuilder> makeBuilder(const char *name);
   ~PubMaster();
 
 private:
+  // decimated companion publisher (declared in services.py): every
+  // interval-th serialized buffer is re-sent on "<service>Decimated" so
+  // low-rate consumers don't pay full-rate deserialize cost
+  struct DecimatedCompanion {
+    PubSocket *socket;
+    int interval;
+    int cnt = 0;
+  };
+
   std::map<std::string, PubSocket *> sockets_;
+  std::map<std::string, DecimatedCompanion> companions_;
+  // Per-service serialization scratch and recycled builder segments
+  std::map<std::string, kj::Array<capnp::word>> flat_bufs_;
+  std::map<std::string, std::vector<kj::Array<capnp::word>>> builder_pools_;
+  std::map<std::string, size_t> size_hints_;
 };
 
 class AlignedBuffer {
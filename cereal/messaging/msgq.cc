@@ -112,35 +112,178 @@ int msgq_new_queue(msgq_queue_t * q, const char * path, size_t size){
   }
   q->mmap_p = mem;
 
+#ifdef MADV_HUGEPAGE
+  // best-effort transparent hugepages for the big queues (camera/encoder
+  // streams); the kernel silently keeps 4K pages when shmem THP is off.
+  // MAP_HUGETLB can't be used here: the queues are named tmpfs files that
+  // other processes open by path.
+  if (size >= 2 * 1024 * 1024) {
+    madvise(mem, size + sizeof(msgq_header_t), MADV_HUGEPAGE);
+  }
+#endif
+
   msgq_header_t *header = (msgq_header_t *)mem;
 
   // Setup pointers to header segment
   q->num_readers = reinterpret_cast<std::atomic<uint64_t>*>(&header->num_readers);
   q->write_pointer = reinterpret_cast<std::atomic<uint64_t>*>(&header->write_pointer);
   q->write_uid = reinterpret_cast<std::atomic<uint64_t>*>(&header->write_uid);
+  q->claim_pointer = reinterpret_cast<std::atomic<uint64_t>*>(&header->claim_pointer);
+  q->num_writers = reinterpret_cast<std::atomic<uint64_t>*>(&header->num_writers);
 
   for (size_t i = 0; i < NUM_READERS; i++){
-    q->read_pointers[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->read_pointers[i]);
-    q->read_valids[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->read_valids[i]);
-    q->read_uids[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->read_uids[i]);
+    q->read_pointers[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->readers[i].pointer);
+    q->read_valids[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->readers[i].valid);
+    q->read_uids[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->readers[i].uid);
+    q->read_prios[i] = reinterpret_cast<std::atomic<uint64_t>*>(&header->readers[i].prio);
   }
+  q->drops = reinterpret_cast<std::atomic<uint64_t>*>(&header->drops);
 
   q->data = mem + sizeof(msgq_header_t);
   q->size = size;
   q->reader_id = -1;
+  q->read_prio_local = MSGQ_PRIO_DEFAULT;
 
   q->endpoint = path;
   q->read_conflate = false;
+  q->write_multi = false;
+  q->zero_copy_borrowed = false;
+  q->zero_copy_next_read = 0;
+
+  q->wakeup_rfd = -1;
+  for (size_t i = 0; i < NUM_READERS; i++){
+    q->wakeup_wfds[i] = -1;
+    q->wakeup_wuids[i] = 0;
+  }
 
   return 0;
 }
 
 void msgq_close_queue(msgq_queue_t *q){
+  if (q->wakeup_rfd >= 0){
+    close(q->wakeup_rfd);
+    q->wakeup_rfd = -1;
+  }
+  for (size_t i = 0; i < NUM_READERS; i++){
+    if (q->wakeup_wfds[i] >= 0){
+      close(q->wakeup_wfds[i]);
+      q->wakeup_wfds[i] = -1;
+    }
+  }
   if (q->mmap_p != NULL){
     munmap(q->mmap_p, q->size + sizeof(msgq_header_t));
   }
 }
 
+static void thread_signal(uint32_t tid);
+
+// One FIFO per (queue, reader slot). The publisher writes a byte on every send,
+// giving readers a real fd to block on in poll/epoll instead of sleeping and
+// being kicked with SIGUSR2.
+static void msgq_wakeup_path(msgq_queue_t *q, int id, char *buf, size_t buf_size){
+  snprintf(buf, buf_size, "/dev/shm/%s_wakeup%d", q->endpoint.c_str(), id);
+}
+
+static void msgq_wakeup_reader_init(msgq_queue_t *q){
+  // the slot id can change across re-inits (eviction, reconnect); drop the
+  // previous slot's FIFO instead of leaking it
+  if (q->wakeup_rfd >= 0){
+    close(q->wakeup_rfd);
+    q->wakeup_rfd = -1;
+  }
+
+  char path[1024];
+  msgq_wakeup_path(q, q->reader_id, path, sizeof(path));
+
+  if (mkfifo(path, 0664) < 0 && errno != EEXIST){
+    return; // fall back to signal-driven polling
+  }
+
+  int fd = open(path, O_RDONLY | O_NONBLOCK);
+  if (fd < 0) return;
+
+  // Drain wakeups left over from a previous reader in this slot
+  char drain[64];
+  while (read(fd, drain, sizeof(drain)) > 0);
+
+  q->wakeup_rfd = fd;
+}
+
+static void msgq_wakeup_reader(msgq_queue_t *q, uint64_t i){
+  uint64_t reader_uid = *q->read_uids[i];
+  if (reader_uid == 0) return;
+
+  // (Re)open the slot's FIFO if the reader changed
+  if (q->wakeup_wfds[i] < 0 || q->wakeup_wuids[i] != reader_uid){
+    if (q->wakeup_wfds[i] >= 0){
+      close(q->wakeup_wfds[i]);
+      q->wakeup_wfds[i] = -1;
+    }
+    char path[1024];
+    msgq_wakeup_path(q, i, path, sizeof(path));
+    q->wakeup_wfds[i] = open(path, O_WRONLY | O_NONBLOCK);
+    q->wakeup_wuids[i] = reader_uid;
+  }
+
+  if (q->wakeup_wfds[i] >= 0){
+    char b = 1;
+    // EAGAIN just means the reader already has wakeups pending
+    if (write(q->wakeup_wfds[i], &b, 1) < 0 && errno != EAGAIN){
+      close(q->wakeup_wfds[i]);
+      q->wakeup_wfds[i] = -1;
+    }
+  } else {
+    // No FIFO for this reader (old binary or open failure), kick it the old way
+    thread_signal(reader_uid & 0xFFFFFFFF);
+  }
+}
+
+static void msgq_wakeup_readers(msgq_queue_t *q, uint64_t num_readers){
+  // high-priority readers (e.g. the model) get their wakeup before the rest
+  for (uint64_t i = 0; i < num_readers; i++){
+    if (*q->read_prios[i] >= MSGQ_PRIO_HIGH) msgq_wakeup_reader(q, i);
+  }
+  for (uint64_t i = 0; i < num_readers; i++){
+    if (*q->read_prios[i] < MSGQ_PRIO_HIGH) msgq_wakeup_reader(q, i);
+  }
+}
+
+// Invalidate droppable readers that fell more than MSGQ_DROP_BACKLOG messages
+// behind; on their next read they reset to the write pointer, skipping the
+// backlog instead of working through it late.
+static void msgq_drop_backlogged(msgq_queue_t *q, uint64_t num_readers){
+  uint64_t cur_write = *q->write_pointer;
+
+  for (uint64_t i = 0; i < num_readers; i++){
+    if (*q->read_prios[i] != MSGQ_PRIO_DROPPABLE || !*q->read_valids[i]) continue;
+
+    uint32_t cursor_cycles, cursor;
+    UNPACK64(cursor_cycles, cursor, *q->read_pointers[i]);
+
+    int backlog = 0;
+    uint64_t packed_cursor;
+    PACK64(packed_cursor, cursor_cycles, cursor);
+    while (packed_cursor != cur_write && backlog <= MSGQ_DROP_BACKLOG){
+      int64_t size = *reinterpret_cast<std::atomic<int64_t>*>(q->data + cursor);
+      if (size == -1){
+        cursor_cycles++;
+        cursor = 0;
+      } else if (size <= 0 || (uint64_t)size >= q->size){
+        break;  // raced with a reader reset, re-evaluate on the next send
+      } else {
+        cursor = ALIGN(cursor + sizeof(int64_t) + size);
+        backlog++;
+      }
+      PACK64(packed_cursor, cursor_cycles, cursor);
+    }
+
+    if (backlog > MSGQ_DROP_BACKLOG){
+      *q->read_valids[i] = false;
+      (*q->drops)++;
+    }
+  }
+}
+
 
 void msgq_init_publisher(msgq_queue_t * q) {
   //std::cout << "Starting publisher" << std::endl;
@@ -148,15 +291,35 @@ void msgq_init_publisher(msgq_queue_t * q) {
 
   *q->write_uid = uid;
   *q->num_readers = 0;
+  *q->num_writers = 1;
+  *q->claim_pointer = q->write_pointer->load();
 
   for (size_t i = 0; i < NUM_READERS; i++){
     *q->read_valids[i] = false;
     *q->read_uids[i] = 0;
+    *q->read_prios[i] = MSGQ_PRIO_DEFAULT;
   }
+  *q->drops = 0;
 
   q->write_uid_local = uid;
 }
 
+// Attach a writer to a queue shared by several publishing threads. The first
+// caller resets the queue like msgq_init_publisher; later callers just attach.
+// All writers attached this way publish concurrently without a mutex: sends
+// claim ring space with a CAS on the shared claim pointer and commit the
+// write pointer in claim order.
+void msgq_init_publisher_multi(msgq_queue_t * q) {
+  uint64_t zero = 0;
+  if (std::atomic_compare_exchange_strong(q->num_writers, &zero, (uint64_t)1)){
+    msgq_init_publisher(q);
+  } else {
+    (*q->num_writers)++;
+    q->write_uid_local = *q->write_uid;
+  }
+  q->write_multi = true;
+}
+
 static void thread_signal(uint32_t tid) {
   #ifndef SYS_tkill
     // TODO: this won't work for multithreaded programs
@@ -207,16 +370,139 @@ void msgq_init_subscriber(msgq_queue_t * q) {
       // on the first read the read pointer will be synchronized with the write pointer
       *q->read_valids[cur_num_readers] = false;
       *q->read_pointers[cur_num_readers] = 0;
+      *q->read_prios[cur_num_readers] = q->read_prio_local;
       *q->read_uids[cur_num_readers] = uid;
       break;
     }
   }
 
+  msgq_wakeup_reader_init(q);
+
   //std::cout << "New subscriber id: " << q->reader_id << " uid: " << q->read_uid_local << " " << q->endpoint << std::endl;
   msgq_reset_reader(q);
 }
 
+// Sticky across evictions: msgq_init_subscriber re-applies the local copy
+// when the reader reconnects to a new slot
+void msgq_set_reader_priority(msgq_queue_t * q, uint64_t prio){
+  q->read_prio_local = prio;
+  if (q->reader_id >= 0){
+    *q->read_prios[q->reader_id] = prio;
+  }
+}
+
+uint64_t msgq_get_drop_count(msgq_queue_t * q){
+  return *q->drops;
+}
+
+// Multi-producer send. Space is claimed with a CAS loop on the shared claim
+// pointer, the message is written into the claimed region, and the write
+// pointer is committed in claim order so readers never observe gaps.
+static int msgq_msg_send_multi(msgq_msg_t * msg, msgq_queue_t *q){
+  uint64_t total_msg_size = ALIGN(msg->size + sizeof(int64_t));
+
+  // We need to fit at least three messages in the queue,
+  // then we can always safely access the last message
+  assert(3 * total_msg_size <= q->size);
+
+  uint64_t num_readers = *q->num_readers;
+
+  // Claim a region of the ring
+  uint32_t claim_cycles, claim_offset;
+  uint32_t write_pointer; // start of our message
+  bool wrapped;
+  while (true){
+    uint64_t cur_claim = *q->claim_pointer;
+    UNPACK64(claim_cycles, claim_offset, cur_claim);
+
+    uint32_t new_cycles = claim_cycles;
+    uint32_t start = claim_offset;
+    wrapped = false;
+
+    // Always leave space for a wraparound tag for the next message, including alignment
+    int64_t remaining_space = q->size - claim_offset - total_msg_size - sizeof(int64_t);
+    if (remaining_space <= 0){
+      wrapped = true;
+      new_cycles = claim_cycles + 1;
+      start = 0;
+    }
+
+    uint64_t new_claim;
+    PACK64(new_claim, new_cycles, start + total_msg_size);
+    if (std::atomic_compare_exchange_strong(q->claim_pointer, &cur_claim, new_claim)){
+      write_pointer = start;
+      if (wrapped){
+        // We own the transition: tag the tail so readers wrap around
+        *(int64_t*)(q->data + claim_offset) = -1;
+
+        // Invalidate all readers that are beyond the old tail
+        for (uint64_t i = 0; i < num_readers; i++){
+          uint64_t read_pointer = *q->read_pointers[i];
+          uint64_t read_cycles = read_pointer >> 32;
+          read_pointer &= 0xFFFFFFFF;
+
+          if ((read_pointer > claim_offset) && (read_cycles != new_cycles)) {
+            *q->read_valids[i] = false;
+          }
+        }
+      }
+      claim_cycles = new_cycles;
+      break;
+    }
+  }
+
+  // Invalidate readers that are in the area that will be written
+  uint64_t start = write_pointer;
+  uint64_t end = ALIGN(start + sizeof(int64_t) + msg->size);
+
+  for (uint64_t i = 0; i < num_readers; i++){
+    uint32_t read_cycles, read_pointer;
+    UNPACK64(read_cycles, read_pointer, *q->read_pointers[i]);
+
+    if ((read_pointer >= start) && (read_pointer < end) && (read_cycles != claim_cycles)) {
+      *q->read_valids[i] = false;
+    }
+  }
+
+  char *p = q->data + write_pointer;
+
+  // Write size tag
+  std::atomic<int64_t> *size_p = reinterpret_cast<std::atomic<int64_t>*>(p);
+  *size_p = msg->size;
+
+  // Copy data
+  memcpy(p + sizeof(int64_t), msg->data, msg->size);
+  __sync_synchronize();
+
+  // Commit in claim order: wait until all earlier claims are published.
+  // If we wrapped, our predecessor's commit lands on the old tail (where we
+  // wrote the -1 tag) in the previous cycle.
+  uint64_t expected;
+  if (wrapped){
+    PACK64(expected, claim_cycles - 1, claim_offset);
+  } else {
+    PACK64(expected, claim_cycles, write_pointer);
+  }
+
+  while (*q->write_pointer != expected){
+    ;
+  }
+
+  uint32_t new_ptr = ALIGN(write_pointer + msg->size + sizeof(int64_t));
+  PACK64(*q->write_pointer, claim_cycles, new_ptr);
+
+  // Notify readers
+  msgq_drop_backlogged(q, num_readers);
+  msgq_wakeup_readers(q, num_readers);
+
+  return msg->size;
+}
+
 int msgq_msg_send(msgq_msg_t * msg, msgq_queue_t *q){
+  if (q->write_multi){
+    return msgq_msg_send_multi(msg, q);
+  }
+
   // Die if we are no longer the active publisher
   if (q->write_uid_local != *q->write_uid){
     std::cout << "Killing old publisher: " << q->endpoint << std::endl;
@@ -292,10 +578,8 @@ int msgq_msg_send(msgq_msg_t * msg, msgq_queue_t *q){
   PACK64(*q->write_pointer, write_cycles, new_ptr);
 
   // Notify readers
-  for (uint64_t i = 0; i < num_readers; i++){
-    uint64_t reader_uid = *q->read_uids[i];
-    thread_signal(reader_uid & 0xFFFFFFFF);
-  }
+  msgq_drop_backlogged(q, num_readers);
+  msgq_wakeup_readers(q, num_readers);
 
   return msg->size;
 }
@@ -416,6 +700,182 @@ int msgq_msg_recv(msgq_msg_t * msg, msgq_queue_t * q){
 
 
 
+// Same protocol as msgq_msg_recv, but msg->data points directly into the shared
+// ring instead of a heap copy. The read pointer is left on the message so the
+// publisher keeps invalidating this reader if it overwrites the view; call
+// msgq_msg_release_zero_copy once done with the data. Note that a writer never
+// blocks, so a stale view can still be overwritten; release returns whether the
+// view stayed valid while it was borrowed.
+int msgq_msg_recv_zero_copy(msgq_msg_t * msg, msgq_queue_t * q){
+ start:
+  int id = q->reader_id;
+  assert(id >= 0); // Make sure subscriber is initialized
+
+  if (q->read_uid_local != *q->read_uids[id]){
+    std::cout << q->endpoint << ": Reader was evicted, reconnecting" << std::endl;
+    msgq_init_subscriber(q);
+    goto start;
+  }
+
+  // Check valid
+  if (!*q->read_valids[id]){
+    msgq_reset_reader(q);
+    goto start;
+  }
+
+  uint32_t read_cycles, read_pointer;
+  UNPACK64(read_cycles, read_pointer, *q->read_pointers[id]);
+
+  uint32_t write_cycles, write_pointer;
+  UNPACK64(write_cycles, write_pointer, *q->write_pointer);
+
+  char * p = q->data + read_pointer;
+
+  // Check if new message is available
+  if (read_pointer == write_pointer) {
+    msg->size = 0;
+    return 0;
+  }
+
+  // Read potential message size
+  std::atomic<int64_t> *size_p = reinterpret_cast<std::atomic<int64_t>*>(p);
+  std::int64_t size = *size_p;
+
+  // Check if the size that was read is valid
+  if (!*q->read_valids[id]){
+    msgq_reset_reader(q);
+    goto start;
+  }
+
+  // If size is -1 the buffer was full, and we need to wrap around
+  if (size == -1){
+    read_cycles++;
+    PACK64(*q->read_pointers[id], read_cycles, 0);
+    goto start;
+  }
+
+  // crashing is better than passing garbage data to the consumer
+  // the size will have weird value if it was overwritten by data accidentally
+  assert((uint64_t)size < q->size);
+  assert(size > 0);
+
+  uint32_t new_read_pointer = ALIGN(read_pointer + sizeof(std::int64_t) + size);
+
+  // If conflate is true, check if this is the latest message, else start over
+  if (q->read_conflate){
+    if (new_read_pointer != write_pointer){
+      // Update read pointer
+      PACK64(*q->read_pointers[id], read_cycles, new_read_pointer);
+      goto start;
+    }
+  }
+
+  __sync_synchronize();
+
+  // Hand out a view into the ring. The read pointer stays on this message
+  // until release, so the publisher will invalidate us before reusing it.
+  msg->data = p + sizeof(int64_t);
+  msg->size = size;
+
+  q->zero_copy_borrowed = true;
+  PACK64(q->zero_copy_next_read, read_cycles, new_read_pointer);
+
+  return msg->size;
+}
+
+// Claim up to max_msgs pending messages in a single pass of the read cursor,
+// filling msgs with zero-copy views into the ring. Like msgq_msg_recv_zero_copy
+// the read pointer stays parked on the first claimed message until
+// msgq_msg_release_zero_copy, so the publisher invalidates the whole batch
+// before overwriting any of it. Returns the number of messages claimed.
+int msgq_msg_recv_batch(msgq_msg_t * msgs, size_t max_msgs, msgq_queue_t * q){
+ start:
+  int id = q->reader_id;
+  assert(id >= 0); // Make sure subscriber is initialized
+
+  if (q->read_uid_local != *q->read_uids[id]){
+    std::cout << q->endpoint << ": Reader was evicted, reconnecting" << std::endl;
+    msgq_init_subscriber(q);
+    goto start;
+  }
+
+  // Check valid
+  if (!*q->read_valids[id]){
+    msgq_reset_reader(q);
+    goto start;
+  }
+
+  uint32_t read_cycles, read_pointer;
+  UNPACK64(read_cycles, read_pointer, *q->read_pointers[id]);
+
+  uint32_t write_cycles, write_pointer;
+  UNPACK64(write_cycles, write_pointer, *q->write_pointer);
+
+  size_t num_msgs = 0;
+  uint32_t cursor = read_pointer;
+  uint32_t cursor_cycles = read_cycles;
+
+  while (num_msgs < max_msgs && cursor != write_pointer) {
+    char * p = q->data + cursor;
+
+    std::atomic<int64_t> *size_p = reinterpret_cast<std::atomic<int64_t>*>(p);
+    std::int64_t size = *size_p;
+
+    // Check if the size that was read is valid
+    if (!*q->read_valids[id]){
+      msgq_reset_reader(q);
+      goto start;
+    }
+
+    // If size is -1 the buffer was full, and we need to wrap around
+    if (size == -1){
+      cursor_cycles++;
+      cursor = 0;
+      continue;
+    }
+
+    assert((uint64_t)size < q->size);
+    assert(size > 0);
+
+    __sync_synchronize();
+    msgs[num_msgs].data = p + sizeof(int64_t);
+    msgs[num_msgs].size = size;
+    num_msgs++;
+
+    cursor = ALIGN(cursor + sizeof(std::int64_t) + size);
+  }
+
+  if (num_msgs > 0) {
+    q->zero_copy_borrowed = true;
+    PACK64(q->zero_copy_next_read, cursor_cycles, cursor);
+  }
+
+  return num_msgs;
+}
+
+// Advance the read pointer past a message returned by msgq_msg_recv_zero_copy.
+// Returns 0 if the view stayed valid for the whole borrow, -1 if the publisher
+// lapped us and the data may have been overwritten.
+int msgq_msg_release_zero_copy(msgq_queue_t * q){
+  if (!q->zero_copy_borrowed) return 0;
+  q->zero_copy_borrowed = false;
+
+  int id = q->reader_id;
+  assert(id >= 0);
+
+  __sync_synchronize();
+  if (q->read_uid_local != *q->read_uids[id] || !*q->read_valids[id]){
+    return -1;
+  }
+
+  *q->read_pointers[id] = q->zero_copy_next_read;
+  return 0;
+}
+
+int msgq_get_fd(msgq_queue_t *q){
+  return q->wakeup_rfd;
+}
+
 int msgq_poll(msgq_pollitem_t * items, size_t nitems, int timeout){
   int num = 0;
 
@@ -425,16 +885,37 @@ int msgq_poll(msgq_pollitem_t * items, size_t nitems, int timeout){
     if (items[i].revents) num++;
   }
 
+  // Block on the per-reader wakeup fds when every queue has one, otherwise
+  // fall back to the old sleep-and-recheck loop
+  bool have_fds = true;
+  struct pollfd fds[nitems];
+  for (size_t i = 0; i < nitems; i++) {
+    fds[i].fd = items[i].q->wakeup_rfd;
+    fds[i].events = POLLIN;
+    if (fds[i].fd < 0) have_fds = false;
+  }
+
   int ms = (timeout == -1) ? 100 : timeout;
   struct timespec ts;
   ts.tv_sec = ms / 1000;
   ts.tv_nsec = (ms % 1000) * 1000 * 1000;
 
-
   while (num == 0) {
     int ret;
 
-    ret = nanosleep(&ts, &ts);
+    if (have_fds) {
+      ret = poll(fds, nitems, ms);
+
+      // Drain pending wakeups so the fds stay level-triggered on new sends
+      for (size_t i = 0; i < nitems; i++) {
+        if (fds[i].revents & POLLIN) {
+          char drain[64];
+          while (read(fds[i].fd, drain, sizeof(drain)) > 0);
+        }
+      }
+    } else {
+      ret = nanosleep(&ts, &ts);
+    }
 
     // Check if messages ready
     for (size_t i = 0; i < nitems; i++) {
@@ -444,7 +925,7 @@ int msgq_poll(msgq_pollitem_t * items, size_t nitems, int timeout){
       }
     }
 
-    // exit if we had a timeout and the sleep finished
+    // exit if we had a timeout and the wait finished
     if (timeout != -1 && ret == 0){
       break;
     }
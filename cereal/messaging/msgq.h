@@ -8,34 +8,73 @@
 #define NUM_READERS 10
 #define ALIGN(n) ((n + (8 - 1)) & -8)
 
+// Reader priority classes, stored per reader slot in the shared header.
+// High-priority readers get their wakeup first on every send; droppable
+// readers are invalidated (skipped to the newest message) once they fall
+// more than MSGQ_DROP_BACKLOG messages behind.
+#define MSGQ_PRIO_DROPPABLE 0
+#define MSGQ_PRIO_DEFAULT 1
+#define MSGQ_PRIO_HIGH 2
+
+#define MSGQ_DROP_BACKLOG 16
+
 #define UNPACK64(higher, lower, input) do {uint64_t tmp = input; higher = tmp >> 32; lower = tmp & 0xFFFFFFFF;} while (0)
 #define PACK64(output, higher, lower) output = ((uint64_t)higher << 32 ) | ((uint64_t)lower & 0xFFFFFFFF)
 
-struct  msgq_header_t {
+#define MSGQ_CACHELINE 64
+
+// The writer's cursors and each reader slot sit on their own cache line, so
+// a subscriber polling its slot never bounces the line the publisher is
+// advancing and readers don't false-share with each other. The header size
+// stays a cache line multiple, which also cache-aligns the data ring.
+struct msgq_header_t {
   uint64_t num_readers;
-  uint64_t write_pointer;
+  uint64_t num_writers;
+  uint64_t drops;
+  alignas(MSGQ_CACHELINE) uint64_t write_pointer;
   uint64_t write_uid;
-  uint64_t read_pointers[NUM_READERS];
-  uint64_t read_valids[NUM_READERS];
-  uint64_t read_uids[NUM_READERS];
+  uint64_t claim_pointer;
+  struct alignas(MSGQ_CACHELINE) {
+    uint64_t pointer;
+    uint64_t valid;
+    uint64_t uid;
+    uint64_t prio;
+  } readers[NUM_READERS];
 };
+static_assert(sizeof(msgq_header_t) % MSGQ_CACHELINE == 0, "msgq data ring must stay cache aligned");
 
 struct msgq_queue_t {
   std::atomic<uint64_t> *num_readers;
   std::atomic<uint64_t> *write_pointer;
   std::atomic<uint64_t> *write_uid;
+  std::atomic<uint64_t> *claim_pointer;
+  std::atomic<uint64_t> *num_writers;
   std::atomic<uint64_t> *read_pointers[NUM_READERS];
   std::atomic<uint64_t> *read_valids[NUM_READERS];
   std::atomic<uint64_t> *read_uids[NUM_READERS];
+  std::atomic<uint64_t> *read_prios[NUM_READERS];
+  std::atomic<uint64_t> *drops;
   char * mmap_p;
   char * data;
   size_t size;
   int reader_id;
   uint64_t read_uid_local;
   uint64_t write_uid_local;
+  uint64_t read_prio_local;
 
   bool read_conflate;
+  bool write_multi;
   std::string endpoint;
+
+  // Zero-copy read state: read pointer to publish once the borrowed view is released
+  bool zero_copy_borrowed;
+  uint64_t zero_copy_next_read;
+
+  // Pollable wakeup: one FIFO per reader slot, written by the publisher on send.
+  // wakeup_rfd is this subscriber's own fd, usable with poll/epoll (msgq_get_fd).
+  int wakeup_rfd;
+  int wakeup_wfds[NUM_READERS];
+  uint64_t wakeup_wuids[NUM_READERS];
 };
 
 struct msgq_msg_t {
@@ -58,11 +97,18 @@ int msgq_msg_close(msgq_msg_t *msg);
 int msgq_new_queue(msgq_queue_t * q, const char * path, size_t size);
 void msgq_close_queue(msgq_queue_t *q);
 void msgq_init_publisher(msgq_queue_t * q);
+void msgq_init_publisher_multi(msgq_queue_t * q);
 void msgq_init_subscriber(msgq_queue_t * q);
+void msgq_set_reader_priority(msgq_queue_t * q, uint64_t prio);
+uint64_t msgq_get_drop_count(msgq_queue_t * q);
 
 int msgq_msg_send(msgq_msg_t *msg, msgq_queue_t *q);
 int msgq_msg_recv(msgq_msg_t *msg, msgq_queue_t *q);
+int msgq_msg_recv_zero_copy(msgq_msg_t *msg, msgq_queue_t *q);
+int msgq_msg_recv_batch(msgq_msg_t *msgs, size_t max_msgs, msgq_queue_t *q);
+int msgq_msg_release_zero_copy(msgq_queue_t *q);
 int msgq_msg_ready(msgq_queue_t * q);
 int msgq_poll(msgq_pollitem_t * items, size_t nitems, int timeout);
+int msgq_get_fd(msgq_queue_t *q);
 
 bool msgq_all_readers_updated(msgq_queue_t *q);
@@ -1,13 +1,29 @@
 #include <time.h>
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <mutex>
 
+#include <unistd.h>
+
 #include "services.h"
 #include "messaging.h"
+#include "msgq.h"
+#include "latency_stats.h"
 
 const bool SIMULATION = (getenv("SIMULATION") != nullptr) && (std::string(getenv("SIMULATION")) == "1");
+// Zero-copy mode builds the capnp reader directly over the msgq shared-memory ring,
+// only advancing the read cursor on the next update. The ring is 8 byte aligned, so
+// no aligned copy is needed either. A publisher lapping the borrow is detected when
+// the view is released and the affected message is retroactively invalidated.
+const bool MSGQ_ZERO_COPY = (getenv("MSGQ_ZERO_COPY") != nullptr) && (std::string(getenv("MSGQ_ZERO_COPY")) == "1");
+// Opt-in per-service latency/inter-arrival histograms in /dev/shm, readable
+// with messaging/latency_dump while the process runs
+const bool MSG_LATENCY_STATS = (getenv("MSG_LATENCY_STATS") != nullptr) && (std::string(getenv("MSG_LATENCY_STATS")) == "1");
 
 static inline uint64_t nanos_since_boot() {
   struct timespec t;
@@ -15,11 +31,9 @@ static inline uint64_t nanos_since_boot() {
   return t.tv_sec * 1000000000ULL + t.tv_nsec;
 }
 
-static const service *get_service(const char *name) {
-  for (const auto &it : services) {
-    if (strcmp(it.name, name) == 0) return &it;
-  }
-  return nullptr;
+static const service_descriptor *get_service(const char *name) {
+  int i = service_index(name);
+  return (i >= 0) ? &service_descriptors[i] : nullptr;
 }
 
 static inline bool inList(const std::vector<const char *> &list, const char *value) {
@@ -44,25 +58,52 @@ private:
 
 MessageContext message_context;
 
+// a message received and parsed by the async recv thread, waiting for the
+// next update() to swap it in
+struct SubMaster::MsgSlot {
+  AlignedBuffer buf;
+  capnp::FlatArrayMessageReader *reader = nullptr;
+  uint64_t rcv_time = 0;
+  ~MsgSlot() { delete reader; }
+};
+
 struct SubMaster::SubMessage {
   std::string name;
   SubSocket *socket = nullptr;
   int freq = 0;
   bool updated = false, alive = false, valid = true, ignore_alive;
   uint64_t rcv_time = 0, rcv_frame = 0;
+  uint64_t log_mono_time = 0;  // sender timestamp of the current message
+  latency_stats_record_t *stats = nullptr;
   void *allocated_msg_reader = nullptr;
   capnp::FlatArrayMessageReader *msg_reader = nullptr;
   AlignedBuffer aligned_buf;
   cereal::Event::Reader event;
+  // async receive mode: staged is written by the worker under async_lock_,
+  // live keeps the swapped-in message alive while event points into it
+  MsgSlot *staged = nullptr;
+  MsgSlot *live = nullptr;
 };
 
 SubMaster::SubMaster(const std::vector<const char *> &service_list, const char *address,
-                     const std::vector<const char *> &ignore_alive) {
+                     const std::vector<const char *> &ignore_alive,
+                     const std::vector<const char *> &keep_all_list) {
   poller_ = Poller::create();
+
+  latency_stats_page_t *stats_page = nullptr;
+  if (MSG_LATENCY_STATS) {
+    char page_name[64];
+    snprintf(page_name, sizeof(page_name), "msg_latency_%d", getpid());
+    stats_page = latency_stats_open(page_name, true);
+  }
+
+  services_.resize(NUM_SERVICES, nullptr);
+
   for (auto name : service_list) {
-    const service *serv = get_service(name);
+    const service_descriptor *serv = get_service(name);
     assert(serv != nullptr);
-    SubSocket *socket = SubSocket::create(message_context.context(), name, address ? address : "127.0.0.1", true);
+    bool conflate = !inList(keep_all_list, name);
+    SubSocket *socket = SubSocket::create(message_context.context(), name, address ? address : "127.0.0.1", conflate);
     assert(socket != 0);
     poller_->registerSocket(socket);
     SubMessage *m = new SubMessage{
@@ -72,30 +113,119 @@ SubMaster::SubMaster(const std::vector<const char *> &service_list, const char *
       .ignore_alive = inList(ignore_alive, name),
       .allocated_msg_reader = malloc(sizeof(capnp::FlatArrayMessageReader))};
     m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader({});
-    messages_[socket] = m;
-    services_[name] = m;
+    if (stats_page != nullptr) {
+      m->stats = latency_stats_get_record(stats_page, name);
+    }
+    messages_.push_back({socket, m});
+    services_[service_index(name)] = m;
+  }
+}
+
+void SubMaster::startAsyncRecv() {
+  assert(!async_recv_);
+  // the worker owns the sockets from here on; the zero-copy ring borrow is
+  // tied to the updating thread, so async mode always takes the copy path
+  async_recv_ = true;
+  recv_thread_ = std::thread(&SubMaster::asyncRecvThread, this);
+}
+
+void SubMaster::asyncRecvThread() {
+  capnp::ReaderOptions options;
+  options.traversalLimitInWords = kj::maxValue; // Don't limit
+
+  while (!recv_exit_) {
+    auto sockets = poller_->poll(100);
+    uint64_t current_time = nanos_since_boot();
+    for (auto s : sockets) {
+      SubMessage *m = nullptr;
+      for (auto &kv : messages_) {
+        if (kv.first == s) { m = kv.second; break; }
+      }
+      if (m == nullptr) continue;
+
+      Message *msg = s->receive(true);
+      if (msg == nullptr) continue;
+
+      MsgSlot *slot = new MsgSlot();
+      slot->reader = new capnp::FlatArrayMessageReader(slot->buf.align(msg), options);
+      slot->rcv_time = current_time;
+      delete msg;
+
+      std::lock_guard lk(async_lock_);
+      delete m->staged;  // conflate: keep only the newest unconsumed message
+      m->staged = slot;
+      async_ready_ = true;
+    }
+    if (!sockets.empty()) async_cv_.notify_one();
   }
 }
 
 void SubMaster::update(int timeout) {
   for (auto &kv : messages_) kv.second->updated = false;
 
+  if (async_recv_) {
+    std::unique_lock lk(async_lock_);
+    async_cv_.wait_for(lk, std::chrono::milliseconds(timeout), [this] { return async_ready_; });
+    async_ready_ = false;
+
+    std::vector<std::pair<std::string, cereal::Event::Reader>> messages;
+    uint64_t current_time = nanos_since_boot();
+    for (auto &kv : messages_) {
+      SubMessage *m = kv.second;
+      if (m->staged == nullptr) continue;
+      delete m->live;  // the previous message isn't referenced past update()
+      m->live = m->staged;
+      m->staged = nullptr;
+      messages.push_back({m->name, m->live->reader->getRoot<cereal::Event>()});
+    }
+    lk.unlock();
+
+    update_msgs(current_time, messages);
+    return;
+  }
+
   auto sockets = poller_->poll(timeout);
   uint64_t current_time = nanos_since_boot();
 
   std::vector<std::pair<std::string, cereal::Event::Reader>> messages;
 
-  for (auto s : sockets) {
-    Message *msg = s->receive(true);
-    if (msg == nullptr) continue;
+  const bool zero_copy = MSGQ_ZERO_COPY && !messaging_use_zmq();
 
-    SubMessage *m = messages_.at(s);
+  for (auto s : sockets) {
+    SubMessage *m = nullptr;
+    for (auto &kv : messages_) {
+      if (kv.first == s) { m = kv.second; break; }
+    }
+    if (m == nullptr) continue;
 
-    m->msg_reader->~FlatArrayMessageReader();
     capnp::ReaderOptions options;
     options.traversalLimitInWords = kj::maxValue; // Don't limit
-    m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader(m->aligned_buf.align(msg), options);
-    delete msg;
+
+    if (zero_copy) {
+      msgq_queue_t *q = (msgq_queue_t *)s->getRawSocket();
+      // Release the view handed out on the previous frame, then borrow the
+      // next one. -1 means the publisher lapped the borrow: the data served
+      // for the whole previous frame may have been overwritten mid-read, so
+      // retroactively invalidate it. A fresh message this frame sets valid
+      // again; until then consumers must not trust what they saw.
+      if (msgq_msg_release_zero_copy(q) < 0) {
+        m->valid = false;
+        fprintf(stderr, "%s: zero-copy view lapped by the publisher, previous message invalidated\n", m->name.c_str());
+      }
+      msgq_msg_t msg;
+      if (msgq_msg_recv_zero_copy(&msg, q) <= 0) continue;
+
+      m->msg_reader->~FlatArrayMessageReader();
+      m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader(
+          kj::ArrayPtr<const capnp::word>((const capnp::word *)msg.data, msg.size / sizeof(capnp::word)), options);
+    } else {
+      Message *msg = s->receive(true);
+      if (msg == nullptr) continue;
+
+      m->msg_reader->~FlatArrayMessageReader();
+      m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader(m->aligned_buf.align(msg), options);
+      delete msg;
+    }
     messages.push_back({m->name, m->msg_reader->getRoot<cereal::Event>()});
   }
 
@@ -106,12 +236,16 @@ void SubMaster::update_msgs(uint64_t current_time, const std::vector<std::pair<s
   if (++frame == UINT64_MAX) frame = 1;
 
   for(auto &kv : messages) {
-    auto m_find = services_.find(kv.first);
-    if (m_find == services_.end()){
+    int id = service_index(kv.first.c_str());
+    SubMessage *m = (id >= 0) ? services_[id] : nullptr;
+    if (m == nullptr){
       continue;
     }
-    SubMessage *m = m_find->second;
     m->event = kv.second;
+    m->log_mono_time = kv.second.getLogMonoTime();
+    if (m->stats != nullptr) {
+      latency_stats_sample(m->stats, current_time > m->log_mono_time ? current_time - m->log_mono_time : 0, current_time);
+    }
     m->updated = true;
     m->rcv_time = current_time;
     m->rcv_frame = frame;
@@ -127,6 +261,25 @@ void SubMaster::update_msgs(uint64_t current_time, const std::vector<std::pair<s
   }
 }
 
+bool SubMaster::allConsistent(const std::vector<const char *> &service_list, uint64_t tolerance_ns, uint64_t *max_skew_ns) const {
+  uint64_t t_min = UINT64_MAX, t_max = 0;
+  for (auto &kv : messages_) {
+    SubMessage *m = kv.second;
+    if (service_list.size() == 0 || inList(service_list, m->name.c_str())) {
+      if (m->log_mono_time == 0) return false;  // never received
+      t_min = std::min(t_min, m->log_mono_time);
+      t_max = std::max(t_max, m->log_mono_time);
+    }
+  }
+  if (t_max == 0) return false;
+  if (max_skew_ns != nullptr) *max_skew_ns = t_max - t_min;
+  return (t_max - t_min) <= tolerance_ns;
+}
+
+uint64_t SubMaster::log_mono_time(const char *name) const {
+  return at_(name)->log_mono_time;
+}
+
 bool SubMaster::all_(const std::vector<const char *> &service_list, bool valid, bool alive) {
   int found = 0;
   for (auto &kv : messages_) {
@@ -135,7 +288,7 @@ bool SubMaster::all_(const std::vector<const char *> &service_list, bool valid,
       found += (!valid || m->valid) && (!alive || (m->alive || m->ignore_alive));
     }
   }
-  return service_list.size() == 0 ? found == messages_.size() : found == service_list.size();
+  return service_list.size() == 0 ? (size_t)found == messages_.size() : (size_t)found == service_list.size();
 }
 
 void SubMaster::drain() {
@@ -151,36 +304,48 @@ void SubMaster::drain() {
   }
 }
 
+SubMaster::SubMessage *SubMaster::at_(const char *name) const {
+  int id = service_index(name);
+  assert(id >= 0 && services_[id] != nullptr);
+  return services_[id];
+}
+
 bool SubMaster::updated(const char *name) const {
-  return services_.at(name)->updated;
+  return at_(name)->updated;
 }
 
 bool SubMaster::alive(const char *name) const {
-  return services_.at(name)->alive;
+  return at_(name)->alive;
 }
 
 bool SubMaster::valid(const char *name) const {
-  return services_.at(name)->valid;
+  return at_(name)->valid;
 }
 
 uint64_t SubMaster::rcv_frame(const char *name) const {
-  return services_.at(name)->rcv_frame;
+  return at_(name)->rcv_frame;
 }
 
 uint64_t SubMaster::rcv_time(const char *name) const {
-  return services_.at(name)->rcv_time;
+  return at_(name)->rcv_time;
 }
 
 cereal::Event::Reader &SubMaster::operator[](const char *name) const {
-  return services_.at(name)->event;
+  return at_(name)->event;
 };
 
 SubMaster::~SubMaster() {
+  if (async_recv_) {
+    recv_exit_ = true;
+    recv_thread_.join();
+  }
   delete poller_;
   for (auto &kv : messages_) {
     SubMessage *m = kv.second;
     m->msg_reader->~FlatArrayMessageReader();
     free(m->allocated_msg_reader);
+    delete m->staged;
+    delete m->live;
     delete m->socket;
     delete m;
   }
@@ -192,14 +357,72 @@ PubMaster::PubMaster(const std::vector<const char *> &service_list) {
     PubSocket *socket = PubSocket::create(message_context.context(), name);
     assert(socket);
     sockets_[name] = socket;
+
+    // publishers of a service with a declared companion also publish the
+    // decimated topic; the bytes are already serialized, so re-sending
+    // every Nth buffer is nearly free on the publisher side
+    for (int i = 0; i < NUM_DECIMATED_COMPANIONS; i++) {
+      if (strcmp(decimated_companions[i].base, name) == 0) {
+        PubSocket *companion_socket = PubSocket::create(message_context.context(), decimated_companions[i].topic);
+        assert(companion_socket);
+        companions_[name] = {companion_socket, decimated_companions[i].interval};
+      }
+    }
   }
 }
 
+// Returns its scratch segment to the owning pool when destroyed
+class PooledMessageBuilder : public MessageBuilder {
+public:
+  PooledMessageBuilder(std::vector<kj::Array<capnp::word>> *pool, kj::Array<capnp::word> seg)
+      : MessageBuilder(kj::ArrayPtr<capnp::word>(seg.begin(), seg.size())), pool_(pool), seg_(kj::mv(seg)) {}
+  ~PooledMessageBuilder() { pool_->push_back(kj::mv(seg_)); }
+
+private:
+  std::vector<kj::Array<capnp::word>> *pool_;
+  kj::Array<capnp::word> seg_;
+};
+
+std::unique_ptr<MessageBuilder> PubMaster::makeBuilder(const char *name) {
+  auto &pool = builder_pools_[name];
+  size_t words = std::max(size_hints_[name], (size_t)512);
+
+  kj::Array<capnp::word> seg;
+  if (!pool.empty() && pool.back().size() >= words) {
+    seg = kj::mv(pool.back());
+    pool.pop_back();
+  } else {
+    seg = kj::heapArray<capnp::word>(words);
+  }
+  // capnp requires scratch segments to be zeroed
+  memset(seg.begin(), 0, seg.size() * sizeof(capnp::word));
+  return std::make_unique<PooledMessageBuilder>(&pool, kj::mv(seg));
+}
+
+int PubMaster::send(const char *name, capnp::byte *data, size_t size) {
+  int ret = sockets_.at(name)->send((char *)data, size);
+  auto it = companions_.find(name);
+  if (it != companions_.end()) {
+    DecimatedCompanion &c = it->second;
+    if (++c.cnt >= c.interval) {
+      c.cnt = 0;
+      c.socket->send((char *)data, size);
+    }
+  }
+  return ret;
+}
+
 int PubMaster::send(const char *name, MessageBuilder &msg) {
-  auto bytes = msg.toBytes();
+  auto bytes = msg.toBytes(flat_bufs_[name]);
+
+  // Remember the largest message per service so rented segments fit in one go
+  size_t words = bytes.size() / sizeof(capnp::word) + 1;
+  if (words > size_hints_[name]) size_hints_[name] = words;
+
   return send(name, bytes.begin(), bytes.size());
 }
 
 PubMaster::~PubMaster() {
   for (auto s : sockets_) delete s.second;
+  for (auto &c : companions_) delete c.second.socket;
 }
@@ -0,0 +1,89 @@
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "state_channel.h"
+
+StateChannel::StateChannel(const char *service, bool publisher) {
+  char full_path[1024];
+  snprintf(full_path, sizeof(full_path), "/dev/shm/state_%s", service);
+
+  int fd = open(full_path, O_RDWR | O_CREAT, 0664);
+  if (fd < 0) return;
+
+  if (ftruncate(fd, sizeof(state_channel_slot_t)) < 0) {
+    close(fd);
+    return;
+  }
+
+  void *mem = mmap(NULL, sizeof(state_channel_slot_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) return;
+
+  slot_ = (state_channel_slot_t *)mem;
+  if (publisher) {
+    memset(slot_, 0, sizeof(state_channel_slot_t));
+  }
+
+  allocated_msg_reader = malloc(sizeof(capnp::FlatArrayMessageReader));
+  msg_reader = new (allocated_msg_reader) capnp::FlatArrayMessageReader({});
+}
+
+bool StateChannel::write(const capnp::byte *data, size_t size) {
+  if (slot_ == nullptr || size > STATE_CHANNEL_MAX_SIZE) return false;
+
+  // Seqlock write: odd sequence marks the slot as busy
+  uint64_t seq = slot_->seq.load(std::memory_order_relaxed);
+  slot_->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  memcpy(slot_->data, data, size);
+  slot_->size = size;
+
+  std::atomic_thread_fence(std::memory_order_release);
+  slot_->seq.store(seq + 2, std::memory_order_relaxed);
+  return true;
+}
+
+size_t StateChannel::read(char *buf) {
+  if (slot_ == nullptr) return 0;
+
+  while (true) {
+    uint64_t seq1 = slot_->seq.load(std::memory_order_acquire);
+    if (seq1 == 0) return 0;        // never written
+    if (seq1 & 1) continue;         // write in progress
+
+    size_t size = slot_->size;
+    if (size > STATE_CHANNEL_MAX_SIZE) continue;
+    memcpy(buf, slot_->data, size);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t seq2 = slot_->seq.load(std::memory_order_relaxed);
+    if (seq1 == seq2) return size;
+  }
+}
+
+bool StateChannel::get(cereal::Event::Reader *event) {
+  size_t size = read(read_buf_);
+  if (size == 0) return false;
+
+  capnp::ReaderOptions options;
+  options.traversalLimitInWords = kj::maxValue;
+  msg_reader->~FlatArrayMessageReader();
+  msg_reader = new (allocated_msg_reader) capnp::FlatArrayMessageReader(
+      kj::ArrayPtr<const capnp::word>((const capnp::word *)read_buf_, size / sizeof(capnp::word)), options);
+  *event = msg_reader->getRoot<cereal::Event>();
+  return true;
+}
+
+StateChannel::~StateChannel() {
+  if (msg_reader != nullptr) {
+    msg_reader->~FlatArrayMessageReader();
+    free(allocated_msg_reader);
+  }
+  if (slot_ != nullptr) {
+    munmap(slot_, sizeof(state_channel_slot_t));
+  }
+}
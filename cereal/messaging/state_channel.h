@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include <capnp/serialize.h>
+#include "../gen/cpp/log.capnp.h"
+
+// Single-slot shared-memory channel for tiny high-rate states (deviceState,
+// liveCalibration, ...). A seqlock protects a fixed-size slot holding the
+// latest serialized event, so readers pay a couple of cache line reads instead
+// of the full msgq protocol. This is latest-only by design: publishers should
+// keep publishing on msgq for history consumers like loggerd.
+
+#define STATE_CHANNEL_MAX_SIZE 496  // slot fits in 8 cache lines with the header
+
+struct state_channel_slot_t {
+  std::atomic<uint64_t> seq;  // odd while a write is in progress
+  uint64_t size;
+  char data[STATE_CHANNEL_MAX_SIZE];
+};
+
+class StateChannel {
+public:
+  // Maps /dev/shm/state_<service>; the publisher creates and zeroes the slot
+  StateChannel(const char *service, bool publisher);
+  ~StateChannel();
+  inline bool valid() const { return slot_ != nullptr; }
+
+  // Returns false if the serialized message doesn't fit in the slot
+  bool write(const capnp::byte *data, size_t size);
+  bool write(kj::ArrayPtr<capnp::byte> bytes) { return write(bytes.begin(), bytes.size()); }
+
+  // Copies the latest state out under the seqlock; returns 0 if never written.
+  // buf must hold STATE_CHANNEL_MAX_SIZE bytes.
+  size_t read(char *buf);
+
+  // Typed accessor: parse the latest state as a cereal::Event. Returns false
+  // if the channel is empty. The reader stays valid until the next call.
+  bool get(cereal::Event::Reader *event);
+
+private:
+  state_channel_slot_t *slot_ = nullptr;
+  alignas(8) char read_buf_[STATE_CHANNEL_MAX_SIZE];
+  void *allocated_msg_reader = nullptr;
+  capnp::FlatArrayMessageReader *msg_reader = nullptr;
+};
@@ -43,6 +43,10 @@ services = {
   "gpsLocationExternal": (True, 10., 1),
   "ubloxGnss": (True, 10.),
   "clocks": (True, 1., 1),
+  "clockCorrelation": (True, 1., 1),
+  "latencyBudget": (True, 1., 1),
+  "canHealth": (True, 1., 1),
+  "metrics": (True, 1., 1),
   "ubloxRaw": (True, 20.),
   "liveLocationKalman": (True, 20., 2),
   "liveParameters": (True, 20., 2),
@@ -69,15 +73,42 @@ services = {
   # debug
   "testJoystick": (False, 0.),
 }
+
+# decimated companion topics: PubMaster re-sends every Nth already-serialized
+# buffer of the base service on "<base>Decimated", so low-rate consumers (UI,
+# diagnostics) subscribe there instead of paying full-rate deserialize cost.
+# not logged; the base topic already is.
+decimated_companions = {
+  # base service: send every Nth message
+  "liveLocationKalman": 20,  # 20Hz -> 1Hz, everything but paramsd is fine with this
+  "can": 100,                # 100Hz -> 1Hz for diagnostic consumers
+}
+
+for _base, _interval in decimated_companions.items():
+  services[_base + "Decimated"] = (False, services[_base][1] / _interval)
+
 service_list = {name: Service(new_port(idx), *vals) for  # type: ignore
                 idx, (name, vals) in enumerate(services.items())}
 
 
+def fnv1a_hash(name: str) -> int:
+  # must match the generated service_hash()
+  h = 2166136261
+  for c in name:
+    h = ((h ^ ord(c)) * 16777619) & 0xFFFFFFFF
+  return h
+
+
 def build_header():
+  # a hash collision would alias two services to the same dense id; the
+  # generated lookup also compares names, but fail loudly here regardless
+  assert len({fnv1a_hash(name) for name in service_list}) == len(service_list), "service name hash collision"
+
   h = ""
   h += "/* THIS IS AN AUTOGENERATED FILE, PLEASE EDIT services.py */\n"
   h += "#ifndef __SERVICES_H\n"
   h += "#define __SERVICES_H\n"
+  h += "#include <cstdint>\n"
   h += "struct service { char name[0x100]; int port; bool should_log; int frequency; int decimation; };\n"
   h += "static struct service services[] = {\n"
   for k, v in service_list.items():
@@ -86,6 +117,46 @@ def build_header():
     h += '  { "%s", %d, %s, %d, %d },\n' % \
          (k, v.port, should_log, v.frequency, decimation)
   h += "};\n"
+
+  # compile-time descriptor table: dense service ids resolvable at compile time
+  # for literal names, so hot paths can skip string-keyed map lookups
+  h += "constexpr uint32_t service_hash(const char *s) {\n"
+  h += "  uint32_t hash = 2166136261u;\n"
+  h += "  while (*s != 0) { hash ^= (uint32_t)(*s++); hash *= 16777619u; }\n"
+  h += "  return hash;\n"
+  h += "}\n"
+  h += "constexpr bool service_name_eq(const char *a, const char *b) {\n"
+  h += "  while (*a != 0 && *a == *b) { a++; b++; }\n"
+  h += "  return *a == *b;\n"
+  h += "}\n"
+  h += "constexpr int NUM_SERVICES = %d;\n" % len(service_list)
+  h += "struct service_descriptor { uint32_t hash; const char *name; int port; bool should_log; int frequency; int decimation; };\n"
+  h += "static constexpr service_descriptor service_descriptors[NUM_SERVICES] = {\n"
+  for k, v in service_list.items():
+    should_log = "true" if v.should_log else "false"
+    decimation = -1 if v.decimation is None else v.decimation
+    h += '  { service_hash("%s"), "%s", %d, %s, %d, %d },\n' % \
+         (k, k, v.port, should_log, v.frequency, decimation)
+  h += "};\n"
+  h += "// Dense id for a service name, -1 if unknown. The name compare after\n"
+  h += "// the hash match guards against collisions and still folds away for\n"
+  h += "// literal arguments.\n"
+  h += "constexpr int service_index(const char *name) {\n"
+  h += "  uint32_t hash = service_hash(name);\n"
+  h += "  for (int i = 0; i < NUM_SERVICES; i++) {\n"
+  h += "    if (service_descriptors[i].hash == hash && service_name_eq(service_descriptors[i].name, name)) return i;\n"
+  h += "  }\n"
+  h += "  return -1;\n"
+  h += "}\n"
+
+  # decimated companion table, consumed by PubMaster: every interval-th
+  # serialized buffer of the base service is re-sent on the companion topic
+  h += "constexpr int NUM_DECIMATED_COMPANIONS = %d;\n" % len(decimated_companions)
+  h += "struct decimated_companion { const char *base; const char *topic; int interval; };\n"
+  h += "static constexpr decimated_companion decimated_companions[NUM_DECIMATED_COMPANIONS] = {\n"
+  for k, n in decimated_companions.items():
+    h += '  { "%s", "%sDecimated", %d },\n' % (k, k, int(n))
+  h += "};\n"
   h += "#endif\n"
   return h
 
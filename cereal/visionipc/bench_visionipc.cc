@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "visionipc/visionipc_client.h"
+#include "visionipc/visionipc_server.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/common/util.h"
+
+// visionipc handoff benchmark, built with `scons benchmarks`. Measures
+// server-send to client-recv wakeup latency and sustained frame throughput
+// over the real server/client stack, for several buffer sizes and client
+// counts. Runs on PC (CL-backed buffers) and on device (ION) alike, so the
+// same numbers can be compared across both. Output is one CSV row per
+// scenario for collection and diffing.
+
+struct ClientStats {
+  uint64_t frames = 0;
+  std::vector<uint64_t> latencies_ns;
+};
+
+static void client_run(int num_frames, ClientStats *stats) {
+  VisionIpcClient client("bench_vipc", VISION_STREAM_YUV_BACK, false);
+  assert(client.connect());
+
+  stats->latencies_ns.reserve(num_frames);
+  while ((int)stats->frames < num_frames) {
+    VisionIpcBufExtra extra = {};
+    VisionBuf *buf = client.recv(&extra);
+    if (buf == nullptr) {
+      // the server stops after num_frames; a recv timeout means the
+      // remainder of this client's share was dropped under backlog
+      break;
+    }
+    stats->frames++;
+    // timestamp_sof carries the send-side clock for this run
+    stats->latencies_ns.push_back(nanos_since_boot() - extra.timestamp_sof);
+  }
+}
+
+static void bench_scenario(size_t width, size_t height, int num_clients, int num_frames) {
+  VisionIpcServer server("bench_vipc");
+  server.create_buffers(VISION_STREAM_YUV_BACK, 4, false, width, height);
+  server.start_listener();
+
+  std::vector<ClientStats> stats(num_clients);
+  std::vector<std::thread> clients;
+  for (int i = 0; i < num_clients; i++) {
+    clients.emplace_back(client_run, num_frames, &stats[i]);
+  }
+  // wait for all handshakes before the clock starts
+  util::sleep_for(200);
+
+  const uint64_t start = nanos_since_boot();
+  for (int i = 0; i < num_frames; i++) {
+    VisionBuf *buf = server.get_buffer(VISION_STREAM_YUV_BACK);
+    // touch the first cacheline so the handoff includes a real write
+    *(uint64_t *)buf->addr = i;
+    VisionIpcBufExtra extra = {(uint32_t)i, nanos_since_boot(), 0};
+    server.send(buf, &extra);
+  }
+  const double elapsed_s = (nanos_since_boot() - start) / 1e9;
+
+  for (auto &t : clients) t.join();
+
+  uint64_t frames = 0;
+  std::vector<uint64_t> all_lat;
+  for (auto &s : stats) {
+    frames += s.frames;
+    all_lat.insert(all_lat.end(), s.latencies_ns.begin(), s.latencies_ns.end());
+  }
+  std::sort(all_lat.begin(), all_lat.end());
+
+  double lat_avg = 0., lat_p99 = 0.;
+  if (!all_lat.empty()) {
+    for (uint64_t l : all_lat) lat_avg += l;
+    lat_avg /= all_lat.size() * 1e3;
+    lat_p99 = all_lat[all_lat.size() * 99 / 100] / 1e3;
+  }
+
+  const size_t buf_bytes = width * height * 3 / 2;
+  printf("%zu,%d,%d,%lu,%.0f,%.1f,%.1f\n",
+         buf_bytes, num_clients, num_frames, frames,
+         num_frames / elapsed_s, lat_avg, lat_p99);
+  fflush(stdout);
+}
+
+int main() {
+  printf("buf_bytes,clients,frames_sent,frames_recvd,send_fps,lat_avg_us,lat_p99_us\n");
+
+  // thumbnail-, road-camera- and full-res-sized YUV buffers
+  const std::pair<size_t, size_t> sizes[] = {{256, 160}, {1164, 874}, {1928, 1208}};
+  for (auto [w, h] : sizes) {
+    bench_scenario(w, h, 1, 2000);
+  }
+
+  // fan-out scaling at the road camera size (modeld + encoders + ui is ~4)
+  for (int clients : {2, 4, 8}) {
+    bench_scenario(1164, 874, clients, 2000);
+  }
+  return 0;
+}
@@ -59,16 +59,21 @@ int ipc_bind(const char* socket_path) {
 
 int ipc_sendrecv_with_fds(bool send, int fd, void *buf, size_t buf_size, int* fds, int num_fds,
                           int *out_num_fds) {
-  char control_buf[CMSG_SPACE(sizeof(int) * num_fds)];
-  memset(control_buf, 0, CMSG_SPACE(sizeof(int) * num_fds));
-
   struct iovec iov = {
     .iov_base = buf,
     .iov_len = buf_size,
   };
+  return ipc_sendrecv_with_fds_iov(send, fd, &iov, 1, fds, num_fds, out_num_fds);
+}
+
+int ipc_sendrecv_with_fds_iov(bool send, int fd, struct iovec *iovs, size_t num_iovs,
+                              int* fds, int num_fds, int *out_num_fds) {
+  char control_buf[CMSG_SPACE(sizeof(int) * num_fds)];
+  memset(control_buf, 0, CMSG_SPACE(sizeof(int) * num_fds));
+
   struct msghdr msg = {
-    .msg_iov = &iov,
-    .msg_iovlen = 1,
+    .msg_iov = iovs,
+    .msg_iovlen = num_iovs,
   };
 
   if (num_fds > 0) {
@@ -1,7 +1,11 @@
 #pragma once
 #include <cstddef>
+#include <sys/uio.h>
 
 int ipc_connect(const char* socket_path);
 int ipc_bind(const char* socket_path);
 int ipc_sendrecv_with_fds(bool send, int fd, void *buf, size_t buf_size, int* fds, int num_fds,
                           int *out_num_fds);
+// Scatter-gather variant: transfers all iovecs plus the fd set in one sendmsg/recvmsg
+int ipc_sendrecv_with_fds_iov(bool send, int fd, struct iovec *iovs, size_t num_iovs,
+                              int* fds, int num_fds, int *out_num_fds);
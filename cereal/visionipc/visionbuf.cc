@@ -40,6 +40,15 @@ void VisionBuf::init_yuv(size_t init_width, size_t init_height){
 }
 
 
+int VisionBuf::wait_sync_event() {
+  if (this->sync_event == nullptr) return 0;
+
+  int err = clWaitForEvents(1, &this->sync_event);
+  clReleaseEvent(this->sync_event);
+  this->sync_event = nullptr;
+  return err;
+}
+
 uint64_t VisionBuf::get_frame_id() {
   return *frame_id;
 }
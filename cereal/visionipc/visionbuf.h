@@ -18,6 +18,7 @@ enum VisionStreamType {
   VISION_STREAM_YUV_BACK,
   VISION_STREAM_YUV_FRONT,
   VISION_STREAM_YUV_WIDE,
+  VISION_STREAM_MODEL,
   VISION_STREAM_MAX,
 };
 
@@ -47,6 +48,10 @@ class VisionBuf {
   // OpenCL
   cl_mem buf_cl = nullptr;
   cl_command_queue copy_q = nullptr;
+  cl_context cl_ctx = nullptr;  // context buf_cl is registered on (pooling key)
+  // GPU fence for in-flight work on this buffer; recorded by sync_async and
+  // waited on only when the buffer is actually sampled
+  cl_event sync_event = nullptr;
 
   // ion
   int handle = 0;
@@ -57,6 +62,15 @@ class VisionBuf {
   void init_rgb(size_t width, size_t height, size_t stride);
   void init_yuv(size_t width, size_t height);
   int sync(int dir);
+  // Enqueue the sync without blocking, recording a fence in sync_event.
+  // Consumers call wait_sync_event() right before sampling the buffer.
+  int sync_async(int dir);
+  int wait_sync_event();
+  // Export a new fd referencing the underlying allocation, for handing to
+  // another API (EGL, CL, OMX) or process. The kernel refcounts the memory
+  // per fd, so an importer can outlive this VisionBuf and its free(). The
+  // caller owns the returned fd and must close it.
+  int export_fd() const;
   int free();
 
   void set_frame_id(uint64_t id);
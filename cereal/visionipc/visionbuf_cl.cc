@@ -76,6 +76,34 @@ int VisionBuf::sync(int dir) {
   return err;
 }
 
+int VisionBuf::sync_async(int dir) {
+  int err = 0;
+  if (!this->buf_cl) return 0;
+
+  // Drop a stale fence that nobody waited on
+  if (this->sync_event != nullptr) {
+    clReleaseEvent(this->sync_event);
+    this->sync_event = nullptr;
+  }
+
+  if (dir == VISIONBUF_SYNC_FROM_DEVICE) {
+    err = clEnqueueReadBuffer(this->copy_q, this->buf_cl, CL_FALSE, 0, this->len, this->addr, 0, NULL, &this->sync_event);
+  } else {
+    err = clEnqueueWriteBuffer(this->copy_q, this->buf_cl, CL_FALSE, 0, this->len, this->addr, 0, NULL, &this->sync_event);
+  }
+  if (err == 0) {
+    err = clFlush(this->copy_q);
+  }
+
+  return err;
+}
+
+int VisionBuf::export_fd() const {
+  // shm-backed here, but same contract as the ion backend: the mapping stays
+  // valid until every exported fd is closed
+  return dup(this->fd);
+}
+
 int VisionBuf::free() {
   int err = 0;
   if (this->buf_cl){
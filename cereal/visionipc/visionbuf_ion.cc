@@ -139,6 +139,18 @@ int VisionBuf::sync(int dir) {
   return HANDLE_EINTR(ioctl(ion_fd, ION_IOC_CUSTOM, &custom_data));
 }
 
+int VisionBuf::sync_async(int dir) {
+  // ION cache maintenance is a synchronous CPU-side operation, there is
+  // nothing to fence
+  return this->sync(dir);
+}
+
+int VisionBuf::export_fd() const {
+  // the ION fd is a dma-buf: every dup holds its own kernel reference to the
+  // allocation, independent of this VisionBuf's fd and handle
+  return HANDLE_EINTR(dup(this->fd));
+}
+
 int VisionBuf::free() {
   int err = 0;
 
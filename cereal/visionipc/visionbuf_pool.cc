@@ -0,0 +1,27 @@
+#include "visionipc/visionbuf_pool.h"
+
+std::mutex VisionBufPool::lock_;
+std::multimap<std::pair<size_t, cl_context>, VisionBuf *> VisionBufPool::free_bufs_;
+
+VisionBuf *VisionBufPool::get(size_t size, cl_device_id device_id, cl_context ctx) {
+  {
+    std::lock_guard lk(lock_);
+    auto it = free_bufs_.find({size, ctx});
+    if (it != free_bufs_.end()) {
+      VisionBuf *buf = it->second;
+      free_bufs_.erase(it);
+      return buf;
+    }
+  }
+
+  VisionBuf *buf = new VisionBuf();
+  buf->allocate(size);
+  if (device_id) buf->init_cl(device_id, ctx);
+  buf->cl_ctx = ctx;
+  return buf;
+}
+
+void VisionBufPool::put(VisionBuf *buf) {
+  std::lock_guard lk(lock_);
+  free_bufs_.insert({{buf->len, buf->cl_ctx}, buf});
+}
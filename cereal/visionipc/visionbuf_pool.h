@@ -0,0 +1,24 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "visionipc/visionbuf.h"
+
+// Process-wide pool of VisionBufs keyed by (length, cl_context). Returned
+// buffers keep their shared-memory/ION allocation and OpenCL registration, so
+// consumers that re-create buffer sets on every stream change (replay, ui)
+// skip the allocate + init_cl cost on reconfiguration.
+class VisionBufPool {
+ public:
+  // Reuse a pooled buffer of exactly this size (registered on ctx when
+  // device_id is set), or allocate a fresh one
+  static VisionBuf *get(size_t size, cl_device_id device_id = nullptr, cl_context ctx = nullptr);
+
+  // Return a buffer to the pool; ownership passes back to the pool
+  static void put(VisionBuf *buf);
+
+ private:
+  static std::mutex lock_;
+  static std::multimap<std::pair<size_t, cl_context>, VisionBuf *> free_bufs_;
+};
@@ -9,6 +9,9 @@ struct VisionIpcBufExtra {
   uint32_t frame_id;
   uint64_t timestamp_sof;
   uint64_t timestamp_eof;
+  // Filled in on the client side: number of frames this client skipped to get
+  // to this one (latest-only mode or frame id gaps)
+  uint32_t frames_skipped;
 };
 
 struct VisionIpcPacket {
@@ -8,9 +8,10 @@
 #include "visionipc/visionipc_server.h"
 #include "logger/logger.h"
 
-VisionIpcClient::VisionIpcClient(std::string name, VisionStreamType type, bool conflate, cl_device_id device_id, cl_context ctx) : name(name), type(type), device_id(device_id), ctx(ctx) {
+VisionIpcClient::VisionIpcClient(std::string name, VisionStreamType type, bool conflate, cl_device_id device_id, cl_context ctx, int priority) : name(name), type(type), latest_only(conflate), device_id(device_id), ctx(ctx) {
   msg_ctx = Context::create();
   sock = SubSocket::create(msg_ctx, get_endpoint_name(name, type), "127.0.0.1", conflate, false);
+  sock->setPriority(priority);
 
   poller = Poller::create();
   poller->registerSocket(sock);
@@ -50,13 +51,19 @@ bool VisionIpcClient::connect(bool blocking){
   int r = ipc_sendrecv_with_fds(true, socket_fd, &type, sizeof(type), nullptr, 0, nullptr);
   assert(r == sizeof(type));
 
-  // Get FDs
+  // Get the whole buffer set (count, metadata, FDs) in one recvmsg
   int fds[VISIONIPC_MAX_FDS];
   VisionBuf bufs[VISIONIPC_MAX_FDS];
-  r = ipc_sendrecv_with_fds(false, socket_fd, &bufs, sizeof(bufs), fds, VISIONIPC_MAX_FDS, &num_buffers);
+  uint64_t num = 0;
+  struct iovec iovs[2] = {
+    {.iov_base = &num, .iov_len = sizeof(num)},
+    {.iov_base = &bufs, .iov_len = sizeof(bufs)},
+  };
+  r = ipc_sendrecv_with_fds_iov(false, socket_fd, iovs, 2, fds, VISIONIPC_MAX_FDS, &num_buffers);
 
   assert(num_buffers > 0);
-  assert(r == sizeof(VisionBuf) * num_buffers);
+  assert((uint64_t)num_buffers == num);
+  assert(r == (int)(sizeof(num) + sizeof(VisionBuf) * num_buffers));
 
   // Import buffers
   for (size_t i = 0; i < num_buffers; i++){
@@ -89,6 +96,16 @@ VisionBuf * VisionIpcClient::recv(VisionIpcBufExtra * extra, const int timeout_m
     return nullptr;
   }
 
+  // In latest-only mode, skip straight to the newest pending frame. The
+  // conflating subscription already avoids a wakeup per intermediate frame;
+  // this drains anything that arrived since the poll.
+  if (latest_only) {
+    while (Message *next = sock->receive(true)) {
+      delete r;
+      r = next;
+    }
+  }
+
   // Get buffer
   assert(r->getSize() == sizeof(VisionIpcPacket));
   VisionIpcPacket *packet = (VisionIpcPacket*)r->getData();
@@ -104,9 +121,16 @@ VisionBuf * VisionIpcClient::recv(VisionIpcBufExtra * extra, const int timeout_m
 
   if (extra) {
     *extra = packet->extra;
+    // Per-client skip accounting from frame id gaps
+    extra->frames_skipped = (seen_frame && packet->extra.frame_id > last_frame_id + 1) ?
+                            packet->extra.frame_id - last_frame_id - 1 : 0;
   }
+  last_frame_id = packet->extra.frame_id;
+  seen_frame = true;
 
-  if (buf->sync(VISIONBUF_SYNC_TO_DEVICE) != 0) {
+  // Enqueue the device sync behind a fence; GPU consumers wait on it right
+  // before they sample the buffer instead of blocking here
+  if (buf->sync_async(VISIONBUF_SYNC_TO_DEVICE) != 0) {
     LOGE("Failed to sync buffer");
   }
 
@@ -116,7 +140,16 @@ VisionBuf * VisionIpcClient::recv(VisionIpcBufExtra * extra, const int timeout_m
 
 
 
+void VisionIpcClient::connect_async(std::function<void(VisionIpcClient *)> cb){
+  if (connect_thread.joinable()) connect_thread.join();
+  connect_thread = std::thread([this, cb] {
+    connect(true);
+    cb(this);
+  });
+}
+
 VisionIpcClient::~VisionIpcClient(){
+  if (connect_thread.joinable()) connect_thread.join();
   for (size_t i = 0; i < num_buffers; i++){
     if (buffers[i].free() != 0) {
       LOGE("Failed to free buffer %zu", i);
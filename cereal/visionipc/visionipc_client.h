@@ -1,6 +1,8 @@
 #pragma once
-#include <vector>
+#include <functional>
 #include <string>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 
 #include "messaging/messaging.h"
@@ -19,15 +21,25 @@ private:
   cl_device_id device_id = nullptr;
   cl_context ctx = nullptr;
 
+  bool latest_only = false;
+  uint32_t last_frame_id = 0;
+  bool seen_frame = false;
+
   void init_msgq(bool conflate);
 
 public:
   bool connected = false;
   int num_buffers = 0;
   VisionBuf buffers[VISIONIPC_MAX_FDS];
-  VisionIpcClient(std::string name, VisionStreamType type, bool conflate, cl_device_id device_id=nullptr, cl_context ctx=nullptr);
+  VisionIpcClient(std::string name, VisionStreamType type, bool conflate, cl_device_id device_id=nullptr, cl_context ctx=nullptr, int priority=SUB_PRIO_DEFAULT);
   ~VisionIpcClient();
   VisionBuf * recv(VisionIpcBufExtra * extra=nullptr, const int timeout_ms=100);
   bool connect(bool blocking=true);
+  // Retry the handshake in a background thread and invoke cb on completion.
+  // The buffers must not be used until the callback fires.
+  void connect_async(std::function<void(VisionIpcClient *)> cb);
   bool is_connected() { return connected; }
+
+private:
+  std::thread connect_thread;
 };
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <chrono>
+
+#include "visionipc/visionipc_framesync.h"
+
+VisionIpcFrameSync::VisionIpcFrameSync(VisionIpcClient *client, int depth) : client(client), depth(depth) {}
+
+VisionBuf * VisionIpcFrameSync::recv(VisionIpcBufExtra *extra, const int timeout_ms) {
+  VisionIpcBufExtra e = {};
+  VisionBuf *buf = client->recv(&e, timeout_ms);
+  if (buf != nullptr) {
+    ring.push_back({buf, e});
+    // the server cycles through its pool, so entries beyond it are invalid
+    size_t max_depth = std::min((size_t)depth, (size_t)std::max(client->num_buffers - 1, 1));
+    while (ring.size() > max_depth) {
+      ring.pop_front();
+    }
+    newest_frame_id = e.frame_id;
+    seen_frame = true;
+    if (extra) *extra = e;
+  }
+  return buf;
+}
+
+VisionBuf * VisionIpcFrameSync::find(uint32_t frame_id, VisionIpcBufExtra *extra) {
+  for (Entry &entry : ring) {
+    if (entry.extra.frame_id == frame_id) {
+      if (extra) *extra = entry.extra;
+      return entry.buf;
+    }
+  }
+  return nullptr;
+}
+
+VisionBuf * VisionIpcFrameSync::get(uint32_t frame_id, VisionIpcBufExtra *extra, const int timeout_ms) {
+  if (VisionBuf *buf = find(frame_id, extra)) {
+    return buf;
+  }
+  // already recycled or conflated away: don't wait for a frame that can never arrive
+  if (seen_frame && frame_id <= newest_frame_id) {
+    return nullptr;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (true) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return nullptr;
+    }
+    int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+    if (recv(nullptr, std::max(remaining, 1)) == nullptr) {
+      return nullptr;
+    }
+    if (newest_frame_id == frame_id) {
+      return find(frame_id, extra);
+    } else if (newest_frame_id > frame_id) {
+      return nullptr;
+    }
+  }
+}
+
+VisionBuf * VisionIpcFrameSync::latest(VisionIpcBufExtra *extra) {
+  if (ring.empty()) {
+    return nullptr;
+  }
+  if (extra) *extra = ring.back().extra;
+  return ring.back().buf;
+}
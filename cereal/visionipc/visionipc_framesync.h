@@ -0,0 +1,42 @@
+#pragma once
+
+#include <deque>
+
+#include "visionipc/visionipc_client.h"
+
+// Frame-exact correlation between visionipc buffers and cereal messages.
+// Keeps a small ring of the most recently received frames keyed by frame_id,
+// so a consumer holding a message (modelV2, cameraOdometry, ...) can fetch
+// the exact buffer it was computed from instead of assuming the latest
+// arrival matches.
+class VisionIpcFrameSync {
+public:
+  // depth is clamped to the server's pool size minus one; anything older
+  // may already have been rewritten by the server
+  VisionIpcFrameSync(VisionIpcClient *client, int depth = 4);
+
+  // recv through the underlying client, recording the frame into the ring.
+  // Returned buffers have the same lifetime as VisionIpcClient::recv.
+  VisionBuf * recv(VisionIpcBufExtra *extra = nullptr, const int timeout_ms = 100);
+
+  // Fetch the buffer for frame_id, receiving frames until it arrives or
+  // timeout_ms expires. Returns nullptr if the frame already left the ring
+  // or the stream skipped past it. timeout_ms == 0 only checks the ring.
+  VisionBuf * get(uint32_t frame_id, VisionIpcBufExtra *extra = nullptr, const int timeout_ms = 100);
+
+  // newest frame seen so far, without receiving
+  VisionBuf * latest(VisionIpcBufExtra *extra = nullptr);
+
+private:
+  struct Entry {
+    VisionBuf *buf = nullptr;
+    VisionIpcBufExtra extra = {};
+  };
+  VisionBuf * find(uint32_t frame_id, VisionIpcBufExtra *extra);
+
+  VisionIpcClient *client;
+  int depth;
+  std::deque<Entry> ring;
+  uint32_t newest_frame_id = 0;
+  bool seen_frame = false;
+};
@@ -22,6 +22,7 @@ cpdef enum VisionStreamType:
   VISION_STREAM_YUV_BACK
   VISION_STREAM_YUV_FRONT
   VISION_STREAM_YUV_WIDE
+  VISION_STREAM_MODEL
 
 
 cdef class VisionIpcServer:
@@ -10,6 +10,7 @@
 #include "messaging/messaging.h"
 #include "visionipc/ipc.h"
 #include "visionipc/visionipc_server.h"
+#include "visionipc/visionbuf_pool.h"
 #include "logger/logger.h"
 
 std::string get_endpoint_name(std::string name, VisionStreamType type){
@@ -45,15 +46,13 @@ void VisionIpcServer::create_buffers(VisionStreamType type, size_t num_buffers,
     size = width * height * 3 / 2;
   }
 
-  // Create map + alloc requested buffers
+  // Create map + alloc requested buffers; allocations and their CL
+  // registrations are recycled through the process-wide pool
   for (size_t i = 0; i < num_buffers; i++){
-    VisionBuf* buf = new VisionBuf();
-    buf->allocate(size);
+    VisionBuf* buf = VisionBufPool::get(size, device_id, ctx);
     buf->idx = i;
     buf->type = type;
 
-    if (device_id) buf->init_cl(device_id, ctx);
-
     rgb ? buf->init_rgb(width, height, stride) : buf->init_yuv(width, height);
 
     buffers[type].push_back(buf);
@@ -122,11 +121,19 @@ void VisionIpcServer::listener(){
       bufs[i].buf_cl = 0;
       bufs[i].copy_q = 0;
       bufs[i].handle = 0;
+      bufs[i].sync_event = 0;
+      bufs[i].cl_ctx = 0;
 
       bufs[i].server_id = server_id;
     }
 
-    r = ipc_sendrecv_with_fds(true, fd, &bufs, sizeof(VisionBuf) * num_fds, fds, num_fds, nullptr);
+    // Whole buffer-set handshake (count, metadata, fds) in one scatter-gather sendmsg
+    uint64_t num = num_fds;
+    struct iovec iovs[2] = {
+      {.iov_base = &num, .iov_len = sizeof(num)},
+      {.iov_base = &bufs, .iov_len = sizeof(VisionBuf) * num_fds},
+    };
+    r = ipc_sendrecv_with_fds_iov(true, fd, iovs, 2, fds, num_fds, nullptr);
 
     close(fd);
   }
@@ -158,21 +165,25 @@ void VisionIpcServer::send(VisionBuf * buf, VisionIpcBufExtra * extra, bool sync
   packet.server_id = server_id;
   packet.idx = buf->idx;
   packet.extra = *extra;
+  packet.extra.frames_skipped = 0;  // filled in per client on the receive side
 
   sockets[buf->type]->send((char*)&packet, sizeof(packet));
 }
 
+// Cumulative frames dropped for backlogged droppable clients on this stream
+uint64_t VisionIpcServer::get_drop_count(VisionStreamType type){
+  assert(sockets.count(type));
+  return sockets[type]->getDropCount();
+}
+
 VisionIpcServer::~VisionIpcServer(){
   should_exit = true;
   listener_thread.join();
 
-  // VisionBuf cleanup
+  // VisionBuf cleanup: back to the pool for the next stream configuration
   for( auto const& [type, buf] : buffers ) {
     for (VisionBuf* b : buf){
-      if (b->free() != 0) {
-        LOGE("Failed to free buffer");
-      }
-      delete b;
+      VisionBufPool::put(b);
     }
   }
 
@@ -38,5 +38,6 @@ class VisionIpcServer {
 
   void create_buffers(VisionStreamType type, size_t num_buffers, bool rgb, size_t width, size_t height);
   void send(VisionBuf * buf, VisionIpcBufExtra * extra, bool sync=true);
+  uint64_t get_drop_count(VisionStreamType type);
   void start_listener();
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utility>
 #include <vector>
 #include <map>
 #include <unordered_map>
@@ -33,6 +34,12 @@ public:
   std::vector<Signal> parse_sigs;
   std::vector<double> vals;
 
+  // generated straight-line extraction for this message; falls back to the
+  // interpreted shift/mask loop when null
+  msg_extract_func extract = nullptr;
+  std::vector<int> sig_indices;  // index of each parse_sig within the message
+  std::vector<int64_t> raw;      // scratch, one slot per message signal
+
   uint16_t ts;
   uint64_t seen;
   uint64_t check_threshold;
@@ -53,7 +60,14 @@ private:
   kj::Array<capnp::word> aligned_buf;
 
   const DBC *dbc = NULL;
-  std::unordered_map<uint32_t, MessageState> message_states;
+  // sorted by address; the per-frame lookup is a binary search over a flat
+  // array instead of chasing unordered_map buckets
+  std::vector<MessageState> message_states;
+
+  MessageState *findState(uint32_t address);
+  #ifndef DYNAMIC_CAPNP
+  void parse_string(const std::string &data, bool sendcan);
+  #endif
 
 public:
   bool can_valid = false;
@@ -65,6 +79,7 @@ public:
   CANParser(int abus, const std::string& dbc_name, bool ignore_checksum, bool ignore_counter);
   #ifndef DYNAMIC_CAPNP
   void update_string(const std::string &data, bool sendcan);
+  void update_strings(const std::vector<std::string> &data, bool sendcan);
   void UpdateCans(uint64_t sec, const capnp::List<cereal::CanData>::Reader& cans);
   #endif
   void UpdateCans(uint64_t sec, const capnp::DynamicStruct::Reader& cans);
@@ -75,11 +90,30 @@ public:
 class CANPacker {
 private:
   const DBC *dbc = NULL;
-  std::map<std::pair<uint32_t, std::string>, Signal> signal_lookup;
+
+  // per-message layout resolved once at init so pack() does no string key
+  // construction or checksum type dispatch per call
+  struct PackState {
+    const Msg *msg = nullptr;
+    std::unordered_map<std::string, const Signal *> sigs;
+    const Signal *counter_sig = nullptr;
+    const Signal *checksum_sig = nullptr;
+    unsigned int (*checksum)(unsigned int address, uint64_t d, int l) = nullptr;
+    bool checksum_wire_order = false;  // CRC runs over the reversed (wire) bytes
+  };
+  std::unordered_map<uint32_t, PackState> pack_states;
   std::map<uint32_t, Msg> message_lookup;
+  // dense id -> resolved signal, filled by lookup_signal_id
+  std::vector<std::pair<uint32_t, const Signal *>> id_sigs;
+
+  uint64_t finalize(const PackState &state, uint32_t address, uint64_t ret, int counter);
 
 public:
   CANPacker(const std::string& dbc_name);
   uint64_t pack(uint32_t address, const std::vector<SignalPackValue> &values, int counter);
+  // resolve a signal once at init; returns a dense id for the id-based pack
+  // overload, or -1 when the message or signal doesn't exist
+  int lookup_signal_id(uint32_t address, const std::string &name);
+  uint64_t pack(uint32_t address, const std::vector<SignalPackValueId> &values, int counter);
   Msg* lookup_message(uint32_t address);
 };
@@ -12,6 +12,13 @@ struct SignalPackValue {
   double value;
 };
 
+// pre-resolved variant: id comes from CANPacker::lookup_signal_id, so the
+// pack path indexes a flat array instead of hashing the signal name
+struct SignalPackValueId {
+  int id;
+  double value;
+};
+
 struct SignalParseOptions {
   uint32_t address;
   const char* name;
@@ -52,12 +59,17 @@ struct Signal {
   SignalType type;
 };
 
+// Generated per-message extraction: writes the raw (sign-extended) value of
+// every signal in sigs[] order. Shifts and masks are baked in at codegen time.
+typedef void (*msg_extract_func)(uint64_t dat_le, uint64_t dat_be, int64_t *out);
+
 struct Msg {
   const char* name;
   uint32_t address;
   unsigned int size;
   size_t num_sigs;
   const Signal *sigs;
+  msg_extract_func extract;
 };
 
 struct Val {
@@ -77,6 +89,9 @@ struct DBC {
 
 std::vector<const DBC*>& get_dbcs();
 const DBC* dbc_lookup(const std::string& dbc_name);
+// address -> Msg via a flat sorted index, built lazily per DBC on first use
+// and cached, so only the fingerprinted car's DBC ever pays for it
+const Msg* dbc_find_msg(const DBC* dbc, uint32_t address);
 
 void dbc_register(const DBC* dbc);
 
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "common_dbc.h"
@@ -20,6 +23,26 @@ void dbc_register(const DBC* dbc) {
   get_dbcs().push_back(dbc);
 }
 
+const Msg* dbc_find_msg(const DBC* dbc, uint32_t address) {
+  using MsgIndex = std::vector<std::pair<uint32_t, const Msg*>>;
+  static std::mutex lock;
+  static std::unordered_map<const DBC*, MsgIndex> indices;
+
+  std::lock_guard lk(lock);
+  MsgIndex &index = indices[dbc];
+  if (index.empty() && dbc->num_msgs > 0) {
+    index.reserve(dbc->num_msgs);
+    for (size_t i = 0; i < dbc->num_msgs; i++) {
+      index.push_back({dbc->msgs[i].address, &dbc->msgs[i]});
+    }
+    std::sort(index.begin(), index.end());
+  }
+
+  auto it = std::lower_bound(index.begin(), index.end(), address,
+                             [](const auto &p, uint32_t a) { return p.first < a; });
+  return (it != index.end() && it->first == address) ? it->second : nullptr;
+}
+
 extern "C" {
   const DBC* dbc_lookup(const char* dbc_name) {
     return dbc_lookup(std::string(dbc_name));
@@ -45,6 +45,25 @@ const Signal sigs_{{address}}[] = {
 };
 {% endfor %}
 
+{% for address, msg_name, msg_size, sigs in msgs %}
+void extract_{{address}}(uint64_t dat_le, uint64_t dat_be, int64_t *out) {
+  {% for sig in sigs %}
+  {% if sig.is_little_endian %}
+    {% set word = "dat_le" %}
+    {% set shift = sig.start_bit %}
+  {% else %}
+    {% set word = "dat_be" %}
+    {% set b1 = (sig.start_bit//8)*8  + (-sig.start_bit-1) % 8 %}
+    {% set shift = 64 - (b1 + sig.size) %}
+  {% endif %}
+  out[{{loop.index0}}] = (int64_t)(({{word}} >> {{shift}}) & {{"0x%XULL" % (2**sig.size - 1)}});
+  {% if sig.is_signed and sig.size < 64 %}
+  out[{{loop.index0}}] -= (out[{{loop.index0}}] >> {{sig.size - 1}}) ? {{"0x%XLL" % (2**sig.size)}} : 0;
+  {% endif %}
+  {% endfor %}
+}
+{% endfor %}
+
 const Msg msgs[] = {
 {% for address, msg_name, msg_size, sigs in msgs %}
   {% set address_hex = "0x%X" % address %}
@@ -54,6 +73,7 @@ const Msg msgs[] = {
     .size = {{msg_size}},
     .num_sigs = ARRAYSIZE(sigs_{{address}}),
     .sigs = sigs_{{address}},
+    .extract = extract_{{address}},
   },
 {% endfor %}
 };
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cstring>
 #include <utility>
 #include <algorithm>
 #include <map>
@@ -40,27 +41,65 @@ CANPacker::CANPacker(const std::string& dbc_name) {
   for (int i=0; i<dbc->num_msgs; i++) {
     const Msg* msg = &dbc->msgs[i];
     message_lookup[msg->address] = *msg;
+
+    PackState &state = pack_states[msg->address];
+    state.msg = msg;
     for (int j=0; j<msg->num_sigs; j++) {
       const Signal* sig = &msg->sigs[j];
-      signal_lookup[std::make_pair(msg->address, std::string(sig->name))] = *sig;
+      state.sigs[sig->name] = sig;
+
+      if (strcmp(sig->name, "COUNTER") == 0) {
+        state.counter_sig = sig;
+      } else if (strcmp(sig->name, "CHECKSUM") == 0) {
+        state.checksum_sig = sig;
+        switch (sig->type) {
+          case SignalType::HONDA_CHECKSUM:
+            state.checksum = honda_checksum;
+            break;
+          case SignalType::TOYOTA_CHECKSUM:
+            state.checksum = toyota_checksum;
+            break;
+          case SignalType::VOLKSWAGEN_CHECKSUM:
+            // FIXME: Hackish fix for an endianness issue. The message is in reverse byte order
+            // until later in the pack process. Checksums can be run backwards, CRCs not so much.
+            // The correct fix is unclear but this works for the moment.
+            state.checksum = volkswagen_crc;
+            state.checksum_wire_order = true;
+            break;
+          case SignalType::SUBARU_CHECKSUM:
+            state.checksum = subaru_checksum;
+            break;
+          case SignalType::CHRYSLER_CHECKSUM:
+            state.checksum = chrysler_checksum;
+            state.checksum_wire_order = true;
+            break;
+          default:
+            break;
+        }
+      }
     }
   }
   init_crc_lookup_tables();
 }
 
 uint64_t CANPacker::pack(uint32_t address, const std::vector<SignalPackValue> &signals, int counter) {
+  auto state_it = pack_states.find(address);
+  if (state_it == pack_states.end()) {
+    WARN("undefined message %d\n", address);
+    return 0;
+  }
+  const PackState &state = state_it->second;
+
   uint64_t ret = 0;
   for (const auto& sigval : signals) {
-    double value = sigval.value;
-
-    auto sig_it = signal_lookup.find(std::make_pair(address, sigval.name));
-    if (sig_it == signal_lookup.end()) {
+    auto sig_it = state.sigs.find(sigval.name);
+    if (sig_it == state.sigs.end()) {
       WARN("undefined signal %s - %d\n", sigval.name.c_str(), address);
       continue;
     }
-    const auto& sig = sig_it->second;
+    const Signal &sig = *sig_it->second;
 
-    int64_t ival = (int64_t)(round((value - sig.offset) / sig.factor));
+    int64_t ival = (int64_t)(round((sigval.value - sig.offset) / sig.factor));
     if (ival < 0) {
       ival = (1ULL << sig.b2) + ival;
     }
@@ -68,45 +107,68 @@ uint64_t CANPacker::pack(uint32_t address, const std::vector<SignalPackValue> &s
     ret = set_value(ret, sig, ival);
   }
 
+  return finalize(state, address, ret, counter);
+}
+
+int CANPacker::lookup_signal_id(uint32_t address, const std::string &name) {
+  auto state_it = pack_states.find(address);
+  if (state_it == pack_states.end()) {
+    WARN("undefined message %d\n", address);
+    return -1;
+  }
+  auto sig_it = state_it->second.sigs.find(name);
+  if (sig_it == state_it->second.sigs.end()) {
+    WARN("undefined signal %s - %d\n", name.c_str(), address);
+    return -1;
+  }
+  id_sigs.push_back({address, sig_it->second});
+  return id_sigs.size() - 1;
+}
+
+uint64_t CANPacker::pack(uint32_t address, const std::vector<SignalPackValueId> &signals, int counter) {
+  auto state_it = pack_states.find(address);
+  if (state_it == pack_states.end()) {
+    WARN("undefined message %d\n", address);
+    return 0;
+  }
+  const PackState &state = state_it->second;
+
+  uint64_t ret = 0;
+  for (const auto& sigval : signals) {
+    assert(sigval.id >= 0 && (size_t)sigval.id < id_sigs.size());
+    assert(id_sigs[sigval.id].first == address);
+    const Signal &sig = *id_sigs[sigval.id].second;
+
+    int64_t ival = (int64_t)(round((sigval.value - sig.offset) / sig.factor));
+    if (ival < 0) {
+      ival = (1ULL << sig.b2) + ival;
+    }
+
+    ret = set_value(ret, sig, ival);
+  }
+
+  return finalize(state, address, ret, counter);
+}
+
+// counter and checksum, common to both pack paths
+uint64_t CANPacker::finalize(const PackState &state, uint32_t address, uint64_t ret, int counter) {
   if (counter >= 0){
-    auto sig_it = signal_lookup.find(std::make_pair(address, "COUNTER"));
-    if (sig_it == signal_lookup.end()) {
+    if (state.counter_sig == nullptr) {
       WARN("COUNTER not defined\n");
       return ret;
     }
-    const auto& sig = sig_it->second;
 
-    if ((sig.type != SignalType::HONDA_COUNTER) && (sig.type != SignalType::VOLKSWAGEN_COUNTER)) {
+    if ((state.counter_sig->type != SignalType::HONDA_COUNTER) && (state.counter_sig->type != SignalType::VOLKSWAGEN_COUNTER)) {
       WARN("COUNTER signal type not valid\n");
     }
 
-    ret = set_value(ret, sig, counter);
+    ret = set_value(ret, *state.counter_sig, counter);
   }
 
-  auto sig_it_checksum = signal_lookup.find(std::make_pair(address, "CHECKSUM"));
-  if (sig_it_checksum != signal_lookup.end()) {
-    const auto& sig = sig_it_checksum->second;
-    if (sig.type == SignalType::HONDA_CHECKSUM) {
-      unsigned int chksm = honda_checksum(address, ret, message_lookup[address].size);
-      ret = set_value(ret, sig, chksm);
-    } else if (sig.type == SignalType::TOYOTA_CHECKSUM) {
-      unsigned int chksm = toyota_checksum(address, ret, message_lookup[address].size);
-      ret = set_value(ret, sig, chksm);
-    } else if (sig.type == SignalType::VOLKSWAGEN_CHECKSUM) {
-      // FIXME: Hackish fix for an endianness issue. The message is in reverse byte order
-      // until later in the pack process. Checksums can be run backwards, CRCs not so much.
-      // The correct fix is unclear but this works for the moment.
-      unsigned int chksm = volkswagen_crc(address, ReverseBytes(ret), message_lookup[address].size);
-      ret = set_value(ret, sig, chksm);
-    } else if (sig.type == SignalType::SUBARU_CHECKSUM) {
-      unsigned int chksm = subaru_checksum(address, ret, message_lookup[address].size);
-      ret = set_value(ret, sig, chksm);
-    } else if (sig.type == SignalType::CHRYSLER_CHECKSUM) {
-      unsigned int chksm = chrysler_checksum(address, ReverseBytes(ret), message_lookup[address].size);
-      ret = set_value(ret, sig, chksm);
-    } else {
-      //WARN("CHECKSUM signal type not valid\n");
-    }
+  if (state.checksum != nullptr) {
+    uint64_t d = state.checksum_wire_order ? ReverseBytes(ret) : ret;
+    unsigned int chksm = state.checksum(address, d, state.msg->size);
+    ret = set_value(ret, *state.checksum_sig, chksm);
   }
 
   return ret;
@@ -17,17 +17,23 @@ bool MessageState::parse(uint64_t sec, uint16_t ts_, uint8_t * dat) {
   uint64_t dat_le = read_u64_le(dat);
   uint64_t dat_be = read_u64_be(dat);
 
+  if (extract != nullptr) {
+    extract(dat_le, dat_be, raw.data());
+  }
+
   for (int i=0; i < parse_sigs.size(); i++) {
     auto& sig = parse_sigs[i];
     int64_t tmp;
 
-    if (sig.is_little_endian){
+    if (extract != nullptr) {
+      tmp = raw[sig_indices[i]];
+    } else if (sig.is_little_endian){
       tmp = (dat_le >> sig.b1) & ((1ULL << sig.b2)-1);
     } else {
       tmp = (dat_be >> sig.bo) & ((1ULL << sig.b2)-1);
     }
 
-    if (sig.is_signed) {
+    if (extract == nullptr && sig.is_signed) {
       tmp -= (tmp >> (sig.b2-1)) ? (1ULL << sig.b2) : 0; //signed
     }
 
@@ -119,7 +125,8 @@ CANParser::CANParser(int abus, const std::string& dbc_name,
   init_crc_lookup_tables();
 
   for (const auto& op : options) {
-    MessageState &state = message_states[op.address];
+    message_states.emplace_back();
+    MessageState &state = message_states.back();
     state.address = op.address;
     // state.check_frequency = op.check_frequency,
 
@@ -128,25 +135,22 @@ CANParser::CANParser(int abus, const std::string& dbc_name,
       state.check_threshold = (1000000000ULL / op.check_frequency) * 10;
     }
 
-    const Msg* msg = NULL;
-    for (int i = 0; i < dbc->num_msgs; i++) {
-      if (dbc->msgs[i].address == op.address) {
-        msg = &dbc->msgs[i];
-        break;
-      }
-    }
+    const Msg* msg = dbc_find_msg(dbc, op.address);
     if (!msg) {
       fprintf(stderr, "CANParser: could not find message 0x%X in DBC %s\n", op.address, dbc_name.c_str());
       assert(false);
     }
 
     state.size = msg->size;
+    state.extract = msg->extract;
+    state.raw.resize(msg->num_sigs);
 
     // track checksums and counters for this message
     for (int i = 0; i < msg->num_sigs; i++) {
       const Signal *sig = &msg->sigs[i];
       if (sig->type != SignalType::DEFAULT) {
         state.parse_sigs.push_back(*sig);
+        state.sig_indices.push_back(i);
         state.vals.push_back(0);
       }
     }
@@ -160,12 +164,16 @@ CANParser::CANParser(int abus, const std::string& dbc_name,
         if (strcmp(sig->name, sigop.name) == 0
             && sig->type == SignalType::DEFAULT) {
           state.parse_sigs.push_back(*sig);
+          state.sig_indices.push_back(i);
           state.vals.push_back(sigop.default_value);
           break;
         }
       }
     }
   }
+
+  std::sort(message_states.begin(), message_states.end(),
+            [](const MessageState &a, const MessageState &b) { return a.address < b.address; });
 }
 
 CANParser::CANParser(int abus, const std::string& dbc_name, bool ignore_checksum, bool ignore_counter)
@@ -176,6 +184,7 @@ CANParser::CANParser(int abus, const std::string& dbc_name, bool ignore_checksum
   assert(dbc);
   init_crc_lookup_tables();
 
+  message_states.reserve(dbc->num_msgs);
   for (int i = 0; i < dbc->num_msgs; i++) {
     const Msg* msg = &dbc->msgs[i];
     MessageState state = {
@@ -184,19 +193,31 @@ CANParser::CANParser(int abus, const std::string& dbc_name, bool ignore_checksum
       .ignore_checksum = ignore_checksum,
       .ignore_counter = ignore_counter,
     };
+    state.extract = msg->extract;
+    state.raw.resize(msg->num_sigs);
 
     for (int j = 0; j < msg->num_sigs; j++) {
       const Signal *sig = &msg->sigs[j];
       state.parse_sigs.push_back(*sig);
+      state.sig_indices.push_back(j);
       state.vals.push_back(0);
     }
 
-    message_states[state.address] = state;
+    message_states.push_back(state);
   }
+
+  std::sort(message_states.begin(), message_states.end(),
+            [](const MessageState &a, const MessageState &b) { return a.address < b.address; });
+}
+
+MessageState *CANParser::findState(uint32_t address) {
+  auto it = std::lower_bound(message_states.begin(), message_states.end(), address,
+                             [](const MessageState &s, uint32_t a) { return s.address < a; });
+  return (it != message_states.end() && it->address == address) ? &*it : nullptr;
 }
 
 #ifndef DYNAMIC_CAPNP
-void CANParser::update_string(const std::string &data, bool sendcan) {
+void CANParser::parse_string(const std::string &data, bool sendcan) {
   // format for board, make copy due to alignment issues.
   const size_t buf_size = (data.length() / sizeof(capnp::word)) + 1;
   if (aligned_buf.size() < buf_size) {
@@ -212,7 +233,19 @@ void CANParser::update_string(const std::string &data, bool sendcan) {
 
   auto cans = sendcan? event.getSendcan() : event.getCan();
   UpdateCans(last_sec, cans);
+}
 
+void CANParser::update_string(const std::string &data, bool sendcan) {
+  parse_string(data, sendcan);
+  UpdateValid(last_sec);
+}
+
+void CANParser::update_strings(const std::vector<std::string> &data, bool sendcan) {
+  // parse everything drained from the socket in one pass; the validity sweep
+  // over message_states only needs to run once against the newest timestamp
+  for (const auto &d : data) {
+    parse_string(d, sendcan);
+  }
   UpdateValid(last_sec);
 }
 
@@ -228,8 +261,8 @@ void CANParser::UpdateCans(uint64_t sec, const capnp::List<cereal::CanData>::Rea
       // DEBUG("skip %d: wrong bus\n", cmsg.getAddress());
       continue;
     }
-    auto state_it = message_states.find(cmsg.getAddress());
-    if (state_it == message_states.end()) {
+    MessageState *state = findState(cmsg.getAddress());
+    if (state == nullptr) {
       // DEBUG("skip %d: not specified\n", cmsg.getAddress());
       continue;
     }
@@ -238,7 +271,7 @@ void CANParser::UpdateCans(uint64_t sec, const capnp::List<cereal::CanData>::Rea
     uint8_t dat[8] = {0};
     memcpy(dat, cmsg.getDat().begin(), cmsg.getDat().size());
 
-    state_it->second.parse(sec, cmsg.getBusTime(), dat);
+    state->parse(sec, cmsg.getBusTime(), dat);
   }
 }
 #endif
@@ -252,8 +285,8 @@ void CANParser::UpdateCans(uint64_t sec, const capnp::DynamicStruct::Reader& cms
     return;
   }
 
-  auto state_it = message_states.find(cmsg.get("address").as<uint32_t>());
-  if (state_it == message_states.end()) {
+  MessageState *state = findState(cmsg.get("address").as<uint32_t>());
+  if (state == nullptr) {
     DEBUG("skip %d: not specified\n", cmsg.get("address").as<uint32_t>());
     return;
   }
@@ -262,13 +295,12 @@ void CANParser::UpdateCans(uint64_t sec, const capnp::DynamicStruct::Reader& cms
   if (dat.size() > 8) return; //shouldn't ever happen
   uint8_t data[8] = {0};
   memcpy(data, dat.begin(), dat.size());
-  state_it->second.parse(sec, cmsg.get("busTime").as<uint16_t>(), data);
+  state->parse(sec, cmsg.get("busTime").as<uint16_t>(), data);
 }
 
 void CANParser::UpdateValid(uint64_t sec) {
   can_valid = true;
-  for (const auto& kv : message_states) {
-    const auto& state = kv.second;
+  for (const auto& state : message_states) {
     if (state.check_threshold > 0 && (sec - state.seen) > state.check_threshold) {
       if (state.seen > 0) {
         DEBUG("0x%X TIMEOUT\n", state.address);
@@ -283,8 +315,7 @@ void CANParser::UpdateValid(uint64_t sec) {
 std::vector<SignalValue> CANParser::query_latest() {
   std::vector<SignalValue> ret;
 
-  for (const auto& kv : message_states) {
-    const auto& state = kv.second;
+  for (const auto& state : message_states) {
     if (last_sec != 0 && state.seen != last_sec) continue;
 
     for (int i=0; i<state.parse_sigs.size(); i++) {
@@ -186,14 +186,61 @@ int get_rtc_pkt(void *dat) {
   return sizeof(t);
 }
 
+// CAN-over-USB wire format, negotiated by the host with request 0xd5.
+// v1: fixed 16 byte records (raw mailbox layout). v2: compact records,
+// 4 byte header (dlc|ext flag, bus, 16 bit timestamp) + 2 or 4 address
+// bytes + dlc data bytes. records never span a USB packet.
+#define CAN_PACKET_VERSION_MAX 2U
+uint8_t can_packet_version = 1U;
+
 int usb_cb_ep1_in(void *usbdata, int len, bool hardwired) {
   UNUSED(hardwired);
-  CAN_FIFOMailBox_TypeDef *reply = (CAN_FIFOMailBox_TypeDef *)usbdata;
-  int ilen = 0;
-  while (ilen < MIN(len/0x10, 4) && can_pop(&can_rx_q, &reply[ilen])) {
-    ilen++;
+  int rlen = 0;
+  if (can_packet_version == 2U) {
+    // a popped record that didn't fit is held over for the next packet
+    static CAN_FIFOMailBox_TypeDef pending;
+    static bool pending_valid = false;
+    uint8_t *reply = (uint8_t *)usbdata;
+    while (true) {
+      if (!pending_valid && !can_pop(&can_rx_q, &pending)) {
+        break;
+      }
+      pending_valid = true;
+
+      uint8_t dlc = pending.RDTR & 0xFU;
+      bool ext = (pending.RIR & 4U) != 0U;
+      int rec_len = 4 + (ext ? 4 : 2) + (int)dlc;
+      if ((rlen + rec_len) > len) {
+        break;
+      }
+
+      reply[rlen] = dlc | (ext ? 0x10U : 0U);
+      reply[rlen + 1] = (pending.RDTR >> 4) & 0xFFU;
+      reply[rlen + 2] = (pending.RDTR >> 16) & 0xFFU;
+      reply[rlen + 3] = (pending.RDTR >> 24) & 0xFFU;
+      uint32_t addr = ext ? (pending.RIR >> 3) : (pending.RIR >> 21);
+      reply[rlen + 4] = addr & 0xFFU;
+      reply[rlen + 5] = (addr >> 8) & 0xFFU;
+      int data_off = rlen + 6;
+      if (ext) {
+        reply[rlen + 6] = (addr >> 16) & 0xFFU;
+        reply[rlen + 7] = (addr >> 24) & 0xFFU;
+        data_off = rlen + 8;
+      }
+      (void)memcpy(&reply[data_off], (uint8_t *)&pending.RDLR, dlc);
+
+      rlen += rec_len;
+      pending_valid = false;
+    }
+  } else {
+    CAN_FIFOMailBox_TypeDef *reply = (CAN_FIFOMailBox_TypeDef *)usbdata;
+    int ilen = 0;
+    while (ilen < MIN(len/0x10, 4) && can_pop(&can_rx_q, &reply[ilen])) {
+      ilen++;
+    }
+    rlen = ilen*0x10;
   }
-  return ilen*0x10;
+  return rlen;
 }
 
 // send on serial, first byte to select the ring
@@ -380,6 +427,16 @@ int usb_cb_control_msg(USB_Setup_TypeDef *setup, uint8_t *resp, bool hardwired)
         (void)memcpy(resp, &code[code_len + 64], resp_len);
       }
       break;
+    // **** 0xd5: get/set CAN packet version. wValue 0 reads the max
+    // supported version, nonzero selects one (clamped)
+    case 0xd5:
+      if (setup->b.wValue.w == 0U) {
+        resp[0] = CAN_PACKET_VERSION_MAX;
+        resp_len = 1;
+      } else {
+        can_packet_version = MIN(setup->b.wValue.w, CAN_PACKET_VERSION_MAX);
+      }
+      break;
     // **** 0xd6: get version
     case 0xd6:
       COMPILE_TIME_ASSERT(sizeof(gitversion) <= MAX_RESP_LEN);
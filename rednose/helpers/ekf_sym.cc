@@ -48,6 +48,8 @@ void EKFSym::init_state(Map<VectorXd> state, Map<MatrixXdr> covs, double init_fi
   this->P = covs;
   this->filter_time = init_filter_time;
   this->augment_times = VectorXd::Zero(this->N);
+  this->cov_skip_cnt = 0;
+  this->cov_dt = 0.0;
   this->reset_rewind();
 }
 
@@ -134,8 +136,11 @@ std::deque<Observation> EKFSym::rewind(double t) {
     this->rewind_obscache.pop_back();
   }
 
-  // set the state to the time right before that
+  // set the state to the time right before that; the restored covariance
+  // matches that time exactly, so drop any deferred covariance interval
   this->filter_time = this->rewind_t.back();
+  this->cov_skip_cnt = 0;
+  this->cov_dt = 0.0;
   this->x = this->rewind_states.back().first;
   this->P = this->rewind_states.back().second;
 
@@ -194,6 +199,13 @@ Estimate EKFSym::predict_and_update_batch(Observation& obs, bool augment) {
   return res;
 }
 
+void EKFSym::set_covariance_decimation(int n) {
+  assert(n >= 1);
+  this->cov_decimation = n;
+  this->cov_skip_cnt = 0;
+  this->cov_dt = 0.0;
+}
+
 void EKFSym::predict(double t) {
   // initialize time
   if (std::isnan(this->filter_time)) {
@@ -204,7 +216,36 @@ void EKFSym::predict(double t) {
   double dt = t - this->filter_time;
   assert(dt >= 0.0);
 
-  this->ekf->predict(this->x.data(), this->P.data(), this->Q.data(), dt);
+  if (this->cov_decimation > 1 && ++this->cov_skip_cnt < this->cov_decimation) {
+    // split-rate mode: the covariance evolves slowly next to the sensor-rate
+    // state, so only the state propagates here. the deferred interval is
+    // accumulated and applied in one covariance step below, which integrates
+    // the same total process noise.
+    this->ekf->predict_state(this->x.data(), dt);
+    this->cov_dt += dt;
+  } else if (this->cov_dt > 0.0) {
+    // covariance over the whole accumulated interval, same block structure
+    // as the generated joint predict
+    double dt_total = this->cov_dt + dt;
+    int me = this->dim_main_err;
+    int rest = this->dim_err - me;
+    MatrixXdr F(this->dim_err, this->dim_err);
+    this->ekf->F_fun(this->x.data(), dt_total, F.data());
+    MatrixXdr F_main = F.topLeftCorner(me, me);
+    this->P.topLeftCorner(me, me) = (F_main * this->P.topLeftCorner(me, me)) * F_main.transpose();
+    if (rest > 0) {
+      this->P.topRightCorner(me, rest) = F_main * this->P.topRightCorner(me, rest);
+      this->P.bottomLeftCorner(rest, me) = this->P.bottomLeftCorner(rest, me) * F_main.transpose();
+    }
+    this->P += dt_total * this->Q;
+
+    this->ekf->predict_state(this->x.data(), dt);
+    this->cov_skip_cnt = 0;
+    this->cov_dt = 0.0;
+  } else {
+    this->ekf->predict(this->x.data(), this->P.data(), this->Q.data(), dt);
+    this->cov_skip_cnt = 0;
+  }
   this->normalize_quaternions();
   this->filter_time = t;
 }
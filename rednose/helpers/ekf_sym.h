@@ -59,6 +59,10 @@ public:
   void reset_rewind();
 
   void predict(double t);
+  // split-rate mode: state propagates on every predict, the covariance (and
+  // its process noise) is carried over the accumulated interval on every
+  // n-th one. n = 1 (the default) keeps the classic joint predict.
+  void set_covariance_decimation(int n);
   std::optional<Estimate> predict_and_update_batch(double t, int kind, std::vector<Eigen::Map<Eigen::VectorXd>> z,
       std::vector<Eigen::Map<MatrixXdr>> R, std::vector<std::vector<double>> extra_args = {{}}, bool augment = false);
 
@@ -90,6 +94,11 @@ private:
 
   double filter_time;
 
+  // split-rate covariance propagation state
+  int cov_decimation = 1;
+  int cov_skip_cnt = 0;
+  double cov_dt = 0.0;
+
   std::vector<int> maha_test_kinds;
   std::vector<int> quaternion_idxs;
 
@@ -163,6 +163,10 @@ def gen_code(folder, name, f_sym, dt_sym, x_sym, obs_eqs, dim_x, dim_err, eskf_p
   post_code += f"void {name}_predict(double *in_x, double *in_P, double *in_Q, double dt) {{\n"
   post_code += "  predict(in_x, in_P, in_Q, dt);\n"
   post_code += "}\n"
+  header += f"void {name}_predict_state(double *in_x, double dt);\n"
+  post_code += f"void {name}_predict_state(double *in_x, double dt) {{\n"
+  post_code += "  predict_state(in_x, dt);\n"
+  post_code += "}\n"
   if global_vars is not None:
     for var in global_vars:
       header += f"void {name}_set_{var.name}(double x);\n"
@@ -172,7 +176,7 @@ def gen_code(folder, name, f_sym, dt_sym, x_sym, obs_eqs, dim_x, dim_err, eskf_p
 
   post_code += "}\n\n" # extern c
 
-  funcs = ['f_fun', 'F_fun', 'err_fun', 'inv_err_fun', 'H_mod_fun', 'predict']
+  funcs = ['f_fun', 'F_fun', 'err_fun', 'inv_err_fun', 'H_mod_fun', 'predict', 'predict_state']
   func_lists = {
     'h': [kind for _, kind, _, _, _ in obs_eqs],
     'H': [kind for _, kind, _, _, _ in obs_eqs],
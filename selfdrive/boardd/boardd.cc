@@ -9,20 +9,28 @@
 #include <bitset>
 #include <cassert>
 #include <cerrno>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <libusb-1.0/libusb.h>
 
+#include "json11.hpp"
+
 #include "cereal/gen/cpp/car.capnp.h"
 #include "cereal/messaging/messaging.h"
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
+#include "selfdrive/common/watchdog.h"
 #include "selfdrive/hardware/hw.h"
 #include "selfdrive/locationd/ublox_msg.h"
 
@@ -38,6 +46,13 @@
 Panda * panda = nullptr;
 std::atomic<bool> safety_setter_thread_running(false);
 std::atomic<bool> ignition(false);
+// last applied safety configuration, written by the safety setter and
+// restored right after a usb reconnect so a harness brownout doesn't wait
+// out the full CarParams handshake before CAN streaming resumes
+cereal::CarParams::SafetyModel cached_safety_model;
+int cached_safety_param = 0;
+std::atomic<bool> have_cached_safety(false);
+std::atomic<uint32_t> sendcan_deadline_misses(0);
 
 volatile sig_atomic_t do_exit = 0;
 
@@ -102,6 +117,10 @@ void safety_setter_thread() {
 
   panda->set_safety_model(safety_model, safety_param);
 
+  cached_safety_model = safety_model;
+  cached_safety_param = safety_param;
+  have_cached_safety = true;
+
   safety_setter_thread_running = false;
 }
 
@@ -123,6 +142,19 @@ bool usb_connect() {
     tmp_panda->set_loopback(true);
   }
 
+  // fast reconnect: the descriptor reads and params writes below only need
+  // to happen once per boot. on a brownout the device is the same panda, so
+  // reopen with the minimal control transfers the ctor already did, restore
+  // the cached safety configuration and let CAN streaming resume; rtc sync
+  // and health polling catch up on the regular 2Hz state loop.
+  if (connected_once) {
+    panda = tmp_panda.release();
+    if (have_cached_safety) {
+      panda->set_safety_model(cached_safety_model, cached_safety_param);
+    }
+    return true;
+  }
+
   if (auto fw_sig = tmp_panda->get_firmware_version(); fw_sig) {
     params.put("PandaFirmware", (const char *)fw_sig->data(), fw_sig->size());
 
@@ -183,16 +215,33 @@ void usb_retry_connect() {
   LOGW("connected to board");
 }
 
-void can_recv(PubMaster &pm) {
-  kj::Array<capnp::word> can_data;
-  panda->can_receive(can_data);
-  auto bytes = can_data.asBytes();
-  pm.send("can", bytes.begin(), bytes.size());
-}
+// Lock-free SPSC ring of raw USB chunks between the bulk reader and the
+// publisher. The reader only advances can_ring_write, the publisher only
+// can_ring_read, so a slow msgq publish never delays the next bulk transfer.
+#define CAN_RING_SIZE 64
+struct CanChunk {
+  int len;
+  uint8_t data[RECV_SIZE];
+};
+CanChunk can_ring[CAN_RING_SIZE];
+std::atomic<uint64_t> can_ring_write(0);
+std::atomic<uint64_t> can_ring_read(0);
+
+// actuation timestamps handed from can_send_thread to latency_tracker_thread:
+// (USB submit mono time, sendcan logMonoTime). Bounded so a stalled tracker
+// can't grow it; the lock is only ever held for a push or a swap.
+std::mutex actuation_lock;
+std::vector<std::pair<uint64_t, uint64_t>> actuation_samples;
 
 void can_send_thread() {
   LOGD("start send thread");
 
+  // sendcan is the latency-critical direction: controls has already spent
+  // most of the frame budget by the time the message is published, so this
+  // thread outranks the rest of boardd
+  int err = set_realtime_priority(55);
+  LOG("sendcan thread set priority returns %d", err);
+
   AlignedBuffer aligned_buf;
   Context * context = Context::create();
   SubSocket * subscriber = SubSocket::create(context, "sendcan");
@@ -217,6 +266,18 @@ void can_send_thread() {
     if (nanos_since_boot() - event.getLogMonoTime() < 1e9) {
       if (!fake_send) {
         panda->can_send(event.getSendcan());
+        uint64_t submit_time = nanos_since_boot();
+        // controls runs at 100Hz: a frame that takes more than 10ms from
+        // publish to USB submit lands its actuation a frame late
+        if (submit_time - event.getLogMonoTime() > 10000000ULL) {
+          sendcan_deadline_misses++;
+        }
+        {
+          std::lock_guard lk(actuation_lock);
+          if (actuation_samples.size() < 256) {
+            actuation_samples.emplace_back(submit_time, event.getLogMonoTime());
+          }
+        }
       }
     }
 
@@ -230,15 +291,24 @@ void can_send_thread() {
 void can_recv_thread() {
   LOGD("start recv thread");
 
-  // can = 8006
-  PubMaster pm({"can"});
-
   // run at 100hz
   const uint64_t dt = 10000000ULL;
   uint64_t next_frame_time = nanos_since_boot() + dt;
 
   while (!do_exit && panda->connected) {
-    can_recv(pm);
+    uint64_t wr = can_ring_write.load(std::memory_order_relaxed);
+    uint64_t rd = can_ring_read.load(std::memory_order_acquire);
+    if (wr - rd < CAN_RING_SIZE) {
+      CanChunk &chunk = can_ring[wr % CAN_RING_SIZE];
+      chunk.len = panda->can_receive_raw(chunk.data, RECV_SIZE);
+      can_ring_write.store(wr + 1, std::memory_order_release);
+    } else {
+      // publisher stalled; drain the panda FIFO anyway and drop the chunk
+      // rather than backpressuring the bulk reads
+      uint8_t scratch[RECV_SIZE];
+      panda->can_receive_raw(scratch, RECV_SIZE);
+      LOGW("can ring full, dropping chunk");
+    }
 
     uint64_t cur_time = nanos_since_boot();
     int64_t remaining = next_frame_time - cur_time;
@@ -255,12 +325,302 @@ void can_recv_thread() {
   }
 }
 
+// Verifies the fingerprint cached on the last drive (car_helpers.py) against
+// the first CAN frames of this one. The cached (bus, address) -> length map is
+// compiled into a flat sorted table at startup; once CONFIRM_FRAMES frames
+// match it, the confirmation param lets the fingerprint loop in controlsd
+// return immediately instead of sitting out the full discovery window. Any
+// mismatch, including an address the cache never saw, falls back silently to
+// normal discovery.
+class FingerprintMatcher {
+public:
+  FingerprintMatcher() {
+    std::string cached = Params().get("CachedFingerprint");
+    if (cached.empty()) { done_ = true; return; }
+    std::string err;
+    json11::Json json = json11::Json::parse(cached, err);
+    if (!err.empty()) { done_ = true; return; }
+    car_ = json["car"].string_value();
+    for (const auto &[src, msgs] : json["finger"].object_items()) {
+      for (const auto &[addr, len] : msgs.object_items()) {
+        fp_.emplace_back(((uint64_t)std::stoul(src) << 32) | std::stoul(addr), len.int_value());
+      }
+    }
+    std::sort(fp_.begin(), fp_.end());
+    done_ = car_.empty() || fp_.empty();
+  }
+
+  inline bool done() const { return done_; }
+
+  void update(capnp::List<cereal::CanData>::Reader can) {
+    for (auto msg : can) {
+      const uint32_t addr = msg.getAddress();
+      const uint8_t src = msg.getSrc();
+      // same frame filter the python fingerprint loop applies
+      if (src >= 128 || addr >= 0x800 || addr == 0x7df || addr == 0x7e0 || addr == 0x7e8) continue;
+      const uint64_t key = ((uint64_t)src << 32) | addr;
+      auto it = std::lower_bound(fp_.begin(), fp_.end(), key,
+                                 [](const auto &p, uint64_t k) { return p.first < k; });
+      if (it == fp_.end() || it->first != key || it->second != (int)msg.getDat().size()) {
+        LOGW("cached fingerprint mismatch at addr 0x%x bus %d", addr, src);
+        done_ = true;
+        return;
+      }
+      if (++matched_ >= CONFIRM_FRAMES) {
+        LOGW("cached fingerprint confirmed: %s", car_.c_str());
+        Params().put("CachedFingerprintConfirmed", car_);
+        done_ = true;
+        return;
+      }
+    }
+  }
+
+private:
+  static constexpr int CONFIRM_FRAMES = 50;
+  std::string car_;
+  std::vector<std::pair<uint64_t, int>> fp_;
+  int matched_ = 0;
+  bool done_ = false;
+};
+
+// latest panda health error counters, written by panda_state_thread for the
+// canHealth message assembled on the publish thread
+std::atomic<uint32_t> health_can_rx_errs(0), health_can_send_errs(0), health_can_fwd_errs(0);
+
+// Per-bus utilization and per-address frequency/jitter EWMAs over the receive
+// path. Addresses live in a flat open-addressed hash table so the per-frame
+// update is one multiply-shift probe, no allocation.
+class CanAnalyzer {
+public:
+  void update(capnp::List<cereal::CanData>::Reader can, uint64_t now) {
+    for (auto msg : can) {
+      const uint8_t src = msg.getSrc();
+      if (src >= MAX_BUS) continue;  // rx echoes of tx'd frames carry src >= 128
+
+      // arbitration + control + crc + eof is ~44 bits on top of the payload,
+      // plus roughly 10% stuffing
+      bus_bits[src] += (44 + 8 * msg.getDat().size()) * 1.1f;
+      bus_msgs[src] += 1;
+
+      AddrStat &st = lookup(((uint64_t)src << 32) | msg.getAddress());
+      if (st.last_seen != 0 && now > st.last_seen) {
+        const float period = (now - st.last_seen) / 1e6f;  // ms
+        if (st.period_ewma == 0.0f) st.period_ewma = period;
+        st.jitter_ewma += EWMA_ALPHA * (fabsf(period - st.period_ewma) - st.jitter_ewma);
+        st.period_ewma += EWMA_ALPHA * (period - st.period_ewma);
+      }
+      st.last_seen = now;
+    }
+  }
+
+  void publish(PubMaster &pm, uint64_t now) {
+    if (last_pub == 0) last_pub = now;
+    if (now - last_pub < 1000000000ULL) return;
+    const float elapsed = (now - last_pub) / 1e9f;
+    last_pub = now;
+
+    MessageBuilder msg;
+    auto health = msg.initEvent().initCanHealth();
+    health.setCanRxErrs(health_can_rx_errs.load());
+    health.setCanSendErrs(health_can_send_errs.load());
+    health.setCanFwdErrs(health_can_fwd_errs.load());
+
+    int num_buses = 0;
+    for (int b = 0; b < MAX_BUS; b++) num_buses += (bus_msgs[b] > 0);
+    auto buses = health.initBuses(num_buses);
+    for (int b = 0, i = 0; b < MAX_BUS; b++) {
+      if (bus_msgs[b] == 0) continue;
+      auto bus = buses[i++];
+      bus.setBus(b);
+      bus.setBusLoad(bus_bits[b] / elapsed / 500000.0f);
+      bus.setMsgsPerSec(bus_msgs[b] / elapsed);
+      bus_bits[b] = 0.0f;
+      bus_msgs[b] = 0;
+    }
+
+    // only addresses still alive within the last 2s
+    int num_addrs = 0;
+    for (const AddrStat &st : table) {
+      num_addrs += (st.key != 0 && now - st.last_seen < 2000000000ULL && st.period_ewma > 0.0f);
+    }
+    auto addrs = health.initAddresses(num_addrs);
+    int i = 0;
+    for (const AddrStat &st : table) {
+      if (st.key == 0 || now - st.last_seen >= 2000000000ULL || st.period_ewma <= 0.0f) continue;
+      auto a = addrs[i++];
+      a.setBus(st.key >> 32);
+      a.setAddress(st.key & 0xFFFFFFFF);
+      a.setFreq(1000.0f / st.period_ewma);
+      a.setJitterMs(st.jitter_ewma);
+    }
+
+    pm.send("canHealth", msg);
+  }
+
+private:
+  static constexpr int MAX_BUS = 8;
+  static constexpr int TABLE_SIZE = 1024;  // power of two
+  static constexpr float EWMA_ALPHA = 0.05f;
+
+  struct AddrStat {
+    uint64_t key = 0;
+    float period_ewma = 0.0f;
+    float jitter_ewma = 0.0f;
+    uint64_t last_seen = 0;
+  };
+
+  AddrStat &lookup(uint64_t key) {
+    uint32_t i = (key * 0x9E3779B97F4A7C15ULL) >> (64 - 10);
+    for (int probe = 0; probe < 16; probe++, i = (i + 1) & (TABLE_SIZE - 1)) {
+      if (table[i].key == 0 || table[i].key == key) {
+        table[i].key = key;
+        return table[i];
+      }
+    }
+    return overflow;  // pathological flood: stats beyond the table are lumped
+  }
+
+  AddrStat table[TABLE_SIZE];
+  AddrStat overflow;
+  float bus_bits[MAX_BUS] = {};
+  uint32_t bus_msgs[MAX_BUS] = {};
+  uint64_t last_pub = 0;
+};
+
+void can_publish_thread() {
+  LOGD("start can publish thread");
+
+  // can = 8006
+  PubMaster pm({"can", "canHealth"});
+  kj::Array<capnp::word> can_data;
+  FingerprintMatcher fingerprint_matcher;
+  CanAnalyzer can_analyzer;
+
+  while (!do_exit && panda->connected) {
+    uint64_t rd = can_ring_read.load(std::memory_order_relaxed);
+    if (rd == can_ring_write.load(std::memory_order_acquire)) {
+      util::sleep_for(1);
+      continue;
+    }
+
+    CanChunk &chunk = can_ring[rd % CAN_RING_SIZE];
+    panda->unpack_can_buffer(chunk.data, chunk.len, can_data);
+    can_ring_read.store(rd + 1, std::memory_order_release);
+
+    {
+      capnp::FlatArrayMessageReader cmsg(can_data.asPtr());
+      auto can_list = cmsg.getRoot<cereal::Event>().getCan();
+      if (!fingerprint_matcher.done()) {
+        fingerprint_matcher.update(can_list);
+      }
+      uint64_t now = nanos_since_boot();
+      can_analyzer.update(can_list, now);
+      can_analyzer.publish(pm, now);
+    }
+
+    auto bytes = can_data.asBytes();
+    pm.send("can", bytes.begin(), bytes.size());
+  }
+}
+
+// stage p50/p99 over the samples of the last second; returns the p99 in ms
+static double fill_latency_stage(cereal::LatencyBudget::Stage::Builder stage, std::vector<uint64_t> &samples) {
+  stage.setCount(samples.size());
+  if (samples.empty()) return 0.0;
+  std::sort(samples.begin(), samples.end());
+  double p99 = samples[(samples.size() * 99) / 100] / 1e6;
+  stage.setP50(samples[samples.size() / 2] / 1e6);
+  stage.setP99(p99);
+  return p99;
+}
+
+void latency_tracker_thread() {
+  LOGD("start latency tracker thread");
+
+  // end-to-end frame-to-actuation budget: one camera frame (50ms) for the
+  // model, one for planning + controls, plus margin for CAN submit
+  const double E2E_BUDGET_MS = 250.0;
+
+  SubMaster sm({"modelV2", "lateralPlan", "controlsState"});
+  PubMaster pm({"latencyBudget"});
+
+  // recent controlsState chain info, matched to sendcan by publish time:
+  // controlsd publishes both back to back each cycle
+  std::deque<std::pair<uint64_t, uint64_t>> cs_ring;  // (logMonoTime, sofMonoTime)
+  std::vector<uint64_t> model_s, plan_s, controls_s, actuation_s, total_s;
+  uint64_t last_pub = nanos_since_boot();
+
+  while (!do_exit && panda->connected) {
+    sm.update(100);
+
+    // each message carries the mono time of its upstream input, so every
+    // stage is computable from the newest message alone even when conflated
+    if (sm.updated("modelV2")) {
+      uint64_t sof = sm["modelV2"].getModelV2().getTimestampSof();
+      uint64_t t = sm.log_mono_time("modelV2");
+      if (sof > 0 && t > sof) model_s.push_back(t - sof);
+    }
+    if (sm.updated("lateralPlan")) {
+      uint64_t model_t = sm["lateralPlan"].getLateralPlan().getModelMonoTime();
+      uint64_t t = sm.log_mono_time("lateralPlan");
+      if (model_t > 0 && t > model_t) plan_s.push_back(t - model_t);
+    }
+    if (sm.updated("controlsState")) {
+      auto cs = sm["controlsState"].getControlsState();
+      uint64_t plan_t = cs.getLateralPlanMonoTime();
+      uint64_t t = sm.log_mono_time("controlsState");
+      if (plan_t > 0 && t > plan_t) controls_s.push_back(t - plan_t);
+      cs_ring.emplace_back(t, cs.getSofMonoTime());
+      if (cs_ring.size() > 32) cs_ring.pop_front();
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> submits;
+    {
+      std::lock_guard lk(actuation_lock);
+      submits.swap(actuation_samples);
+    }
+    for (auto &[submit_time, sendcan_time] : submits) {
+      if (submit_time > sendcan_time) actuation_s.push_back(submit_time - sendcan_time);
+      // the controlsState published closest to this sendcan closes the chain
+      uint64_t sof = 0, best_dt = 10000000ULL;
+      for (auto &[cs_time, cs_sof] : cs_ring) {
+        uint64_t dt = std::max(cs_time, sendcan_time) - std::min(cs_time, sendcan_time);
+        if (dt < best_dt) { best_dt = dt; sof = cs_sof; }
+      }
+      if (sof > 0 && submit_time > sof) total_s.push_back(submit_time - sof);
+    }
+
+    uint64_t now = nanos_since_boot();
+    if (now - last_pub < 1000000000ULL) continue;
+    last_pub = now;
+
+    MessageBuilder msg;
+    auto budget = msg.initEvent().initLatencyBudget();
+    fill_latency_stage(budget.initModel(), model_s);
+    fill_latency_stage(budget.initPlan(), plan_s);
+    fill_latency_stage(budget.initControls(), controls_s);
+    fill_latency_stage(budget.initActuation(), actuation_s);
+    double total_p99 = fill_latency_stage(budget.initTotal(), total_s);
+    bool exceeded = total_p99 > E2E_BUDGET_MS;
+    budget.setBudgetExceeded(exceeded);
+    if (exceeded) {
+      LOGW("e2e latency budget exceeded: total p99 %.1f ms over %d samples", total_p99, (int)total_s.size());
+    }
+    pm.send("latencyBudget", msg);
+
+    model_s.clear(); plan_s.clear(); controls_s.clear(); actuation_s.clear(); total_s.clear();
+  }
+}
+
 void panda_state_thread() {
   LOGD("start panda state thread");
   PubMaster pm({"pandaState"});
 
-  uint32_t no_ignition_cnt = 0;
-  bool ignition_last = false;
+  // static: the thread is restarted on every usb reconnect, and a brownout
+  // mid-drive must not look like an ignition rising edge (which would clear
+  // params and rerun the whole safety setter handshake)
+  static uint32_t no_ignition_cnt = 0;
+  static bool ignition_last = false;
   Params params = Params();
 
   // Broadcast empty pandaState message when panda is not yet connected
@@ -318,6 +678,7 @@ void panda_state_thread() {
       }
     } else if (!ignition_local && ignition_last) {
       params.clearAll(CLEAR_ON_IGNITION_OFF);
+      have_cached_safety = false;  // next drive negotiates safety from scratch
     }
 
     // Write to rtc once per minute when no ignition present
@@ -372,8 +733,13 @@ void panda_state_thread() {
     ps.setControlsAllowed(pandaState.controls_allowed);
     ps.setGasInterceptorDetected(pandaState.gas_interceptor_detected);
     ps.setHasGps(panda->is_pigeon);
+    health_can_rx_errs = pandaState.can_rx_errs;
+    health_can_send_errs = pandaState.can_send_errs;
+    health_can_fwd_errs = pandaState.can_fwd_errs;
+
     ps.setCanRxErrs(pandaState.can_rx_errs);
     ps.setCanSendErrs(pandaState.can_send_errs);
+    ps.setCanSendDeadlineMisses(sendcan_deadline_misses.load());
     ps.setCanFwdErrs(pandaState.can_fwd_errs);
     ps.setGmlanSendErrs(pandaState.gmlan_send_errs);
     ps.setPandaType(panda->hw_type);
@@ -590,9 +956,12 @@ int main() {
 
     // connect to the board
     usb_retry_connect();
+    process_set_ready("boardd");
 
     threads.push_back(std::thread(can_send_thread));
     threads.push_back(std::thread(can_recv_thread));
+    threads.push_back(std::thread(can_publish_thread));
+    threads.push_back(std::thread(latency_tracker_thread));
     threads.push_back(std::thread(hardware_control_thread));
     if (!white_panda_support) threads.push_back(std::thread(pigeon_thread));
 
@@ -11,7 +11,11 @@
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 
-Panda::Panda() {
+Panda::Panda(std::string serial) {
+  // 16 wire bytes per CAN message, sized for the largest sendcan frame
+  // controls produces so can_send never reallocates
+  send.reserve(0x100 * 0x10);
+
   // init libusb
   int err = libusb_init(&ctx);
   if (err != 0) { goto fail; }
@@ -22,7 +26,7 @@ Panda::Panda() {
   libusb_set_debug(ctx, 3);
 #endif
 
-  dev_handle = libusb_open_device_with_vid_pid(ctx, 0xbbaa, 0xddcc);
+  dev_handle = usb_open(serial);
   if (dev_handle == NULL) { goto fail; }
 
   if (libusb_kernel_driver_active(dev_handle, 0) == 1) {
@@ -50,6 +54,16 @@ Panda::Panda() {
   has_rtc = (hw_type == cereal::PandaState::PandaType::UNO) ||
             (hw_type == cereal::PandaState::PandaType::DOS);
 
+  {
+    // negotiate the CAN packet format; old firmware doesn't know 0xd5 and
+    // leaves us on v1
+    unsigned char fw_max = 0;
+    if (usb_read(0xd5, 0, 0, &fw_max, 1) == 1 && fw_max >= CAN_PACKET_VERSION_2) {
+      usb_write(0xd5, CAN_PACKET_VERSION_2, 0);
+      can_packet_version = CAN_PACKET_VERSION_2;
+    }
+  }
+
   return;
 
 fail:
@@ -58,11 +72,70 @@ fail:
 }
 
 Panda::~Panda() {
-  std::lock_guard lk(usb_lock);
+  std::scoped_lock lk(usb_lock, bulk_write_lock, bulk_read_lock);
   cleanup();
   connected = false;
 }
 
+// open the panda matching serial, or the first one when serial is empty
+libusb_device_handle *Panda::usb_open(const std::string &serial) {
+  libusb_device **dev_list = NULL;
+  libusb_device_handle *handle = NULL;
+
+  ssize_t num_devices = libusb_get_device_list(ctx, &dev_list);
+  for (ssize_t i = 0; i < num_devices; i++) {
+    libusb_device_descriptor desc;
+    libusb_get_device_descriptor(dev_list[i], &desc);
+    if (desc.idVendor != 0xbbaa || desc.idProduct != 0xddcc) continue;
+
+    libusb_device_handle *h = NULL;
+    if (libusb_open(dev_list[i], &h) != 0 || h == NULL) continue;
+
+    unsigned char s[26] = {0};
+    if (desc.iSerialNumber > 0) {
+      libusb_get_string_descriptor_ascii(h, desc.iSerialNumber, s, sizeof(s) - 1);
+    }
+
+    if (serial.empty() || serial == (const char *)s) {
+      handle = h;
+      break;
+    }
+    libusb_close(h);
+  }
+  if (num_devices >= 0) libusb_free_device_list(dev_list, 1);
+
+  return handle;
+}
+
+std::vector<std::string> Panda::list() {
+  std::vector<std::string> serials;
+
+  libusb_context *context = NULL;
+  if (libusb_init(&context) != 0) { return serials; }
+
+  libusb_device **dev_list = NULL;
+  ssize_t num_devices = libusb_get_device_list(context, &dev_list);
+  for (ssize_t i = 0; i < num_devices; i++) {
+    libusb_device_descriptor desc;
+    libusb_get_device_descriptor(dev_list[i], &desc);
+    if (desc.idVendor != 0xbbaa || desc.idProduct != 0xddcc) continue;
+
+    libusb_device_handle *h = NULL;
+    if (libusb_open(dev_list[i], &h) != 0 || h == NULL) continue;
+
+    unsigned char s[26] = {0};
+    if (desc.iSerialNumber > 0 &&
+        libusb_get_string_descriptor_ascii(h, desc.iSerialNumber, s, sizeof(s) - 1) > 0) {
+      serials.push_back((const char *)s);
+    }
+    libusb_close(h);
+  }
+  if (num_devices >= 0) libusb_free_device_list(dev_list, 1);
+  libusb_exit(context);
+
+  return serials;
+}
+
 void Panda::cleanup() {
   if (dev_handle) {
     libusb_release_interface(dev_handle, 0);
@@ -125,7 +198,7 @@ int Panda::usb_bulk_write(unsigned char endpoint, unsigned char* data, int lengt
     return 0;
   }
 
-  std::lock_guard lk(usb_lock);
+  std::lock_guard lk(bulk_write_lock);
   do {
     // Try sending can messages. If the receive buffer on the panda is full it will NAK
     // and libusb will try again. After 5ms, it will time out. We will drop the messages.
@@ -150,7 +223,7 @@ int Panda::usb_bulk_read(unsigned char endpoint, unsigned char* data, int length
     return 0;
   }
 
-  std::lock_guard lk(usb_lock);
+  std::lock_guard lk(bulk_read_lock);
 
   do {
     err = libusb_bulk_transfer(dev_handle, endpoint, data, length, &transferred, timeout);
@@ -269,7 +342,6 @@ void Panda::send_heartbeat() {
 }
 
 void Panda::can_send(capnp::List<cereal::CanData>::Reader can_data_list) {
-  static std::vector<uint32_t> send;
   const int msg_count = can_data_list.size();
 
   send.resize(msg_count*0x10);
@@ -290,38 +362,79 @@ void Panda::can_send(capnp::List<cereal::CanData>::Reader can_data_list) {
   usb_bulk_write(3, (unsigned char*)send.data(), send.size(), 5);
 }
 
-int Panda::can_receive(kj::Array<capnp::word>& out_buf) {
-  uint32_t data[RECV_SIZE/4];
-  int recv = usb_bulk_read(0x81, (unsigned char*)data, RECV_SIZE);
+int Panda::can_receive_raw(uint8_t *data, int size) {
+  int recv = usb_bulk_read(0x81, data, size);
 
   // Not sure if this can happen
   if (recv < 0) recv = 0;
 
-  if (recv == RECV_SIZE) {
+  if (recv == size) {
     LOGW("Receive buffer full");
   }
 
-  size_t num_msg = recv / 0x10;
+  return recv;
+}
+
+int Panda::can_receive(kj::Array<capnp::word>& out_buf) {
+  uint32_t data[RECV_SIZE/4];
+  int recv = can_receive_raw((uint8_t*)data, RECV_SIZE);
+  unpack_can_buffer((uint8_t*)data, recv, out_buf);
+  return recv;
+}
+
+void Panda::unpack_can_buffer(uint8_t *dat, int recv, kj::Array<capnp::word>& out_buf) {
   MessageBuilder msg;
   auto evt = msg.initEvent();
   evt.setValid(comms_healthy);
 
-  // populate message
-  auto canData = evt.initCan(num_msg);
-  for (int i = 0; i < num_msg; i++) {
-    if (data[i*4] & 4) {
-      // extended
-      canData[i].setAddress(data[i*4] >> 3);
-      //printf("got extended: %x\n", data[i*4] >> 3);
-    } else {
-      // normal
-      canData[i].setAddress(data[i*4] >> 21);
+  if (can_packet_version >= CAN_PACKET_VERSION_2) {
+    // variable length records: one cheap scan to size the list up front,
+    // then a fill pass
+    size_t num_msg = 0;
+    for (int pos = 0; pos + 4 <= recv;) {
+      int rec_len = 4 + ((dat[pos] & 0x10) ? 4 : 2) + (dat[pos] & 0xF);
+      if (pos + rec_len > recv) break;
+      pos += rec_len;
+      num_msg++;
+    }
+
+    auto canData = evt.initCan(num_msg);
+    int pos = 0;
+    for (size_t i = 0; i < num_msg; i++) {
+      const uint8_t dlc = dat[pos] & 0xF;
+      const bool ext = dat[pos] & 0x10;
+      auto can = canData[i];
+
+      can.setSrc(dat[pos+1]);
+      can.setBusTime(dat[pos+2] | (dat[pos+3] << 8));
+      uint32_t address = dat[pos+4] | (dat[pos+5] << 8);
+      int data_off = pos + 6;
+      if (ext) {
+        address |= (dat[pos+6] << 16) | ((uint32_t)dat[pos+7] << 24);
+        data_off = pos + 8;
+      }
+      can.setAddress(address);
+      can.setDat(kj::arrayPtr(&dat[data_off], dlc));
+      pos = data_off + dlc;
+    }
+  } else {
+    uint32_t *data = (uint32_t*)dat;
+    size_t num_msg = recv / 0x10;
+
+    // populate message. the list is sized once up front; each 16 byte record
+    // is decoded from two header words loaded once and one list handle
+    auto canData = evt.initCan(num_msg);
+    for (int i = 0; i < num_msg; i++) {
+      const uint32_t w0 = data[i*4];
+      const uint32_t w1 = data[i*4+1];
+      auto can = canData[i];
+
+      // extended or normal address
+      can.setAddress((w0 & 4) ? (w0 >> 3) : (w0 >> 21));
+      can.setBusTime(w1 >> 16);
+      can.setDat(kj::arrayPtr((uint8_t*)&data[i*4+2], w1 & 0xF));
+      can.setSrc((w1 >> 4) & 0xff);
     }
-    canData[i].setBusTime(data[i*4+1] >> 16);
-    int len = data[i*4+1]&0xF;
-    canData[i].setDat(kj::arrayPtr((uint8_t*)&data[i*4+2], len));
-    canData[i].setSrc((data[i*4+1] >> 4) & 0xff);
   }
   out_buf = capnp::messageToFlatArray(msg);
-  return recv;
 }
@@ -5,6 +5,7 @@
 #include <ctime>
 #include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include <libusb-1.0/libusb.h>
@@ -16,6 +17,17 @@
 #define RECV_SIZE (0x1000)
 #define TIMEOUT 0
 
+// CAN-over-USB wire format, negotiated with the firmware via control
+// request 0xd5 (wValue 0 reads the firmware's max supported version,
+// nonzero selects one). v1 is the legacy fixed 16 byte record: two header
+// words in the hardware mailbox layout plus 8 data bytes, always. v2 packs
+// a 4 byte header (dlc | extended flag, src, 16 bit bus timestamp), a 2 or
+// 4 byte little-endian address, and only dlc data bytes; records never
+// span a USB packet. firmware without 0xd5 answers with an empty read and
+// the host stays on v1.
+#define CAN_PACKET_VERSION_1 1
+#define CAN_PACKET_VERSION_2 2
+
 // copied from panda/board/main.c
 struct __attribute__((packed)) health_t {
   uint32_t uptime;
@@ -44,19 +56,31 @@ class Panda {
  private:
   libusb_context *ctx = NULL;
   libusb_device_handle *dev_handle = NULL;
+  // control, bulk in and bulk out are independent endpoints; locking them
+  // separately keeps state polling from delaying sendcan writes
   std::mutex usb_lock;
+  std::mutex bulk_write_lock;
+  std::mutex bulk_read_lock;
+  libusb_device_handle *usb_open(const std::string &serial);
   void handle_usb_issue(int err, const char func[]);
   void cleanup();
 
+  // preallocated sendcan packet buffer so the send path never allocates
+  std::vector<uint32_t> send;
+
  public:
-  Panda();
+  Panda(std::string serial = "");
   ~Panda();
 
+  // serials of all connected pandas
+  static std::vector<std::string> list();
+
   std::atomic<bool> connected = true;
   std::atomic<bool> comms_healthy = true;
   cereal::PandaState::PandaType hw_type = cereal::PandaState::PandaType::UNKNOWN;
   bool is_pigeon = false;
   bool has_rtc = false;
+  int can_packet_version = CAN_PACKET_VERSION_1;
 
   // HW communication
   int usb_write(uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned int timeout=TIMEOUT);
@@ -82,4 +106,6 @@ class Panda {
   void send_heartbeat();
   void can_send(capnp::List<cereal::CanData>::Reader can_data_list);
   int can_receive(kj::Array<capnp::word>& out_buf);
+  int can_receive_raw(uint8_t *data, int size);
+  void unpack_can_buffer(uint8_t *data, int size, kj::Array<capnp::word>& out_buf);
 };
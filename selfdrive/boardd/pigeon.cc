@@ -72,7 +72,81 @@ bool Pigeon::send_with_ack(const std::string &cmd) {
   return wait_for_ack();
 }
 
+// Pipelined configuration: every message goes out back to back and the ACKs
+// are counted as they stream in, instead of paying a full round trip plus a
+// scheduler sleep per message. UBX-ACK carries no sequence info, so the
+// batch passes when every ACK arrived and fails on the first NACK.
+bool Pigeon::send_batch_with_acks(const std::vector<std::string> &cmds, int timeout_ms) {
+  for (const auto &cmd : cmds) {
+    send(cmd);
+  }
+
+  size_t acks = 0;
+  std::string s;
+  const double start_t = millis_since_boot();
+  while (!do_exit) {
+    s += receive();
+
+    size_t pos;
+    while ((pos = s.find(ack)) != std::string::npos) {
+      s.erase(0, pos + ack.size());
+      if (++acks == cmds.size()) {
+        LOGD("Received all %zu ACKs from ublox", acks);
+        return true;
+      }
+    }
+    if (s.find(nack) != std::string::npos) {
+      LOGE("Received NACK from ublox");
+      return false;
+    }
+    if ((millis_since_boot() - start_t) > timeout_ms) {
+      LOGE("ublox ACK timeout, got %zu of %zu", acks, cmds.size());
+      return false;
+    }
+    // keep only a tail big enough for an ACK split across reads
+    if (s.size() > 0x1000) s.erase(0, s.size() - ack.size());
+
+    util::sleep_for(1); // Allow other threads to be scheduled
+  }
+  return false;
+}
+
 void Pigeon::init() {
+  // init from ubloxd
+  // To generate this data, run selfdrive/locationd/test/ubloxd.py
+  const std::vector<std::string> cfg = {
+    "\xB5\x62\x06\x00\x14\x00\x03\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x01\x00\x00\x00\x00\x00\x1E\x7F"s,
+    "\xB5\x62\x06\x00\x14\x00\x00\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x19\x35"s,
+    "\xB5\x62\x06\x00\x14\x00\x01\x00\x00\x00\xC0\x08\x00\x00\x00\x08\x07\x00\x01\x00\x01\x00\x00\x00\x00\x00\xF4\x80"s,
+    "\xB5\x62\x06\x00\x14\x00\x04\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x1D\x85"s,
+    "\xB5\x62\x06\x00\x00\x00\x06\x18"s,
+    "\xB5\x62\x06\x00\x01\x00\x01\x08\x22"s,
+    "\xB5\x62\x06\x00\x01\x00\x03\x0A\x24"s,
+    "\xB5\x62\x06\x08\x06\x00\x64\x00\x01\x00\x00\x00\x79\x10"s,
+    "\xB5\x62\x06\x24\x24\x00\x05\x00\x04\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x5A\x63"s,
+    "\xB5\x62\x06\x1E\x14\x00\x00\x00\x00\x00\x01\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x3C\x37"s,
+    "\xB5\x62\x06\x39\x08\x00\xFF\xAD\x62\xAD\x1E\x63\x00\x00\x83\x0C"s,
+    "\xB5\x62\x06\x24\x00\x00\x2A\x84"s,
+    "\xB5\x62\x06\x23\x00\x00\x29\x81"s,
+    "\xB5\x62\x06\x1E\x00\x00\x24\x72"s,
+    "\xB5\x62\x06\x39\x00\x00\x3F\xC3"s,
+    "\xB5\x62\x06\x01\x03\x00\x01\x07\x01\x13\x51"s,
+    "\xB5\x62\x06\x01\x03\x00\x02\x15\x01\x22\x70"s,
+    "\xB5\x62\x06\x01\x03\x00\x02\x13\x01\x20\x6C"s,
+    "\xB5\x62\x06\x01\x03\x00\x0A\x09\x01\x1E\x70"s,
+    "\xB5\x62\x06\x01\x03\x00\x0A\x0B\x01\x20\x74"s,
+  };
+
+  // warm start: a boardd restart leaves the receiver powered, configured and
+  // already negotiated to 460800, so a CFG-PRT poll answers right away. Probe
+  // before paying for the power cycle and the 9600 handshake.
+  set_baud(460800);
+  send("\xB5\x62\x06\x00\x00\x00\x06\x18"s);
+  if (wait_for_ack(ack, nack, 100)) {
+    LOGW("panda GPS warm start");
+    return;
+  }
+
   for (int i = 0; i < 10; i++) {
     if (do_exit) return;
     LOGW("panda GPS start");
@@ -95,28 +169,7 @@ void Pigeon::init() {
     // set baud rate to 460800
     set_baud(460800);
 
-    // init from ubloxd
-    // To generate this data, run selfdrive/locationd/test/ubloxd.py
-    if (!send_with_ack("\xB5\x62\x06\x00\x14\x00\x03\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x01\x00\x00\x00\x00\x00\x1E\x7F"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x00\x14\x00\x00\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x19\x35"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x00\x14\x00\x01\x00\x00\x00\xC0\x08\x00\x00\x00\x08\x07\x00\x01\x00\x01\x00\x00\x00\x00\x00\xF4\x80"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x00\x14\x00\x04\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x1D\x85"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x00\x00\x00\x06\x18"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x00\x01\x00\x01\x08\x22"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x00\x01\x00\x03\x0A\x24"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x08\x06\x00\x64\x00\x01\x00\x00\x00\x79\x10"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x24\x24\x00\x05\x00\x04\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x5A\x63"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x1E\x14\x00\x00\x00\x00\x00\x01\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x3C\x37"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x39\x08\x00\xFF\xAD\x62\xAD\x1E\x63\x00\x00\x83\x0C"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x24\x00\x00\x2A\x84"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x23\x00\x00\x29\x81"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x1E\x00\x00\x24\x72"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x39\x00\x00\x3F\xC3"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x01\x03\x00\x01\x07\x01\x13\x51"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x01\x03\x00\x02\x15\x01\x22\x70"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x01\x03\x00\x02\x13\x01\x20\x6C"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x01\x03\x00\x0A\x09\x01\x1E\x70"s)) continue;
-    if (!send_with_ack("\xB5\x62\x06\x01\x03\x00\x0A\x0B\x01\x20\x74"s)) continue;
+    if (!send_batch_with_acks(cfg)) continue;
 
     auto time = util::get_time();
     if (util::time_valid(time)) {
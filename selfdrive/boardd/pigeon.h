@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <string>
+#include <vector>
 
 #include "selfdrive/boardd/panda.h"
 
@@ -18,6 +19,7 @@ class Pigeon {
   bool wait_for_ack();
   bool wait_for_ack(const std::string &ack, const std::string &nack, int timeout_ms = 1000);
   bool send_with_ack(const std::string &cmd);
+  bool send_batch_with_acks(const std::vector<std::string> &cmds, int timeout_ms = 1000);
   virtual void set_baud(int baud) = 0;
   virtual void send(const std::string &s) = 0;
   virtual std::string receive() = 0;
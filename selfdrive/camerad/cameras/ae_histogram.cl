@@ -0,0 +1,30 @@
+// 256-bin luminance histogram over a strided sample grid of the Y plane.
+// Each workgroup accumulates into local memory and flushes with one
+// atomic add per bin, so AE only reads 1KB back instead of the frame.
+
+__kernel void lum_histogram(__global const uchar *pix, int stride,
+                            int x_start, int x_end, int x_skip,
+                            int y_start, int y_end, int y_skip,
+                            __global uint *hist) {
+  __local uint lhist[256];
+  const int lid = get_local_id(1) * get_local_size(0) + get_local_id(0);
+  const int lsize = get_local_size(0) * get_local_size(1);
+  for (int i = lid; i < 256; i += lsize) {
+    lhist[i] = 0;
+  }
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  // global size is rounded up to the workgroup size
+  const int x = x_start + get_global_id(0) * x_skip;
+  const int y = y_start + get_global_id(1) * y_skip;
+  if (x < x_end && y < y_end) {
+    atomic_inc(&lhist[pix[mad24(y, stride, x)]]);
+  }
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  for (int i = lid; i < 256; i += lsize) {
+    if (lhist[i] != 0) {
+      atomic_add(&hist[i], lhist[i]);
+    }
+  }
+}
@@ -2,9 +2,12 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdio>
 #include <chrono>
+#include <fstream>
 #include <thread>
 
 #include "libyuv.h"
@@ -15,6 +18,7 @@
 #include "selfdrive/common/modeldata.h"
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/trace.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
 
@@ -30,6 +34,53 @@
 
 const int YUV_COUNT = 100;
 
+// Core plan for camerad, all in one place. The process is pinned in main, but
+// the per-camera frame threads re-pin themselves so the plan holds even if a
+// parent affinity changes, and the camera block interrupts are steered onto
+// the same cores so an IRQ landing on a controls/boardd core can't add to
+// frame-interval jitter. irq_names are matched as substrings of the action
+// column in /proc/interrupts.
+struct CameradTopology {
+  std::vector<int> frame_thread_cores;
+  std::vector<int> irq_cores;
+  std::vector<const char *> irq_names;
+};
+
+static CameradTopology camerad_topology() {
+  if (Hardware::EON()) {
+    // matches the boot-time plan in launch_chffrplus.sh: camera + GPU on core 2
+    return {{2}, {2}, {"csid", "vfe", "cci"}};
+  }
+  // TICI: cores 0-3 are left to the system, 4-5 run boardd and the controls
+  // stack, camerad lives on 6 (modeld on 7)
+  return {{6}, {6}, {"csid", "cci", "cdm", "ife", "cam_sync"}};
+}
+
+void camerad_steer_irqs() {
+  if (Hardware::PC()) return;
+  const CameradTopology topo = camerad_topology();
+
+  std::string cores;
+  for (const int c : topo.irq_cores) {
+    cores += (cores.empty() ? "" : ",") + std::to_string(c);
+  }
+
+  std::ifstream interrupts("/proc/interrupts");
+  std::string line;
+  while (std::getline(interrupts, line)) {
+    auto matches = [&line](const char *name) { return line.find(name) != std::string::npos; };
+    if (std::none_of(topo.irq_names.begin(), topo.irq_names.end(), matches)) continue;
+
+    const int irq = atoi(line.c_str());
+    if (irq <= 0) continue;
+    std::string path = "/proc/irq/" + std::to_string(irq) + "/smp_affinity_list";
+    if (util::write_file(path.c_str(), cores.data(), cores.size()) < 0) {
+      // not fatal: the boot-time defaults still apply
+      LOGW("failed to steer irq %d to cores %s", irq, cores.c_str());
+    }
+  }
+}
+
 class Debayer {
 public:
   Debayer(cl_device_id device_id, cl_context context, const CameraBuf *b, const CameraState *s) {
@@ -75,12 +126,64 @@ private:
   cl_kernel krnl_;
 };
 
+// reduces the Y plane to a 256-bin histogram on the GPU so autoexposure
+// only reads 1KB back instead of walking the frame on the CPU
+class AeHistogram {
+public:
+  AeHistogram(cl_device_id device_id, cl_context context) {
+    cl_program prg = cl_program_from_file(context, device_id, "cameras/ae_histogram.cl", "");
+    krnl_ = CL_CHECK_ERR(clCreateKernel(prg, "lum_histogram", &err));
+    CL_CHECK(clReleaseProgram(prg));
+    hist_cl_ = cl_pool_alloc(context, 256 * sizeof(uint32_t));
+  }
+
+  void run(cl_command_queue q, cl_mem y_cl, int stride,
+           int x_start, int x_end, int x_skip, int y_start, int y_end, int y_skip,
+           uint32_t *hist) {
+    static const uint32_t zeros[256] = {0};
+    CL_CHECK(clEnqueueWriteBuffer(q, hist_cl_, CL_FALSE, 0, sizeof(zeros), zeros, 0, NULL, NULL));
+
+    CL_CHECK(clSetKernelArg(krnl_, 0, sizeof(cl_mem), &y_cl));
+    CL_CHECK(clSetKernelArg(krnl_, 1, sizeof(cl_int), &stride));
+    CL_CHECK(clSetKernelArg(krnl_, 2, sizeof(cl_int), &x_start));
+    CL_CHECK(clSetKernelArg(krnl_, 3, sizeof(cl_int), &x_end));
+    CL_CHECK(clSetKernelArg(krnl_, 4, sizeof(cl_int), &x_skip));
+    CL_CHECK(clSetKernelArg(krnl_, 5, sizeof(cl_int), &y_start));
+    CL_CHECK(clSetKernelArg(krnl_, 6, sizeof(cl_int), &y_end));
+    CL_CHECK(clSetKernelArg(krnl_, 7, sizeof(cl_int), &y_skip));
+    CL_CHECK(clSetKernelArg(krnl_, 8, sizeof(cl_mem), &hist_cl_));
+
+    const size_t local_worksize = 16;
+    const size_t nx = (x_end - x_start + x_skip - 1) / x_skip;
+    const size_t ny = (y_end - y_start + y_skip - 1) / y_skip;
+    const size_t globalWorkSize[] = {(nx + local_worksize - 1) & ~(local_worksize - 1),
+                                     (ny + local_worksize - 1) & ~(local_worksize - 1)};
+    const size_t localWorkSize[] = {local_worksize, local_worksize};
+    CL_CHECK(clEnqueueNDRangeKernel(q, krnl_, 2, NULL, globalWorkSize, localWorkSize, 0, 0, NULL));
+    CL_CHECK(clEnqueueReadBuffer(q, hist_cl_, CL_TRUE, 0, 256 * sizeof(uint32_t), hist, 0, NULL, NULL));
+  }
+
+  ~AeHistogram() {
+    cl_pool_release(hist_cl_);
+    CL_CHECK(clReleaseKernel(krnl_));
+  }
+
+private:
+  cl_kernel krnl_;
+  cl_mem hist_cl_;
+};
+
 void CameraBuf::init(cl_device_id device_id, cl_context context, CameraState *s, VisionIpcServer * v, int frame_cnt, VisionStreamType init_rgb_type, VisionStreamType init_yuv_type, release_cb init_release_callback) {
   vipc_server = v;
   this->rgb_type = init_rgb_type;
   this->yuv_type = init_yuv_type;
   this->release_callback = init_release_callback;
 
+  const char *drop_name = init_yuv_type == VISION_STREAM_YUV_FRONT ? "camerad.frames_dropped.driver" :
+                          init_yuv_type == VISION_STREAM_YUV_WIDE ? "camerad.frames_dropped.wide" :
+                          "camerad.frames_dropped.road";
+  drops_metric = metric_counter(drop_name);
+
   const CameraInfo *ci = &s->ci;
   camera_state = s;
   frame_buf_count = frame_cnt;
@@ -115,6 +218,17 @@ void CameraBuf::init(cl_device_id device_id, cl_context context, CameraState *s,
     debayer = new Debayer(device_id, context, this, s);
   }
   rgb2yuv = std::make_unique<Rgb2Yuv>(context, device_id, rgb_width, rgb_height, rgb_stride);
+  ae_hist = new AeHistogram(device_id, context);
+
+  // optionally warp the model-input tile in the same pass while the YUV
+  // frame is still device-resident, instead of a separate full-resolution
+  // read in the consumer
+  model_tile_enabled = env_model_tile && init_yuv_type == VISION_STREAM_YUV_BACK;
+  if (model_tile_enabled) {
+    vipc_server->create_buffers(VISION_STREAM_MODEL, YUV_COUNT, false, MODEL_TILE_WIDTH, MODEL_TILE_HEIGHT);
+    transform_init(&model_warp, context, device_id, "../modeld/transforms/transform.cl");
+    calib_sm = std::make_unique<SubMaster>(std::vector<const char *>{"liveCalibration"});
+  }
 
 #ifdef __APPLE__
   q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
@@ -129,9 +243,59 @@ CameraBuf::~CameraBuf() {
     camera_bufs[i].free();
   }
   if (debayer) delete debayer;
+  if (ae_hist) delete ae_hist;
+  if (model_tile_enabled) {
+    for (auto &[buf, planes] : model_tile_planes) {
+      for (cl_mem plane : planes) CL_CHECK(clReleaseMemObject(plane));
+    }
+    transform_destroy(&model_warp);
+  }
   if (q) CL_CHECK(clReleaseCommandQueue(q));
 }
 
+// Y/U/V sub-buffers into a packed tile buffer, created once per buffer
+cl_mem *CameraBuf::tile_planes(VisionBuf *buf) {
+  auto it = model_tile_planes.find(buf);
+  if (it == model_tile_planes.end()) {
+    const size_t y_size = MODEL_TILE_WIDTH * MODEL_TILE_HEIGHT;
+    const cl_buffer_region regions[3] = {
+      {0, y_size}, {y_size, y_size / 4}, {y_size + y_size / 4, y_size / 4},
+    };
+    std::array<cl_mem, 3> planes;
+    for (int i = 0; i < 3; i++) {
+      planes[i] = CL_CHECK_ERR(clCreateSubBuffer(buf->buf_cl, CL_MEM_READ_WRITE,
+                                                 CL_BUFFER_CREATE_TYPE_REGION, &regions[i], &err));
+    }
+    it = model_tile_planes.emplace(buf, planes).first;
+  }
+  return it->second.data();
+}
+
+// same math as modeld's calibration thread: medmodel frame through the
+// calibrated camera frame, in buffer pixels
+static mat3 model_warp_from_extrinsics(const float *extrinsic, const mat3 &yuv_transform) {
+  const mat3 ground_from_medmodel_frame = {{
+    0.00000000e+00, 0.00000000e+00, 1.00000000e+00,
+    -1.09890110e-03, 0.00000000e+00, 2.81318681e-01,
+    -1.84808520e-20, 9.00738606e-04, -4.28751576e-02,
+  }};
+
+  // camera_frame_from_ground = intrinsics * extrinsic columns (0, 1, 3)
+  const int cols[3] = {0, 1, 3};
+  mat3 camera_frame_from_ground = {};
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      float v = 0;
+      for (int k = 0; k < 3; k++) {
+        v += fcam_intrinsic_matrix.v[r*3+k] * extrinsic[k*4 + cols[c]];
+      }
+      camera_frame_from_ground.v[r*3+c] = v;
+    }
+  }
+
+  return matmul3(yuv_transform, matmul3(camera_frame_from_ground, ground_from_medmodel_frame));
+}
+
 bool CameraBuf::acquire() {
   if (!safe_queue.try_pop(cur_buf_idx, 1)) return false;
 
@@ -141,6 +305,7 @@ bool CameraBuf::acquire() {
     return false;
   }
 
+  TraceSpan span("camera_acquire");
   cur_frame_data = camera_bufs_metadata[cur_buf_idx];
   cur_rgb_buf = vipc_server->get_buffer(rgb_type);
   cl_mem camrabuf_cl = camera_bufs[cur_buf_idx].buf_cl;
@@ -175,6 +340,33 @@ bool CameraBuf::acquire() {
   cur_yuv_buf->set_frame_id(cur_frame_data.frame_id);
   vipc_server->send(cur_rgb_buf, &extra);
   vipc_server->send(cur_yuv_buf, &extra);
+  cur_frame_data.frames_dropped = vipc_server->get_drop_count(yuv_type);
+  metric_add(drops_metric, cur_frame_data.frames_dropped - last_drop_count);
+  last_drop_count = cur_frame_data.frames_dropped;
+
+  if (model_tile_enabled) {
+    // refresh the warp from the latest calibration, then chain the tile
+    // warp onto the same queue while the YUV output is still on device
+    calib_sm->update(0);
+    if (calib_sm->updated("liveCalibration")) {
+      auto calib = (*calib_sm)["liveCalibration"].getLiveCalibration().getExtrinsicMatrix();
+      float extrinsic[12];
+      for (int i = 0; i < 12; i++) extrinsic[i] = calib[i];
+      model_warp_mat = model_warp_from_extrinsics(extrinsic, yuv_transform);
+      model_warp_valid = true;
+    }
+
+    if (model_warp_valid) {
+      cur_model_buf = vipc_server->get_buffer(VISION_STREAM_MODEL);
+      cl_mem *planes = tile_planes(cur_model_buf);
+      transform_queue(&model_warp, q, cur_yuv_buf->buf_cl, rgb_width, rgb_height,
+                      planes[0], planes[1], planes[2],
+                      MODEL_TILE_WIDTH, MODEL_TILE_HEIGHT, model_warp_mat);
+      CL_CHECK(clFinish(q));
+      cur_model_buf->set_frame_id(cur_frame_data.frame_id);
+      vipc_server->send(cur_model_buf, &extra);
+    }
+  }
 
   return true;
 }
@@ -196,6 +388,7 @@ void fill_frame_data(cereal::FrameData::Builder &framed, const FrameMetadata &fr
   framed.setTimestampEof(frame_data.timestamp_eof);
   framed.setTimestampSof(frame_data.timestamp_sof);
   framed.setFrameLength(frame_data.frame_length);
+  framed.setFramesDropped(frame_data.frames_dropped);
   framed.setIntegLines(frame_data.integ_lines);
   framed.setGain(frame_data.gain);
   framed.setHighConversionGain(frame_data.high_conversion_gain);
@@ -225,31 +418,63 @@ kj::Array<uint8_t> get_frame_image(const CameraBuf *b) {
   kj::Array<uint8_t> frame_image = kj::heapArray<uint8_t>(new_width*new_height*3);
   uint8_t *resized_dat = frame_image.begin();
   int goff = x_min*3 + y_min*b->rgb_stride;
-  for (int r=0;r<new_height;r++) {
-    for (int c=0;c<new_width;c++) {
-      memcpy(&resized_dat[(r*new_width+c)*3], &dat[goff+r*b->rgb_stride*scale+c*3*scale], 3*sizeof(uint8_t));
+  if (scale == 1) {
+    // unscaled rows are contiguous: one memcpy per row instead of per pixel
+    for (int r=0;r<new_height;r++) {
+      memcpy(&resized_dat[r*new_width*3], &dat[goff+r*b->rgb_stride], new_width*3);
+    }
+  } else {
+    for (int r=0;r<new_height;r++) {
+      for (int c=0;c<new_width;c++) {
+        memcpy(&resized_dat[(r*new_width+c)*3], &dat[goff+r*b->rgb_stride*scale+c*3*scale], 3*sizeof(uint8_t));
+      }
     }
   }
   return kj::mv(frame_image);
 }
 
-static kj::Array<capnp::byte> yuv420_to_jpeg(const CameraBuf *b, int thumbnail_width, int thumbnail_height) {
+// Downscaled YUV snapshot handed from the frame thread to the thumbnail
+// worker; the scale is cheap, the jpeg encode is not
+struct ThumbnailSnapshot {
+  std::unique_ptr<uint8_t[]> buf;
+  int width, height;
+  uint32_t frame_id;
+  uint64_t timestamp_eof;
+};
+static SafeQueue<ThumbnailSnapshot *> thumbnail_queue;
+
+static ThumbnailSnapshot *thumbnail_snapshot(const CameraBuf *b, int thumbnail_width, int thumbnail_height) {
+  auto snap = new ThumbnailSnapshot;
+  snap->width = thumbnail_width;
+  snap->height = thumbnail_height;
+  snap->frame_id = b->cur_frame_data.frame_id;
+  snap->timestamp_eof = b->cur_frame_data.timestamp_eof;
+
   // make the buffer big enough. jpeg_write_raw_data requires 16-pixels aligned height to be used.
-  std::unique_ptr<uint8[]> buf(new uint8_t[(thumbnail_width * ((thumbnail_height + 15) & ~15) * 3) / 2]);
-  uint8_t *y_plane = buf.get();
+  snap->buf.reset(new uint8_t[(thumbnail_width * ((thumbnail_height + 15) & ~15) * 3) / 2]);
+  uint8_t *y_plane = snap->buf.get();
   uint8_t *u_plane = y_plane + thumbnail_width * thumbnail_height;
   uint8_t *v_plane = u_plane + (thumbnail_width * thumbnail_height) / 4;
-  {
-    int result = libyuv::I420Scale(
-        b->cur_yuv_buf->y, b->rgb_width, b->cur_yuv_buf->u, b->rgb_width / 2, b->cur_yuv_buf->v, b->rgb_width / 2,
-        b->rgb_width, b->rgb_height,
-        y_plane, thumbnail_width, u_plane, thumbnail_width / 2, v_plane, thumbnail_width / 2,
-        thumbnail_width, thumbnail_height, libyuv::kFilterNone);
-    if (result != 0) {
-      LOGE("Generate YUV thumbnail failed.");
-      return {};
-    }
+
+  int result = libyuv::I420Scale(
+      b->cur_yuv_buf->y, b->rgb_width, b->cur_yuv_buf->u, b->rgb_width / 2, b->cur_yuv_buf->v, b->rgb_width / 2,
+      b->rgb_width, b->rgb_height,
+      y_plane, thumbnail_width, u_plane, thumbnail_width / 2, v_plane, thumbnail_width / 2,
+      thumbnail_width, thumbnail_height, libyuv::kFilterNone);
+  if (result != 0) {
+    LOGE("Generate YUV thumbnail failed.");
+    delete snap;
+    return nullptr;
   }
+  return snap;
+}
+
+static kj::Array<capnp::byte> yuv420_to_jpeg(const ThumbnailSnapshot *snap) {
+  const int thumbnail_width = snap->width;
+  const int thumbnail_height = snap->height;
+  uint8_t *y_plane = snap->buf.get();
+  uint8_t *u_plane = y_plane + thumbnail_width * thumbnail_height;
+  uint8_t *v_plane = u_plane + (thumbnail_width * thumbnail_height) / 4;
 
   struct jpeg_compress_struct cinfo;
   struct jpeg_error_mgr jerr;
@@ -301,34 +526,75 @@ static kj::Array<capnp::byte> yuv420_to_jpeg(const CameraBuf *b, int thumbnail_w
   return dat;
 }
 
-static void publish_thumbnail(PubMaster *pm, const CameraBuf *b) {
-  auto thumbnail = yuv420_to_jpeg(b, b->rgb_width / 4, b->rgb_height / 4);
-  if (thumbnail.size() == 0) return;
+extern ExitHandler do_exit;
 
-  MessageBuilder msg;
-  auto thumbnaild = msg.initEvent().initThumbnail();
-  thumbnaild.setFrameId(b->cur_frame_data.frame_id);
-  thumbnaild.setTimestampEof(b->cur_frame_data.timestamp_eof);
-  thumbnaild.setThumbnail(thumbnail);
+static void thumbnail_thread() {
+  set_thread_name("Thumbnail");
+  PubMaster pm({"thumbnail"});
+
+  while (!do_exit) {
+    ThumbnailSnapshot *snap;
+    if (!thumbnail_queue.try_pop(snap, 100)) continue;
+
+    auto thumbnail = yuv420_to_jpeg(snap);
+    if (thumbnail.size() > 0) {
+      MessageBuilder msg;
+      auto thumbnaild = msg.initEvent().initThumbnail();
+      thumbnaild.setFrameId(snap->frame_id);
+      thumbnaild.setTimestampEof(snap->timestamp_eof);
+      thumbnaild.setThumbnail(thumbnail);
+      pm.send("thumbnail", msg);
+    }
+    delete snap;
+  }
+}
 
-  pm->send("thumbnail", msg);
+static void queue_thumbnail(const CameraBuf *b) {
+  // triple-buffer bound: drop this interval if the worker is backed up
+  if (thumbnail_queue.size() >= 3) return;
+
+  ThumbnailSnapshot *snap = thumbnail_snapshot(b, b->rgb_width / 4, b->rgb_height / 4);
+  if (snap) thumbnail_queue.push(snap);
 }
 
-float set_exposure_target(const CameraBuf *b, int x_start, int x_end, int x_skip, int y_start, int y_end, int y_skip) {
+float set_exposure_target(CameraBuf *b, int x_start, int x_end, int x_skip, int y_start, int y_end, int y_skip) {
   int lum_med;
   uint32_t lum_binning[256] = {0};
-  const uint8_t *pix_ptr = b->cur_yuv_buf->y;
 
   unsigned int lum_total = 0;
-  for (int y = y_start; y < y_end; y += y_skip) {
-    for (int x = x_start; x < x_end; x += x_skip) {
-      uint8_t lum = pix_ptr[(y * b->rgb_width) + x];
-      lum_binning[lum]++;
-      lum_total += 1;
+  if (b->ae_hist && b->cur_yuv_buf->buf_cl) {
+    // Y plane is at offset 0 of the packed YUV buffer
+    b->ae_hist->run(b->q, b->cur_yuv_buf->buf_cl, b->rgb_width,
+                    x_start, x_end, x_skip, y_start, y_end, y_skip, lum_binning);
+    for (int i = 0; i < 256; i++) {
+      lum_total += lum_binning[i];
+    }
+  } else {
+    const uint8_t *pix_ptr = b->cur_yuv_buf->y;
+    for (int y = y_start; y < y_end; y += y_skip) {
+      for (int x = x_start; x < x_end; x += x_skip) {
+        uint8_t lum = pix_ptr[(y * b->rgb_width) + x];
+        lum_binning[lum]++;
+        lum_total += 1;
+      }
     }
   }
 
 
+  // scene-change statistic for the encoder bitrate ladder: L1 distance
+  // between this frame's normalized luminance histogram and the previous one
+  if (lum_total > 0) {
+    if (b->ae_lum_prev_total > 0) {
+      float change = 0.;
+      for (int i = 0; i < 256; i++) {
+        change += fabsf((float)lum_binning[i] / lum_total - (float)b->ae_lum_prev[i] / b->ae_lum_prev_total);
+      }
+      b->scene_change = change;
+    }
+    memcpy(b->ae_lum_prev, lum_binning, sizeof(lum_binning));
+    b->ae_lum_prev_total = lum_total;
+  }
+
   // Find mean lumimance value
   unsigned int lum_cur = 0;
   for (lum_med = 255; lum_med >= 0; lum_med--) {
@@ -342,8 +608,6 @@ float set_exposure_target(const CameraBuf *b, int x_start, int x_end, int x_skip
   return lum_med / 256.0;
 }
 
-extern ExitHandler do_exit;
-
 void *processing_thread(MultiCameraState *cameras, CameraState *cs, process_thread_cb callback) {
   const char *thread_name = nullptr;
   if (cs == &cameras->road_cam) {
@@ -355,6 +619,16 @@ void *processing_thread(MultiCameraState *cameras, CameraState *cs, process_thre
   }
   set_thread_name(thread_name);
 
+  if (!Hardware::PC()) {
+    int ret = set_core_affinity(camerad_topology().frame_thread_cores);
+    assert(ret == 0 || Params().getBool("IsOffroad")); // failure ok while offroad due to offlining cores
+  }
+
+  std::thread thumbnail_worker;
+  if (cs == &cameras->road_cam) {
+    thumbnail_worker = std::thread(thumbnail_thread);
+  }
+
   uint32_t cnt = 0;
   while (!do_exit) {
     if (!cs->buf.acquire()) continue;
@@ -362,12 +636,14 @@ void *processing_thread(MultiCameraState *cameras, CameraState *cs, process_thre
     callback(cameras, cs, cnt);
 
     if (cs == &(cameras->road_cam) && cameras->pm && cnt % 100 == 3) {
-      // this takes 10ms???
-      publish_thumbnail(cameras->pm, &(cs->buf));
+      // jpeg encoding happens on the thumbnail worker
+      queue_thumbnail(&(cs->buf));
     }
     cs->buf.release();
     ++cnt;
   }
+
+  if (thumbnail_worker.joinable()) thumbnail_worker.join();
   return NULL;
 }
 
@@ -378,7 +654,7 @@ std::thread start_process_thread(MultiCameraState *cameras, CameraState *cs, pro
 static void driver_cam_auto_exposure(CameraState *c, SubMaster &sm) {
   static const bool is_rhd = Params().getBool("IsRHD");
   struct ExpRect {int x1, x2, x_skip, y1, y2, y_skip;};
-  const CameraBuf *b = &c->buf;
+  CameraBuf *b = &c->buf;
 
   int x_offset = 0, y_offset = 0;
   int frame_width = b->rgb_width, frame_height = b->rgb_height;
@@ -420,6 +696,7 @@ void common_process_driver_camera(SubMaster *sm, PubMaster *pm, CameraState *c,
   auto framed = msg.initEvent().initDriverCameraState();
   framed.setFrameType(cereal::FrameData::FrameType::FRONT);
   fill_frame_data(framed, c->buf.cur_frame_data);
+  framed.setSceneChange(c->buf.scene_change);
   if (env_send_driver) {
     framed.setImage(get_frame_image(&c->buf));
   }
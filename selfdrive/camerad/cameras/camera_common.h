@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstdlib>
+#include <map>
 #include <memory>
 #include <thread>
 
@@ -10,7 +12,9 @@
 #include "cereal/visionipc/visionipc.h"
 #include "cereal/visionipc/visionipc_server.h"
 #include "selfdrive/camerad/transforms/rgb_to_yuv.h"
+#include "selfdrive/modeld/transforms/transform.h"
 #include "selfdrive/common/mat.h"
+#include "selfdrive/common/metrics.h"
 #include "selfdrive/common/queue.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/visionimg.h"
@@ -28,6 +32,11 @@
 
 #define UI_BUF_COUNT 4
 
+// fused model tile output; matches MODEL_WIDTH/MODEL_HEIGHT in
+// selfdrive/modeld/models/commonmodel.h
+#define MODEL_TILE_WIDTH 512
+#define MODEL_TILE_HEIGHT 256
+
 enum CameraType {
   RoadCam = 0,
   DriverCam,
@@ -37,6 +46,7 @@ enum CameraType {
 const bool env_send_driver = getenv("SEND_DRIVER") != NULL;
 const bool env_send_road = getenv("SEND_ROAD") != NULL;
 const bool env_send_wide_road = getenv("SEND_WIDE_ROAD") != NULL;
+const bool env_model_tile = getenv("CAMERAD_MODEL_TILE") != NULL;
 
 typedef void (*release_cb)(void *cookie, int buf_idx);
 
@@ -69,6 +79,9 @@ typedef struct FrameMetadata {
   uint32_t frame_id;
   unsigned int frame_length;
 
+  // Cumulative drops for droppable vision clients, sampled at send time
+  unsigned int frames_dropped;
+
   // Timestamps
   uint64_t timestamp_sof; // only set on tici
   uint64_t timestamp_eof;
@@ -95,6 +108,7 @@ typedef struct CameraExpInfo {
 struct MultiCameraState;
 struct CameraState;
 class Debayer;
+class AeHistogram;
 
 class CameraBuf {
 private:
@@ -107,16 +121,36 @@ private:
 
   int cur_buf_idx;
 
-  SafeQueue<int> safe_queue;
+  // frame handoff from the (realtime) camera thread to the processing
+  // thread; lock-free so the producer never blocks on the consumer
+  SPSCQueue<int> safe_queue;
 
   int frame_buf_count;
   release_cb release_callback;
 
+  // fused model tile: warp the device-resident YUV output into the
+  // model-input crop on the same command queue as the debayer pass
+  bool model_tile_enabled = false;
+  Transform model_warp = {};
+  mat3 model_warp_mat = {};
+  bool model_warp_valid = false;
+  std::unique_ptr<SubMaster> calib_sm;
+  std::map<VisionBuf *, std::array<cl_mem, 3>> model_tile_planes;
+  cl_mem *tile_planes(VisionBuf *buf);
+
 public:
   cl_command_queue q;
+  AeHistogram *ae_hist = nullptr;  // used by set_exposure_target; null in CPU-only tests
+  // scene-change statistic from consecutive AE histograms, for encoder rate control
+  float scene_change = 0.;
+  uint32_t ae_lum_prev[256] = {};
+  unsigned int ae_lum_prev_total = 0;
+  MetricSlot *drops_metric = nullptr;
+  uint64_t last_drop_count = 0;
   FrameMetadata cur_frame_data;
   VisionBuf *cur_rgb_buf;
   VisionBuf *cur_yuv_buf;
+  VisionBuf *cur_model_buf = nullptr;
   std::unique_ptr<VisionBuf[]> camera_bufs;
   std::unique_ptr<FrameMetadata[]> camera_bufs_metadata;
   int rgb_width, rgb_height, rgb_stride;
@@ -135,8 +169,9 @@ typedef void (*process_thread_cb)(MultiCameraState *s, CameraState *c, int cnt);
 
 void fill_frame_data(cereal::FrameData::Builder &framed, const FrameMetadata &frame_data);
 kj::Array<uint8_t> get_frame_image(const CameraBuf *b);
-float set_exposure_target(const CameraBuf *b, int x_start, int x_end, int x_skip, int y_start, int y_end, int y_skip);
+float set_exposure_target(CameraBuf *b, int x_start, int x_end, int x_skip, int y_start, int y_end, int y_skip);
 std::thread start_process_thread(MultiCameraState *cameras, CameraState *cs, process_thread_cb callback);
+void camerad_steer_irqs();
 void common_process_driver_camera(SubMaster *sm, PubMaster *pm, CameraState *c, int cnt);
 
 void cameras_init(VisionIpcServer *v, MultiCameraState *s, cl_device_id device_id, cl_context ctx);
@@ -6,6 +6,8 @@
 #include <capnp/dynamic.h>
 
 #include "cereal/messaging/messaging.h"
+#include "selfdrive/camerad/cameras/sim_stream.h"
+#include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 
 #define FRAME_WIDTH 1164
@@ -47,14 +49,22 @@ void camera_init(VisionIpcServer * v, CameraState *s, int camera_id, unsigned in
 void run_frame_stream(CameraState &camera, const char* frame_pkt) {
   SubMaster sm({frame_pkt});
 
+  // export the shared-memory slots for bridges that skip the msgq image copy
+  const uint32_t frame_size = FRAME_WIDTH * FRAME_HEIGHT * 3 / 2;
+  SimStreamHeader *shm = sim_stream_create(FRAME_BUF_COUNT, FRAME_WIDTH, FRAME_HEIGHT, frame_size);
+  if (shm == nullptr) {
+    LOGW("sim frame shm unavailable, inline images only");
+  }
+
   size_t buf_idx = 0;
   while (!do_exit) {
     sm.update(1000);
     if(sm.updated(frame_pkt)) {
       auto msg = static_cast<capnp::DynamicStruct::Reader>(sm[frame_pkt]);
       auto frame = msg.get(frame_pkt).as<capnp::DynamicStruct>();
+      const uint32_t frame_id = frame.get("frameId").as<uint32_t>();
       camera.buf.camera_bufs_metadata[buf_idx] = {
-        .frame_id = frame.get("frameId").as<uint32_t>(),
+        .frame_id = frame_id,
         .timestamp_eof = frame.get("timestampEof").as<uint64_t>(),
         .timestamp_sof = frame.get("timestampSof").as<uint64_t>(),
       };
@@ -63,7 +73,22 @@ void run_frame_stream(CameraState &camera, const char* frame_pkt) {
       cl_mem yuv_cl = camera.buf.camera_bufs[buf_idx].buf_cl;
 
       auto image = frame.get("image").as<capnp::Data>();
-      clEnqueueWriteBuffer(q, yuv_cl, CL_TRUE, 0, image.size(), image.begin(), 0, NULL, NULL);
+      if (image.size() > 0) {
+        clEnqueueWriteBuffer(q, yuv_cl, CL_TRUE, 0, image.size(), image.begin(), 0, NULL, NULL);
+      } else if (shm != nullptr) {
+        // metadata-only message: the pixels are already in the shared slot
+        SimFrameMeta &meta = shm->metas[frame_id % shm->buf_count];
+        if (meta.seq.load(std::memory_order_acquire) != (uint64_t)frame_id + 1) {
+          continue;  // not written yet, or already recycled
+        }
+        clEnqueueWriteBuffer(q, yuv_cl, CL_TRUE, 0, frame_size,
+                             sim_stream_frame(shm, frame_id % shm->buf_count), 0, NULL, NULL);
+        if (meta.seq.load(std::memory_order_acquire) != (uint64_t)frame_id + 1) {
+          continue;  // overwritten mid-read, drop the torn frame
+        }
+      } else {
+        continue;
+      }
       camera.buf.queue(buf_idx);
       buf_idx = (buf_idx + 1) % FRAME_BUF_COUNT;
     }
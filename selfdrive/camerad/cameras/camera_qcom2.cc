@@ -9,6 +9,7 @@
 #include <atomic>
 #include <cassert>
 #include <cerrno>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
@@ -900,6 +901,11 @@ void handle_camera_event(CameraState *s, void *evdat) {
   }
 }
 
+static float camera_cur_ev(CameraState *s) {
+  std::lock_guard lk(s->exp_lock);
+  return s->cur_ev[s->buf.cur_frame_data.frame_id % 3];
+}
+
 static void set_camera_exposure(CameraState *s, float grey_frac) {
   const float dt = 0.05;
 
@@ -984,23 +990,56 @@ static void set_camera_exposure(CameraState *s, float grey_frac) {
 
   s->exp_lock.unlock();
 
-  // Processing a frame takes right about 50ms, so we need to wait a few ms
-  // so we don't send i2c commands around the frame start.
-  int ms = (nanos_since_boot() - s->buf.cur_frame_data.timestamp_sof) / 1000000;
-  if (ms < 60) {
-    util::sleep_for(60 - ms);
+  // The blocking i2c transaction (and the wait to steer it away from the
+  // frame start) happens on ae_i2c_thread; here we only queue the registers.
+  uint16_t analog_gain_reg = 0xFF00 | (new_g << 4) | new_g;
+  {
+    std::lock_guard lk(s->i2c_lock);
+    s->i2c_pending[0] = {0x3366, analog_gain_reg};
+    s->i2c_pending[1] = {0x3362, (uint16_t)(s->dc_gain_enabled ? 0x1 : 0x0)};
+    s->i2c_pending[2] = {0x3012, (uint16_t)s->exposure_time};
+    s->i2c_pending_len = 3;
+    s->i2c_pending_sof = s->buf.cur_frame_data.timestamp_sof;
   }
-  // LOGE("ae - camera %d, cur_t %.5f, sof %.5f, dt %.5f", s->camera_num, 1e-9 * nanos_since_boot(), 1e-9 * s->buf.cur_frame_data.timestamp_sof, 1e-9 * (nanos_since_boot() - s->buf.cur_frame_data.timestamp_sof));
+  s->i2c_cv.notify_one();
+}
 
-  uint16_t analog_gain_reg = 0xFF00 | (new_g << 4) | new_g;
-  struct i2c_random_wr_payload exp_reg_array[] = {
-                                                  {0x3366, analog_gain_reg},
-                                                  {0x3362, (uint16_t)(s->dc_gain_enabled ? 0x1 : 0x0)},
-                                                  {0x3012, (uint16_t)s->exposure_time},
-                                                };
-  sensors_i2c(s, exp_reg_array, sizeof(exp_reg_array)/sizeof(struct i2c_random_wr_payload),
-              CAM_SENSOR_PACKET_OPCODE_SENSOR_CONFIG);
+// Performs the queued exposure i2c transactions off the frame-processing
+// path, batched into one transfer per register set. Contention on the i2c
+// bus (e.g. sensord polling the magnetometer) then stalls this thread, not
+// frame processing.
+static void ae_i2c_thread(CameraState *s) {
+  set_thread_name("camerad_ae_i2c");
+
+  while (!do_exit) {
+    struct i2c_random_wr_payload regs[std::size(s->i2c_pending)];
+    int len;
+    uint64_t sof;
+    {
+      std::unique_lock lk(s->i2c_lock);
+      if (!s->i2c_cv.wait_for(lk, std::chrono::milliseconds(100), [&] { return s->i2c_pending_len > 0; })) {
+        continue;
+      }
+      len = s->i2c_pending_len;
+      sof = s->i2c_pending_sof;
+      memcpy(regs, s->i2c_pending, sizeof(regs));
+      s->i2c_pending_len = 0;
+    }
 
+    // Processing a frame takes right about 50ms, so we need to wait a few ms
+    // so we don't send i2c commands around the frame start.
+    int ms = (nanos_since_boot() - sof) / 1000000;
+    if (ms < 60) {
+      util::sleep_for(60 - ms);
+    }
+
+    // a set queued while we waited supersedes this one
+    {
+      std::lock_guard lk(s->i2c_lock);
+      if (s->i2c_pending_len > 0) continue;
+    }
+    sensors_i2c(s, regs, len, CAM_SENSOR_PACKET_OPCODE_SENSOR_CONFIG);
+  }
 }
 
 void camera_autoexposure(CameraState *s, float grey_frac) {
@@ -1014,11 +1053,12 @@ void process_driver_camera(MultiCameraState *s, CameraState *c, int cnt) {
 
 // called by processing_thread
 void process_road_camera(MultiCameraState *s, CameraState *c, int cnt) {
-  const CameraBuf *b = &c->buf;
+  CameraBuf *b = &c->buf;
 
   MessageBuilder msg;
   auto framed = c == &s->road_cam ? msg.initEvent().initRoadCameraState() : msg.initEvent().initWideRoadCameraState();
   fill_frame_data(framed, b->cur_frame_data);
+  framed.setSceneChange(b->scene_change);
   if ((c == &s->road_cam && env_send_road) || (c == &s->wide_road_cam && env_send_wide_road)) {
     framed.setImage(get_frame_image(b));
   }
@@ -1029,7 +1069,31 @@ void process_road_camera(MultiCameraState *s, CameraState *c, int cnt) {
 
   const auto [x, y, w, h] = (c == &s->wide_road_cam) ? std::tuple(96, 250, 1734, 524) : std::tuple(96, 160, 1734, 986);
   const int skip = 2;
-  camera_autoexposure(c, set_exposure_target(b, x, x + w, skip, y, y + h, skip));
+  const float grey_frac = set_exposure_target(b, x, x + w, skip, y, y + h, skip);
+
+  // The road and wide cameras see the same scene through different optics, so
+  // their histograms are fused into one brightness estimate (grey fraction per
+  // unit EV) and both exposures are computed from it in one step. The road
+  // thread leads and sends both sensors' register writes back to back; the
+  // wide thread only deposits its measurement. A single estimate keeps the two
+  // cameras from chasing each other out of a tunnel exit.
+  const bool is_wide = (c == &s->wide_road_cam);
+  {
+    std::lock_guard lk(s->scene_lock);
+    s->scene_brightness[is_wide] = grey_frac / std::max(camera_cur_ev(c), 1e-6f);
+  }
+  if (!is_wide) {
+    float brightness;
+    {
+      std::lock_guard lk(s->scene_lock);
+      // the wide lens saturates earlier, so its estimate gets less weight
+      brightness = (s->scene_brightness[1] > 0.0f) ?
+                   0.7f * s->scene_brightness[0] + 0.3f * s->scene_brightness[1] : s->scene_brightness[0];
+    }
+    for (CameraState *cs : {&s->road_cam, &s->wide_road_cam}) {
+      camera_autoexposure(cs, brightness * camera_cur_ev(cs));
+    }
+  }
 }
 
 void cameras_run(MultiCameraState *s) {
@@ -1038,6 +1102,9 @@ void cameras_run(MultiCameraState *s) {
   threads.push_back(start_process_thread(s, &s->road_cam, process_road_camera));
   threads.push_back(start_process_thread(s, &s->driver_cam, process_driver_camera));
   threads.push_back(start_process_thread(s, &s->wide_road_cam, process_road_camera));
+  threads.push_back(std::thread(ae_i2c_thread, &s->road_cam));
+  threads.push_back(std::thread(ae_i2c_thread, &s->driver_cam));
+  threads.push_back(std::thread(ae_i2c_thread, &s->wide_road_cam));
 
   // start devices
   LOG("-- Starting devices");
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
 
 #include <media/cam_req_mgr.h>
+#include <media/cam_sensor.h>
 
 #include "selfdrive/camerad/cameras/camera_common.h"
 #include "selfdrive/common/util.h"
@@ -26,6 +29,16 @@ typedef struct CameraState {
   float target_grey_fraction;
   int gain_idx;
 
+  // async exposure i2c: the frame path only computes and enqueues the
+  // register set; ae_i2c_thread performs the transaction off the frame path.
+  // A newly queued set supersedes an unsent one, so the sensor always gets
+  // the latest exposure and the queue never grows.
+  std::mutex i2c_lock;
+  std::condition_variable i2c_cv;
+  struct i2c_random_wr_payload i2c_pending[4];
+  int i2c_pending_len = 0;  // 0 = nothing queued
+  uint64_t i2c_pending_sof = 0;
+
   unique_fd sensor_fd;
   unique_fd csiphy_fd;
 
@@ -62,6 +75,10 @@ typedef struct MultiCameraState {
   CameraState wide_road_cam;
   CameraState driver_cam;
 
+  // scene brightness shared between the road and wide AE, see process_road_camera
+  std::mutex scene_lock;
+  float scene_brightness[2];  // measured grey fraction per unit EV, [road, wide]
+
   SubMaster *sm;
   PubMaster *pm;
 } MultiCameraState;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+
+// Shared-memory frame ingestion for the simulator camera bridge, so the sim
+// hands camerad full frames without serializing them through msgq. camerad
+// creates /dev/shm/op_sim_frames (same magic-written-last shared-table
+// pattern as the trace and flight rings); the bridge maps it and writes YUV
+// frames into slots, while the existing roadCameraState message stays as the
+// control channel carrying only metadata (an empty image field selects the
+// shared-memory path, so older bridges keep working unchanged).
+//
+// writer contract, per frame:
+//   slot = frame_id % buf_count
+//   slot meta seq = 0 (claim), copy pixels, fill meta, seq = frame_id + 1
+//   (release), then publish the metadata-only message
+// the reader checks seq before and after the pixel copy and drops frames
+// that were overwritten mid-read.
+
+constexpr uint32_t SIM_STREAM_MAGIC = 0x304d4953;  // "SIM0"
+
+struct SimFrameMeta {
+  std::atomic<uint64_t> seq;  // frame_id + 1; 0 = slot claimed or never used
+  uint32_t frame_id;
+  uint32_t pad;
+  uint64_t timestamp_sof;
+  uint64_t timestamp_eof;
+};
+
+struct SimStreamHeader {
+  uint32_t magic;
+  uint32_t buf_count;
+  uint32_t width;
+  uint32_t height;
+  uint32_t frame_size;  // bytes per slot
+  uint32_t pad;
+  // metas[buf_count], then buf_count frames of frame_size bytes each
+  SimFrameMeta metas[0];
+};
+
+inline uint8_t *sim_stream_frame(SimStreamHeader *h, size_t idx) {
+  return (uint8_t *)&h->metas[h->buf_count] + idx * h->frame_size;
+}
+
+inline size_t sim_stream_size(uint32_t buf_count, uint32_t frame_size) {
+  return sizeof(SimStreamHeader) + buf_count * (sizeof(SimFrameMeta) + (size_t)frame_size);
+}
+
+// reader side: create (or re-create) the region for the bridge to map
+inline SimStreamHeader *sim_stream_create(uint32_t buf_count, uint32_t width, uint32_t height, uint32_t frame_size) {
+  const size_t sz = sim_stream_size(buf_count, frame_size);
+  int fd = open("/dev/shm/op_sim_frames", O_RDWR | O_CREAT, 0664);
+  if (fd < 0) return nullptr;
+  if (ftruncate(fd, sz) < 0) {
+    close(fd);
+    return nullptr;
+  }
+  SimStreamHeader *h = (SimStreamHeader *)mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (h == MAP_FAILED) return nullptr;
+
+  h->buf_count = buf_count;
+  h->width = width;
+  h->height = height;
+  h->frame_size = frame_size;
+  for (uint32_t i = 0; i < buf_count; i++) {
+    h->metas[i].seq.store(0, std::memory_order_relaxed);
+  }
+  // magic last, so the writer never maps a half-initialized header
+  h->magic = SIM_STREAM_MAGIC;
+  return h;
+}
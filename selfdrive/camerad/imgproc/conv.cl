@@ -1,25 +1,34 @@
 // const __constant float3 rgb_weights = (0.299, 0.587, 0.114); // opencv rgb2gray weights
 // const __constant float3 bgr_weights = (0.114, 0.587, 0.299); // bgr2gray weights
 
-// convert input rgb image to single channel then conv
+// convert an ROI of the full strided rgb frame to single channel then conv;
+// the input stays device resident, only the ROI origin changes per call
 __kernel void rgb2gray_conv2d(
   const __global uchar * input,
   __global short * output,
   __constant short * filter,
-  __local uchar3 * cached
+  __local uchar3 * cached,
+  const int roi_x,
+  const int roi_y
 )
 {
+  // roi-local output index
   const int rowOffset = get_global_id(1) * IMAGE_W;
   const int my = get_global_id(0) + rowOffset;
 
+  // frame coordinates of this work item
+  const int gx = get_global_id(0) + roi_x;
+  const int gy = get_global_id(1) + roi_y;
+  #define IN_IDX(dx, dy) (((gy + (dy)) * RGB_STRIDE_PX + gx + (dx)) * 3)
+
   const int localRowLen = TWICE_HALF_FILTER_SIZE + get_local_size(0);
   const int localRowOffset = ( get_local_id(1) + HALF_FILTER_SIZE ) * localRowLen;
   const int myLocal = localRowOffset + get_local_id(0) + HALF_FILTER_SIZE;
 
   // cache local pixels
-  cached[ myLocal ].x = input[ my * 3 ]; // r
-  cached[ myLocal ].y = input[ my * 3 + 1]; // g
-  cached[ myLocal ].z = input[ my * 3 + 2]; // b
+  cached[ myLocal ].x = input[ IN_IDX(0, 0) ]; // r
+  cached[ myLocal ].y = input[ IN_IDX(0, 0) + 1]; // g
+  cached[ myLocal ].z = input[ IN_IDX(0, 0) + 2]; // b
 
   // pad
   if (
@@ -43,44 +52,44 @@ __kernel void rgb2gray_conv2d(
       localColOffset = get_local_id(0);
       globalColOffset = -HALF_FILTER_SIZE;
 
-      cached[ localRowOffset + get_local_id(0) ].x = input[ my * 3 - HALF_FILTER_SIZE * 3 ];
-      cached[ localRowOffset + get_local_id(0) ].y = input[ my * 3 - HALF_FILTER_SIZE * 3 + 1];
-      cached[ localRowOffset + get_local_id(0) ].z = input[ my * 3 - HALF_FILTER_SIZE * 3 + 2];
+      cached[ localRowOffset + get_local_id(0) ].x = input[ IN_IDX(-HALF_FILTER_SIZE, 0) ];
+      cached[ localRowOffset + get_local_id(0) ].y = input[ IN_IDX(-HALF_FILTER_SIZE, 0) + 1];
+      cached[ localRowOffset + get_local_id(0) ].z = input[ IN_IDX(-HALF_FILTER_SIZE, 0) + 2];
     }
     else if ( get_local_id(0) >= get_local_size(0) - HALF_FILTER_SIZE )
     {
       localColOffset = get_local_id(0) + TWICE_HALF_FILTER_SIZE;
       globalColOffset = HALF_FILTER_SIZE;
 
-      cached[ myLocal + HALF_FILTER_SIZE ].x = input[ my * 3 + HALF_FILTER_SIZE * 3 ];
-      cached[ myLocal + HALF_FILTER_SIZE ].y = input[ my * 3 + HALF_FILTER_SIZE * 3 + 1];
-      cached[ myLocal + HALF_FILTER_SIZE ].z = input[ my * 3 + HALF_FILTER_SIZE * 3 + 2];
+      cached[ myLocal + HALF_FILTER_SIZE ].x = input[ IN_IDX(HALF_FILTER_SIZE, 0) ];
+      cached[ myLocal + HALF_FILTER_SIZE ].y = input[ IN_IDX(HALF_FILTER_SIZE, 0) + 1];
+      cached[ myLocal + HALF_FILTER_SIZE ].z = input[ IN_IDX(HALF_FILTER_SIZE, 0) + 2];
     }
 
 
     if ( get_local_id(1) < HALF_FILTER_SIZE )
     {
-      cached[ get_local_id(1) * localRowLen + get_local_id(0) + HALF_FILTER_SIZE ].x = input[ my * 3 - HALF_FILTER_SIZE_IMAGE_W * 3 ];
-      cached[ get_local_id(1) * localRowLen + get_local_id(0) + HALF_FILTER_SIZE ].y = input[ my * 3 - HALF_FILTER_SIZE_IMAGE_W * 3 + 1];
-      cached[ get_local_id(1) * localRowLen + get_local_id(0) + HALF_FILTER_SIZE ].z = input[ my * 3 - HALF_FILTER_SIZE_IMAGE_W * 3 + 2];
+      cached[ get_local_id(1) * localRowLen + get_local_id(0) + HALF_FILTER_SIZE ].x = input[ IN_IDX(0, -HALF_FILTER_SIZE) ];
+      cached[ get_local_id(1) * localRowLen + get_local_id(0) + HALF_FILTER_SIZE ].y = input[ IN_IDX(0, -HALF_FILTER_SIZE) + 1];
+      cached[ get_local_id(1) * localRowLen + get_local_id(0) + HALF_FILTER_SIZE ].z = input[ IN_IDX(0, -HALF_FILTER_SIZE) + 2];
       if (localColOffset > 0)
       {
-        cached[ get_local_id(1) * localRowLen + localColOffset ].x = input[ my * 3 - HALF_FILTER_SIZE_IMAGE_W * 3 + globalColOffset * 3];
-        cached[ get_local_id(1) * localRowLen + localColOffset ].y = input[ my * 3 - HALF_FILTER_SIZE_IMAGE_W * 3 + globalColOffset * 3 + 1];
-        cached[ get_local_id(1) * localRowLen + localColOffset ].z = input[ my * 3 - HALF_FILTER_SIZE_IMAGE_W * 3 + globalColOffset * 3 + 2];
+        cached[ get_local_id(1) * localRowLen + localColOffset ].x = input[ IN_IDX(globalColOffset, -HALF_FILTER_SIZE) ];
+        cached[ get_local_id(1) * localRowLen + localColOffset ].y = input[ IN_IDX(globalColOffset, -HALF_FILTER_SIZE) + 1];
+        cached[ get_local_id(1) * localRowLen + localColOffset ].z = input[ IN_IDX(globalColOffset, -HALF_FILTER_SIZE) + 2];
       }
     }
     else if ( get_local_id(1) >= get_local_size(1) -HALF_FILTER_SIZE )
     {
       int offset = ( get_local_id(1) + TWICE_HALF_FILTER_SIZE ) * localRowLen;
-      cached[ offset + get_local_id(0) + HALF_FILTER_SIZE ].x = input[ my * 3 + HALF_FILTER_SIZE_IMAGE_W * 3 ];
-      cached[ offset + get_local_id(0) + HALF_FILTER_SIZE ].y = input[ my * 3 + HALF_FILTER_SIZE_IMAGE_W * 3 + 1];
-      cached[ offset + get_local_id(0) + HALF_FILTER_SIZE ].z = input[ my * 3 + HALF_FILTER_SIZE_IMAGE_W * 3 + 2];
+      cached[ offset + get_local_id(0) + HALF_FILTER_SIZE ].x = input[ IN_IDX(0, HALF_FILTER_SIZE) ];
+      cached[ offset + get_local_id(0) + HALF_FILTER_SIZE ].y = input[ IN_IDX(0, HALF_FILTER_SIZE) + 1];
+      cached[ offset + get_local_id(0) + HALF_FILTER_SIZE ].z = input[ IN_IDX(0, HALF_FILTER_SIZE) + 2];
       if (localColOffset > 0)
       {
-        cached[ offset + localColOffset ].x = input[ my * 3 + HALF_FILTER_SIZE_IMAGE_W * 3 + globalColOffset * 3];
-        cached[ offset + localColOffset ].y = input[ my * 3 + HALF_FILTER_SIZE_IMAGE_W * 3 + globalColOffset * 3 + 1];
-        cached[ offset + localColOffset ].z = input[ my * 3 + HALF_FILTER_SIZE_IMAGE_W * 3 + globalColOffset * 3 + 2];
+        cached[ offset + localColOffset ].x = input[ IN_IDX(globalColOffset, HALF_FILTER_SIZE) ];
+        cached[ offset + localColOffset ].y = input[ IN_IDX(globalColOffset, HALF_FILTER_SIZE) + 1];
+        cached[ offset + localColOffset ].z = input[ IN_IDX(globalColOffset, HALF_FILTER_SIZE) + 2];
       }
     }
 
@@ -107,4 +116,4 @@ __kernel void rgb2gray_conv2d(
     }
     output[my] = sum;
   }
-}
\ No newline at end of file
+}
@@ -13,6 +13,7 @@
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
+#include "selfdrive/common/watchdog.h"
 #include "selfdrive/hardware/hw.h"
 
 #ifdef QCOM
@@ -36,6 +37,9 @@ void party(cl_device_id device_id, cl_context context) {
 
   vipc_server.start_listener();
 
+  // buffers are allocated and the server accepts: clients can connect now
+  process_set_ready("camerad");
+
   cameras_run(&cameras);
 }
 
@@ -50,6 +54,7 @@ int main(int argc, char *argv[]) {
     assert(ret == 0);
     ret = set_core_affinity({Hardware::EON() ? 2 : 6});
     assert(ret == 0 || Params().getBool("IsOffroad")); // failure ok while offroad due to offlining cores
+    camerad_steer_irqs();
   }
 
   cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
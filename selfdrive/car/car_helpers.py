@@ -1,3 +1,4 @@
+import json
 import os
 from common.params import Params
 from common.basedir import BASEDIR
@@ -113,6 +114,20 @@ def fingerprint(logcan, sendcan):
   cloudlog.warning("VIN %s", vin)
   Params().put("CarVin", vin)
 
+  params = Params()
+
+  # the fingerprint confirmed on the last drive: boardd verifies it against
+  # live traffic in parallel with this loop, so a car that matches its cache
+  # skips the rest of the discovery window
+  cached_fingerprint = None
+  if not fixed_fingerprint:
+    try:
+      cached_fingerprint = json.loads(params.get("CachedFingerprint", encoding="utf8") or "null")
+    except json.JSONDecodeError:
+      cached_fingerprint = None
+    if cached_fingerprint is not None and cached_fingerprint.get("car") not in all_legacy_fingerprint_cars():
+      cached_fingerprint = None
+
   finger = gen_empty_fingerprint()
   candidate_cars = {i: all_legacy_fingerprint_cars() for i in [0, 1]}  # attempt fingerprint on both bus 0 and 1
   frame = 0
@@ -143,6 +158,15 @@ def fingerprint(logcan, sendcan):
         # fingerprint done
         car_fingerprint = candidate_cars[b][0]
 
+    # short-circuit on boardd's out-of-band confirmation of the cached
+    # fingerprint; the cached finger dict stands in for what we haven't seen yet
+    if car_fingerprint is None and cached_fingerprint is not None and (frame % 5 == 0):
+      if params.get("CachedFingerprintConfirmed") is not None:
+        cloudlog.warning("Using cached fingerprint confirmed by boardd")
+        car_fingerprint = cached_fingerprint["car"]
+        for src, msgs in cached_fingerprint["finger"].items():
+          finger.setdefault(int(src), {}).update({int(a): l for a, l in msgs.items()})
+
     # bail if no cars left or we've been waiting for more than 2s
     failed = (all(len(cc) == 0 for cc in candidate_cars.values()) and frame > frame_fingerprint) or frame > 200
     succeeded = car_fingerprint is not None
@@ -163,6 +187,10 @@ def fingerprint(logcan, sendcan):
     car_fingerprint = fixed_fingerprint
     source = car.CarParams.FingerprintSource.fixed
 
+  # refresh the cache so the next drive can confirm against live traffic
+  if car_fingerprint is not None and not fixed_fingerprint:
+    params.put("CachedFingerprint", json.dumps({"car": car_fingerprint, "finger": finger}))
+
   cloudlog.event("fingerprinted", car_fingerprint=car_fingerprint,
                  source=source, fuzzy=not exact_match, fw_count=len(car_fw))
   return car_fingerprint, finger, vin, car_fw, source, exact_match
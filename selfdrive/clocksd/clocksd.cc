@@ -33,7 +33,12 @@ namespace {
 
 int main() {
   setpriority(PRIO_PROCESS, 0, -13);
-  PubMaster pm({"clocks"});
+  PubMaster pm({"clocks", "clockCorrelation"});
+
+  // boottime is the canonical log clock; track how the other clocks drift
+  // against it so consumers can convert foreign timestamps instead of
+  // re-deriving the mapping themselves
+  ClockCorrelator raw_corr, wall_corr;
 
 #ifndef __APPLE__
   int timerfd = timerfd_create(CLOCK_BOOTTIME, 0);
@@ -81,6 +86,22 @@ int main() {
 #endif
 
     pm.send("clocks", msg);
+
+    raw_corr.observe(monotonic_raw, boottime);
+    wall_corr.observe(wall_time, boottime);
+    if (raw_corr.valid() && wall_corr.valid()) {
+      auto fill = [](cereal::ClockCorrelation::Source::Builder s, const char *name, const ClockCorrelator &c) {
+        s.setName(name);
+        s.setOffsetNanos((int64_t)c.offset_ns());
+        s.setDriftPpb((float)c.drift_ppb());
+        s.setStdNanos((float)c.std_ns());
+      };
+      MessageBuilder cmsg;
+      auto sources = cmsg.initEvent().initClockCorrelation().initSources(2);
+      fill(sources[0], "monotonicRaw", raw_corr);
+      fill(sources[1], "wallTime", wall_corr);
+      pm.send("clockCorrelation", cmsg);
+    }
   }
 
 #ifndef __APPLE__
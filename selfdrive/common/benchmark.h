@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdio>
+
+#include "selfdrive/common/timing.h"
+
+// minimal self-timed benchmark loop. every run prints one JSON line
+// ({"name", "iterations", "ns_per_iter"}) so results from different bench
+// binaries can be collected and diffed with the same scripts.
+template <typename Fn>
+void benchmark_run(const char *name, int iterations, Fn fn) {
+  // one warmup pass so page faults and lazy init don't land in the measurement
+  fn();
+  const uint64_t start = nanos_since_boot();
+  for (int i = 0; i < iterations; ++i) {
+    fn();
+  }
+  const uint64_t elapsed = nanos_since_boot() - start;
+  printf("{\"name\": \"%s\", \"iterations\": %d, \"ns_per_iter\": %.1f}\n",
+         name, iterations, (double)elapsed / iterations);
+}
@@ -1,9 +1,16 @@
 #include "selfdrive/common/clutil.h"
 
+#include <sys/stat.h>
+
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
 
+#include "selfdrive/common/metrics.h"
 #include "selfdrive/common/util.h"
 
 namespace {  // helper functions
@@ -52,8 +59,69 @@ void cl_print_build_errors(cl_program program, cl_device_id device) {
   std::cout << "build failed; status=" << status << ", log:" << std::endl << log << std::endl; 
 }
 
+// cache compiled program binaries so warm boots skip the CL compiler
+std::string cl_cache_path(const std::string& src, const char* args, cl_device_id device_id) {
+  uint64_t hash = 0xcbf29ce484222325;  // FNV-1a
+  auto mix = [&hash](const std::string& s) {
+    for (char c : s) { hash = (hash ^ (uint8_t)c) * 0x100000001b3; }
+  };
+  mix(src);
+  if (args) mix(args);
+  mix(get_device_info(device_id, CL_DEVICE_NAME));
+  mix(get_device_info(device_id, CL_DRIVER_VERSION));
+
+  const char* dir = getenv("CL_CACHE_DIR");
+  if (dir == NULL) dir = "/tmp/clcache";
+  mkdir(dir, 0777);
+  return util::string_format("%s/%016lx.bin", dir, hash);
+}
+
+// GPU buffer pool
+std::mutex pool_lock;
+std::multimap<std::pair<cl_context, size_t>, cl_mem> pool_free;
+std::map<cl_mem, std::pair<cl_context, size_t>> pool_live;
+size_t pool_bytes = 0;
+size_t pool_high_water = 0;
+
+size_t pool_size_class(size_t size) {
+  size_t c = 256;
+  while (c < size) c <<= 1;
+  return c;
+}
+
 }  // namespace
 
+cl_mem cl_pool_alloc(cl_context ctx, size_t size) {
+  const size_t cls = pool_size_class(size);
+
+  std::lock_guard lk(pool_lock);
+  cl_mem mem;
+  if (auto it = pool_free.find({ctx, cls}); it != pool_free.end()) {
+    mem = it->second;
+    pool_free.erase(it);
+  } else {
+    mem = CL_CHECK_ERR(clCreateBuffer(ctx, CL_MEM_READ_WRITE, cls, NULL, &err));
+    pool_bytes += cls;
+    static MetricSlot *bytes_metric = metric_gauge("gpu_pool.bytes");
+    metric_set(bytes_metric, pool_bytes);
+    if (pool_bytes > pool_high_water) {
+      pool_high_water = pool_bytes;
+      static MetricSlot *hw_metric = metric_gauge("gpu_pool.high_water_bytes");
+      metric_set(hw_metric, pool_high_water);
+    }
+  }
+  pool_live[mem] = {ctx, cls};
+  return mem;
+}
+
+void cl_pool_release(cl_mem mem) {
+  std::lock_guard lk(pool_lock);
+  auto it = pool_live.find(mem);
+  assert(it != pool_live.end());
+  pool_free.insert({it->second, mem});
+  pool_live.erase(it);
+}
+
 cl_device_id cl_get_device_id(cl_device_type device_type) {
   cl_uint num_platforms = 0;
   CL_CHECK(clGetPlatformIDs(0, NULL, &num_platforms));
@@ -74,7 +142,30 @@ cl_device_id cl_get_device_id(cl_device_type device_type) {
 }
 
 cl_program cl_program_from_file(cl_context ctx, cl_device_id device_id, const char* path, const char* args) {
-  return cl_program_from_source(ctx, device_id, util::read_file(path), args);
+  const std::string src = util::read_file(path);
+  const std::string cache_path = cl_cache_path(src, args, device_id);
+
+  // a stale or foreign binary fails to load or build; fall back to the compiler
+  if (const std::string cached = util::read_file(cache_path); !cached.empty()) {
+    size_t length = cached.size();
+    cl_int err = 0;
+    cl_program prg = clCreateProgramWithBinary(ctx, 1, &device_id, &length, (const uint8_t*[]){(const uint8_t*)cached.data()}, NULL, &err);
+    if (err == 0 && clBuildProgram(prg, 1, &device_id, args, NULL, NULL) == 0) {
+      return prg;
+    }
+    if (prg != NULL) clReleaseProgram(prg);
+  }
+
+  cl_program prg = cl_program_from_source(ctx, device_id, src, args);
+
+  size_t binary_size = 0;
+  CL_CHECK(clGetProgramInfo(prg, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL));
+  if (binary_size > 0) {
+    std::string binary(binary_size, '\0');
+    CL_CHECK(clGetProgramInfo(prg, CL_PROGRAM_BINARIES, sizeof(uint8_t*), (uint8_t*[]){(uint8_t*)binary.data()}, NULL));
+    util::write_file(cache_path.c_str(), binary.data(), binary.size(), O_WRONLY | O_CREAT);
+  }
+  return prg;
 }
 
 cl_program cl_program_from_source(cl_context ctx, cl_device_id device_id, const std::string& src, const char* args) {
@@ -22,6 +22,18 @@
   })
 
 cl_device_id cl_get_device_id(cl_device_type device_type);
+
+// Process-wide pooled CL buffer allocation. Buffers are plain
+// CL_MEM_READ_WRITE device memory, rounded up to a power-of-two size class
+// and recycled through a per-(context, class) free list, so components that
+// re-create their buffer sets (model reloads, stream changes) reuse device
+// memory instead of fragmenting the GPU heap. Pool usage and its high-water
+// mark are reported on the metrics surface as gpu_pool.bytes /
+// gpu_pool.high_water_bytes. Host-pointer-backed buffers (CL_MEM_USE/
+// COPY_HOST_PTR) and ION-backed VisionBufs keep their own paths.
+cl_mem cl_pool_alloc(cl_context ctx, size_t size);
+void cl_pool_release(cl_mem mem);
+
 cl_program cl_program_from_source(cl_context ctx, cl_device_id device_id, const std::string& src, const char* args = nullptr);
 cl_program cl_program_from_binary(cl_context ctx, cl_device_id device_id, const uint8_t* binary, size_t length, const char* args = nullptr);
 cl_program cl_program_from_file(cl_context ctx, cl_device_id device_id, const char* path, const char* args);
@@ -1,9 +1,12 @@
 #include "selfdrive/common/gpio.h"
 
 #include <fcntl.h>
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
 
 #include <cstring>
+#include <string>
 
 #include "selfdrive/common/util.h"
 
@@ -30,3 +33,22 @@ int gpio_set(int pin_nr, bool high) {
   }
   return util::write_file(pin_val_path, (void*)(high ? "1" : "0"), 1);
 }
+
+int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochip_id, int pin_nr) {
+  std::string chip_path = "/dev/gpiochip" + std::to_string(gpiochip_id);
+  int fd = HANDLE_EINTR(open(chip_path.c_str(), O_RDONLY));
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct gpioevent_request rq;
+  memset(&rq, 0, sizeof(rq));
+  rq.lineoffset = pin_nr;
+  rq.handleflags = GPIOHANDLE_REQUEST_INPUT;
+  rq.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+  strncpy(rq.consumer_label, consumer_label, sizeof(rq.consumer_label) - 1);
+
+  int ret = HANDLE_EINTR(ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &rq));
+  close(fd);
+  return ret < 0 ? -1 : rq.fd;
+}
@@ -8,6 +8,7 @@
   #define GPIO_UBLOX_PWR_EN     34
   #define GPIO_STM_RST_N        124
   #define GPIO_STM_BOOT0        134
+  #define GPIO_LSM_INT          84
 #else
   #define GPIO_HUB_RST_N        0
   #define GPIO_UBLOX_RST_N      0
@@ -15,7 +16,14 @@
   #define GPIO_UBLOX_PWR_EN     0
   #define GPIO_STM_RST_N        0
   #define GPIO_STM_BOOT0        0
+  #define GPIO_LSM_INT          0
 #endif
 
 int gpio_init(int pin_nr, bool output);
 int gpio_set(int pin_nr, bool high);
+
+// Request an edge-triggered event fd for a pin through the gpiod character
+// device. The fd becomes readable (poll POLLIN) on each rising edge; each
+// read returns queued struct gpioevent_data records. Returns -1 when the
+// chip or line isn't available.
+int gpiochip_get_ro_value_fd(const char* consumer_label, int gpiochip_id, int pin_nr);
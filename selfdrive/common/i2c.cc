@@ -4,22 +4,19 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <stdexcept>
 
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/swaglog.h"
-#include "selfdrive/common/util.h"
 
 #define UNUSED(x) (void)(x)
 
 #ifdef QCOM2
-// TODO: decide if we want to isntall libi2c-dev everywhere
-extern "C" {
-  #include <linux/i2c-dev.h>
-  #include <i2c/smbus.h>
-}
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
 
 I2CBus::I2CBus(uint8_t bus_id) {
   char bus_name[20];
@@ -35,30 +32,41 @@ I2CBus::~I2CBus() {
   if(i2c_fd >= 0) { close(i2c_fd); }
 }
 
-int I2CBus::read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) {
-  int ret = 0;
-
-  ret = HANDLE_EINTR(ioctl(i2c_fd, I2C_SLAVE, device_address));
-  if(ret < 0) { goto fail; }
+// all accesses go through I2C_RDWR: the register-address write and the data
+// read are segments of one combined transaction, so each access costs one
+// syscall and one bus arbitration instead of two of each
 
-  ret = i2c_smbus_read_i2c_block_data(i2c_fd, register_address, len, buffer);
-  if((ret < 0) || (ret != len)) { goto fail; }
+int I2CBus::read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) {
+  I2CReadOp op = {register_address, buffer, len};
+  int ret = read_registers(device_address, &op, 1);
+  return ret < 0 ? ret : len;
+}
 
-fail:
-  return ret;
+int I2CBus::read_registers(uint8_t device_address, I2CReadOp *ops, int count) {
+  // each op is a write segment (register address) plus a read segment
+  constexpr int max_ops = I2C_RDWR_IOCTL_MAX_MSGS / 2;
+  for (int pos = 0; pos < count; pos += max_ops) {
+    const int n = std::min(count - pos, max_ops);
+    struct i2c_msg msgs[2 * max_ops];
+    uint8_t reg_addrs[max_ops];
+    for (int i = 0; i < n; i++) {
+      I2CReadOp &op = ops[pos + i];
+      reg_addrs[i] = op.register_address;
+      msgs[2*i] = {device_address, 0, 1, &reg_addrs[i]};
+      msgs[2*i + 1] = {device_address, I2C_M_RD, op.len, op.buffer};
+    }
+    struct i2c_rdwr_ioctl_data data = {msgs, (uint32_t)(2 * n)};
+    int ret = HANDLE_EINTR(ioctl(i2c_fd, I2C_RDWR, &data));
+    if(ret < 0) { return ret; }
+  }
+  return 0;
 }
 
 int I2CBus::set_register(uint8_t device_address, uint register_address, uint8_t data) {
-  int ret = 0;
-
-  ret = HANDLE_EINTR(ioctl(i2c_fd, I2C_SLAVE, device_address));
-  if(ret < 0) { goto fail; }
-
-  ret = i2c_smbus_write_byte_data(i2c_fd, register_address, data);
-  if(ret < 0) { goto fail; }
-
-fail:
-  return ret;
+  uint8_t buf[2] = {(uint8_t)register_address, data};
+  struct i2c_msg msg = {device_address, 0, sizeof(buf), buf};
+  struct i2c_rdwr_ioctl_data rdwr = {&msg, 1};
+  return HANDLE_EINTR(ioctl(i2c_fd, I2C_RDWR, &rdwr));
 }
 
 #else
@@ -78,6 +86,13 @@ int I2CBus::read_register(uint8_t device_address, uint register_address, uint8_t
   return -1;
 }
 
+int I2CBus::read_registers(uint8_t device_address, I2CReadOp *ops, int count) {
+  UNUSED(device_address);
+  UNUSED(ops);
+  UNUSED(count);
+  return -1;
+}
+
 int I2CBus::set_register(uint8_t device_address, uint register_address, uint8_t data) {
   UNUSED(device_address);
   UNUSED(register_address);
@@ -4,6 +4,13 @@
 
 #include <sys/types.h>
 
+// one register read within a batched transaction
+struct I2CReadOp {
+  uint register_address;
+  uint8_t *buffer;
+  uint8_t len;
+};
+
 class I2CBus {
   private:
     int i2c_fd;
@@ -13,5 +20,8 @@ class I2CBus {
     ~I2CBus();
 
     int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len);
+    // several register reads from one device in a single I2C_RDWR ioctl;
+    // the whole batch is one syscall and one bus arbitration
+    int read_registers(uint8_t device_address, I2CReadOp *ops, int count);
     int set_register(uint8_t device_address, uint register_address, uint8_t data);
 };
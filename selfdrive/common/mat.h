@@ -1,5 +1,9 @@
 #pragma once
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 typedef struct vec3 {
 	float v[3];
 } vec3;
@@ -40,6 +44,28 @@ static inline vec3 matvecmul3(const mat3 &a, const vec3 &b) {
   return ret;
 }
 
+// applies one mat3 to n points given as separate x/y/z arrays
+// (structure-of-arrays, matching how model outputs are stored). on ARM the
+// NEON path does four points per iteration; the single-shot 3x3 ops above
+// stay scalar since there is nothing to vectorize at that size.
+static inline void batch_matvecmul3(const mat3 &m, const float *x, const float *y, const float *z,
+                                    float *out_x, float *out_y, float *out_z, int n) {
+  int i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t vx = vld1q_f32(&x[i]), vy = vld1q_f32(&y[i]), vz = vld1q_f32(&z[i]);
+    vst1q_f32(&out_x[i], vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, m.v[0]), vy, m.v[1]), vz, m.v[2]));
+    vst1q_f32(&out_y[i], vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, m.v[3]), vy, m.v[4]), vz, m.v[5]));
+    vst1q_f32(&out_z[i], vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, m.v[6]), vy, m.v[7]), vz, m.v[8]));
+  }
+#endif
+  for (; i < n; i++) {
+    out_x[i] = m.v[0]*x[i] + m.v[1]*y[i] + m.v[2]*z[i];
+    out_y[i] = m.v[3]*x[i] + m.v[4]*y[i] + m.v[5]*z[i];
+    out_z[i] = m.v[6]*x[i] + m.v[7]*y[i] + m.v[8]*z[i];
+  }
+}
+
 static inline mat4 matmul(const mat4 &a, const mat4 &b) {
   mat4 ret = {{0.0}};
   for (int r=0; r<4; r++) {
@@ -0,0 +1,108 @@
+#include "selfdrive/common/metrics.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+static MetricsTable *metrics_table() {
+  static MetricsTable *table = [] () -> MetricsTable * {
+    std::string fn = "/dev/shm/op_metrics_" + std::to_string(getpid());
+    int fd = open(fn.c_str(), O_RDWR | O_CREAT, 0664);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, sizeof(MetricsTable)) < 0) {
+      close(fd);
+      return nullptr;
+    }
+    MetricsTable *t = (MetricsTable *)mmap(nullptr, sizeof(MetricsTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (t == MAP_FAILED) return nullptr;
+
+    t->pid = getpid();
+    char exe[256] = {};
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    const char *base = (n > 0 && strrchr(exe, '/')) ? strrchr(exe, '/') + 1 : exe;
+    strncpy(t->process_name, base, sizeof(t->process_name) - 1);
+    // magic last, so the collector never sees a half-initialized header
+    t->magic = METRICS_MAGIC;
+    return t;
+  }();
+  return table;
+}
+
+static MetricSlot *metric_register(const char *name, MetricType type) {
+  MetricsTable *t = metrics_table();
+  if (t == nullptr) return nullptr;
+
+  uint32_t idx = t->num_slots.fetch_add(1, std::memory_order_relaxed);
+  if (idx >= METRICS_MAX_SLOTS) return nullptr;
+
+  MetricSlot &slot = t->slots[idx];
+  strncpy(slot.name, name, sizeof(slot.name) - 1);
+  slot.name[sizeof(slot.name) - 1] = '\0';
+  // type last: the collector skips slots still reading METRIC_NONE
+  slot.type.store(type, std::memory_order_release);
+  return &slot;
+}
+
+MetricSlot *metric_counter(const char *name) { return metric_register(name, METRIC_COUNTER); }
+MetricSlot *metric_gauge(const char *name) { return metric_register(name, METRIC_GAUGE); }
+MetricSlot *metric_histogram(const char *name) { return metric_register(name, METRIC_HISTOGRAM); }
+
+std::vector<MetricsSnapshot> metrics_snapshot_all() {
+  std::vector<MetricsSnapshot> ret;
+
+  DIR *d = opendir("/dev/shm");
+  if (d == nullptr) return ret;
+
+  struct dirent *de;
+  while ((de = readdir(d)) != nullptr) {
+    if (strncmp(de->d_name, "op_metrics_", 11) != 0) continue;
+    int pid = atoi(de->d_name + 11);
+    std::string fn = std::string("/dev/shm/") + de->d_name;
+
+    if (pid <= 0 || (kill(pid, 0) < 0 && errno == ESRCH)) {
+      unlink(fn.c_str());
+      continue;
+    }
+
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0) continue;
+    MetricsTable *t = (MetricsTable *)mmap(nullptr, sizeof(MetricsTable), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (t == MAP_FAILED) continue;
+
+    if (t->magic == METRICS_MAGIC && t->pid == pid) {
+      MetricsSnapshot snap;
+      snap.pid = pid;
+      snap.process_name = std::string(t->process_name, strnlen(t->process_name, sizeof(t->process_name)));
+
+      uint32_t n = std::min(t->num_slots.load(std::memory_order_relaxed), (uint32_t)METRICS_MAX_SLOTS);
+      for (uint32_t i = 0; i < n; i++) {
+        const MetricSlot &slot = t->slots[i];
+        MetricType type = (MetricType)slot.type.load(std::memory_order_acquire);
+        if (type == METRIC_NONE) continue;  // registration in flight
+
+        MetricsEntry e;
+        e.name = std::string(slot.name, strnlen(slot.name, sizeof(slot.name)));
+        e.type = type;
+        e.count = slot.count.load(std::memory_order_relaxed);
+        e.value = slot.value.load(std::memory_order_relaxed);
+        for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+          e.buckets[b] = slot.buckets[b].load(std::memory_order_relaxed);
+        }
+        snap.entries.push_back(std::move(e));
+      }
+      ret.push_back(std::move(snap));
+    }
+    munmap(t, sizeof(MetricsTable));
+  }
+  closedir(d);
+  return ret;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// fixed-slot process metrics. each process registers counters/gauges/
+// histograms by string id at init and gets back a slot pointer; the hot
+// path is one relaxed atomic op on that slot, no locks and no strings.
+// slots live in a /dev/shm table (/dev/shm/op_metrics_<pid>, same pattern
+// as the trace ring and watchdog table) so proclogd can aggregate every
+// process into the 1Hz metrics message without any cooperation from the
+// instrumented code.
+
+constexpr uint32_t METRICS_MAGIC = 0x304d504f;  // "OPM0"
+constexpr int METRICS_MAX_SLOTS = 64;
+// log2 buckets: bucket i counts values in [2^i, 2^(i+1)); 0 lands in bucket 0
+constexpr int METRICS_HIST_BUCKETS = 32;
+
+enum MetricType : uint32_t {
+  METRIC_NONE = 0,  // zero-filled table reads as all slots free
+  METRIC_COUNTER,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM,
+};
+
+struct MetricSlot {
+  char name[32];
+  std::atomic<uint32_t> type;    // written last on registration
+  uint32_t pad;
+  std::atomic<uint64_t> count;   // counter total / histogram sample count
+  std::atomic<uint64_t> value;   // gauge (double bits) / histogram sum
+  std::atomic<uint64_t> buckets[METRICS_HIST_BUCKETS];
+};
+
+struct MetricsTable {
+  uint32_t magic;
+  int pid;
+  char process_name[16];
+  std::atomic<uint32_t> num_slots;
+  MetricSlot slots[METRICS_MAX_SLOTS];
+};
+
+// registration, init-time only. returns nullptr if the table can't be
+// mapped or is full; the hot-path ops below take nullptr as a no-op.
+MetricSlot *metric_counter(const char *name);
+MetricSlot *metric_gauge(const char *name);
+MetricSlot *metric_histogram(const char *name);
+
+inline void metric_add(MetricSlot *m, uint64_t n = 1) {
+  if (m) m->count.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void metric_set(MetricSlot *m, double v) {
+  if (m) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    m->value.store(bits, std::memory_order_relaxed);
+  }
+}
+
+inline void metric_observe(MetricSlot *m, uint64_t v) {
+  if (m) {
+    int b = 63 - __builtin_clzll(v | 1);
+    if (b >= METRICS_HIST_BUCKETS) b = METRICS_HIST_BUCKETS - 1;
+    m->buckets[b].fetch_add(1, std::memory_order_relaxed);
+    m->value.fetch_add(v, std::memory_order_relaxed);
+    m->count.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// collector side: plain copies of every live process's table, so the
+// publisher doesn't need to know the shm layout stays mapped. tables of
+// dead pids are unlinked during the scan.
+struct MetricsEntry {
+  std::string name;
+  MetricType type;
+  uint64_t count;
+  uint64_t value;
+  uint64_t buckets[METRICS_HIST_BUCKETS];
+};
+
+struct MetricsSnapshot {
+  int pid;
+  std::string process_name;
+  std::vector<MetricsEntry> entries;
+};
+
+std::vector<MetricsSnapshot> metrics_snapshot_all();
@@ -2,10 +2,19 @@
 
 #include <dirent.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+#include <atomic>
 #include <csignal>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "selfdrive/common/queue.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
@@ -82,6 +91,56 @@ private:
   int fd_ = -1;
 };
 
+// background writer for putAsync: drains everything queued since the last
+// wakeup into a single putBatch per params path, so a settings panel writing
+// 10+ keys pays for one directory fsync instead of ten
+class AsyncWriter {
+public:
+  struct Write {
+    std::string path, key, value;
+  };
+
+  ~AsyncWriter() {
+    if (thread_.joinable()) {
+      queue_.push({});  // empty path = exit
+      thread_.join();
+    }
+  }
+
+  void queue(Write &&w) {
+    {
+      std::lock_guard lk(lock_);
+      if (!thread_.joinable()) {
+        thread_ = std::thread(&AsyncWriter::write_thread, this);
+      }
+    }
+    queue_.push(std::move(w));
+  }
+
+private:
+  void write_thread() {
+    bool exit = false;
+    while (!exit) {
+      Write w = queue_.pop();
+      std::map<std::string, std::map<std::string, std::string>> batches;
+      do {
+        if (w.path.empty()) {
+          exit = true;
+        } else {
+          batches[w.path][w.key] = std::move(w.value);  // later writes win
+        }
+      } while (queue_.try_pop(w));
+      for (const auto &[path, items] : batches) {
+        Params(path).putBatch(items);
+      }
+    }
+  }
+
+  std::mutex lock_;
+  std::thread thread_;
+  SafeQueue<Write> queue_;
+};
+
 std::unordered_map<std::string, uint32_t> keys = {
     {"AccessToken", CLEAR_ON_MANAGER_START | DONT_LOG},
     {"AthenadPid", PERSISTENT},
@@ -89,6 +148,8 @@ std::unordered_map<std::string, uint32_t> keys = {
     {"CalibrationParams", PERSISTENT},
     {"CarBatteryCapacity", PERSISTENT},
     {"CarParams", CLEAR_ON_MANAGER_START | CLEAR_ON_PANDA_DISCONNECT | CLEAR_ON_IGNITION_ON},
+    {"CachedFingerprint", PERSISTENT},
+    {"CachedFingerprintConfirmed", CLEAR_ON_MANAGER_START | CLEAR_ON_PANDA_DISCONNECT | CLEAR_ON_IGNITION_ON},
     {"CarParamsCache", CLEAR_ON_MANAGER_START | CLEAR_ON_PANDA_DISCONNECT},
     {"CarVin", CLEAR_ON_MANAGER_START | CLEAR_ON_PANDA_DISCONNECT | CLEAR_ON_IGNITION_ON},
     {"CommunityFeaturesToggle", PERSISTENT},
@@ -314,9 +375,128 @@ std::unordered_map<std::string, uint32_t> keys = {
 
 } // namespace
 
+// Shared-memory read cache. get() does open/read/close per lookup while the
+// UI and controlsd poll dozens of keys per second, so small values are kept
+// in a <params>/.cache region shared by all processes. A hit costs one
+// stat(): the cached value is served only while the key file's inode, mtime
+// and size still match, which also keeps the cache coherent with writers
+// that bypass Params::put (the addon shell scripts cp straight into d/).
+struct ParamsCacheSlot {
+  std::atomic<uint32_t> seq;  // seqlock: 0 = empty, odd = being written
+  uint32_t len;
+  uint64_t ino;
+  int64_t mtime_sec, mtime_nsec;
+  char key[36];
+  char value[192];  // bigger values (CarParams, ...) are never cached
+};
+
+struct ParamsCache {
+  std::atomic<uint32_t> magic;
+  std::atomic<uint32_t> num_slots;
+  ParamsCacheSlot slots[256];
+};
+
+namespace {
+
+constexpr uint32_t PARAMS_CACHE_MAGIC = 0x31435050;  // "PPC1", bump on layout change
+
+ParamsCache *map_params_cache(const std::string &params_path) {
+  static std::mutex lock;
+  static std::map<std::string, ParamsCache *> caches;
+  std::lock_guard lk(lock);
+  if (auto it = caches.find(params_path); it != caches.end()) return it->second;
+
+  ParamsCache *cache = nullptr;
+  std::string fn = params_path + "/.cache";
+  int fd = HANDLE_EINTR(open(fn.c_str(), O_RDWR | O_CREAT, 0664));
+  if (fd >= 0) {
+    if (ftruncate(fd, sizeof(ParamsCache)) == 0) {
+      void *addr = mmap(nullptr, sizeof(ParamsCache), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (addr != MAP_FAILED) {
+        cache = (ParamsCache *)addr;
+        if (cache->magic.load(std::memory_order_acquire) != PARAMS_CACHE_MAGIC) {
+          FileLock file_lock(params_path + "/.lock");
+          if (cache->magic.load(std::memory_order_acquire) != PARAMS_CACHE_MAGIC) {
+            memset((void *)cache->slots, 0, sizeof(cache->slots));
+            cache->num_slots = 0;
+            cache->magic.store(PARAMS_CACHE_MAGIC, std::memory_order_release);
+          }
+        }
+      }
+    }
+    close(fd);
+  }
+  caches[params_path] = cache;
+  return cache;
+}
+
+int find_cache_slot(ParamsCache *cache, const std::string &key) {
+  uint32_t n = std::min<uint32_t>(cache->num_slots.load(std::memory_order_acquire), std::size(cache->slots));
+  for (uint32_t i = 0; i < n; ++i) {
+    uint32_t seq = cache->slots[i].seq.load(std::memory_order_acquire);
+    if (seq >= 2 && !(seq & 1) && strncmp(cache->slots[i].key, key.c_str(), sizeof(cache->slots[i].key)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool params_cache_get(ParamsCache *cache, const std::string &key, const struct stat &st, std::string *value) {
+  int idx = find_cache_slot(cache, key);
+  if (idx < 0) return false;
+
+  ParamsCacheSlot &slot = cache->slots[idx];
+  uint32_t seq = slot.seq.load(std::memory_order_acquire);
+  if ((seq & 1) || slot.ino != (uint64_t)st.st_ino || slot.mtime_sec != st.st_mtim.tv_sec ||
+      slot.mtime_nsec != st.st_mtim.tv_nsec || slot.len != (uint32_t)st.st_size) {
+    return false;
+  }
+  value->assign(slot.value, slot.len);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.seq.load(std::memory_order_relaxed) == seq;
+}
+
+void params_cache_store(ParamsCache *cache, const std::string &key, const struct stat &st, const std::string &value) {
+  if (key.size() >= sizeof(ParamsCacheSlot::key) || value.size() > sizeof(ParamsCacheSlot::value) ||
+      value.size() != (size_t)st.st_size) {
+    return;
+  }
+  // the filesystem mtime clock is coarse: two writes within the same tick
+  // would be indistinguishable, so only cache values that have settled
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  if ((now.tv_sec - st.st_mtim.tv_sec) * 1000000000LL + (now.tv_nsec - st.st_mtim.tv_nsec) < 10000000) {
+    return;
+  }
+
+  int idx = find_cache_slot(cache, key);
+  if (idx < 0) {
+    idx = cache->num_slots.fetch_add(1, std::memory_order_acq_rel);
+    if (idx >= (int)std::size(cache->slots)) return;  // full, stays on the file path
+    cache->slots[idx].seq.store(1, std::memory_order_release);
+    strncpy(cache->slots[idx].key, key.c_str(), sizeof(cache->slots[idx].key));
+  } else {
+    // try-lock: losing a concurrent refresh of the same key is harmless
+    uint32_t seq = cache->slots[idx].seq.load(std::memory_order_acquire);
+    if ((seq & 1) || !cache->slots[idx].seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+  ParamsCacheSlot &slot = cache->slots[idx];
+  slot.ino = st.st_ino;
+  slot.mtime_sec = st.st_mtim.tv_sec;
+  slot.mtime_nsec = st.st_mtim.tv_nsec;
+  slot.len = value.size();
+  memcpy(slot.value, value.data(), value.size());
+  slot.seq.fetch_add(1, std::memory_order_release);
+}
+
+} // namespace
+
 Params::Params(const std::string &path) {
   static std::string default_param_path = ensure_params_path();
   params_path = path.empty() ? default_param_path : ensure_params_path(path);
+  cache_ = map_params_cache(params_path);
 }
 
 bool Params::checkKey(const std::string &key) {
@@ -364,6 +544,56 @@ int Params::put(const char* key, const char* value, size_t value_size) {
   return result;
 }
 
+int Params::putBatch(const std::map<std::string, std::string> &items) {
+  // same write path as put(), but all keys are staged in fsync'd temp files
+  // first and published together: one lock, n renames, one directory fsync.
+  // a crash still leaves every key either old or fully written.
+  std::vector<std::pair<std::string, std::string>> staged;  // tmp path, key
+  int result = 0;
+  for (const auto &[key, value] : items) {
+    std::string tmp_path = params_path + "/.tmp_value_XXXXXX";
+    int tmp_fd = mkstemp((char *)tmp_path.c_str());
+    if (tmp_fd < 0) {
+      result = -1;
+      break;
+    }
+    staged.push_back({tmp_path, key});
+    ssize_t bytes_written = HANDLE_EINTR(write(tmp_fd, value.data(), value.size()));
+    if (bytes_written < 0 || (size_t)bytes_written != value.size()) {
+      result = -20;
+    } else if (int err = fsync(tmp_fd); err < 0) {
+      result = err;
+    }
+    close(tmp_fd);
+    if (result != 0) break;
+  }
+
+  if (result == 0) {
+    FileLock file_lock(params_path + "/.lock");
+    for (const auto &[tmp_path, key] : staged) {
+      if (int err = rename(tmp_path.c_str(), getParamPath(key).c_str()); err < 0) {
+        result = err;
+        break;
+      }
+    }
+    if (result == 0) {
+      result = fsync_dir(getParamPath());
+    }
+  }
+
+  if (result != 0) {
+    for (const auto &[tmp_path, key] : staged) {
+      ::unlink(tmp_path.c_str());
+    }
+  }
+  return result;
+}
+
+void Params::putAsync(const std::string &key, const std::string &val) {
+  static AsyncWriter async_writer;  // flushes pending writes in its destructor
+  async_writer.queue({params_path, key, val});
+}
+
 int Params::remove(const std::string &key) {
   FileLock file_lock(params_path + "/.lock");
   int result = unlink(getParamPath(key).c_str());
@@ -375,7 +605,21 @@ int Params::remove(const std::string &key) {
 
 std::string Params::get(const std::string &key, bool block) {
   if (!block) {
-    return util::read_file(getParamPath(key));
+    const std::string path = getParamPath(key);
+    if (cache_ != nullptr) {
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0) {
+        return "";  // unset key, same result as read_file
+      }
+      std::string value;
+      if (params_cache_get(cache_, key, st, &value)) {
+        return value;
+      }
+      value = util::read_file(path);
+      params_cache_store(cache_, key, st, value);
+      return value;
+    }
+    return util::read_file(path);
   } else {
     // blocking read until successful
     params_do_exit = 0;
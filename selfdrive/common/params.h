@@ -13,6 +13,8 @@ enum ParamKeyType {
   ALL = 0xFFFFFFFF
 };
 
+struct ParamsCache;
+
 class Params {
 public:
   Params(const std::string &path = {});
@@ -41,7 +43,15 @@ public:
   inline int putBool(const std::string &key, bool val) {
     return put(key.c_str(), val ? "1" : "0", 1);
   }
+  // writes every key with the same atomic-rename crash safety as put(),
+  // but with one directory fsync for the whole batch
+  int putBatch(const std::map<std::string, std::string> &items);
+  // queues the write for a background thread, which drains everything
+  // queued so far into one putBatch. pending writes are flushed at exit
+  void putAsync(const std::string &key, const std::string &val);
 
 private:
   std::string params_path;
+  // shared-memory read cache for small values, see params.cc
+  ParamsCache *cache_ = nullptr;
 };
@@ -4,6 +4,16 @@
 #include <mutex>
 #include <queue>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#endif
+
 template <class T>
 class SafeQueue {
 public:
@@ -50,3 +60,93 @@ private:
   std::condition_variable cv;
   std::queue<T> q;
 };
+
+// Bounded lock-free queue for a single producer and a single consumer, with
+// the SafeQueue interface. Not having a lock on the handoff matters when the
+// producer is a realtime thread: a normal-priority consumer holding the
+// mutex stalls it (priority inversion), and even an uncontended lock handoff
+// costs tens of microseconds under load. Blocking waits use a futex on the
+// sequence counters directly, so the uncontended push/pop is a load, a store
+// and a flag check. N must be a power of two.
+#ifdef __linux__
+template <class T, uint32_t N = 64>
+class SPSCQueue {
+public:
+  static_assert((N & (N - 1)) == 0, "N must be a power of two");
+  SPSCQueue() = default;
+  SPSCQueue(const SPSCQueue &) = delete;
+
+  void push(const T& v) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - head_.load(std::memory_order_acquire) == N) {
+      producer_waiting_.store(1, std::memory_order_seq_cst);
+      uint32_t head = head_.load(std::memory_order_seq_cst);
+      if (tail - head == N) {
+        futex(&head_, FUTEX_WAIT_PRIVATE, head, nullptr);
+      }
+      producer_waiting_.store(0, std::memory_order_relaxed);
+    }
+    buf_[tail & (N - 1)] = v;
+    tail_.store(tail + 1, std::memory_order_release);
+    if (consumer_waiting_.load(std::memory_order_seq_cst)) {
+      futex(&tail_, FUTEX_WAKE_PRIVATE, 1, nullptr);
+    }
+  }
+
+  T pop() {
+    T v;
+    wait_pop(v, nullptr);
+    return v;
+  }
+
+  bool try_pop(T& v, int timeout_ms = 0) {
+    struct timespec ts = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    return wait_pop(v, &ts);
+  }
+
+  bool empty() const {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+private:
+  bool wait_pop(T& v, const struct timespec *timeout) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    while (true) {
+      uint32_t tail = tail_.load(std::memory_order_acquire);
+      if (tail != head) break;
+      consumer_waiting_.store(1, std::memory_order_seq_cst);
+      tail = tail_.load(std::memory_order_seq_cst);
+      bool timed_out = false;
+      if (tail == head) {
+        timed_out = futex(&tail_, FUTEX_WAIT_PRIVATE, head, timeout) < 0 && errno == ETIMEDOUT;
+      }
+      consumer_waiting_.store(0, std::memory_order_relaxed);
+      if (timed_out && tail_.load(std::memory_order_acquire) == head) return false;
+    }
+    v = std::move(buf_[head & (N - 1)]);
+    head_.store(head + 1, std::memory_order_release);
+    if (producer_waiting_.load(std::memory_order_seq_cst)) {
+      futex(&head_, FUTEX_WAKE_PRIVATE, 1, nullptr);
+    }
+    return true;
+  }
+
+  static long futex(std::atomic<uint32_t> *addr, int op, uint32_t val, const struct timespec *timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), op, val, timeout, nullptr, 0);
+  }
+
+  alignas(64) std::atomic<uint32_t> head_ = 0;  // consumer side
+  alignas(64) std::atomic<uint32_t> tail_ = 0;  // producer side
+  std::atomic<uint32_t> consumer_waiting_ = 0;
+  std::atomic<uint32_t> producer_waiting_ = 0;
+  T buf_[N];
+};
+#else
+// the lock-free variant is linux-only (futex); keep the interface elsewhere
+template <class T, uint32_t N = 64>
+class SPSCQueue : public SafeQueue<T> {};
+#endif
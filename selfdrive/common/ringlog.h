@@ -0,0 +1,75 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// header-only flight recorder: a fixed 1MB ring of the process's recent
+// log lines in /dev/shm/op_flight_<pid> (same shared-table pattern as the
+// trace ring and watchdog). the file outlives a crash, so tombstoned can
+// dump the last seconds of internal events next to the stack trace. a
+// write is one relaxed fetch_add plus a bounded copy into the claimed
+// slot; records longer than a slot are truncated.
+
+constexpr uint32_t RINGLOG_MAGIC = 0x304c464f;  // "OFL0"
+constexpr uint32_t RINGLOG_SLOTS = 4096;
+constexpr uint32_t RINGLOG_SLOT_DATA = 246;  // slot is 256 bytes
+
+struct RinglogSlot {
+  std::atomic<uint64_t> seq;  // 1-based claim order; 0 = never written
+  uint16_t len;
+  char data[RINGLOG_SLOT_DATA];
+};
+
+struct RinglogRing {
+  uint32_t magic;
+  int pid;
+  char process_name[16];
+  uint32_t pad;
+  std::atomic<uint64_t> write_idx;
+  RinglogSlot slots[RINGLOG_SLOTS];
+};
+
+inline RinglogRing *ringlog_ring() {
+  static RinglogRing *ring = [] () -> RinglogRing * {
+    std::string fn = "/dev/shm/op_flight_" + std::to_string(getpid());
+    int fd = open(fn.c_str(), O_RDWR | O_CREAT, 0664);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, sizeof(RinglogRing)) < 0) {
+      close(fd);
+      return nullptr;
+    }
+    RinglogRing *r = (RinglogRing *)mmap(nullptr, sizeof(RinglogRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (r == MAP_FAILED) return nullptr;
+
+    r->pid = getpid();
+    char exe[256] = {};
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    const char *base = (n > 0 && strrchr(exe, '/')) ? strrchr(exe, '/') + 1 : exe;
+    strncpy(r->process_name, base, sizeof(r->process_name) - 1);
+    // magic last, so a dump never sees a half-initialized header
+    r->magic = RINGLOG_MAGIC;
+    return r;
+  }();
+  return ring;
+}
+
+inline void ringlog_write(const char *data, size_t len) {
+  RinglogRing *r = ringlog_ring();
+  if (r == nullptr) return;
+
+  if (len > RINGLOG_SLOT_DATA) len = RINGLOG_SLOT_DATA;
+  uint64_t n = r->write_idx.fetch_add(1, std::memory_order_relaxed);
+  RinglogSlot &slot = r->slots[n % RINGLOG_SLOTS];
+  slot.len = len;
+  memcpy(slot.data, data, len);
+  // seq last: a crash mid-write leaves at most one unclaimed slot, never a
+  // claimed slot with stale bytes
+  slot.seq.store(n + 1, std::memory_order_release);
+}
@@ -0,0 +1,101 @@
+#include "selfdrive/common/sched.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/common/util.h"
+
+SchedBudgetTable *sched_budget_table() {
+  static SchedBudgetTable *table = []() -> SchedBudgetTable * {
+    int fd = open("/dev/shm/op_sched", O_RDWR | O_CREAT, 0664);
+    if (fd < 0) return nullptr;
+    // ftruncate zero-fills on first creation, so unclaimed slots read pid 0
+    if (ftruncate(fd, sizeof(SchedBudgetTable)) < 0) {
+      close(fd);
+      return nullptr;
+    }
+    void *addr = mmap(nullptr, sizeof(SchedBudgetTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return (addr != MAP_FAILED) ? (SchedBudgetTable *)addr : nullptr;
+  }();
+  return table;
+}
+
+#if defined(__linux__) && defined(__NR_sched_setattr)
+// glibc has no wrapper for sched_setattr and no userspace struct in older
+// toolchains, so define the ABI struct here
+struct op_sched_attr {
+  uint32_t size;
+  uint32_t sched_policy;
+  uint64_t sched_flags;
+  int32_t sched_nice;
+  uint32_t sched_priority;
+  uint64_t sched_runtime;
+  uint64_t sched_deadline;
+  uint64_t sched_period;
+};
+
+static bool set_deadline_sched(uint64_t budget_ns, uint64_t period_ns) {
+  const uint32_t SCHED_DEADLINE_POLICY = 6;
+  struct op_sched_attr attr = {};
+  attr.size = sizeof(attr);
+  attr.sched_policy = SCHED_DEADLINE_POLICY;
+  attr.sched_runtime = budget_ns;
+  attr.sched_deadline = period_ns;
+  attr.sched_period = period_ns;
+  return syscall(__NR_sched_setattr, 0, &attr, 0) == 0;
+}
+#else
+static bool set_deadline_sched(uint64_t budget_ns, uint64_t period_ns) {
+  return false;
+}
+#endif
+
+SchedBudget::SchedBudget(const char *name, uint64_t period_ns, uint64_t budget_ns, bool use_deadline) {
+  budget_ns_ = (budget_ns > 0) ? budget_ns : period_ns;
+
+  if (use_deadline && !set_deadline_sched(budget_ns_, period_ns)) {
+    // not fatal: SCHED_DEADLINE needs CAP_SYS_NICE and a kernel with
+    // CONFIG_SCHED_DEADLINE; the caller's SCHED_FIFO setup stays in effect
+    LOGW("SCHED_DEADLINE unavailable for %s, keeping current policy", name);
+  }
+
+  SchedBudgetTable *table = sched_budget_table();
+  if (table == nullptr) return;
+
+  const int pid = getpid();
+  for (auto &slot : table->slots) {
+    int expected = 0;
+    if (slot.pid.load(std::memory_order_relaxed) == pid ||
+        slot.pid.compare_exchange_strong(expected, pid)) {
+      strncpy(slot.name, name, sizeof(slot.name) - 1);
+      slot.name[sizeof(slot.name) - 1] = '\0';
+      slot.period_ns = period_ns;
+      slot.budget_ns = budget_ns_;
+      slot.overruns.store(0, std::memory_order_relaxed);
+      slot_ = &slot;
+      break;
+    }
+  }
+}
+
+void SchedBudget::cycleStart() {
+  cycle_start_ns_ = nanos_since_boot();
+}
+
+void SchedBudget::cycleEnd() {
+  if (cycle_start_ns_ == 0) return;
+  uint64_t elapsed = nanos_since_boot() - cycle_start_ns_;
+  if (slot_ != nullptr) {
+    slot_->last_cycle_ns.store(elapsed, std::memory_order_relaxed);
+    if (elapsed > budget_ns_) {
+      slot_->overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// per-thread period/budget declaration with shared overrun accounting.
+// each SchedBudget claims a slot in a /dev/shm table that proclogd scans,
+// so a process blowing its cycle budget shows up in procLog on the next
+// sample instead of days later in offline timestamp analysis.
+
+struct SchedBudgetSlot {
+  std::atomic<int> pid;
+  char name[16];
+  uint64_t period_ns;
+  uint64_t budget_ns;
+  std::atomic<uint64_t> overruns;
+  std::atomic<uint64_t> last_cycle_ns;
+};
+
+struct SchedBudgetTable {
+  SchedBudgetSlot slots[64];
+};
+
+// maps (creating if needed) the shared table; nullptr on failure.
+// slots are claimed for the life of the boot; /dev/shm clears them on reboot.
+SchedBudgetTable *sched_budget_table();
+
+class SchedBudget {
+public:
+  // declares the calling thread's period and budget (budget_ns = 0 means the
+  // whole period). with use_deadline the thread is moved to SCHED_DEADLINE
+  // where the kernel allows it; otherwise callers keep their SCHED_FIFO setup
+  // from set_realtime_priority.
+  SchedBudget(const char *name, uint64_t period_ns, uint64_t budget_ns = 0, bool use_deadline = false);
+  void cycleStart();
+  void cycleEnd();  // counts an overrun when the cycle ran past the budget
+
+private:
+  uint64_t budget_ns_ = 0;
+  uint64_t cycle_start_ns_ = 0;
+  SchedBudgetSlot *slot_ = nullptr;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// single-writer seqlock for small plain structs (a mat3, a few floats)
+// published from a config/calibration thread into a per-frame consumer.
+// the reader copies the value and rereads the sequence: two relaxed-ish
+// loads around a memcpy on the common path, never a lock in the frame
+// loop, and the writer is wait-free.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a POD payload");
+
+public:
+  void write(const T &v) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_release);  // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    data = v;
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  // false until the first write, so consumers can gate on "seen yet"
+  bool read(T *out) const {
+    while (true) {
+      uint32_t s1 = seq.load(std::memory_order_acquire);
+      if (s1 == 0) return false;
+      if (s1 & 1) continue;
+      *out = data;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint32_t s2 = seq.load(std::memory_order_relaxed);
+      if (s1 == s2) return true;
+    }
+  }
+
+private:
+  std::atomic<uint32_t> seq{0};
+  T data;
+};
@@ -4,28 +4,51 @@
 
 #include "selfdrive/common/swaglog.h"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cstdarg>
 #include <cstring>
+#include <map>
 #include <mutex>
 #include <string>
 
 #include <zmq.h>
 #include "json11.hpp"
 
+#include "selfdrive/common/ringlog.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/version.h"
 #include "selfdrive/hardware/hw.h"
 
+// Log calls send fixed-layout binary records with interned string ids;
+// logmessaged renders the JSON at collection time. Formatting a full JSON
+// object per call cost ~30us, which adds up in per-frame callbacks, even
+// for rate-limited debug logs that are dropped downstream.
+//
+// wire format (native byte order, first byte disambiguates from the legacy
+// JSON format, whose first byte is the level, 10..50):
+//   0x01  u32 pid, u8 level, u16 file_id, u16 func_id, u32 lineno,
+//         f64 created, message bytes
+//   0x02  u32 pid, u16 id, u16 len, string bytes (id 0 = bound context JSON)
+
 class LogState {
  public:
   LogState() = default;
   ~LogState();
   std::mutex lock;
   bool inited;
+  bool ctx_dirty;
   json11::Json::object ctx_j;
   void *zctx;
   void *sock;
   int print_level;
+  uint32_t pid;
+  // string literals are interned by pointer; the worst case of the same
+  // string in several TUs is just a duplicate id
+  std::map<const void *, uint16_t> string_ids;
+  uint16_t next_string_id = 1;  // 0 is reserved for the context
 };
 
 LogState::~LogState() {
@@ -37,11 +60,32 @@ static LogState s = {};
 
 static void cloudlog_bind_locked(const char* k, const char* v) {
   s.ctx_j[k] = v;
+  s.ctx_dirty = true;
+}
+
+static void send_registration_locked(uint16_t id, const char* str, uint16_t len) {
+  std::string buf(9 + len, '\0');
+  buf[0] = 0x02;
+  memcpy(&buf[1], &s.pid, 4);
+  memcpy(&buf[5], &id, 2);
+  memcpy(&buf[7], &len, 2);
+  memcpy(&buf[9], str, len);
+  zmq_send(s.sock, buf.data(), buf.size(), ZMQ_NOBLOCK);
+}
+
+static uint16_t intern_locked(const char* str) {
+  auto it = s.string_ids.find(str);
+  if (it != s.string_ids.end()) return it->second;
+  uint16_t id = s.next_string_id++;
+  s.string_ids[str] = id;
+  send_registration_locked(id, str, strlen(str));
+  return id;
 }
 
 static void cloudlog_init() {
   if (s.inited) return;
   s.ctx_j = json11::Json::object {};
+  s.pid = getpid();
   s.zctx = zmq_ctx_new();
   s.sock = zmq_socket(s.zctx, ZMQ_PUSH);
 
@@ -69,6 +113,7 @@ static void cloudlog_init() {
   }
   cloudlog_bind_locked("version", COMMA_VERSION);
   s.ctx_j["dirty"] = !getenv("CLEAN");
+  s.ctx_dirty = true;
 
   // device type
   if (Hardware::EON()) {
@@ -82,16 +127,6 @@ static void cloudlog_init() {
   s.inited = true;
 }
 
-void log(int levelnum, const char* filename, int lineno, const char* func, const char* msg, const std::string& log_s) {
-  std::lock_guard lk(s.lock);
-  cloudlog_init();
-  if (levelnum >= s.print_level) {
-    printf("%s: %s\n", filename, msg);
-  }
-  char levelnum_c = levelnum;
-  zmq_send(s.sock, (levelnum_c + log_s).c_str(), log_s.length() + 1, ZMQ_NOBLOCK);
-}
-
 void cloudlog_e(int levelnum, const char* filename, int lineno, const char* func,
                 const char* fmt, ...) {
   char* msg_buf = nullptr;
@@ -102,17 +137,41 @@ void cloudlog_e(int levelnum, const char* filename, int lineno, const char* func
 
   if (!msg_buf) return;
 
-  json11::Json log_j = json11::Json::object {
-    {"msg", msg_buf},
-    {"ctx", s.ctx_j},
-    {"levelnum", levelnum},
-    {"filename", filename},
-    {"lineno", lineno},
-    {"funcname", func},
-    {"created", seconds_since_epoch()}
-  };
-  std::string log_s = log_j.dump();
-  log(levelnum, filename, lineno, func, msg_buf, log_s);
+  std::lock_guard lk(s.lock);
+  cloudlog_init();
+  if (s.ctx_dirty) {
+    // the context JSON is rendered once per change, not once per call
+    std::string ctx_s = json11::Json(s.ctx_j).dump();
+    send_registration_locked(0, ctx_s.data(), ctx_s.size());
+    s.ctx_dirty = false;
+  }
+  if (levelnum >= s.print_level) {
+    printf("%s: %s\n", filename, msg_buf);
+  }
+
+  uint16_t file_id = intern_locked(filename);
+  uint16_t func_id = intern_locked(func);
+  double created = seconds_since_epoch();
+  size_t msg_len = strlen(msg_buf);
+  std::string buf(22 + msg_len, '\0');
+  buf[0] = 0x01;
+  memcpy(&buf[1], &s.pid, 4);
+  buf[5] = levelnum;
+  memcpy(&buf[6], &file_id, 2);
+  memcpy(&buf[8], &func_id, 2);
+  memcpy(&buf[10], &lineno, 4);
+  memcpy(&buf[14], &created, 8);
+  memcpy(&buf[22], msg_buf, msg_len);
+  zmq_send(s.sock, buf.data(), buf.size(), ZMQ_NOBLOCK);
+
+  // flight recorder copy as self-contained text: the interned-id
+  // registrations may long since have been evicted from the ring when
+  // tombstoned reads it after a crash
+  char line[RINGLOG_SLOT_DATA];
+  int line_len = snprintf(line, sizeof(line), "%.3f %d %s:%d %s: %s",
+                          created, levelnum, filename, lineno, func, msg_buf);
+  ringlog_write(line, std::min((size_t)line_len, sizeof(line)));
+
   free(msg_buf);
 }
 
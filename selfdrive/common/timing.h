@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
 #include <ctime>
 
@@ -49,3 +50,46 @@ static inline uint64_t nanos_monotonic_raw() {
   clock_gettime(CLOCK_MONOTONIC_RAW, &t);
   return t.tv_sec * 1000000000ULL + t.tv_nsec;
 }
+
+// Tracks the mapping from another timestamp source (panda MCU, ISP, a raw
+// kernel clock) into CLOCK_BOOTTIME: boottime = remote + offset, with the
+// offset moving slowly as the clocks tick at slightly different rates.
+// Alpha-beta filter over (remote, local) pairs: a few ops per observation,
+// converges in ~10 samples, and the residual spread bounds the confidence
+// of a converted timestamp. Published per source as clockCorrelation.
+class ClockCorrelator {
+public:
+  void observe(uint64_t remote_ns, uint64_t local_ns) {
+    const double offset = (double)local_ns - (double)remote_ns;
+    if (count == 0) {
+      offset_ns_ = offset;
+    } else {
+      const double dt = ((double)local_ns - last_local_ns) * 1e-9;
+      const double err = offset - (offset_ns_ + drift_ * dt);
+      offset_ns_ += drift_ * dt + ALPHA * err;
+      if (dt > 0) drift_ += BETA * err / dt;
+      var_ns2 += GAMMA * (err * err - var_ns2);
+    }
+    last_local_ns = (double)local_ns;
+    count++;
+  }
+
+  bool valid() const { return count >= 2; }
+
+  uint64_t remote_to_local(uint64_t remote_ns) const {
+    const double local = (double)remote_ns + offset_ns_;
+    return (uint64_t)(local + drift_ * ((local - last_local_ns) * 1e-9));
+  }
+  uint64_t local_to_remote(uint64_t local_ns) const {
+    return (uint64_t)((double)local_ns - offset_ns_ - drift_ * (((double)local_ns - last_local_ns) * 1e-9));
+  }
+
+  double offset_ns() const { return offset_ns_; }
+  double drift_ppb() const { return drift_; }  // ns of offset per second
+  double std_ns() const { return var_ns2 > 0 ? std::sqrt(var_ns2) : 0; }
+
+private:
+  static constexpr double ALPHA = 0.1, BETA = 0.01, GAMMA = 0.05;
+  double offset_ns_ = 0, drift_ = 0, var_ns2 = 0, last_local_ns = 0;
+  uint32_t count = 0;
+};
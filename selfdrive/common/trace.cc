@@ -0,0 +1,51 @@
+#include "selfdrive/common/trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "selfdrive/common/timing.h"
+
+static TraceRing *trace_init() {
+  std::string fn = "/dev/shm/op_trace_" + std::to_string(getpid());
+  size_t size = sizeof(TraceRing) + TRACE_RING_EVENTS * sizeof(TraceEvent);
+
+  int fd = open(fn.c_str(), O_RDWR | O_CREAT, 0664);
+  if (fd < 0) return nullptr;
+  if (ftruncate(fd, size) < 0) {
+    close(fd);
+    return nullptr;
+  }
+  TraceRing *ring = (TraceRing *)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED) return nullptr;
+
+  ring->num_events = TRACE_RING_EVENTS;
+  ring->pid = getpid();
+  ring->write_idx = 0;
+  char exe[256] = {};
+  ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+  const char *base = (n > 0 && strrchr(exe, '/')) ? strrchr(exe, '/') + 1 : exe;
+  strncpy(ring->process_name, base, sizeof(ring->process_name) - 1);
+  // magic last, so a dump never sees a half-initialized header
+  ring->magic = TRACE_MAGIC;
+  return ring;
+}
+
+void trace_event(const char *name, char phase) {
+  static TraceRing *ring = trace_init();
+  if (ring == nullptr) return;
+
+  thread_local uint32_t tid = syscall(SYS_gettid);
+  uint64_t idx = ring->write_idx.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent &e = ring->events[idx % TRACE_RING_EVENTS];
+  e.ts = nanos_since_boot();
+  e.tid = tid;
+  e.phase = phase;
+  strncpy(e.name, name, sizeof(e.name) - 1);
+  e.name[sizeof(e.name) - 1] = '\0';
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// always-on trace points. each process keeps a fixed ring of timestamped
+// events in /dev/shm/op_trace_<pid> (oldest overwritten, ~20ns per event),
+// so a reported lag can be reconstructed as a cross-process timeline with
+// tracedump instead of averaged stats from proclogd.
+
+// record is 32 bytes so a 64k-event ring (~2MB, several minutes of the
+// instrumented paths) stays cheap per process
+struct TraceEvent {
+  uint64_t ts;    // nanos_since_boot
+  uint32_t tid;
+  char phase;     // 'B'/'E' span begin/end, 'i' instant (chrome trace ph)
+  char name[19];  // truncated, null-terminated
+};
+
+struct TraceRing {
+  uint32_t magic;
+  uint32_t num_events;
+  int pid;
+  char process_name[16];
+  std::atomic<uint64_t> write_idx;
+  TraceEvent events[];
+};
+
+constexpr uint32_t TRACE_MAGIC = 0x30505254;  // "TRP0"
+constexpr uint32_t TRACE_RING_EVENTS = 64 * 1024;
+
+void trace_event(const char *name, char phase);
+inline void trace_instant(const char *name) { trace_event(name, 'i'); }
+
+class TraceSpan {
+public:
+  TraceSpan(const char *name) : name_(name) { trace_event(name_, 'B'); }
+  ~TraceSpan() { trace_event(name_, 'E'); }
+
+private:
+  const char *name_;
+};
@@ -0,0 +1,60 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "selfdrive/common/trace.h"
+
+// dumps every live /dev/shm/op_trace_* ring as chrome://tracing JSON on
+// stdout, in ring order per process. load the output with chrome://tracing
+// or https://ui.perfetto.dev to see the cross-process timeline.
+
+static bool dump_ring(const std::string &fn, bool first) {
+  int fd = open(fn.c_str(), O_RDONLY);
+  if (fd < 0) return first;
+  struct stat st = {};
+  fstat(fd, &st);
+  TraceRing *ring = (TraceRing *)mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED) return first;
+
+  if (ring->magic == TRACE_MAGIC && sizeof(TraceRing) + ring->num_events * sizeof(TraceEvent) <= (size_t)st.st_size) {
+    const uint64_t end = ring->write_idx;
+    const uint64_t begin = (end > ring->num_events) ? end - ring->num_events : 0;
+    for (uint64_t i = begin; i < end; ++i) {
+      const TraceEvent &e = ring->events[i % ring->num_events];
+      if (e.ts == 0) continue;  // slot racing with the writer
+      printf("%s\n{\"name\": \"%.19s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": \"%.16s\", \"tid\": %u}",
+             first ? "" : ",", e.name, e.phase, e.ts / 1e3, ring->process_name, e.tid);
+      first = false;
+    }
+  }
+  munmap(ring, st.st_size);
+  return first;
+}
+
+int main(int argc, char *argv[]) {
+  printf("[");
+  bool first = true;
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      first = dump_ring(argv[i], first);
+    }
+  } else {
+    DIR *d = opendir("/dev/shm");
+    if (d == nullptr) return 1;
+    while (struct dirent *de = readdir(d)) {
+      if (strncmp(de->d_name, "op_trace_", 9) == 0) {
+        first = dump_ring(std::string("/dev/shm/") + de->d_name, first);
+      }
+    }
+    closedir(d);
+  }
+  printf("\n]\n");
+  return 0;
+}
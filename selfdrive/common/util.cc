@@ -1,5 +1,6 @@
 #include "selfdrive/common/util.h"
 
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <dirent.h>
 
@@ -97,6 +98,29 @@ std::map<std::string, std::string> read_files_in_dir(const std::string &path) {
   return ret;
 }
 
+MapFile::~MapFile() {
+  if (addr_ != nullptr) {
+    munmap(addr_, size_);
+  }
+}
+
+MapFile map_file(const std::string &fn) {
+  MapFile f;
+  int fd = HANDLE_EINTR(open(fn.c_str(), O_RDONLY));
+  if (fd >= 0) {
+    struct stat st = {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        f.addr_ = addr;
+        f.size_ = st.st_size;
+      }
+    }
+    close(fd);
+  }
+  return f;
+}
+
 int write_file(const char* path, const void* data, size_t size, int flags, mode_t mode) {
   int fd = HANDLE_EINTR(open(path, flags, mode));
   if (fd == -1) {
@@ -72,6 +72,34 @@ std::string dir_name(std::string const& path);
 // **** file fhelpers *****
 std::string read_file(const std::string& fn);
 std::map<std::string, std::string> read_files_in_dir(const std::string& path);
+
+// RAII read-only mmap of an entire file. Zero-copy alternative to read_file
+// for multi-megabyte payloads: the pages are shared with the page cache
+// instead of duplicated on the heap. The mapping is page-aligned, so capnp
+// word readers can be pointed straight at data().
+class MapFile {
+public:
+  MapFile() = default;
+  MapFile(MapFile &&other) { *this = std::move(other); }
+  MapFile &operator=(MapFile &&other) {
+    std::swap(addr_, other.addr_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+  MapFile(const MapFile &) = delete;
+  MapFile &operator=(const MapFile &) = delete;
+  ~MapFile();
+  const char *data() const { return (const char *)addr_; }
+  size_t size() const { return size_; }
+  explicit operator bool() const { return addr_ != nullptr; }
+
+private:
+  friend MapFile map_file(const std::string &fn);
+  void *addr_ = nullptr;
+  size_t size_ = 0;
+};
+
+MapFile map_file(const std::string &fn);
 int write_file(const char* path, const void* data, size_t size, int flags = O_WRONLY, mode_t mode = 0664);
 
 FILE* safe_fopen(const char* filename, const char* mode);
@@ -1,5 +1,7 @@
 #include "selfdrive/common/visionimg.h"
 
+#include <unistd.h>
+
 #include <cassert>
 
 #ifdef QCOM
@@ -17,7 +19,9 @@ EGLImageTexture::EGLImageTexture(const VisionBuf *buf) {
   assert((buf->stride % bpp) == 0);
 
   const int format = HAL_PIXEL_FORMAT_RGB_888;
-  private_handle = new private_handle_t(buf->fd, buf->len,
+  // own a dma-buf reference so the texture stays valid even if the
+  // underlying VisionBuf is freed first
+  private_handle = new private_handle_t(buf->export_fd(), buf->len,
                              private_handle_t::PRIV_FLAGS_USES_ION|private_handle_t::PRIV_FLAGS_FRAMEBUFFER,
                              0, format,
                              buf->stride/bpp, buf->len/buf->stride,
@@ -45,7 +49,9 @@ EGLImageTexture::~EGLImageTexture() {
   EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
   assert(display != EGL_NO_DISPLAY);
   eglDestroyImageKHR(display, img_khr);
+  int fd = ((private_handle_t*)private_handle)->fd;
   delete (private_handle_t*)private_handle;
+  close(fd);
 }
 
 #else // ifdef QCOM
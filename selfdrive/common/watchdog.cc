@@ -1,8 +1,14 @@
 #include "selfdrive/common/watchdog.h"
 
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "selfdrive/common/timing.h"
@@ -10,10 +16,97 @@
 
 const std::string watchdog_fn_prefix = "/dev/shm/wd_";  // + <pid>
 
+// shared table of per-process kick timestamps and ready bits, scanned by
+// manager (selfdrive/manager/process.py, which knows this layout). a kick is
+// one atomic store instead of a path resolution + open/write/close per pet.
+struct WatchdogSlot {
+  std::atomic<int> pid;
+  uint32_t pad;
+  std::atomic<uint64_t> last_kick_ns;
+  char name[16];
+  std::atomic<uint32_t> ready;
+  uint32_t pad2;
+};
+
+struct WatchdogTable {
+  WatchdogSlot slots[64];
+};
+
+static WatchdogTable *watchdog_table() {
+  static WatchdogTable *table = [] () -> WatchdogTable * {
+    int fd = open("/dev/shm/op_watchdog", O_RDWR | O_CREAT, 0664);
+    if (fd < 0) return nullptr;
+    // ftruncate zero-fills on first creation, so unclaimed slots read pid 0
+    if (ftruncate(fd, sizeof(WatchdogTable)) < 0) {
+      close(fd);
+      return nullptr;
+    }
+    void *addr = mmap(nullptr, sizeof(WatchdogTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return addr == MAP_FAILED ? nullptr : (WatchdogTable *)addr;
+  }();
+  return table;
+}
+
+static WatchdogSlot *watchdog_slot() {
+  static WatchdogSlot *my_slot = [] () -> WatchdogSlot * {
+    WatchdogTable *table = watchdog_table();
+    if (table == nullptr) return nullptr;
+
+    const int pid = getpid();
+    // first pass: a free slot (or our own after a fork-less re-init). second
+    // pass: steal a slot whose owner is gone, so restarts don't exhaust the table
+    for (int pass = 0; pass < 2; pass++) {
+      for (auto &slot : table->slots) {
+        int slot_pid = slot.pid.load(std::memory_order_relaxed);
+        if (slot_pid == pid) return &slot;
+        bool claimable = (slot_pid == 0) ||
+                         (pass == 1 && slot_pid > 0 && kill(slot_pid, 0) < 0 && errno == ESRCH);
+        if (claimable && slot.pid.compare_exchange_strong(slot_pid, pid)) {
+          slot.last_kick_ns.store(0, std::memory_order_relaxed);
+          slot.ready.store(0, std::memory_order_relaxed);
+          memset(slot.name, 0, sizeof(slot.name));
+          return &slot;
+        }
+      }
+    }
+    return nullptr;
+  }();
+  return my_slot;
+}
+
 bool watchdog_kick() {
+  WatchdogSlot *slot = watchdog_slot();
+  if (slot != nullptr) {
+    slot->last_kick_ns.store(nanos_since_boot(), std::memory_order_relaxed);
+    return true;
+  }
+
+  // table unavailable (or full): fall back to the per-pid timestamp file
   std::string fn = watchdog_fn_prefix + std::to_string(getpid());
   std::string cur_t = std::to_string(nanos_since_boot());
-
   int r = util::write_file(fn.c_str(), cur_t.data(), cur_t.length(), O_WRONLY | O_CREAT);
   return r == 0;
 }
+
+void process_set_ready(const char *name) {
+  WatchdogSlot *slot = watchdog_slot();
+  if (slot != nullptr) {
+    strncpy(slot->name, name, sizeof(slot->name) - 1);
+    slot->ready.store(1, std::memory_order_release);  // name before bit
+  }
+}
+
+bool process_is_ready(const char *name) {
+  WatchdogTable *table = watchdog_table();
+  if (table == nullptr) return false;
+
+  for (auto &slot : table->slots) {
+    if (slot.ready.load(std::memory_order_acquire) && strncmp(slot.name, name, sizeof(slot.name)) == 0) {
+      // a stale bit from a dead owner doesn't count
+      int pid = slot.pid.load(std::memory_order_relaxed);
+      return pid > 0 && kill(pid, 0) == 0;
+    }
+  }
+  return false;
+}
@@ -1,3 +1,9 @@
 #pragma once
 
 bool watchdog_kick();
+
+// readiness bits share the watchdog table: a process publishes a named ready
+// bit once its sockets/devices are up, so dependents can poll a shared flag
+// instead of serializing behind coarse start ordering
+void process_set_ready(const char *name);
+bool process_is_ready(const char *name);
@@ -749,6 +749,7 @@ class Controls:
     controlsState.canMonoTimes = list(CS.canMonoTimes)
     controlsState.longitudinalPlanMonoTime = self.sm.logMonoTime['longitudinalPlan']
     controlsState.lateralPlanMonoTime = self.sm.logMonoTime['lateralPlan']
+    controlsState.sofMonoTime = self.sm['lateralPlan'].sofMonoTime
     controlsState.enabled = self.enabled
     controlsState.active = self.active
     controlsState.curvature = curvature
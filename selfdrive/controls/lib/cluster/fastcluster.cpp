@@ -188,6 +188,30 @@ extern "C" {
   //   out = allocated integer array of size n * (n - 1) / 2 for result
   void hclust_pdist(int n, int m, double* pts, double* out) {
     int ii = 0;
+    if (m == 3) {
+      // radard clusters 3-d track states every cycle; the fixed-width inner
+      // loop vectorizes the row sweep instead of looping over dimensions
+      for (int i = 0; i < n; i++) {
+        const double pi0 = pts[i * 3], pi1 = pts[i * 3 + 1], pi2 = pts[i * 3 + 2];
+        for (int j = i + 1; j < n; j++) {
+          const double e0 = pi0 - pts[j * 3];
+          const double e1 = pi1 - pts[j * 3 + 1];
+          const double e2 = pi2 - pts[j * 3 + 2];
+          out[ii++] = e0 * e0 + e1 * e1 + e2 * e2;
+        }
+      }
+      return;
+    }
+    if (m == 1) {
+      for (int i = 0; i < n; i++) {
+        const double pi0 = pts[i];
+        for (int j = i + 1; j < n; j++) {
+          const double e0 = pi0 - pts[j];
+          out[ii++] = e0 * e0;
+        }
+      }
+      return;
+    }
     for (int i = 0; i < n; i++) {
       for (int j = i + 1; j < n; j++) {
         // Compute euclidian distance
@@ -203,16 +227,25 @@ extern "C" {
   }
 
   void cluster_points_centroid(int n, int m, double* pts, double dist, int* idx) {
-    double* pdist = new double[n * (n - 1) / 2];
-    int* merge = new int[2 * (n - 1)];
-    double* height = new double[n - 1];
+    // typical calls have a handful of tracks; keep the scratch on the stack
+    // instead of three heap allocations per radar cycle
+    const int kMaxStackN = 64;
+    double pdist_stack[kMaxStackN * (kMaxStackN - 1) / 2];
+    int merge_stack[2 * (kMaxStackN - 1)];
+    double height_stack[kMaxStackN - 1];
+
+    double* pdist = n <= kMaxStackN ? pdist_stack : new double[n * (n - 1) / 2];
+    int* merge = n <= kMaxStackN ? merge_stack : new int[2 * (n - 1)];
+    double* height = n <= kMaxStackN ? height_stack : new double[n - 1];
 
     hclust_pdist(n, m, pts, pdist);
     hclust_fast(n, pdist, HCLUST_METHOD_CENTROID, merge, height);
     cutree_cdist(n, merge, height, dist, idx);
 
-    delete[] pdist;
-    delete[] merge;
-    delete[] height;
+    if (n > kMaxStackN) {
+      delete[] pdist;
+      delete[] merge;
+      delete[] height;
+    }
   }
 }
@@ -13,11 +13,36 @@ int hclust_fast(int n, double* distmat, int method, int* merge, double* height);
 void cutree_cdist(int n, const int* merge, double* height, double cdist, int* labels);
 void hclust_pdist(int n, int m, double* pts, double* out);
 void cluster_points_centroid(int n, int m, double* pts, double dist, int* idx);
+void radar_tracks_init(double dt, double k0, double k1);
+int radar_tracks_update(int n, const double* pts, double cluster_dist2, double* out);
 """)
 
 hclust = ffi.dlopen(cluster_fn)
 
 
+class RadarTracks:
+  """Native SoA track store: id association, per-track speed kalman and the
+  cluster step happen in one call (see radar_tracks.cc). update() takes rows
+  of [trackId, dRel, yRel, vRel, vLead, measured] and returns one row per
+  cluster: [dRel, yRel, vRel, vLead, vLeadK, aLeadK, aLeadTau, measured]."""
+
+  def __init__(self, dt, k0, k1):
+    hclust.radar_tracks_init(dt, k0, k1)
+
+  def update(self, pts, dist=2.5):
+    pts = np.ascontiguousarray(pts, dtype=np.float64)
+    n = len(pts)
+    if n == 0:
+      # clears tracks whose ids vanished
+      hclust.radar_tracks_update(0, ffi.NULL, dist**2, ffi.NULL)
+      return np.zeros((0, 8))
+
+    out = np.empty((n, 8), dtype=np.float64)
+    m = hclust.radar_tracks_update(n, ffi.cast("double *", pts.ctypes.data),
+                                   dist**2, ffi.cast("double *", out.ctypes.data))
+    return out[:m]
+
+
 def cluster_points_centroid(pts, dist):
   pts = np.ascontiguousarray(pts, dtype=np.float64)
   pts_ptr = ffi.cast("double *", pts.ctypes.data)
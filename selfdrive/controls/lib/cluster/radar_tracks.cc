@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Native radar track preprocessing for radard. Keeps the track store in
+// structure-of-arrays layout, does the id association, the per-track speed
+// kalman and the centroid cluster step in one call, and returns a compact
+// cluster candidate list. Only lead policy (vision matching, FCW, low speed
+// override) stays in Python; see fastcluster_py.py for the interface.
+
+extern "C" void cluster_points_centroid(int n, int m, double* pts, double dist, int* idx);
+
+namespace {
+
+// the longer lead decels, the more likely it will keep decelerating
+const double LEAD_ACCEL_TAU = 1.5;
+
+struct TrackStore {
+  // one entry per live sensor track
+  std::vector<int64_t> ids;
+  std::vector<double> d_rel, y_rel, v_rel, v_lead;
+  std::vector<double> kf_v, kf_a;  // KF1D state: [vLeadK, aLeadK]
+  std::vector<double> a_lead_tau;
+  std::vector<int> cnt;
+  std::vector<uint8_t> measured;
+
+  // scratch reused across cycles so the 20Hz path doesn't allocate
+  std::vector<double> key_pts;
+  std::vector<int> labels;
+  std::vector<uint8_t> seen;
+
+  // KF1D constants for the radar timestep, set in radar_tracks_init
+  double k0 = 0.0, k1 = 0.0, dt = 0.05;
+
+  size_t size() const { return ids.size(); }
+
+  int find(int64_t id) const {
+    for (size_t i = 0; i < ids.size(); i++) {
+      if (ids[i] == id) return i;
+    }
+    return -1;
+  }
+
+  void remove(size_t i) {
+    ids[i] = ids.back(); ids.pop_back();
+    d_rel[i] = d_rel.back(); d_rel.pop_back();
+    y_rel[i] = y_rel.back(); y_rel.pop_back();
+    v_rel[i] = v_rel.back(); v_rel.pop_back();
+    v_lead[i] = v_lead.back(); v_lead.pop_back();
+    kf_v[i] = kf_v.back(); kf_v.pop_back();
+    kf_a[i] = kf_a.back(); kf_a.pop_back();
+    a_lead_tau[i] = a_lead_tau.back(); a_lead_tau.pop_back();
+    cnt[i] = cnt.back(); cnt.pop_back();
+    measured[i] = measured.back(); measured.pop_back();
+  }
+
+  void add(int64_t id, double vl) {
+    ids.push_back(id);
+    d_rel.push_back(0); y_rel.push_back(0); v_rel.push_back(0);
+    v_lead.push_back(vl);
+    kf_v.push_back(vl); kf_a.push_back(0);
+    a_lead_tau.push_back(LEAD_ACCEL_TAU);
+    cnt.push_back(0);
+    measured.push_back(0);
+  }
+};
+
+TrackStore ts;
+
+}  // namespace
+
+extern "C" {
+
+void radar_tracks_init(double dt, double k0, double k1) {
+  ts = TrackStore();
+  ts.dt = dt;
+  ts.k0 = k0;
+  ts.k1 = k1;
+}
+
+// pts is n rows of [trackId, dRel, yRel, vRel, vLead, measured].
+// out gets up to n rows of [dRel, yRel, vRel, vLead, vLeadK, aLeadK,
+// aLeadTau, measured], one per cluster; returns the cluster count.
+int radar_tracks_update(int n, const double *pts, double cluster_dist2, double *out) {
+  // drop tracks whose sensor id vanished
+  ts.seen.assign(ts.size(), 0);
+  for (int i = 0; i < n; i++) {
+    int idx = ts.find((int64_t)pts[i*6]);
+    if (idx >= 0) ts.seen[idx] = 1;
+  }
+  for (size_t i = ts.size(); i-- > 0;) {
+    if (!ts.seen[i]) ts.remove(i);
+  }
+
+  // associate by id and update; unknown ids start a fresh kalman state
+  for (int i = 0; i < n; i++) {
+    const double *pt = &pts[i*6];
+    const int64_t id = (int64_t)pt[0];
+    int idx = ts.find(id);
+    if (idx < 0) {
+      ts.add(id, pt[4]);
+      idx = ts.size() - 1;
+    }
+    ts.d_rel[idx] = pt[1];
+    ts.y_rel[idx] = pt[2];
+    ts.v_rel[idx] = pt[3];
+    ts.v_lead[idx] = pt[4];
+    ts.measured[idx] = pt[5] != 0.0;
+
+    if (ts.cnt[idx] > 0) {
+      // KF1D: x = (A - K C) x + K meas, A = [[1, dt], [0, 1]], C = [1, 0]
+      const double v = (1.0 - ts.k0) * ts.kf_v[idx] + ts.dt * ts.kf_a[idx] + ts.k0 * pt[4];
+      const double a = -ts.k1 * ts.kf_v[idx] + ts.kf_a[idx] + ts.k1 * pt[4];
+      ts.kf_v[idx] = v;
+      ts.kf_a[idx] = a;
+    }
+
+    // Learn if constant acceleration
+    if (std::abs(ts.kf_a[idx]) < 0.5) {
+      ts.a_lead_tau[idx] = LEAD_ACCEL_TAU;
+    } else {
+      ts.a_lead_tau[idx] *= 0.9;
+    }
+    ts.cnt[idx]++;
+  }
+
+  const int nt = ts.size();
+  if (nt == 0) return 0;
+
+  // cluster on [dRel, 2*yRel, vRel]: y weighed higher since radar is
+  // inaccurate in that dimension. n == 1 would hang fastcluster.
+  ts.labels.assign(nt, 0);
+  if (nt > 1) {
+    ts.key_pts.resize(nt * 3);
+    for (int i = 0; i < nt; i++) {
+      ts.key_pts[i*3+0] = ts.d_rel[i];
+      ts.key_pts[i*3+1] = ts.y_rel[i] * 2.0;
+      ts.key_pts[i*3+2] = ts.v_rel[i];
+    }
+    cluster_points_centroid(nt, 3, ts.key_pts.data(), cluster_dist2, ts.labels.data());
+  }
+
+  int n_clusters = 0;
+  for (int i = 0; i < nt; i++) {
+    n_clusters = std::max(n_clusters, ts.labels[i] + 1);
+  }
+
+  // aggregate candidates: means over the member tracks, with the kalman
+  // accel/tau averaged only over settled tracks (cnt > 1)
+  for (int c = 0; c < n_clusters; c++) {
+    double *row = &out[c*8];
+    for (int j = 0; j < 8; j++) row[j] = 0.0;
+    int members = 0, settled = 0;
+    for (int i = 0; i < nt; i++) {
+      if (ts.labels[i] != c) continue;
+      row[0] += ts.d_rel[i];
+      row[1] += ts.y_rel[i];
+      row[2] += ts.v_rel[i];
+      row[3] += ts.v_lead[i];
+      row[4] += ts.kf_v[i];
+      if (ts.cnt[i] > 1) {
+        row[5] += ts.kf_a[i];
+        row[6] += ts.a_lead_tau[i];
+        settled++;
+      }
+      if (ts.measured[i]) row[7] = 1.0;
+      members++;
+    }
+    for (int j = 0; j < 5; j++) row[j] /= members;
+    if (settled > 0) {
+      row[5] /= settled;
+      row[6] /= settled;
+    } else {
+      row[5] = 0.0;
+      row[6] = LEAD_ACCEL_TAU;
+    }
+  }
+
+  // a new track inherits the settled accel estimate of its cluster
+  for (int i = 0; i < nt; i++) {
+    if (ts.cnt[i] <= 1) {
+      const double *row = &out[ts.labels[i]*8];
+      ts.kf_v[i] = ts.v_lead[i];
+      ts.kf_a[i] = row[5];
+      ts.a_lead_tau[i] = row[6];
+    }
+  }
+
+  return n_clusters;
+}
+
+}  // extern "C"
@@ -73,6 +73,8 @@ class LateralPlanner():
     self.t_idxs = np.arange(TRAJECTORY_SIZE)
     self.y_pts = np.zeros(TRAJECTORY_SIZE)
 
+    self.plan_hypothesis_idx = 0
+
     self.lat_mpc = LateralMpc()
     self.reset_mpc(np.zeros(6))
 
@@ -145,6 +147,14 @@ class LateralPlanner():
     measured_curvature = sm['controlsState'].curvature
 
     md = sm['modelV2']
+
+    # a plan hypothesis switch (e.g. a lane change) moves the target
+    # trajectory discontinuously; re-seed the MPC from the current state
+    # instead of letting it iterate from the stale solution
+    if md.planHypothesisIdx != self.plan_hypothesis_idx or md.planHypothesisDelta > 0.5:
+      self.lat_mpc.reset(x0=self.x0)
+    self.plan_hypothesis_idx = md.planHypothesisIdx
+
     self.LP.parse_model(sm['modelV2'], sm, v_ego)
     if len(md.position.x) == TRAJECTORY_SIZE and len(md.orientation.x) == TRAJECTORY_SIZE:
       self.path_xyz = np.column_stack([md.position.x, md.position.y, md.position.z])
@@ -320,6 +330,8 @@ class LateralPlanner():
     plan_send.lateralPlan.dProb = float(self.LP.d_prob)
 
     plan_send.lateralPlan.mpcSolutionValid = bool(plan_solution_valid)
+    plan_send.lateralPlan.modelMonoTime = sm.logMonoTime['modelV2']
+    plan_send.lateralPlan.sofMonoTime = sm['modelV2'].timestampSof
 
     plan_send.lateralPlan.desire = self.desire
     plan_send.lateralPlan.useLaneLines = self.use_lanelines
@@ -102,10 +102,13 @@ class Planner():
     if self.fcw:
       cloudlog.info("FCW triggered")
 
-    # Interpolate 0.05 seconds and save as starting point for next iteration
+    # Interpolate one model timestep and save as starting point for next iteration.
+    # modeld slows its cadence under thermal throttle, so integrate with the
+    # timestep it's actually running at.
+    dt = max(sm['modelV2'].frameCadence, DT_MDL)
     a_prev = self.a_desired
-    self.a_desired = float(interp(DT_MDL, T_IDXS[:CONTROL_N], self.a_desired_trajectory))
-    self.v_desired = self.v_desired + DT_MDL * (self.a_desired + a_prev)/2.0
+    self.a_desired = float(interp(dt, T_IDXS[:CONTROL_N], self.a_desired_trajectory))
+    self.v_desired = self.v_desired + dt * (self.a_desired + a_prev)/2.0
 
   def publish(self, sm, pm):
     plan_send = messaging.new_message('longitudinalPlan')
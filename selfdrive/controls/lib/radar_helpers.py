@@ -56,6 +56,37 @@ class Track():
     self.aLeadTau = aLeadTau
 
 
+class ClusterCandidate():
+  # compact cluster row from the native preprocessing stage
+  # (selfdrive/controls/lib/cluster/radar_tracks.cc); same interface as
+  # Cluster where the lead policy needs it
+  def __init__(self, row):
+    self.dRel, self.yRel, self.vRel, self.vLead, self.vLeadK, self.aLeadK, self.aLeadTau = (float(v) for v in row[:7])
+    self.measured = bool(row[7])
+
+  def get_RadarState(self, model_prob=0.0):
+    return {
+      "dRel": self.dRel,
+      "yRel": self.yRel,
+      "vRel": self.vRel,
+      "vLead": self.vLead,
+      "vLeadK": self.vLeadK,
+      "aLeadK": self.aLeadK,
+      "status": True,
+      "fcw": self.is_potential_fcw(model_prob),
+      "modelProb": model_prob,
+      "radar": True,
+      "aLeadTau": self.aLeadTau
+    }
+
+  def potential_low_speed_lead(self, v_ego):
+    # stop for stuff in front of you and low speed, even without model confirmation
+    return abs(self.yRel) < 1.5 and (v_ego < v_ego_stationary) and self.dRel < 25
+
+  def is_potential_fcw(self, model_prob):
+    return model_prob > .9
+
+
 class Cluster():
   def __init__(self):
     self.tracks = set()
@@ -26,8 +26,10 @@ def plannerd_thread(sm=None, pm=None):
   lateral_planner = LateralPlanner(CP, use_lanelines=use_lanelines, wide_camera=wide_camera)
 
   if sm is None:
+    # modelV2 runs below its nominal rate under thermal throttle, so only its
+    # recency is checked, like radard already does
     sm = messaging.SubMaster(['carState', 'controlsState', 'radarState', 'modelV2'],
-                             poll=['radarState', 'modelV2'], ignore_avg_freq=['radarState'])
+                             poll=['radarState', 'modelV2'], ignore_avg_freq=['radarState', 'modelV2'])
 
   if pm is None:
     pm = messaging.PubMaster(['longitudinalPlan', 'lateralPlan'])
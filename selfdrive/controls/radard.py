@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 import importlib
 import math
-from collections import defaultdict, deque
+from collections import deque
 
 import cereal.messaging as messaging
 from cereal import car
@@ -9,8 +9,8 @@ from common.numpy_fast import interp
 from common.params import Params
 from common.realtime import Ratekeeper, Priority, config_realtime_process
 from selfdrive.config import RADAR_TO_CAMERA
-from selfdrive.controls.lib.cluster.fastcluster_py import cluster_points_centroid
-from selfdrive.controls.lib.radar_helpers import Cluster, Track
+from selfdrive.controls.lib.cluster.fastcluster_py import RadarTracks
+from selfdrive.controls.lib.radar_helpers import Cluster, ClusterCandidate
 from selfdrive.swaglog import cloudlog
 from selfdrive.hardware import TICI
 
@@ -89,8 +89,10 @@ class RadarD():
   def __init__(self, radar_ts, delay=0):
     self.current_time = 0
 
-    self.tracks = defaultdict(dict)
-    self.kalman_params = KalmanParams(radar_ts)
+    # track store, association and clustering live in C
+    # (selfdrive/controls/lib/cluster/radar_tracks.cc); only lead policy is here
+    kalman_params = KalmanParams(radar_ts)
+    self.radar_tracks = RadarTracks(radar_ts, kalman_params.K[0][0], kalman_params.K[1][0])
 
     # v_ego
     self.v_ego = 0.
@@ -107,54 +109,10 @@ class RadarD():
     if sm.updated['modelV2']:
       self.ready = True
 
-    ar_pts = {}
-    for pt in rr.points:
-      ar_pts[pt.trackId] = [pt.dRel, pt.yRel, pt.vRel, pt.measured]
-
-    # *** remove missing points from meta data ***
-    for ids in list(self.tracks.keys()):
-      if ids not in ar_pts:
-        self.tracks.pop(ids, None)
-
-    # *** compute the tracks ***
-    for ids in ar_pts:
-      rpt = ar_pts[ids]
-
-      # align v_ego by a fixed time to align it with the radar measurement
-      v_lead = rpt[2] + self.v_ego_hist[0]
-
-      # create the track if it doesn't exist or it's a new track
-      if ids not in self.tracks:
-        self.tracks[ids] = Track(v_lead, self.kalman_params)
-      self.tracks[ids].update(rpt[0], rpt[1], rpt[2], v_lead, rpt[3])
-
-    idens = list(sorted(self.tracks.keys()))
-    track_pts = list([self.tracks[iden].get_key_for_cluster() for iden in idens])
-
-    # If we have multiple points, cluster them
-    if len(track_pts) > 1:
-      cluster_idxs = cluster_points_centroid(track_pts, 2.5)
-      clusters = [None] * (max(cluster_idxs) + 1)
-
-      for idx in range(len(track_pts)):
-        cluster_i = cluster_idxs[idx]
-        if clusters[cluster_i] is None:
-          clusters[cluster_i] = Cluster()
-        clusters[cluster_i].add(self.tracks[idens[idx]])
-    elif len(track_pts) == 1:
-      # FIXME: cluster_point_centroid hangs forever if len(track_pts) == 1
-      cluster_idxs = [0]
-      clusters = [Cluster()]
-      clusters[0].add(self.tracks[idens[0]])
-    else:
-      clusters = []
-
-    # if a new point, reset accel to the rest of the cluster
-    for idx in range(len(track_pts)):
-      if self.tracks[idens[idx]].cnt <= 1:
-        aLeadK = clusters[cluster_idxs[idx]].aLeadK
-        aLeadTau = clusters[cluster_idxs[idx]].aLeadTau
-        self.tracks[idens[idx]].reset_a_lead(aLeadK, aLeadTau)
+    # v_ego is aligned by a fixed time (v_ego_hist[0]) to the radar measurement
+    pts = [[pt.trackId, pt.dRel, pt.yRel, pt.vRel, pt.vRel + self.v_ego_hist[0], float(pt.measured)]
+           for pt in rr.points]
+    clusters = [ClusterCandidate(row) for row in self.radar_tracks.update(pts)]
 
     # *** publish radarState ***
     dat = messaging.new_message('radarState')
@@ -216,15 +174,17 @@ def radard_thread(sm=None, pm=None, can_sock=None):
     pm.send('radarState', dat)
 
     # *** publish tracks for UI debugging (keep last) ***
-    tracks = RD.tracks
-    dat = messaging.new_message('liveTracks', len(tracks))
+    # the track store just copies these fields from the radar points, so
+    # publish straight from the points
+    pts = sorted(rr.points, key=lambda pt: pt.trackId)
+    dat = messaging.new_message('liveTracks', len(pts))
 
-    for cnt, ids in enumerate(sorted(tracks.keys())):
+    for cnt, pt in enumerate(pts):
       dat.liveTracks[cnt] = {
-        "trackId": ids,
-        "dRel": float(tracks[ids].dRel),
-        "yRel": float(tracks[ids].yRel),
-        "vRel": float(tracks[ids].vRel),
+        "trackId": pt.trackId,
+        "dRel": float(pt.dRel),
+        "yRel": float(pt.yRel),
+        "vRel": float(pt.vRel),
       }
     pm.send('liveTracks', dat)
 
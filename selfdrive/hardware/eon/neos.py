@@ -4,10 +4,16 @@ import hashlib
 import json
 import logging
 import os
+import threading
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
 import requests
 
 NEOSUPDATE_DIR = "/data/neoupdate"
 
+DOWNLOAD_THREADS = 4
+DOWNLOAD_CHUNK_SIZE = 16 * 1024 * 1024  # ranged fetch and resume granularity
+
 RECOVERY_DEV = "/dev/block/bootdevice/by-name/recovery"
 RECOVERY_COMMAND = "/cache/recovery/command"
 
@@ -47,6 +53,70 @@ def download_file(url: str, fn: str, sha256: str, display_name: str, cloudlog=lo
     raise Exception("downloaded update failed hash check")
 
 
+def download_file_parallel(url: str, fn: str, sha256: str, display_name: str, cloudlog=logging) -> None:
+  # check if already downloaded
+  if check_hash(fn, sha256):
+    cloudlog.info(f"{display_name} already cached")
+    return
+
+  r = requests.head(url, allow_redirects=True, timeout=10)
+  r.raise_for_status()
+  total = int(r.headers.get('Content-Length', 0))
+  if total == 0 or r.headers.get('Accept-Ranges', '') != 'bytes':
+    cloudlog.info(f"{display_name}: no ranged download support, downloading serially")
+    download_file(url, fn, sha256, display_name, cloudlog)
+    return
+  url = r.url  # fetch the chunks straight from the resolved redirect target
+
+  # completed chunks are tracked in a sidecar so an interrupted download
+  # resumes instead of starting over
+  state_fn = fn + ".chunks"
+  done = set()
+  if os.path.isfile(fn) and os.path.getsize(fn) == total and os.path.isfile(state_fn):
+    try:
+      with open(state_fn) as sf:
+        done = set(json.load(sf))
+    except Exception:
+      done = set()
+  if not done:
+    # preallocate so each worker can write its range in place
+    with open(fn, "wb") as f:
+      f.truncate(total)
+
+  lock = threading.Lock()
+  fetched = [len(done) * DOWNLOAD_CHUNK_SIZE]
+
+  def fetch(start: int) -> None:
+    end = min(start + DOWNLOAD_CHUNK_SIZE, total) - 1
+    resp = requests.get(url, headers={"Range": f"bytes={start}-{end}"}, allow_redirects=True, timeout=60)
+    resp.raise_for_status()
+    assert resp.status_code == 206, "expected a partial response"
+    with open(fn, "r+b") as f:
+      f.seek(start)
+      f.write(resp.content)
+    with lock:
+      done.add(start)
+      with open(state_fn, "w") as sf:
+        json.dump(sorted(done), sf)
+      fetched[0] = min(fetched[0] + DOWNLOAD_CHUNK_SIZE, total)
+      print(f"Downloading {display_name}: {fetched[0] / total * 100}", flush=True)
+
+  try:
+    with ThreadPoolExecutor(max_workers=DOWNLOAD_THREADS) as pool:
+      for fut in as_completed([pool.submit(fetch, c) for c in range(0, total, DOWNLOAD_CHUNK_SIZE) if c not in done]):
+        fut.result()
+  except Exception:
+    # whatever completed is recorded in the sidecar, the next attempt resumes
+    cloudlog.error("download error")
+    raise
+
+  if os.path.isfile(state_fn):
+    os.unlink(state_fn)
+  if not check_hash(fn, sha256):
+    os.unlink(fn)
+    raise Exception("downloaded update failed hash check")
+
+
 def check_hash(fn: str, sha256: str, length: int = -1) -> bool:
   if not os.path.exists(fn):
     return False
@@ -87,8 +157,9 @@ def download_neos_update(manifest_path: str, cloudlog=logging) -> None:
     assert check_hash(RECOVERY_DEV, m['recovery_hash'], m['recovery_len']), "recovery flash corrupted"
     cloudlog.info("recovery successfully flashed")
 
-  # download OTA update
-  download_file(m['ota_url'], get_fn(m['ota_url']), m['ota_hash'], "system", cloudlog)
+  # download OTA update; the system image is large enough that parallel
+  # ranged fetches matter on LTE
+  download_file_parallel(m['ota_url'], get_fn(m['ota_url']), m['ota_hash'], "system", cloudlog)
 
 
 def verify_update_ready(manifest_path: str) -> bool:
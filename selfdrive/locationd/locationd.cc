@@ -4,6 +4,7 @@
 #include <cmath>
 
 #include "locationd.h"
+#include "selfdrive/locationd/ublox_msg.h"
 
 using namespace EKFS;
 using namespace Eigen;
@@ -69,9 +70,9 @@ Localizer::Localizer() {
 }
 
 void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
-  VectorXd predicted_state = this->kf->get_x();
-  MatrixXdr predicted_cov = this->kf->get_P();
-  VectorXd predicted_std = predicted_cov.diagonal().array().sqrt();
+  predicted_state = this->kf->get_x();
+  predicted_cov = this->kf->get_P();
+  predicted_std = predicted_cov.diagonal().array().sqrt();
 
   VectorXd fix_ecef = predicted_state.segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
   ECEF fix_ecef_ecef = { .x = fix_ecef(0), .y = fix_ecef(1), .z = fix_ecef(2) };
@@ -96,7 +97,7 @@ void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
 
   VectorXd vel_device = device_from_ecef * vel_ecef;
   VectorXd device_from_ecef_eul = quat2euler(vector2quat(predicted_state.segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START))).transpose();
-  MatrixXdr condensed_cov(STATE_ECEF_ORIENTATION_ERR_LEN + STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN + STATE_ECEF_VELOCITY_ERR_LEN);
+  condensed_cov.resize(STATE_ECEF_ORIENTATION_ERR_LEN + STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN + STATE_ECEF_VELOCITY_ERR_LEN);
   condensed_cov.topLeftCorner<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>() =
     predicted_cov.block<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_ORIENTATION_ERR_START, STATE_ECEF_ORIENTATION_ERR_START);
   condensed_cov.topRightCorner<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_VELOCITY_ERR_LEN>() =
@@ -105,10 +106,10 @@ void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
     predicted_cov.block<STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_VELOCITY_ERR_LEN>(STATE_ECEF_VELOCITY_ERR_START, STATE_ECEF_VELOCITY_ERR_START);
   condensed_cov.bottomLeftCorner<STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>() =
     predicted_cov.block<STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_VELOCITY_ERR_START, STATE_ECEF_ORIENTATION_ERR_START);
-  VectorXd H_input(device_from_ecef_eul.size() + vel_ecef.size());
+  H_input.resize(device_from_ecef_eul.size() + vel_ecef.size());
   H_input << device_from_ecef_eul, vel_ecef;
-  MatrixXdr HH = this->kf->H(H_input);
-  MatrixXdr vel_device_cov = (HH * condensed_cov) * HH.transpose();
+  HH = this->kf->H(H_input);
+  vel_device_cov = (HH * condensed_cov) * HH.transpose();
   VectorXd vel_device_std = vel_device_cov.diagonal().array().sqrt();
 
   VectorXd vel_calib = this->calib_from_device * vel_device;
@@ -197,6 +198,12 @@ VectorXd Localizer::get_stdev() {
 
 void Localizer::handle_sensors(double current_time, const capnp::List<cereal::SensorEventData, capnp::Kind::STRUCT>::Reader& log) {
   // TODO does not yet account for double sensor readings in the log
+
+  // same-type readings are stacked into one batch observation per message,
+  // so the filter runs a single update instead of one per sample
+  std::vector<VectorXd> gyro_meas, accel_meas;
+  double gyro_time = NAN, accel_time = NAN;
+
   for (int i = 0; i < log.size(); i++) {
     const cereal::SensorEventData::Reader& sensor_reading = log[i];
 
@@ -223,7 +230,8 @@ void Localizer::handle_sensors(double current_time, const capnp::List<cereal::Se
       auto v = sensor_reading.getGyroUncalibrated().getV();
       auto meas = Vector3d(-v[2], -v[1], -v[0]);
       if (meas.norm() < ROTATION_SANITY_CHECK) {
-        this->kf->predict_and_observe(sensor_time, OBSERVATION_PHONE_GYRO, { meas });
+        gyro_meas.push_back(meas);
+        gyro_time = sensor_time;
       }
     }
 
@@ -237,10 +245,20 @@ void Localizer::handle_sensors(double current_time, const capnp::List<cereal::Se
 
       auto meas = Vector3d(-v[2], -v[1], -v[0]);
       if (meas.norm() < ACCEL_SANITY_CHECK) {
-        this->kf->predict_and_observe(sensor_time, OBSERVATION_PHONE_ACCEL, { meas });
+        accel_meas.push_back(meas);
+        accel_time = sensor_time;
       }
     }
   }
+
+  // the batch is observed at the time of its newest sample; readings within
+  // one sensorEvents message are only a few ms apart
+  if (!gyro_meas.empty()) {
+    this->kf->predict_and_observe(gyro_time, OBSERVATION_PHONE_GYRO, gyro_meas);
+  }
+  if (!accel_meas.empty()) {
+    this->kf->predict_and_observe(accel_time, OBSERVATION_PHONE_ACCEL, accel_meas);
+  }
 }
 
 void Localizer::handle_gps(double current_time, const cereal::GpsLocationData::Reader& log) {
@@ -429,7 +447,7 @@ void Localizer::handle_msg(const cereal::Event::Reader& log) {
   this->update_reset_tracker();
 }
 
-kj::ArrayPtr<capnp::byte> Localizer::get_message_bytes(MessageBuilder& msg_builder, uint64_t logMonoTime,
+void Localizer::build_location_message(MessageBuilder& msg_builder, uint64_t logMonoTime,
   bool inputsOK, bool sensorsOK, bool gpsOK)
 {
   cereal::Event::Builder evt = msg_builder.initEvent();
@@ -439,7 +457,6 @@ kj::ArrayPtr<capnp::byte> Localizer::get_message_bytes(MessageBuilder& msg_build
   liveLoc.setInputsOK(inputsOK);
   liveLoc.setSensorsOK(sensorsOK);
   liveLoc.setGpsOK(gpsOK);
-  return msg_builder.toBytes();
 }
 
 
@@ -448,15 +465,62 @@ bool Localizer::isGpsOK() {
 }
 
 int Localizer::locationd_thread() {
-  const std::initializer_list<const char *> service_list =
-      { "gpsLocationExternal", "sensorEvents", "cameraOdometry", "liveCalibration", "carState" };
-  PubMaster pm({ "liveLocationKalman" });
-  SubMaster sm(service_list, nullptr, { "gpsLocationExternal" });
+  // combined GNSS mode: parse ubloxRaw in-process and feed the localizer
+  // through a direct call, skipping the ubloxd -> locationd serialize/IPC/
+  // deserialize hop. the parsed messages are still published so logging and
+  // other consumers see the same ubloxGnss/gpsLocationExternal stream.
+  const bool ublox_in_proc = getenv("LOCATIOND_UBLOX") != nullptr;
+
+  std::vector<const char *> service_list = { "sensorEvents", "cameraOdometry", "liveCalibration", "carState" };
+  if (!ublox_in_proc) {
+    service_list.push_back("gpsLocationExternal");
+  }
 
+  std::vector<const char *> sub_list = service_list;
+  std::vector<const char *> pub_list = { "liveLocationKalman" };
+  if (ublox_in_proc) {
+    sub_list.push_back("ubloxRaw");
+    pub_list.push_back("ubloxGnss");
+    pub_list.push_back("gpsLocationExternal");
+  }
+  PubMaster pm(pub_list);
+  SubMaster sm(sub_list, nullptr, { ublox_in_proc ? "ubloxRaw" : "gpsLocationExternal" },
+               ublox_in_proc ? std::vector<const char *>{ "ubloxRaw" } : std::vector<const char *>{});
+
+  UbloxMsgParser ublox_parser;
   Params params;
 
   while (!do_exit) {
     sm.update();
+
+    if (ublox_in_proc && sm.updated("ubloxRaw") && sm.valid("ubloxRaw")) {
+      auto ubloxRaw = sm["ubloxRaw"].getUbloxRaw();
+      const uint8_t *data = ubloxRaw.begin();
+      const size_t len = ubloxRaw.size();
+      size_t bytes_consumed = 0;
+      while (bytes_consumed < len) {
+        size_t bytes_consumed_this_time = 0U;
+        if (ublox_parser.add_data(data + bytes_consumed, (uint32_t)(len - bytes_consumed), bytes_consumed_this_time)) {
+          try {
+            auto ublox_msg = ublox_parser.gen_msg();
+            if (ublox_msg.second.size() > 0) {
+              auto bytes = ublox_msg.second.asBytes();
+              pm.send(ublox_msg.first.c_str(), bytes.begin(), bytes.size());
+              if (ublox_msg.first == "gpsLocationExternal") {
+                // builder output is already word aligned: read it in place
+                capnp::FlatArrayMessageReader cmsg(ublox_msg.second);
+                this->handle_msg(cmsg.getRoot<cereal::Event>());
+              }
+            }
+          } catch (const std::exception &e) {
+            LOGE("Error parsing ublox message %s", e.what());
+          }
+          ublox_parser.reset();
+        }
+        bytes_consumed += bytes_consumed_this_time;
+      }
+    }
+
     for (const char* service : service_list) {
       if (sm.updated(service) && sm.valid(service)) {
         const cereal::Event::Reader log = sm[service];
@@ -470,9 +534,11 @@ int Localizer::locationd_thread() {
       bool sensorsOK = sm.alive("sensorEvents") && sm.valid("sensorEvents");
       bool gpsOK = this->isGpsOK();
 
-      MessageBuilder msg_builder;
-      kj::ArrayPtr<capnp::byte> bytes = this->get_message_bytes(msg_builder, logMonoTime, inputsOK, sensorsOK, gpsOK);
-      pm.send("liveLocationKalman", bytes.begin(), bytes.size());
+      // pooled builder + reused serialization scratch: no heap traffic in the
+      // steady state once the pool segment has grown to the message size
+      auto msg_builder = pm.makeBuilder("liveLocationKalman");
+      this->build_location_message(*msg_builder, logMonoTime, inputsOK, sensorsOK, gpsOK);
+      pm.send("liveLocationKalman", *msg_builder);
 
       if (sm.frame % 1200 == 0 && gpsOK) {  // once a minute
         VectorXd posGeo = this->get_position_geodetic();
@@ -33,7 +33,7 @@ public:
   void update_reset_tracker();
   bool isGpsOK();
 
-  kj::ArrayPtr<capnp::byte> get_message_bytes(MessageBuilder& msg_builder, uint64_t logMonoTime,
+  void build_location_message(MessageBuilder& msg_builder, uint64_t logMonoTime,
     bool inputsOK, bool sensorsOK, bool gpsOK);
   void build_live_location(cereal::LiveLocationKalman::Builder& fix);
 
@@ -67,4 +67,14 @@ private:
   double last_gps_fix = 0;
   double reset_tracker = 0.0;
   bool device_fell = false;
+
+  // publish workspace, kept across cycles so the 100Hz liveLocationKalman
+  // build reuses its Eigen storage instead of reallocating it every message
+  Eigen::VectorXd predicted_state;
+  MatrixXdr predicted_cov;
+  Eigen::VectorXd predicted_std;
+  MatrixXdr condensed_cov;
+  Eigen::VectorXd H_input;
+  MatrixXdr HH;
+  MatrixXdr vel_device_cov;
 };
@@ -42,6 +42,11 @@ LiveKalman::LiveKalman() {
   this->filter = std::make_shared<EKFSym>(this->name, get_mapmat(this->Q), get_mapvec(this->initial_x),
     get_mapmat(initial_P),  this->dim_state, this->dim_state_err, 0, 0, 0, std::vector<int>(),
     std::vector<int>{3}, std::vector<std::string>(), 0.2);
+  // split-rate predict: the 104Hz IMU stream propagates only the state,
+  // every 4th step carries the covariance over the accumulated interval.
+  // roughly halves the predict matrix math with no estimator degradation
+  // observed on highway logs.
+  this->filter->set_covariance_decimation(4);
 }
 
 void LiveKalman::init_state(VectorXd& state, VectorXd& covs_diag, double filter_time) {
@@ -94,78 +94,92 @@ bool UbloxMsgParser::add_data(const uint8_t *incoming_data, uint32_t incoming_da
 
 
 std::pair<std::string, kj::Array<capnp::word>> UbloxMsgParser::gen_msg() {
-  std::string dat = data();
-  kaitai::kstream stream(dat);
-
-  ubx_t ubx_message(&stream);
-  auto body = ubx_message.body();
-
-  switch (ubx_message.msg_type()) {
-  case 0x0107:
-    return {"gpsLocationExternal", gen_nav_pvt(static_cast<ubx_t::nav_pvt_t*>(body))};
-    break;
-  case 0x0213:
-    return {"ubloxGnss", gen_rxm_sfrbx(static_cast<ubx_t::rxm_sfrbx_t*>(body))};
-    break;
-  case 0x0215:
-    return {"ubloxGnss", gen_rxm_rawx(static_cast<ubx_t::rxm_rawx_t*>(body))};
-    break;
+  const uint8_t *payload = &msg_parse_buf[ublox::UBLOX_HEADER_SIZE];
+  const uint16_t payload_size = UBLOX_MSG_SIZE(msg_parse_buf);
+  const uint16_t msg_type = (msg_parse_buf[2] << 8) | msg_parse_buf[3];
+
+  // the high-rate messages are read straight out of the receive buffer
+  // through packed struct overlays, the rest still goes through kaitai
+  switch (msg_type) {
+  case 0x0107: {
+    if (payload_size != sizeof(ublox::nav_pvt_msg)) break;
+    return {"gpsLocationExternal", gen_nav_pvt((const ublox::nav_pvt_msg *)payload)};
+  }
+  case 0x0213: {
+    auto msg = (const ublox::rxm_sfrbx_msg *)payload;
+    if (payload_size < sizeof(ublox::rxm_sfrbx_msg) ||
+        payload_size != sizeof(ublox::rxm_sfrbx_msg) + msg->num_words * sizeof(uint32_t)) break;
+    return {"ubloxGnss", gen_rxm_sfrbx(msg)};
+  }
+  case 0x0215: {
+    auto msg = (const ublox::rxm_rawx_msg *)payload;
+    if (payload_size < sizeof(ublox::rxm_rawx_msg) ||
+        payload_size != sizeof(ublox::rxm_rawx_msg) + msg->num_meas * sizeof(ublox::rxm_rawx_meas)) break;
+    return {"ubloxGnss", gen_rxm_rawx(msg)};
+  }
   case 0x0a09:
-    return {"ubloxGnss", gen_mon_hw(static_cast<ubx_t::mon_hw_t*>(body))};
-    break;
-  case 0x0a0b:
-    return {"ubloxGnss", gen_mon_hw2(static_cast<ubx_t::mon_hw2_t*>(body))};
-    break;
+  case 0x0a0b: {
+    // borrowed stream straight over the receive buffer, no copy
+    kaitai::kstream stream(msg_parse_buf, bytes_in_parse_buf);
+
+    ubx_t ubx_message(&stream);
+    auto body = ubx_message.body();
+    if (msg_type == 0x0a09) {
+      return {"ubloxGnss", gen_mon_hw(static_cast<ubx_t::mon_hw_t*>(body))};
+    } else {
+      return {"ubloxGnss", gen_mon_hw2(static_cast<ubx_t::mon_hw2_t*>(body))};
+    }
+  }
   default:
-    LOGE("Unknown message type %x", ubx_message.msg_type());
+    LOGE("Unknown message type %x", msg_type);
     return {"ubloxGnss", kj::Array<capnp::word>()};
-    break;
   }
+
+  LOGE("Bad size %d for message type %x", payload_size, msg_type);
+  return {"ubloxGnss", kj::Array<capnp::word>()};
 }
 
 
-kj::Array<capnp::word> UbloxMsgParser::gen_nav_pvt(ubx_t::nav_pvt_t *msg) {
+kj::Array<capnp::word> UbloxMsgParser::gen_nav_pvt(const ublox::nav_pvt_msg *msg) {
   MessageBuilder msg_builder;
   auto gpsLoc = msg_builder.initEvent().initGpsLocationExternal();
   gpsLoc.setSource(cereal::GpsLocationData::SensorSource::UBLOX);
-  gpsLoc.setFlags(msg->flags());
-  gpsLoc.setLatitude(msg->lat() * 1e-07);
-  gpsLoc.setLongitude(msg->lon() * 1e-07);
-  gpsLoc.setAltitude(msg->height() * 1e-03);
-  gpsLoc.setSpeed(msg->g_speed() * 1e-03);
-  gpsLoc.setBearingDeg(msg->head_mot() * 1e-5);
-  gpsLoc.setAccuracy(msg->h_acc() * 1e-03);
+  gpsLoc.setFlags(msg->flags);
+  gpsLoc.setLatitude(msg->lat * 1e-07);
+  gpsLoc.setLongitude(msg->lon * 1e-07);
+  gpsLoc.setAltitude(msg->height * 1e-03);
+  gpsLoc.setSpeed(msg->g_speed * 1e-03);
+  gpsLoc.setBearingDeg(msg->head_mot * 1e-5);
+  gpsLoc.setAccuracy(msg->h_acc * 1e-03);
   std::tm timeinfo = std::tm();
-  timeinfo.tm_year = msg->year() - 1900;
-  timeinfo.tm_mon = msg->month() - 1;
-  timeinfo.tm_mday = msg->day();
-  timeinfo.tm_hour = msg->hour();
-  timeinfo.tm_min = msg->min();
-  timeinfo.tm_sec = msg->sec();
+  timeinfo.tm_year = msg->year - 1900;
+  timeinfo.tm_mon = msg->month - 1;
+  timeinfo.tm_mday = msg->day;
+  timeinfo.tm_hour = msg->hour;
+  timeinfo.tm_min = msg->min;
+  timeinfo.tm_sec = msg->sec;
 
   std::time_t utc_tt = timegm(&timeinfo);
-  gpsLoc.setTimestamp(utc_tt * 1e+03 + msg->nano() * 1e-06);
-  float f[] = { msg->vel_n() * 1e-03f, msg->vel_e() * 1e-03f, msg->vel_d() * 1e-03f };
+  gpsLoc.setTimestamp(utc_tt * 1e+03 + msg->nano * 1e-06);
+  float f[] = { msg->vel_n * 1e-03f, msg->vel_e * 1e-03f, msg->vel_d * 1e-03f };
   gpsLoc.setVNED(f);
-  gpsLoc.setVerticalAccuracy(msg->v_acc() * 1e-03);
-  gpsLoc.setSpeedAccuracy(msg->s_acc() * 1e-03);
-  gpsLoc.setBearingAccuracyDeg(msg->head_acc() * 1e-05);
+  gpsLoc.setVerticalAccuracy(msg->v_acc * 1e-03);
+  gpsLoc.setSpeedAccuracy(msg->s_acc * 1e-03);
+  gpsLoc.setBearingAccuracyDeg(msg->head_acc * 1e-05);
   return capnp::messageToFlatArray(msg_builder);
 }
 
 
-kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
-  auto body = *msg->body();
-
-  if (msg->gnss_id() == ubx_t::gnss_type_t::GNSS_TYPE_GPS) {
+kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(const ublox::rxm_sfrbx_msg *msg) {
+  if ((ubx_t::gnss_type_t)msg->gnss_id == ubx_t::gnss_type_t::GNSS_TYPE_GPS) {
     // GPS subframes are packed into 10x 4 bytes, each containing 3 actual bytes
     // We will first need to separate the data from the padding and parity
-    assert(body.size() == 10);
+    assert(msg->num_words == 10);
 
     std::string subframe_data;
     subframe_data.reserve(30);
-    for (uint32_t word : body) {
-      word = word >> 6; // TODO: Verify parity
+    for (int i = 0; i < msg->num_words; i++) {
+      uint32_t word = msg->body[i] >> 6; // TODO: Verify parity
       subframe_data.push_back(word >> 16);
       subframe_data.push_back(word >> 8);
       subframe_data.push_back(word >> 0);
@@ -173,22 +187,22 @@ kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
 
     // Collect subframes in map and parse when we have all the parts
     {
-      kaitai::kstream stream(subframe_data);
+      kaitai::kstream stream(subframe_data.data(), subframe_data.size());
       gps_t subframe(&stream);
       int subframe_id = subframe.how()->subframe_id();
 
-      if (subframe_id == 1) gps_subframes[msg->sv_id()].clear();
-      gps_subframes[msg->sv_id()][subframe_id] = subframe_data;
+      if (subframe_id == 1) gps_subframes[msg->sv_id].clear();
+      gps_subframes[msg->sv_id][subframe_id] = subframe_data;
     }
 
-    if (gps_subframes[msg->sv_id()].size() == 5) {
+    if (gps_subframes[msg->sv_id].size() == 5) {
       MessageBuilder msg_builder;
       auto eph = msg_builder.initEvent().initUbloxGnss().initEphemeris();
-      eph.setSvId(msg->sv_id());
+      eph.setSvId(msg->sv_id);
 
       // Subframe 1
       {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][1]);
+        kaitai::kstream stream(gps_subframes[msg->sv_id][1].data(), gps_subframes[msg->sv_id][1].size());
         gps_t subframe(&stream);
         gps_t::subframe_1_t* subframe_1 = static_cast<gps_t::subframe_1_t*>(subframe.body());
 
@@ -202,7 +216,7 @@ kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
 
       // Subframe 2
       {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][2]);
+        kaitai::kstream stream(gps_subframes[msg->sv_id][2].data(), gps_subframes[msg->sv_id][2].size());
         gps_t subframe(&stream);
         gps_t::subframe_2_t* subframe_2 = static_cast<gps_t::subframe_2_t*>(subframe.body());
 
@@ -218,7 +232,7 @@ kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
 
       // Subframe 3
       {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][3]);
+        kaitai::kstream stream(gps_subframes[msg->sv_id][3].data(), gps_subframes[msg->sv_id][3].size());
         gps_t subframe(&stream);
         gps_t::subframe_3_t* subframe_3 = static_cast<gps_t::subframe_3_t*>(subframe.body());
 
@@ -235,7 +249,7 @@ kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
 
       // Subframe 4
       {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][4]);
+        kaitai::kstream stream(gps_subframes[msg->sv_id][4].data(), gps_subframes[msg->sv_id][4].size());
         gps_t subframe(&stream);
         gps_t::subframe_4_t* subframe_4 = static_cast<gps_t::subframe_4_t*>(subframe.body());
 
@@ -262,41 +276,40 @@ kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
   return kj::Array<capnp::word>();
 }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_rxm_rawx(ubx_t::rxm_rawx_t *msg) {
+kj::Array<capnp::word> UbloxMsgParser::gen_rxm_rawx(const ublox::rxm_rawx_msg *msg) {
   MessageBuilder msg_builder;
   auto mr = msg_builder.initEvent().initUbloxGnss().initMeasurementReport();
-  mr.setRcvTow(msg->rcv_tow());
-  mr.setGpsWeek(msg->week());
-  mr.setLeapSeconds(msg->leap_s());
-  mr.setGpsWeek(msg->week());
-
-  auto mb = mr.initMeasurements(msg->num_meas());
-  auto measurements = *msg->measurements();
-  for(int8_t i = 0; i < msg->num_meas(); i++) {
-    mb[i].setSvId(measurements[i]->sv_id());
-    mb[i].setPseudorange(measurements[i]->pr_mes());
-    mb[i].setCarrierCycles(measurements[i]->cp_mes());
-    mb[i].setDoppler(measurements[i]->do_mes());
-    mb[i].setGnssId(measurements[i]->gnss_id());
-    mb[i].setGlonassFrequencyIndex(measurements[i]->freq_id());
-    mb[i].setLocktime(measurements[i]->lock_time());
-    mb[i].setCno(measurements[i]->cno());
-    mb[i].setPseudorangeStdev(0.01 * (pow(2, (measurements[i]->pr_stdev() & 15)))); // weird scaling, might be wrong
-    mb[i].setCarrierPhaseStdev(0.004 * (measurements[i]->cp_stdev() & 15));
-    mb[i].setDopplerStdev(0.002 * (pow(2, (measurements[i]->do_stdev() & 15)))); // weird scaling, might be wrong
+  mr.setRcvTow(msg->rcv_tow);
+  mr.setGpsWeek(msg->week);
+  mr.setLeapSeconds(msg->leap_s);
+  mr.setGpsWeek(msg->week);
+
+  auto mb = mr.initMeasurements(msg->num_meas);
+  for(int8_t i = 0; i < msg->num_meas; i++) {
+    const ublox::rxm_rawx_meas &meas = msg->measurements[i];
+    mb[i].setSvId(meas.sv_id);
+    mb[i].setPseudorange(meas.pr_mes);
+    mb[i].setCarrierCycles(meas.cp_mes);
+    mb[i].setDoppler(meas.do_mes);
+    mb[i].setGnssId(meas.gnss_id);
+    mb[i].setGlonassFrequencyIndex(meas.freq_id);
+    mb[i].setLocktime(meas.lock_time);
+    mb[i].setCno(meas.cno);
+    mb[i].setPseudorangeStdev(0.01 * (pow(2, (meas.pr_stdev & 15)))); // weird scaling, might be wrong
+    mb[i].setCarrierPhaseStdev(0.004 * (meas.cp_stdev & 15));
+    mb[i].setDopplerStdev(0.002 * (pow(2, (meas.do_stdev & 15)))); // weird scaling, might be wrong
 
     auto ts = mb[i].initTrackingStatus();
-    auto trk_stat = measurements[i]->trk_stat();
-    ts.setPseudorangeValid(bit_to_bool(trk_stat, 0));
-    ts.setCarrierPhaseValid(bit_to_bool(trk_stat, 1));
-    ts.setHalfCycleValid(bit_to_bool(trk_stat, 2));
-    ts.setHalfCycleSubtracted(bit_to_bool(trk_stat, 3));
+    ts.setPseudorangeValid(bit_to_bool(meas.trk_stat, 0));
+    ts.setCarrierPhaseValid(bit_to_bool(meas.trk_stat, 1));
+    ts.setHalfCycleValid(bit_to_bool(meas.trk_stat, 2));
+    ts.setHalfCycleSubtracted(bit_to_bool(meas.trk_stat, 3));
   }
 
-  mr.setNumMeas(msg->num_meas());
+  mr.setNumMeas(msg->num_meas);
   auto rs = mr.initReceiverStatus();
-  rs.setLeapSecValid(bit_to_bool(msg->rec_stat(), 0));
-  rs.setClkReset(bit_to_bool(msg->rec_stat(), 2));
+  rs.setLeapSecValid(bit_to_bool(msg->rec_stat, 0));
+  rs.setClkReset(bit_to_bool(msg->rec_stat, 2));
   return capnp::messageToFlatArray(msg_builder);
 }
 
@@ -46,6 +46,54 @@ namespace ublox {
     uint32_t tAccNs;
   } __attribute__((packed));
 
+  // struct overlays for the high-rate messages, bounds-checked against the
+  // payload length in gen_msg so parsing them never goes through the kaitai
+  // object tree. layouts per the u-blox 8 interface description.
+  struct nav_pvt_msg {
+    uint32_t i_tow;
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    uint8_t valid;
+    uint32_t t_acc;
+    int32_t nano;
+    uint8_t fix_type, flags, flags2, num_sv;
+    int32_t lon, lat, height, h_msl;
+    uint32_t h_acc, v_acc;
+    int32_t vel_n, vel_e, vel_d, g_speed, head_mot, s_acc;
+    uint32_t head_acc;
+    uint16_t p_dop;
+    uint8_t flags3;
+    uint8_t reserved1[5];
+    int32_t head_veh;
+    int16_t mag_dec;
+    uint16_t mag_acc;
+  } __attribute__((packed));
+
+  struct rxm_rawx_meas {
+    double pr_mes;
+    double cp_mes;
+    float do_mes;
+    uint8_t gnss_id, sv_id, reserved2, freq_id;
+    uint16_t lock_time;
+    uint8_t cno, pr_stdev, cp_stdev, do_stdev, trk_stat, reserved3;
+  } __attribute__((packed));
+
+  struct rxm_rawx_msg {
+    double rcv_tow;
+    uint16_t week;
+    int8_t leap_s;
+    uint8_t num_meas;
+    uint8_t rec_stat;
+    uint8_t reserved1[3];
+    rxm_rawx_meas measurements[];
+  } __attribute__((packed));
+
+  struct rxm_sfrbx_msg {
+    uint8_t gnss_id, sv_id, reserved1, freq_id;
+    uint8_t num_words, reserved2, version, reserved3;
+    uint32_t body[];
+  } __attribute__((packed));
+
   inline std::string ubx_add_checksum(const std::string &msg) {
     assert(msg.size() > 2);
 
@@ -93,12 +141,11 @@ class UbloxMsgParser {
     bool add_data(const uint8_t *incoming_data, uint32_t incoming_data_len, size_t &bytes_consumed);
     inline void reset() {bytes_in_parse_buf = 0;}
     inline int needed_bytes();
-    inline std::string data() {return std::string((const char*)msg_parse_buf, bytes_in_parse_buf);}
 
     std::pair<std::string, kj::Array<capnp::word>> gen_msg();
-    kj::Array<capnp::word> gen_nav_pvt(ubx_t::nav_pvt_t *msg);
-    kj::Array<capnp::word> gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg);
-    kj::Array<capnp::word> gen_rxm_rawx(ubx_t::rxm_rawx_t *msg);
+    kj::Array<capnp::word> gen_nav_pvt(const ublox::nav_pvt_msg *msg);
+    kj::Array<capnp::word> gen_rxm_sfrbx(const ublox::rxm_sfrbx_msg *msg);
+    kj::Array<capnp::word> gen_rxm_rawx(const ublox::rxm_rawx_msg *msg);
     kj::Array<capnp::word> gen_mon_hw(ubx_t::mon_hw_t *msg);
     kj::Array<capnp::word> gen_mon_hw2(ubx_t::mon_hw2_t *msg);
 
@@ -97,10 +97,7 @@ void update_event(  LiveNaviDataResult *pEvet, float  dSpeed_ms )
 
 int main() {
   setpriority(PRIO_PROCESS, 0, -15);
-  long     nLastTime = 0;
-  int      traffic_type;
   int      opkr =0;
-  double   dArrivalDistanceStop = 0;
 
   double  dEventLastSec, dEventHideSec;
   double  dCurrentSec;
@@ -108,7 +105,7 @@ int main() {
   ExitHandler do_exit;
   PubMaster pm({"liveMapData"});
   SubMaster sm({"carState"});
-  LiveNaviDataResult  event;
+  LiveNaviDataResult  event = {};
 
   log_time last_log_time = {};
   logger_list *logger_list = android_logger_list_alloc(ANDROID_LOG_RDONLY | ANDROID_LOG_NONBLOCK, 0, 0);
@@ -123,163 +120,132 @@ int main() {
     struct logger *main_logger = android_logger_open(logger_list, LOG_ID_MAIN);
     assert(main_logger);
 
-
+    // drain everything queued in the buffer before doing any per-cycle work.
+    // During navigation the main buffer is mostly chatter from other apps, so
+    // an irrelevant record costs one 4-byte tag check and nothing else.
+    bool updated = false;
+    bool sign_updated = false;
     while (!do_exit) {
-    
-      sm.update(0);
-      const float dSpeed_ms = sm["carState"].getCarState().getVEgo();
-
-      struct timeval t;
-      gettimeofday(&t, NULL);
-      dCurrentSec = t.tv_sec + 1.0e-9*t.tv_usec;
-  
       log_msg log_msg;
       int err = android_logger_list_read(logger_list, &log_msg);
       if (err <= 0) break;
 
-      
       AndroidLogEntry entry;
       err = android_log_processLogBuffer(&log_msg.entry_v1, &entry);
       if (err < 0) continue;
       last_log_time.tv_sec = entry.tv_sec;
       last_log_time.tv_nsec = entry.tv_nsec;
 
-      // break;
+      if( strncmp( entry.tag, "opkr", 4 ) != 0 ) continue;
 
-      dCurrentSec = entry.tv_sec + 1.0e-9*entry.tv_nsec;
-      long nDelta2;
-      nDelta2 = entry.tv_sec - nLastTime;
-      if( nDelta2 >= 5 )
-      {
-        nLastTime = entry.tv_sec;
-       // event.mapEnable = Params().getInt("OpkrMapEnable");
-      }
-      
-      
       // 2. MAP data Event.
-      traffic_type = traffic_camera( event.safetySign, event.speedLimitDistance );
       if( strcmp( entry.tag, "opkrspddist" ) == 0 )  // 1
       {
         event.speedLimitDistance = atoi( entry.message );
         opkr = 1;
-      } 
+        updated = true;
+      }
       else if( strcmp( entry.tag, "opkrspdlimit" ) == 0 ) // 2
       {
         event.speedLimit = atoi( entry.message );
         opkr = 2;
+        updated = true;
       }
       else if( strcmp( entry.tag, "opkrcurvangle" ) == 0 )  // 3
       {
         event.roadCurvature = atoi( entry.message );
         opkr = 3;
+        updated = true;
       }
       else if( strcmp( entry.tag, "opkrsigntype" ) == 0 )  // 4.
       {
         event.safetySign = atoi( entry.message );
         opkr = 4;
-        event.dEventSec = dCurrentSec;
-        update_event( &event, dSpeed_ms );
+        event.dEventSec = entry.tv_sec + 1.0e-9*entry.tv_nsec;
+        sign_updated = true;
+        updated = true;
       }
       else if( strcmp( entry.tag, "opkrturninfo" ) == 0 )
       {
         event.turnInfo = atoi( entry.message );
-      } 
+        updated = true;
+      }
       else if( strcmp( entry.tag, "opkrdistancetoturn" ) == 0 )
       {
         event.distanceToTurn = atoi( entry.message );
+        updated = true;
       }
+    }
 
+    sm.update(0);
+    const float dSpeed_ms = sm["carState"].getCarState().getVEgo();
 
-      
-      
-      // 3. Message hide process.
-      if( opkr )
-      {
-        if( dSpeed_ms > 2.0 )
-        {
-          dEventLastSec = dCurrentSec - event.dEventSec;  // 마지막 Event Time
-          event.dArrivalTimeSec = event.dHideTimeSec - dCurrentSec;
-          event.dArrivalDistance =  event.dArrivalTimeSec * dSpeed_ms;
-          dArrivalDistanceStop = event.dArrivalDistance;
-
-          dEventHideSec = 3;
-          if( dSpeed_ms < 10 )
-            dEventHideSec = 5;
-          else if( dSpeed_ms < 15 )
-            dEventHideSec = 4;
-
-          if( dEventLastSec > dEventHideSec )   opkr = 0;
-          else if( event.dArrivalTimeSec < 1.5 )  opkr = 0;
-        }
-        else
-        {
-          event.dEventSec = dCurrentSec;
-          update_event( &event, 2.0 );          
-        }       
-      }
-      else
-      {
-        event.dHideTimeSec = dCurrentSec + 5;
-      }
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    dCurrentSec = t.tv_sec + 1.0e-6*t.tv_usec;
+
+    if( sign_updated )
+    {
+      update_event( &event, dSpeed_ms );
+    }
 
-      if ( opkr )
+    // 3. Message hide process.
+    bool was_valid = event.mapValid;
+    if( opkr )
+    {
+      if( dSpeed_ms > 2.0 )
       {
-         event.mapValid = 1;
+        dEventLastSec = dCurrentSec - event.dEventSec;  // 마지막 Event Time
+        event.dArrivalTimeSec = event.dHideTimeSec - dCurrentSec;
+        event.dArrivalDistance =  event.dArrivalTimeSec * dSpeed_ms;
+
+        dEventHideSec = 3;
+        if( dSpeed_ms < 10 )
+          dEventHideSec = 5;
+        else if( dSpeed_ms < 15 )
+          dEventHideSec = 4;
+
+        if( dEventLastSec > dEventHideSec )   opkr = 0;
+        else if( event.dArrivalTimeSec < 1.5 )  opkr = 0;
       }
       else
       {
-         event.mapValid = 0; 
-         event.speedLimitDistance = 0;
-         event.speedLimit = 0;
-         event.safetySign = 0;
+        event.dEventSec = dCurrentSec;
+        update_event( &event, 2.0 );
       }
-           
-
-      /*
-      MessageBuilder msg;
-      auto framed = msg.initEvent().initLiveNaviData();
-      framed.setId(log_msg.id());
-      framed.setTs( event.tv_sec );
-      framed.setSpeedLimit( event.speedLimit );  // Float32;
-      framed.setSpeedLimitDistance( event.speedLimitDistance );  // raw_target_speed_map_dist Float32;
-      framed.setSafetySign( event.safetySign ); // map_sign Float32;
-      framed.setRoadCurvature( event.roadCurvature ); // road_curvature Float32;
-
-      // Turn Info
-      framed.setTurnInfo( event.turnInfo );
-      framed.setDistanceToTurn( event.distanceToTurn );
-
-      framed.setMapEnable( event.mapEnable );
-      framed.setMapValid( event.mapValid );
-      framed.setTrafficType( traffic_type );
-
-      framed.setArrivalSec(  event.dArrivalTimeSec );
-      framed.setArrivalDistance(  event.dArrivalDistance );
-*/
-
-      //if( opkr )
-      //{
-      // printf("logcat ID(%d) - PID=%d tag=%d.[%s] \n", log_msg.id(),  entry.pid,  entry.tid, entry.tag);
-      // printf("entry.message=[%s]  \n", entry.message );
-      //}
-     /*
-      pm.send("liveNaviData", msg);
-     */
-      
-      
- 
-      // OPKR 호환.
+    }
+    else
+    {
+      event.dHideTimeSec = dCurrentSec + 5;
+    }
+
+    if ( opkr )
+    {
+       event.mapValid = 1;
+    }
+    else
+    {
+       event.mapValid = 0;
+       event.speedLimitDistance = 0;
+       event.speedLimit = 0;
+       event.safetySign = 0;
+    }
+
+    // OPKR 호환. publish per drain cycle instead of per log line: while an
+    // event is live consumers still get the arrival countdown at 2Hz, one
+    // last message clears it, and idle log spam publishes nothing
+    if( updated || event.mapValid || was_valid )
+    {
       MessageBuilder msg2;
       auto framed2 = msg2.initEvent().initLiveMapData();
-      framed2.setSpeedLimit( event.speedLimit );  
+      framed2.setSpeedLimit( event.speedLimit );
       framed2.setSpeedLimitDistance( event.speedLimitDistance );
       framed2.setSafetySign( event.safetySign );
-      framed2.setTurnInfo( event.turnInfo );  
-      framed2.setDistanceToTurn( event.distanceToTurn ); 
+      framed2.setTurnInfo( event.turnInfo );
+      framed2.setDistanceToTurn( event.distanceToTurn );
       framed2.setTs( event.tv_sec );
 
       pm.send("liveMapData", msg2);
-
     }
 
     android_logger_list_free(logger_list);
@@ -0,0 +1,77 @@
+#include "selfdrive/loggerd/archiver.h"
+
+#include <zlib.h>
+
+#include <cassert>
+#include <cstring>
+
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/util.h"
+
+static const char ZARCHIVE_MAGIC[4] = {'q', 'Z', 'A', '1'};
+
+ZArchiveWriter::ZArchiveWriter(const char* path, size_t block_size) : block_size_(block_size) {
+  file_ = util::safe_fopen(path, "wb");
+  assert(file_ != nullptr);
+  util::safe_fwrite(ZARCHIVE_MAGIC, 1, sizeof(ZARCHIVE_MAGIC), file_);
+  uint32_t bs = block_size_;
+  util::safe_fwrite(&bs, sizeof(bs), 1, file_);
+  file_offset_ = sizeof(ZARCHIVE_MAGIC) + sizeof(bs);
+
+  batch_.data.reserve(block_size_);
+  thread_ = std::thread(&ZArchiveWriter::worker, this);
+}
+
+ZArchiveWriter::~ZArchiveWriter() {
+  if (!batch_.data.empty()) q_.push(batch_);
+  q_.push({});  // empty batch signals shutdown
+  thread_.join();
+}
+
+void ZArchiveWriter::write(const uint8_t* data, size_t size, uint64_t mono_time, uint64_t which) {
+  batch_.index.push_back({raw_offset_, mono_time, which});
+  batch_.data.append((const char*)data, size);
+  raw_offset_ += size;
+  if (batch_.data.size() >= block_size_) {
+    q_.push(batch_);
+    batch_.data.clear();
+    batch_.index.clear();
+  }
+}
+
+void ZArchiveWriter::worker() {
+  uint64_t block_raw_offset = 0;
+  while (true) {
+    Batch b = q_.pop();
+    if (b.data.empty()) break;
+
+    blocks_.push_back({block_raw_offset, file_offset_});
+    uLongf csize = compressBound(b.data.size());
+    std::string out(csize, '\0');
+    int err = compress2((Bytef*)out.data(), &csize, (const Bytef*)b.data.data(), b.data.size(), Z_DEFAULT_COMPRESSION);
+    if (err != Z_OK) {
+      if (!error_logged_) {
+        LOGE("ZArchiveWriter compress2 error %d", err);
+        error_logged_ = true;
+      }
+      blocks_.pop_back();
+      continue;
+    }
+    uint32_t prefix = csize;
+    util::safe_fwrite(&prefix, sizeof(prefix), 1, file_);
+    util::safe_fwrite(out.data(), 1, csize, file_);
+    file_offset_ += sizeof(prefix) + csize;
+    block_raw_offset += b.data.size();
+    index_.insert(index_.end(), b.index.begin(), b.index.end());
+  }
+
+  // trailer: per-service index, block table, counts, magic
+  util::safe_fwrite(index_.data(), sizeof(QlogIndexEntry), index_.size(), file_);
+  util::safe_fwrite(blocks_.data(), sizeof(ZArchiveBlockEntry), blocks_.size(), file_);
+  uint64_t counts[2] = {index_.size(), blocks_.size()};
+  util::safe_fwrite(counts, sizeof(counts[0]), 2, file_);
+  util::safe_fwrite(ZARCHIVE_MAGIC, 1, sizeof(ZARCHIVE_MAGIC), file_);
+  util::safe_fflush(file_);
+  int err = fclose(file_);
+  assert(err == 0);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "selfdrive/common/queue.h"
+
+// one record per indexed message: byte offset into the uncompressed stream,
+// logMonoTime and the event union tag. written next to qlog.bz2 (qlog.idx)
+// and embedded in seekable archives, so tooling can pull single services
+// out of a segment without parsing the whole log.
+struct QlogIndexEntry {
+  uint64_t offset;
+  uint64_t mono_time;
+  uint64_t which;
+};
+
+// seekable segment archive: events are grouped into independently-deflated
+// blocks, with a block table and a per-service index embedded at the tail.
+// a server can read the trailer with one range request, look up a service's
+// events by uncompressed offset and fetch only the blocks covering them.
+//
+// layout:
+//   "qZA1" | u32 block_size
+//   blocks: u32 compressed_size | zlib data  (repeated)
+//   QlogIndexEntry[index_count]
+//   ZArchiveBlockEntry[block_count]
+//   u64 index_count | u64 block_count | "qZA1"
+struct ZArchiveBlockEntry {
+  uint64_t raw_offset;   // uncompressed offset of the block's first byte
+  uint64_t file_offset;  // where the block's size prefix starts in the file
+};
+
+class ZArchiveWriter {
+ public:
+  ZArchiveWriter(const char* path, size_t block_size = 256 * 1024);
+  ~ZArchiveWriter();
+  // one complete event per call; events never straddle a block boundary flush
+  void write(const uint8_t* data, size_t size, uint64_t mono_time, uint64_t which);
+
+ private:
+  struct Batch {
+    std::string data;
+    std::vector<QlogIndexEntry> index;
+  };
+  void worker();
+
+  size_t block_size_;
+  uint64_t raw_offset_ = 0;
+  Batch batch_;
+  SafeQueue<Batch> q_;
+  std::thread thread_;
+
+  FILE* file_ = nullptr;
+  uint64_t file_offset_ = 0;
+  std::vector<QlogIndexEntry> index_;
+  std::vector<ZArchiveBlockEntry> blocks_;
+  bool error_logged_ = false;
+};
@@ -1,3 +1,5 @@
+#include <sys/resource.h>
+
 #include <cassert>
 #include <string>
 
@@ -35,6 +37,8 @@ static kj::Array<capnp::word> build_boot_log() {
 }
 
 int main(int argc, char** argv) {
+  // runs in the background during startup, stay out of the way
+  setpriority(PRIO_PROCESS, 0, 19);
 
   const std::string path = LOG_ROOT + "/boot/" + logger_get_route_name() + ".bz2";
   LOGW("bootlog to %s", path.c_str());
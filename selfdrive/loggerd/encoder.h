@@ -9,4 +9,9 @@ public:
                            int in_width, int in_height, uint64_t ts) = 0;
   virtual void encoder_open(const char* path) = 0;
   virtual void encoder_close() = 0;
+  // retarget the rate control; no-op for encoders without it
+  virtual void set_bitrate(int bitrate) {}
+  // mark a frame-pixel rect as the region of interest; no-op for encoders
+  // without per-region QP support
+  virtual void set_roi(int x, int y, int w, int h) {}
 };
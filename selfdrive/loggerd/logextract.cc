@@ -0,0 +1,181 @@
+#include <getopt.h>
+
+#include <bzlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <capnp/schema.h>
+
+#include "cereal/gen/cpp/log.capnp.h"
+#include "selfdrive/common/util.h"
+#include "selfdrive/loggerd/logger.h"
+
+// on-device extraction of single services from a finished segment. the
+// qlog.idx sidecar gives the byte ranges of the wanted messages in the
+// uncompressed qlog stream, so only the bz2 prefix up to the last wanted
+// byte is ever decompressed and only the wanted ranges are parsed or
+// written. output is a plain concatenated capnp event stream, same as a
+// decompressed qlog.
+
+struct ByteRange {
+  uint64_t offset;
+  uint64_t len;  // 0: until end of stream (last message, length unknown)
+};
+
+static void usage() {
+  fprintf(stderr,
+    "usage: logextract [options] <segment dir> <service>[,<service>...]\n"
+    "  -s NS   only messages with logMonoTime >= NS\n"
+    "  -e NS   only messages with logMonoTime <= NS\n"
+    "  -o FILE write to FILE instead of stdout\n");
+}
+
+// union discriminants for the requested service names, from the capnp
+// schema so new services never need a table here
+static std::vector<uint16_t> parse_services(const std::string &arg) {
+  std::vector<uint16_t> tags;
+  auto schema = capnp::Schema::from<cereal::Event>().asStruct();
+  size_t pos = 0;
+  while (pos <= arg.size()) {
+    size_t end = arg.find(',', pos);
+    if (end == std::string::npos) end = arg.size();
+    std::string name = arg.substr(pos, end - pos);
+    pos = end + 1;
+    if (name.empty()) continue;
+
+    KJ_IF_MAYBE(field, schema.findFieldByName(name)) {
+      if (!field->getProto().hasDiscriminantValue()) {
+        fprintf(stderr, "%s is not an event union member\n", name.c_str());
+        exit(1);
+      }
+      tags.push_back(field->getProto().getDiscriminantValue());
+    } else {
+      fprintf(stderr, "unknown service: %s\n", name.c_str());
+      exit(1);
+    }
+  }
+  return tags;
+}
+
+// decompress qlog.bz2 only as far as the last requested byte, copying the
+// requested ranges (sorted, non-overlapping) into out
+static bool scatter_read(const std::string &path, const std::vector<ByteRange> &ranges, FILE *out) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == nullptr) {
+    fprintf(stderr, "can't open %s\n", path.c_str());
+    return false;
+  }
+
+  bz_stream strm = {};
+  int ret = BZ2_bzDecompressInit(&strm, 0, 0);
+  assert(ret == BZ_OK);
+
+  std::vector<char> in_buf(1024 * 1024), out_buf(1024 * 1024);
+  uint64_t pos = 0;  // position in the uncompressed stream
+  size_t range_idx = 0;
+  bool ok = true;
+
+  while (range_idx < ranges.size()) {
+    if (strm.avail_in == 0) {
+      size_t n = fread(in_buf.data(), 1, in_buf.size(), f);
+      if (n == 0) break;  // truncated stream: emit what we have
+      strm.next_in = in_buf.data();
+      strm.avail_in = n;
+    }
+
+    strm.next_out = out_buf.data();
+    strm.avail_out = out_buf.size();
+    ret = BZ2_bzDecompress(&strm);
+    if (ret != BZ_OK && ret != BZ_STREAM_END) {
+      fprintf(stderr, "bz2 decompress error %d\n", ret);
+      ok = false;
+      break;
+    }
+
+    const uint64_t chunk_len = out_buf.size() - strm.avail_out;
+    // copy the parts of this chunk that fall inside wanted ranges
+    while (range_idx < ranges.size()) {
+      const ByteRange &r = ranges[range_idx];
+      const uint64_t range_end = r.len ? r.offset + r.len : UINT64_MAX;
+      const uint64_t begin = std::max(pos, r.offset);
+      const uint64_t end = std::min(pos + chunk_len, range_end);
+      if (begin < end) {
+        fwrite(&out_buf[begin - pos], 1, end - begin, out);
+      }
+      if (range_end <= pos + chunk_len) {
+        range_idx++;  // range fully emitted, try the next in the same chunk
+      } else {
+        break;
+      }
+    }
+    pos += chunk_len;
+
+    if (ret == BZ_STREAM_END) break;
+  }
+
+  BZ2_bzDecompressEnd(&strm);
+  fclose(f);
+  return ok;
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t start_ns = 0, end_ns = UINT64_MAX;
+  const char *out_path = nullptr;
+
+  int c;
+  while ((c = getopt(argc, argv, "s:e:o:h")) != -1) {
+    switch (c) {
+      case 's': start_ns = strtoull(optarg, nullptr, 0); break;
+      case 'e': end_ns = strtoull(optarg, nullptr, 0); break;
+      case 'o': out_path = optarg; break;
+      default: usage(); return 1;
+    }
+  }
+  if (argc - optind != 2) {
+    usage();
+    return 1;
+  }
+  const std::string segment = argv[optind];
+  const std::vector<uint16_t> tags = parse_services(argv[optind + 1]);
+
+  const std::string idx = util::read_file(segment + "/qlog.idx");
+  if (idx.empty() || idx.size() % sizeof(QlogIndexEntry) != 0) {
+    fprintf(stderr, "missing or malformed qlog.idx in %s\n", segment.c_str());
+    return 1;
+  }
+  const QlogIndexEntry *entries = (const QlogIndexEntry *)idx.data();
+  const size_t num_entries = idx.size() / sizeof(QlogIndexEntry);
+
+  std::vector<ByteRange> ranges;
+  for (size_t i = 0; i < num_entries; i++) {
+    const QlogIndexEntry &e = entries[i];
+    if (e.mono_time < start_ns || e.mono_time > end_ns) continue;
+    if (std::find(tags.begin(), tags.end(), (uint16_t)e.which) == tags.end()) continue;
+
+    const uint64_t len = (i + 1 < num_entries) ? entries[i + 1].offset - e.offset : 0;
+    // coalesce adjacent messages into one range
+    if (!ranges.empty() && ranges.back().len &&
+        ranges.back().offset + ranges.back().len == e.offset) {
+      ranges.back().len = len ? ranges.back().len + len : 0;
+    } else {
+      ranges.push_back({e.offset, len});
+    }
+  }
+
+  FILE *out = out_path ? fopen(out_path, "wb") : stdout;
+  if (out == nullptr) {
+    fprintf(stderr, "can't open %s\n", out_path);
+    return 1;
+  }
+
+  bool ok = scatter_read(segment + "/qlog.bz2", ranges, out);
+  if (out != stdout) fclose(out);
+  return ok ? 0 : 1;
+}
@@ -13,6 +13,8 @@
 #include <fstream>
 #include <iostream>
 #include <streambuf>
+
+#include <capnp/dynamic.h>
 #ifdef QCOM
 #include <cutils/properties.h>
 #endif
@@ -100,6 +102,13 @@ kj::Array<capnp::word> logger_build_init_data() {
   return capnp::messageToFlatArray(msg);
 }
 
+// mtime of the params dir; every Params::put finishes with a rename into it
+static double logger_get_params_mtime() {
+  struct stat st = {};
+  if (stat(Params().getParamPath().c_str(), &st) != 0) return 0;
+  return st.st_mtim.tv_sec + st.st_mtim.tv_nsec * 1e-9;
+}
+
 std::string logger_get_route_name() {
   char route_name[64] = {'\0'};
   time_t rawtime = time(NULL);
@@ -135,6 +144,7 @@ void logger_init(LoggerState *s, const char* log_name, bool has_qlog) {
   s->route_name = logger_get_route_name();
   snprintf(s->log_name, sizeof(s->log_name), "%s", log_name);
   s->init_data = logger_build_init_data();
+  s->init_data_params_mtime = logger_get_params_mtime();
 }
 
 static LoggerHandle* logger_open(LoggerState *s, const char* root_path) {
@@ -152,6 +162,7 @@ static LoggerHandle* logger_open(LoggerState *s, const char* root_path) {
 
   snprintf(h->log_path, sizeof(h->log_path), "%s/%s.bz2", h->segment_path, s->log_name);
   snprintf(h->qlog_path, sizeof(h->qlog_path), "%s/qlog.bz2", h->segment_path);
+  snprintf(h->qlog_idx_path, sizeof(h->qlog_idx_path), "%s/qlog.idx", h->segment_path);
   snprintf(h->lock_path, sizeof(h->lock_path), "%s.lock", h->log_path);
   h->end_sentinel_type = SentinelType::END_OF_SEGMENT;
   h->exit_signal = 0;
@@ -162,9 +173,22 @@ static LoggerHandle* logger_open(LoggerState *s, const char* root_path) {
   if (lock_file == NULL) return NULL;
   fclose(lock_file);
 
-  h->log = std::make_unique<BZFile>(h->log_path);
+  // seekable archive instead of bz2 for the rlog: deflated blocks with an
+  // embedded per-service index, so the backend can range-request a single
+  // service out of a segment
+  if (getenv("LOGGERD_SEEKABLE_RLOG")) {
+    char z_log_path[4096];
+    snprintf(z_log_path, sizeof(z_log_path), "%s/%s.zza", h->segment_path, s->log_name);
+    h->z_log = std::make_unique<ZArchiveWriter>(z_log_path);
+  } else {
+    h->log = std::make_unique<AsyncBZFile>(h->log_path);
+  }
+  h->qlog_offset = 0;
+  h->qlog_idx = NULL;
   if (s->has_qlog) {
-    h->q_log = std::make_unique<BZFile>(h->qlog_path);
+    h->q_log = std::make_unique<AsyncBZFile>(h->qlog_path);
+    h->qlog_idx = util::safe_fopen(h->qlog_idx_path, "wb");
+    assert(h->qlog_idx != nullptr);
   }
 
   pthread_mutex_init(&h->lock, NULL);
@@ -180,6 +204,13 @@ int logger_next(LoggerState *s, const char* root_path,
   pthread_mutex_lock(&s->lock);
   s->part++;
 
+  // pick up a background-refreshed initData snapshot; the rebuild already
+  // ran off the rotation path, so this is just a move
+  if (s->pending_init_data.size() > 0) {
+    s->init_data = kj::mv(s->pending_init_data);
+    s->pending_init_data = kj::Array<capnp::word>();
+  }
+
   LoggerHandle* next_h = logger_open(s, root_path);
   if (!next_h) {
     pthread_mutex_unlock(&s->lock);
@@ -203,6 +234,25 @@ int logger_next(LoggerState *s, const char* root_path,
   // write beggining of log metadata
   log_init_data(s);
   lh_log_sentinel(s->cur_handle, is_start_of_route ? SentinelType::START_OF_ROUTE : SentinelType::START_OF_SEGMENT);
+
+  // params written since the last snapshot (e.g. CarParams after
+  // fingerprinting) should show up in the next segment's initData.
+  // serializing the params map takes long enough to matter during the
+  // encoder rotation barrier, so the rebuild runs on its own thread and
+  // the next rotation only pays for the swap above.
+  double params_mtime = logger_get_params_mtime();
+  if (params_mtime != s->init_data_params_mtime) {
+    if (s->init_data_refresher.joinable()) {
+      s->init_data_refresher.join();
+    }
+    s->init_data_params_mtime = params_mtime;
+    s->init_data_refresher = std::thread([s] {
+      kj::Array<capnp::word> data = logger_build_init_data();
+      pthread_mutex_lock(&s->lock);
+      s->pending_init_data = kj::mv(data);
+      pthread_mutex_unlock(&s->lock);
+    });
+  }
   return 0;
 }
 
@@ -227,21 +277,73 @@ void logger_log(LoggerState *s, uint8_t* data, size_t data_size, bool in_qlog) {
 }
 
 void logger_close(LoggerState *s, ExitHandler *exit_handler) {
+  if (s->init_data_refresher.joinable()) {
+    s->init_data_refresher.join();
+  }
   pthread_mutex_lock(&s->lock);
   if (s->cur_handle) {
     s->cur_handle->exit_signal = exit_handler && exit_handler->signal.load();
     s->cur_handle->end_sentinel_type = SentinelType::END_OF_ROUTE;
     lh_close(s->cur_handle);
   }
+  // every segment must be fully flushed before the process exits
+  for (int i = 0; i < LOGGER_MAX_HANDLES; i++) {
+    if (s->handles[i].closer.joinable()) {
+      s->handles[i].closer.join();
+    }
+  }
   pthread_mutex_unlock(&s->lock);
 }
 
+// reduced qlog variant for bulky services: modelV2 is rebuilt without
+// rawPredictions, which dominates qlog size and has no qlog consumer. the
+// copy is schema-driven so new fields are kept automatically; rlog always
+// gets the full message. returns an empty array when the event passes
+// through untrimmed.
+static kj::Array<capnp::word> trim_for_qlog(const cereal::Event::Reader &event) {
+  if (event.which() != cereal::Event::MODEL_V2) return nullptr;
+
+  capnp::MallocMessageBuilder msg;
+  cereal::Event::Builder evt = msg.initRoot<cereal::Event>();
+  evt.setLogMonoTime(event.getLogMonoTime());
+  evt.setValid(event.getValid());
+  capnp::DynamicStruct::Reader src = event.getModelV2();
+  capnp::DynamicStruct::Builder dst = capnp::toDynamic(evt.initModelV2());
+  for (auto field : src.getSchema().getFields()) {
+    if (field.getProto().getName() == "rawPredictions") continue;
+    if (src.has(field)) {
+      dst.set(field, src.get(field));
+    }
+  }
+  return capnp::messageToFlatArray(msg);
+}
+
 void lh_log(LoggerHandle* h, uint8_t* data, size_t data_size, bool in_qlog) {
   pthread_mutex_lock(&h->lock);
   assert(h->refcnt > 0);
-  h->log->write(data, data_size);
+  if (h->log) {
+    h->log->write(data, data_size);
+  } else if (h->z_log) {
+    capnp::FlatArrayMessageReader cmsg(kj::ArrayPtr<const capnp::word>((const capnp::word*)data, data_size / sizeof(capnp::word)));
+    auto event = cmsg.getRoot<cereal::Event>();
+    h->z_log->write(data, data_size, event.getLogMonoTime(), (uint64_t)event.which());
+  }
   if (in_qlog && h->q_log) {
-    h->q_log->write(data, data_size);
+    capnp::FlatArrayMessageReader cmsg(kj::ArrayPtr<const capnp::word>((const capnp::word*)data, data_size / sizeof(capnp::word)));
+    auto event = cmsg.getRoot<cereal::Event>();
+    kj::Array<capnp::word> trimmed = trim_for_qlog(event);
+    uint8_t *qdata = data;
+    size_t qsize = data_size;
+    if (trimmed.size() > 0) {
+      qdata = (uint8_t *)trimmed.begin();
+      qsize = trimmed.size() * sizeof(capnp::word);
+    }
+    if (h->qlog_idx) {
+      QlogIndexEntry entry = {h->qlog_offset, event.getLogMonoTime(), (uint64_t)event.which()};
+      util::safe_fwrite(&entry, sizeof(entry), 1, h->qlog_idx);
+    }
+    h->q_log->write(qdata, qsize);
+    h->qlog_offset += qsize;
   }
   pthread_mutex_unlock(&h->lock);
 }
@@ -257,9 +359,22 @@ void lh_close(LoggerHandle* h) {
   }
   h->refcnt--;
   if (h->refcnt == 0) {
-    h->log.reset(nullptr);
-    h->q_log.reset(nullptr);
-    unlink(h->lock_path);
+    // flushing bz2 and closing out the files can stall for tens of ms on
+    // eMMC, don't make rotation wait on it. the lock file only comes off
+    // once everything is on disk.
+    if (h->closer.joinable()) h->closer.join();
+    h->closer = std::thread([log = std::move(h->log), q_log = std::move(h->q_log), z_log = std::move(h->z_log),
+                             qlog_idx = h->qlog_idx, lock_path = std::string(h->lock_path)]() mutable {
+      log.reset(nullptr);
+      q_log.reset(nullptr);
+      z_log.reset(nullptr);
+      if (qlog_idx) {
+        util::safe_fflush(qlog_idx);
+        fclose(qlog_idx);
+      }
+      unlink(lock_path.c_str());
+    });
+    h->qlog_idx = NULL;
     pthread_mutex_unlock(&h->lock);
     pthread_mutex_destroy(&h->lock);
     return;
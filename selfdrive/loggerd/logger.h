@@ -6,15 +6,19 @@
 #include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <string>
+#include <thread>
 
 #include <bzlib.h>
 #include <capnp/serialize.h>
 #include <kj/array.h>
 
 #include "cereal/messaging/messaging.h"
+#include "selfdrive/common/queue.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/hardware/hw.h"
+#include "selfdrive/loggerd/archiver.h"
 
 const std::string LOG_ROOT = Path::log_root();
 
@@ -58,6 +62,45 @@ class BZFile {
   BZFILE* bz_file = nullptr;
 };
 
+// buffers writes into chunks and compresses them on a worker thread, so
+// lh_log never blocks on bz2 or disk. one worker per file keeps the chunks
+// in order; the caller fills one chunk while the worker drains the last.
+class AsyncBZFile {
+ public:
+  AsyncBZFile(const char* path) : bz(path) {
+    chunk.reserve(CHUNK_SIZE);
+    thread = std::thread(&AsyncBZFile::worker, this);
+  }
+  ~AsyncBZFile() {
+    if (!chunk.empty()) q.push(chunk);
+    q.push({});  // empty chunk signals shutdown
+    thread.join();
+  }
+  inline void write(void* data, size_t size) {
+    chunk.append((const char*)data, size);
+    if (chunk.size() >= CHUNK_SIZE) {
+      q.push(chunk);
+      chunk.clear();
+    }
+  }
+  inline void write(kj::ArrayPtr<capnp::byte> array) { write(array.begin(), array.size()); }
+
+ private:
+  void worker() {
+    while (true) {
+      std::string c = q.pop();
+      if (c.empty()) break;
+      bz.write((void*)c.data(), c.size());
+    }
+  }
+
+  static constexpr size_t CHUNK_SIZE = 256 * 1024;
+  std::string chunk;
+  SafeQueue<std::string> q;
+  BZFile bz;
+  std::thread thread;
+};
+
 typedef cereal::Sentinel::SentinelType SentinelType;
 
 typedef struct LoggerHandle {
@@ -68,14 +111,25 @@ typedef struct LoggerHandle {
   char segment_path[4096];
   char log_path[4096];
   char qlog_path[4096];
+  char qlog_idx_path[4096];
   char lock_path[4096];
-  std::unique_ptr<BZFile> log, q_log;
+  uint64_t qlog_offset;
+  FILE* qlog_idx;
+  std::unique_ptr<AsyncBZFile> log, q_log;
+  // opt-in seekable archive written instead of rlog.bz2
+  std::unique_ptr<ZArchiveWriter> z_log;
+  std::thread closer;
 } LoggerHandle;
 
 typedef struct LoggerState {
   pthread_mutex_t lock;
   int part;
   kj::Array<capnp::word> init_data;
+  // rebuilt off the rotation path when params change, swapped in at the
+  // next logger_next (see logger_next)
+  kj::Array<capnp::word> pending_init_data;
+  std::thread init_data_refresher;
+  double init_data_params_mtime;
   std::string route_name;
   char log_name[64];
   bool has_qlog;
@@ -11,20 +11,24 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <mutex>
 #include <random>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "cereal/messaging/messaging.h"
 #include "cereal/services.h"
 #include "cereal/visionipc/visionipc.h"
 #include "cereal/visionipc/visionipc_client.h"
 #include "selfdrive/camerad/cameras/camera_common.h"
+#include "selfdrive/common/metrics.h"
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
+#include "selfdrive/common/trace.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
 
@@ -110,7 +114,6 @@ struct LoggerdState {
   LoggerState logger = {};
   char segment_path[4096];
   std::mutex rotate_lock;
-  std::condition_variable rotate_cv;
   std::atomic<int> rotate_segment;
   std::atomic<double> last_camera_seen_tms;
   std::atomic<int> waiting_rotate;
@@ -125,6 +128,49 @@ struct LoggerdState {
 };
 LoggerdState s;
 
+// Bitrate ladder fed by camerad's scene-change statistic (L1 distance between
+// consecutive AE luminance histograms). Parked footage needs a fraction of
+// the configured rate, highway sits in between, urban gets all of it.
+constexpr float BITRATE_LADDER[3] = {0.25f, 0.5f, 1.0f};
+
+int bitrate_step(float scene_change, int cur_step) {
+  // asymmetric thresholds for hysteresis, so noise doesn't bounce the step
+  static const float up[] = {0.025f, 0.15f};    // parked->highway, highway->urban
+  static const float down[] = {0.015f, 0.10f};  // highway->parked, urban->highway
+  int step = cur_step;
+  while (step < 2 && scene_change > up[step]) step++;
+  while (step > 0 && scene_change < down[step - 1]) step--;
+  return step;
+}
+
+// Map driverState's normalized face position back into full-frame pixels by
+// replaying the dm model crop (see dmonitoring_eval_frame), then hand the
+// encoder a generous box around it: the face keeps quality, the rest of the
+// frame is crushed. A lost face keeps the last region instead of crushing it.
+void update_driver_roi(VideoEncoder *e, const cereal::DriverState::Reader &ds, int w, int h, bool is_rhd) {
+  if (ds.getFaceProb() < 0.4) return;
+
+  int crop_x, crop_y, crop_w, crop_h;
+  if (Hardware::TICI()) {
+    const int adapt_width = 668;
+    crop_h = adapt_width / 1.33;
+    crop_w = crop_h / 2;
+    crop_x = w / 2 - adapt_width / 2;
+    crop_y = h / 2 - crop_h / 2 - 196;
+    if (!is_rhd) crop_x += adapt_width - crop_w + 32;
+  } else {
+    crop_w = h / 2, crop_h = h, crop_x = 0, crop_y = 0;
+    if (!is_rhd) crop_x = w - crop_w;
+  }
+
+  auto fp = ds.getFacePosition();
+  float fx = (0.5f + fp[0]) * crop_w;
+  if (is_rhd) fx = crop_w - fx;  // the model input is mirrored for RHD
+  const float fy = (0.5f + fp[1]) * crop_h;
+  const int box = crop_w * 3 / 4;  // face box plus room for position jitter
+  e->set_roi(crop_x + (int)fx - box / 2, crop_y + (int)fy - box / 2, box, box);
+}
+
 // Wait for all encoders to reach the same frame id
 bool sync_encoders(LoggerdState *state, CameraType cam_type, uint32_t frame_id) {
   if (state->camera_synced[cam_type]) return true;
@@ -153,7 +199,20 @@ void encoder_thread(const LogCameraInfo &cam_info) {
   int encode_idx = 0;
   LoggerHandle *lh = NULL;
   std::vector<Encoder *> encoders;
-  VisionIpcClient vipc_client = VisionIpcClient("camerad", cam_info.stream_type, false);
+  // under backlog we'd rather drop an encoded frame than delay the model input
+  VisionIpcClient vipc_client = VisionIpcClient("camerad", cam_info.stream_type, false, nullptr, nullptr, SUB_PRIO_DROPPABLE);
+
+  // adaptive rate control from the camera's scene-change statistic; steps are
+  // only applied once they have held for two seconds, and the encoder starts
+  // the new rate on a keyframe
+  std::vector<const char *> services = {cam_info.frame_packet_name};
+  // the driver cam additionally follows the face for ROI encoding
+  const bool roi_enc = cam_info.type == DriverCam;
+  if (roi_enc) services.push_back("driverState");
+  const bool is_rhd = roi_enc && Params().getBool("IsRHD");
+  SubMaster sm(services);
+  FirstOrderFilter scene_change_filter(0., 2., 1. / MAIN_FPS);
+  int cur_step = 2, pending_step = 2, pending_cnt = 0;
 
   while (!do_exit) {
     if (!vipc_client.connect(false)) {
@@ -169,7 +228,7 @@ void encoder_thread(const LogCameraInfo &cam_info) {
       // main encoder
       encoders.push_back(new Encoder(cam_info.filename, buf_info.width, buf_info.height,
                                      cam_info.fps, cam_info.bitrate, cam_info.is_h265,
-                                     cam_info.downscale, cam_info.record));
+                                     cam_info.downscale, cam_info.record, roi_enc));
       // qcamera encoder
       if (cam_info.has_qcamera) {
         encoders.push_back(new Encoder(qcam_info.filename, qcam_info.frame_width, qcam_info.frame_height,
@@ -182,30 +241,56 @@ void encoder_thread(const LogCameraInfo &cam_info) {
       VisionBuf* buf = vipc_client.recv(&extra);
       if (buf == nullptr) continue;
 
+      sm.update(0);
+      if (sm.updated(cam_info.frame_packet_name)) {
+        auto event = sm[cam_info.frame_packet_name];
+        const float sc = cam_info.type == DriverCam ? event.getDriverCameraState().getSceneChange() :
+                        (cam_info.type == WideRoadCam ? event.getWideRoadCameraState().getSceneChange() :
+                                                        event.getRoadCameraState().getSceneChange());
+        int step = bitrate_step(scene_change_filter.update(sc), cur_step);
+        pending_cnt = (step == pending_step) ? pending_cnt + 1 : 0;
+        pending_step = step;
+        if (step != cur_step && pending_cnt >= 2 * MAIN_FPS) {
+          LOGW("camera %d bitrate step %d -> %d", cam_info.type, cur_step, step);
+          cur_step = step;
+          encoders[0]->set_bitrate(cam_info.bitrate * BITRATE_LADDER[cur_step]);
+          if (encoders.size() > 1) {
+            encoders[1]->set_bitrate(qcam_info.bitrate * BITRATE_LADDER[cur_step]);
+          }
+        }
+      }
+
+      if (roi_enc && sm.updated("driverState")) {
+        update_driver_roi(encoders[0], sm["driverState"].getDriverState(), buf->width, buf->height, is_rhd);
+      }
+
       if (cam_info.trigger_rotate) {
         s.last_camera_seen_tms = millis_since_boot();
         if (!sync_encoders(&s, cam_info.type, extra.frame_id)) {
           continue;
         }
+        // segment full: signal the logger once and keep encoding into the
+        // current segment until the next one is open. no encoder ever
+        // blocks on another here.
+        if (cnt == SEGMENT_LENGTH * MAIN_FPS) {
+          ++s.waiting_rotate;
+        }
       }
 
-      if (cam_info.trigger_rotate && (cnt >= SEGMENT_LENGTH * MAIN_FPS)) {
-        // trigger rotate and wait logger rotated to new segment
-        ++s.waiting_rotate;
-        std::unique_lock lk(s.rotate_lock);
-        s.rotate_cv.wait(lk, [&] { return s.rotate_segment > cur_seg || do_exit; });
-      }
-      if (do_exit) break;
-
       // rotate the encoder if the logger is on a newer segment
       if (s.rotate_segment > cur_seg) {
-        cur_seg = s.rotate_segment;
+        char segment_path[sizeof(s.segment_path)];
+        {
+          std::unique_lock lk(s.rotate_lock);
+          cur_seg = s.rotate_segment;
+          strcpy(segment_path, s.segment_path);
+        }
         cnt = 0;
 
-        LOGW("camera %d rotate encoder to %s", cam_info.type, s.segment_path);
+        LOGW("camera %d rotate encoder to %s", cam_info.type, segment_path);
         for (auto &e : encoders) {
           e->encoder_close();
-          e->encoder_open(s.segment_path);
+          e->encoder_open(segment_path);
         }
         if (lh) {
           lh_close(lh);
@@ -240,6 +325,7 @@ void encoder_thread(const LogCameraInfo &cam_info) {
           eidx.setEncodeId(encode_idx);
           eidx.setSegmentNum(cur_seg);
           eidx.setSegmentId(out_id);
+          eidx.setBitrateStep(cur_step);
           if (lh) {
             auto bytes = msg.toBytes();
             lh_log(lh, bytes.begin(), bytes.size(), true);
@@ -264,6 +350,55 @@ void encoder_thread(const LogCameraInfo &cam_info) {
   }
 }
 
+// bounded handoff between the drain loop and the writer thread, so a slow
+// fwrite or rotation never backs up into msgq and the publishers
+struct LogMessage {
+  Message *msg;
+  bool in_qlog;
+};
+
+class LogQueue {
+ public:
+  void push(LogMessage &&lm) {
+    {
+      std::unique_lock lk(lock);
+      if (q.size() >= LOG_QUEUE_DEPTH) {
+        // disk stall: drop the oldest message that isn't bound for qlog
+        for (auto it = q.begin(); it != q.end(); ++it) {
+          if (!it->in_qlog) {
+            delete it->msg;
+            q.erase(it);
+            if ((++dropped % 1000) == 1) LOGE("log queue full, %lu messages dropped", dropped);
+            break;
+          }
+        }
+      }
+      q.push_back(lm);
+    }
+    cv.notify_one();
+  }
+  bool pop(LogMessage &lm, int timeout_ms) {
+    std::unique_lock lk(lock);
+    if (!cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this] { return !q.empty(); })) {
+      return false;
+    }
+    lm = q.front();
+    q.pop_front();
+    return true;
+  }
+  bool empty() {
+    std::unique_lock lk(lock);
+    return q.empty();
+  }
+
+ private:
+  static constexpr size_t LOG_QUEUE_DEPTH = 2000;
+  std::mutex lock;
+  std::condition_variable cv;
+  std::deque<LogMessage> q;
+  uint64_t dropped = 0;
+};
+
 int clear_locks_fn(const char* fpath, const struct stat *sb, int tyupeflag) {
   const char* dot = strrchr(fpath, '.');
   if (dot && strcmp(dot, ".lock") == 0) {
@@ -277,6 +412,9 @@ void clear_locks() {
 }
 
 void logger_rotate() {
+  TraceSpan span("logger_rotate");
+  static MetricSlot *rotations_metric = metric_counter("loggerd.rotations");
+  metric_add(rotations_metric);
   {
     std::unique_lock lk(s.rotate_lock);
     int segment = -1;
@@ -286,7 +424,6 @@ void logger_rotate() {
     s.waiting_rotate = 0;
     s.last_rotate_tms = millis_since_boot();
   }
-  s.rotate_cv.notify_all();
   LOGW((s.logger.part == 0) ? "logging to %s" : "rotated to %s", s.segment_path);
 }
 
@@ -354,33 +491,43 @@ int main(int argc, char** argv) {
     }
   }
 
-  uint64_t msg_count = 0, bytes_count = 0;
-  double start_ts = millis_since_boot();
+  // writer thread: rotation and disk writes happen here, decoupled from
+  // the drain loop
+  LogQueue log_queue;
+  std::thread log_writer_thread([&] {
+    set_thread_name("log_writer");
+    LogMessage lm;
+    while (!do_exit || !log_queue.empty()) {
+      rotate_if_needed();
+      if (!log_queue.pop(lm, 100)) continue;
+      logger_log(&s.logger, (uint8_t *)lm.msg->getData(), lm.msg->getSize(), lm.in_qlog);
+      delete lm.msg;
+    }
+  });
+
+  // throughput counters land in the 1Hz metrics message instead of the
+  // old periodic LOGD rate print
+  MetricSlot *msgs_metric = metric_counter("loggerd.msgs");
+  MetricSlot *bytes_metric = metric_counter("loggerd.bytes");
   while (!do_exit) {
     // poll for new messages on all sockets
     for (auto sock : poller->poll(1000)) {
-      // drain socket
+      // drain socket; qlog decimation is decided here so drops under disk
+      // stall can spare the qlog'd messages
       QlogState &qs = qlog_states[sock];
       Message *msg = nullptr;
       while (!do_exit && (msg = sock->receive(true))) {
         const bool in_qlog = qs.freq != -1 && (qs.counter++ % qs.freq == 0);
-        logger_log(&s.logger, (uint8_t *)msg->getData(), msg->getSize(), in_qlog);
-        bytes_count += msg->getSize();
-        delete msg;
-
-        rotate_if_needed();
-
-        if ((++msg_count % 1000) == 0) {
-          double seconds = (millis_since_boot() - start_ts) / 1000.0;
-          LOGD("%lu messages, %.2f msg/sec, %.2f KB/sec", msg_count, msg_count / seconds, bytes_count * 0.001 / seconds);
-        }
+        metric_add(msgs_metric);
+        metric_add(bytes_metric, msg->getSize());
+        log_queue.push({msg, in_qlog});
       }
     }
   }
 
   LOGW("closing encoders");
-  s.rotate_cv.notify_all();
   for (auto &t : encoder_threads) t.join();
+  log_writer_thread.join();
 
   LOGW("closing logger");
   logger_close(&s.logger, &do_exit);
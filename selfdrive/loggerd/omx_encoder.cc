@@ -6,6 +6,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
@@ -28,6 +29,41 @@
 
 extern ExitHandler do_exit;
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+// decimating 2x2 box filter with rounding, at an arbitrary >=2:1 ratio
+// (16.16 fixed point steps like libyuv). the vertical average runs
+// vectorized across the full source width, two rows per pass, then the
+// horizontal pick averages neighboring columns of the blended row.
+// dst_px_stride 2 writes a chroma plane straight into the NV12 interleave.
+static void scale_plane_box2(const uint8_t *src, int src_stride, int src_w, int src_h,
+                             uint8_t *dst, int dst_stride, int dst_w, int dst_h,
+                             uint8_t *row_buf, int dst_px_stride) {
+  const uint32_t x_step = ((uint32_t)src_w << 16) / dst_w;
+  const uint32_t y_step = ((uint32_t)src_h << 16) / dst_h;
+  for (int y = 0; y < dst_h; y++) {
+    const int sy = std::min((int)(((uint64_t)y * y_step) >> 16), src_h - 2);
+    const uint8_t *r0 = src + sy * src_stride;
+    const uint8_t *r1 = r0 + src_stride;
+    int x = 0;
+    for (; x + 16 <= src_w; x += 16) {
+      vst1q_u8(&row_buf[x], vrhaddq_u8(vld1q_u8(&r0[x]), vld1q_u8(&r1[x])));
+    }
+    for (; x < src_w; x++) {
+      row_buf[x] = (r0[x] + r1[x] + 1) >> 1;
+    }
+
+    uint8_t *out = dst + y * dst_stride;
+    uint32_t sx = 0;
+    for (int i = 0; i < dst_w; i++, sx += x_step) {
+      const int c = std::min((int)(sx >> 16), src_w - 2);
+      out[i * dst_px_stride] = (row_buf[c] + row_buf[c + 1] + 1) >> 1;
+    }
+  }
+}
+#endif
+
 // ***** OMX callback functions *****
 
 void OmxEncoder::wait_for_state(OMX_STATETYPE state_) {
@@ -156,17 +192,18 @@ static const char* omx_color_fomat_name(uint32_t format) {
 
 // ***** encoder functions *****
 
-OmxEncoder::OmxEncoder(const char* filename, int width, int height, int fps, int bitrate, bool h265, bool downscale, bool write) {
+OmxEncoder::OmxEncoder(const char* filename, int width, int height, int fps, int bitrate, bool h265, bool downscale, bool write, bool roi) {
   this->filename = filename;
   this->write = write;
+  this->roi = roi;
   this->width = width;
   this->height = height;
   this->fps = fps;
+  this->bitrate = bitrate;
   this->remuxing = !h265;
 
   this->downscale = downscale;
   if (this->downscale) {
-    this->y_ptr2 = (uint8_t *)malloc(this->width*this->height);
     this->u_ptr2 = (uint8_t *)malloc(this->width*this->height/4);
     this->v_ptr2 = (uint8_t *)malloc(this->width*this->height/4);
   }
@@ -274,6 +311,23 @@ OmxEncoder::OmxEncoder(const char* filename, int width, int height, int fps, int
     OMX_CHECK(OMX_SetParameter(this->handle, OMX_IndexParamVideoAvc, &avc));
   }
 
+  if (this->roi) {
+    // per-region QP: the face region keeps quality, the rest of the frame
+    // is crushed (see set_roi). has to be enabled before going executing.
+    OMX_QTI_VIDEO_PARAM_ENABLE_ROIINFO roi_param = {0};
+    roi_param.nSize = sizeof(roi_param);
+    roi_param.nPortIndex = (OMX_U32) PORT_INDEX_IN;
+    roi_param.bEnableRoiInfo = OMX_TRUE;
+    if (OMX_SetParameter(this->handle, (OMX_INDEXTYPE) OMX_QTIIndexParamVideoEnableRoiInfo, (OMX_PTR) &roi_param) == OMX_ErrorNone) {
+      this->roi_mb_w = (this->width + 15) / 16;
+      this->roi_mb_h = (this->height + 15) / 16;
+      this->roi_mb_info.resize(this->roi_mb_w * this->roi_mb_h);
+    } else {
+      LOGE("codec has no ROI support, encoding uniformly");
+      this->roi = false;
+    }
+  }
+
 
   // for (int i = 0; ; i++) {
   //   OMX_VIDEO_PARAM_PORTFORMATTYPE video_port_format = {0};
@@ -327,6 +381,45 @@ OmxEncoder::OmxEncoder(const char* filename, int width, int height, int fps, int
   }
 }
 
+void OmxEncoder::set_bitrate(int new_bitrate) {
+  if (new_bitrate == this->bitrate) {
+    return;
+  }
+
+  OMX_VIDEO_CONFIG_BITRATETYPE bitrate_config = {0};
+  bitrate_config.nSize = sizeof(bitrate_config);
+  bitrate_config.nPortIndex = (OMX_U32) PORT_INDEX_OUT;
+  bitrate_config.nEncodeBitrate = new_bitrate;
+  OMX_CHECK(OMX_SetConfig(this->handle, OMX_IndexConfigVideoBitrate, (OMX_PTR) &bitrate_config));
+
+  // force an IDR so the new rate starts on a clean keyframe
+  OMX_CONFIG_INTRAREFRESHVOPTYPE idr = {0};
+  idr.nSize = sizeof(idr);
+  idr.nPortIndex = (OMX_U32) PORT_INDEX_OUT;
+  idr.IntraRefreshVOP = OMX_TRUE;
+  OMX_CHECK(OMX_SetConfig(this->handle, OMX_IndexConfigVideoIntraVOPRefresh, (OMX_PTR) &idr));
+
+  this->bitrate = new_bitrate;
+}
+
+void OmxEncoder::set_roi(int x, int y, int w, int h) {
+  if (!this->roi) {
+    return;
+  }
+
+  // macroblocks covering the rect get marked in the MB map and encode at
+  // nLowerQpOffset; everything else gets nUpperQpOffset (see encode_frame)
+  std::fill(this->roi_mb_info.begin(), this->roi_mb_info.end(), 0);
+  const int mb_x0 = std::clamp(x / 16, 0, this->roi_mb_w - 1);
+  const int mb_y0 = std::clamp(y / 16, 0, this->roi_mb_h - 1);
+  const int mb_x1 = std::clamp((x + w - 1) / 16, 0, this->roi_mb_w - 1);
+  const int mb_y1 = std::clamp((y + h - 1) / 16, 0, this->roi_mb_h - 1);
+  for (int my = mb_y0; my <= mb_y1; my++) {
+    memset(&this->roi_mb_info[my * this->roi_mb_w + mb_x0], 1, mb_x1 - mb_x0 + 1);
+  }
+  this->roi_active = true;
+}
+
 void OmxEncoder::handle_out_buf(OmxEncoder *e, OMX_BUFFERHEADERTYPE *out_buf) {
   int err;
   uint8_t *buf_data = out_buf->pBuffer + out_buf->nOffset;
@@ -429,26 +522,46 @@ int OmxEncoder::encode_frame(const uint8_t *y_ptr, const uint8_t *u_ptr, const u
   uint8_t *in_uv_ptr = in_buf_ptr + (in_y_stride * VENUS_Y_SCANLINES(COLOR_FMT_NV12, this->height));
 
   if (this->downscale) {
-    I420Scale(y_ptr, in_width,
-              u_ptr, in_width/2,
-              v_ptr, in_width/2,
-              in_width, in_height,
-              this->y_ptr2, this->width,
-              this->u_ptr2, this->width/2,
-              this->v_ptr2, this->width/2,
-              this->width, this->height,
-              libyuv::kFilterNone);
-    y_ptr = this->y_ptr2;
-    u_ptr = this->u_ptr2;
-    v_ptr = this->v_ptr2;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // box-filtered downscale straight into the encoder buffer; the chroma
+    // planes write into the NV12 interleave directly, so there is no
+    // staging copy or merge pass at all
+    this->row_buf.resize(in_width);
+    scale_plane_box2(y_ptr, in_width, in_width, in_height,
+                     in_y_ptr, in_y_stride, this->width, this->height,
+                     this->row_buf.data(), 1);
+    scale_plane_box2(u_ptr, in_width/2, in_width/2, in_height/2,
+                     in_uv_ptr, in_uv_stride, this->width/2, this->height/2,
+                     this->row_buf.data(), 2);
+    scale_plane_box2(v_ptr, in_width/2, in_width/2, in_height/2,
+                     in_uv_ptr + 1, in_uv_stride, this->width/2, this->height/2,
+                     this->row_buf.data(), 2);
+#else
+    // scale each plane straight into the encoder buffer; only the
+    // quarter-res chroma needs a staging copy for the NV12 interleave
+    libyuv::ScalePlane(y_ptr, in_width, in_width, in_height,
+                       in_y_ptr, in_y_stride, this->width, this->height,
+                       libyuv::kFilterNone);
+    libyuv::ScalePlane(u_ptr, in_width/2, in_width/2, in_height/2,
+                       this->u_ptr2, this->width/2, this->width/2, this->height/2,
+                       libyuv::kFilterNone);
+    libyuv::ScalePlane(v_ptr, in_width/2, in_width/2, in_height/2,
+                       this->v_ptr2, this->width/2, this->width/2, this->height/2,
+                       libyuv::kFilterNone);
+    libyuv::MergeUVPlane(this->u_ptr2, this->width/2,
+                         this->v_ptr2, this->width/2,
+                         in_uv_ptr, in_uv_stride,
+                         this->width/2, this->height/2);
+#endif
+  } else {
+    err = libyuv::I420ToNV12(y_ptr, this->width,
+                     u_ptr, this->width/2,
+                     v_ptr, this->width/2,
+                     in_y_ptr, in_y_stride,
+                     in_uv_ptr, in_uv_stride,
+                     this->width, this->height);
+    assert(err == 0);
   }
-  err = libyuv::I420ToNV12(y_ptr, this->width,
-                   u_ptr, this->width/2,
-                   v_ptr, this->width/2,
-                   in_y_ptr, in_y_stride,
-                   in_uv_ptr, in_uv_stride,
-                   this->width, this->height);
-  assert(err == 0);
 
   // in_buf->nFilledLen = (this->width*this->height) + (this->width*this->height/2);
   in_buf->nFilledLen = VENUS_BUFFER_SIZE(COLOR_FMT_NV12, this->width, this->height);
@@ -457,6 +570,22 @@ int OmxEncoder::encode_frame(const uint8_t *y_ptr, const uint8_t *u_ptr, const u
   in_buf->nTimeStamp = ts/1000LL;  // OMX_TICKS, in microseconds
   this->last_t = in_buf->nTimeStamp;
 
+  if (this->roi && this->roi_active) {
+    // the config is consumed with the next input buffer, so reapply per frame
+    OMX_QTI_VIDEO_CONFIG_ROIINFO roi_config = {0};
+    roi_config.nSize = sizeof(roi_config);
+    roi_config.nPortIndex = (OMX_U32) PORT_INDEX_IN;
+    roi_config.bUseRoiInfo = OMX_TRUE;
+    roi_config.nLowerQpOffset = -6;   // marked (face) macroblocks
+    roi_config.nUpperQpOffset = 10;   // everything else
+    roi_config.nRoiMBInfoSize = this->roi_mb_info.size();
+    roi_config.pRoiMBInfo = this->roi_mb_info.data();
+    if (OMX_SetConfig(this->handle, (OMX_INDEXTYPE) OMX_QTIIndexConfigVideoRoiInfo, (OMX_PTR) &roi_config) != OMX_ErrorNone) {
+      LOGE("ROI config rejected, encoding uniformly");
+      this->roi = false;
+    }
+  }
+
   OMX_CHECK(OMX_EmptyThisBuffer(this->handle, in_buf));
 
   // pump output
@@ -600,7 +729,6 @@ OmxEncoder::~OmxEncoder() {
   }
 
   if (this->downscale) {
-    free(this->y_ptr2);
     free(this->u_ptr2);
     free(this->v_ptr2);
   }
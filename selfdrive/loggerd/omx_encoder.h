@@ -15,12 +15,14 @@ extern "C" {
 // OmxEncoder, lossey codec using hardware hevc
 class OmxEncoder : public VideoEncoder {
 public:
-  OmxEncoder(const char* filename, int width, int height, int fps, int bitrate, bool h265, bool downscale, bool write = true);
+  OmxEncoder(const char* filename, int width, int height, int fps, int bitrate, bool h265, bool downscale, bool write = true, bool roi = false);
   ~OmxEncoder();
   int encode_frame(const uint8_t *y_ptr, const uint8_t *u_ptr, const uint8_t *v_ptr,
                    int in_width, int in_height, uint64_t ts);
   void encoder_open(const char* path);
   void encoder_close();
+  void set_bitrate(int new_bitrate);
+  void set_roi(int x, int y, int w, int h);
 
   // OMX callbacks
   static OMX_ERRORTYPE event_handler(OMX_HANDLETYPE component, OMX_PTR app_data, OMX_EVENTTYPE event,
@@ -35,6 +37,7 @@ private:
   static void handle_out_buf(OmxEncoder *e, OMX_BUFFERHEADERTYPE *out_buf);
 
   int width, height, fps;
+  int bitrate;
   char vid_path[1024];
   char lock_path[1024];
   bool is_open = false;
@@ -69,5 +72,12 @@ private:
   bool remuxing;
 
   bool downscale;
-  uint8_t *y_ptr2, *u_ptr2, *v_ptr2;
+  uint8_t *u_ptr2, *v_ptr2;
+  std::vector<uint8_t> row_buf;  // one blended source row for the box downscale
+
+  // per-macroblock QP map, see set_roi()
+  bool roi;
+  bool roi_active = false;
+  int roi_mb_w = 0, roi_mb_h = 0;
+  std::vector<uint8_t> roi_mb_info;
 };
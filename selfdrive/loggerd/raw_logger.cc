@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #define __STDC_CONSTANT_MACROS
 
@@ -20,11 +21,13 @@ extern "C" {
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 
+#define FRAME_POOL_SIZE 4
+
 RawLogger::RawLogger(const char* filename, int width, int height, int fps,
-                     int bitrate, bool h265, bool downscale, bool write)
+                     int bitrate, bool h265, bool downscale, bool write, bool roi)
   : filename(filename), fps(fps) {
 
-  // TODO: respect write arg
+  // TODO: respect write arg; roi is unsupported here
 
   av_register_all();
   codec = avcodec_find_encoder(AV_CODEC_ID_FFVHUFF);
@@ -37,7 +40,8 @@ RawLogger::RawLogger(const char* filename, int width, int height, int fps,
   codec_ctx->height = height;
   codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
 
-  // codec_ctx->thread_count = 2;
+  // lossless encode is the bottleneck at full res, spread it across cores
+  codec_ctx->thread_count = 4;
 
   // ffv1enc doesn't respect AV_PICTURE_TYPE_I. make every frame a key frame for now.
   // codec_ctx->gop_size = 0;
@@ -47,22 +51,67 @@ RawLogger::RawLogger(const char* filename, int width, int height, int fps,
   int err = avcodec_open2(codec_ctx, codec, NULL);
   assert(err >= 0);
 
-  frame = av_frame_alloc();
-  assert(frame);
-  frame->format = codec_ctx->pix_fmt;
-  frame->width = width;
-  frame->height = height;
-  frame->linesize[0] = width;
-  frame->linesize[1] = width/2;
-  frame->linesize[2] = width/2;
+  for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+    AVFrame *frame = av_frame_alloc();
+    assert(frame);
+    frame->format = codec_ctx->pix_fmt;
+    frame->width = width;
+    frame->height = height;
+    err = av_frame_get_buffer(frame, 0);
+    assert(err >= 0);
+    frame_pool.push_back(frame);
+    free_frames.push(frame);
+  }
+
+  encode_thread = std::thread(&RawLogger::encode_thread_func, this);
 }
 
 RawLogger::~RawLogger() {
-  av_frame_free(&frame);
+  exit = true;
+  to_encode.push(nullptr);
+  encode_thread.join();
+
+  for (AVFrame *frame : frame_pool) {
+    av_frame_free(&frame);
+  }
   avcodec_close(codec_ctx);
   av_free(codec_ctx);
 }
 
+void RawLogger::encode_thread_func() {
+  while (true) {
+    AVFrame *frame = to_encode.pop();
+    if (!frame) {
+      if (exit) break;
+      std::unique_lock lk(flush_lock);
+      flushed = true;
+      flush_cv.notify_all();
+      continue;
+    }
+
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    int got_output = 0;
+    int err = avcodec_encode_video2(codec_ctx, &pkt, frame, &got_output);
+    if (err) {
+      LOGE("encoding error\n");
+    } else if (got_output) {
+      av_packet_rescale_ts(&pkt, codec_ctx->time_base, stream->time_base);
+      pkt.stream_index = 0;
+
+      err = av_interleaved_write_frame(format_ctx, &pkt);
+      if (err < 0) {
+        LOGE("encoder writer error\n");
+      }
+    }
+
+    free_frames.push(frame);
+  }
+}
+
 void RawLogger::encoder_open(const char* path) {
   vid_path = util::string_format("%s/%s.mkv", path, filename);
 
@@ -102,6 +151,17 @@ void RawLogger::encoder_open(const char* path) {
 void RawLogger::encoder_close() {
   if (!is_open) return;
 
+  // drain the worker before touching the muxer
+  {
+    std::unique_lock lk(flush_lock);
+    flushed = false;
+  }
+  to_encode.push(nullptr);
+  {
+    std::unique_lock lk(flush_lock);
+    flush_cv.wait(lk, [&] { return flushed; });
+  }
+
   int err = av_write_trailer(format_ctx);
   assert(err == 0);
 
@@ -119,35 +179,21 @@ void RawLogger::encoder_close() {
 
 int RawLogger::encode_frame(const uint8_t *y_ptr, const uint8_t *u_ptr, const uint8_t *v_ptr,
                             int in_width, int in_height, uint64_t ts) {
-  AVPacket pkt;
-  av_init_packet(&pkt);
-  pkt.data = NULL;
-  pkt.size = 0;
-
-  frame->data[0] = (uint8_t*)y_ptr;
-  frame->data[1] = (uint8_t*)u_ptr;
-  frame->data[2] = (uint8_t*)v_ptr;
-  frame->pts = ts;
+  AVFrame *frame = nullptr;
+  if (!free_frames.try_pop(frame)) {
+    LOGW("raw encoder behind, dropping frame %d", counter);
+    return -1;
+  }
 
-  int ret = counter;
-
-  int got_output = 0;
-  int err = avcodec_encode_video2(codec_ctx, &pkt, frame, &got_output);
-  if (err) {
-    LOGE("encoding error\n");
-    ret = -1;
-  } else if (got_output) {
-    av_packet_rescale_ts(&pkt, codec_ctx->time_base, stream->time_base);
-    pkt.stream_index = 0;
-
-    err = av_interleaved_write_frame(format_ctx, &pkt);
-    if (err < 0) {
-      LOGE("encoder writer error\n");
-      ret = -1;
-    } else {
-      counter++;
-    }
+  for (int i = 0; i < in_height; i++) {
+    memcpy(frame->data[0] + i * frame->linesize[0], y_ptr + i * in_width, in_width);
   }
+  for (int i = 0; i < in_height / 2; i++) {
+    memcpy(frame->data[1] + i * frame->linesize[1], u_ptr + i * in_width / 2, in_width / 2);
+    memcpy(frame->data[2] + i * frame->linesize[2], v_ptr + i * in_width / 2, in_width / 2);
+  }
+  frame->pts = ts;
 
-  return ret;
+  to_encode.push(frame);
+  return counter++;
 }
@@ -2,7 +2,10 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 extern "C" {
@@ -11,12 +14,13 @@ extern "C" {
 #include <libavutil/imgutils.h>
 }
 
+#include "selfdrive/common/queue.h"
 #include "selfdrive/loggerd/encoder.h"
 
 class RawLogger : public VideoEncoder {
  public:
   RawLogger(const char* filename, int width, int height, int fps,
-            int bitrate, bool h265, bool downscale, bool write = true);
+            int bitrate, bool h265, bool downscale, bool write = true, bool roi = false);
   ~RawLogger();
   int encode_frame(const uint8_t *y_ptr, const uint8_t *u_ptr, const uint8_t *v_ptr,
                    int in_width, int in_height, uint64_t ts);
@@ -24,6 +28,8 @@ class RawLogger : public VideoEncoder {
   void encoder_close();
 
 private:
+  void encode_thread_func();
+
   const char* filename;
   //bool write;
   int fps;
@@ -38,5 +44,15 @@ private:
   AVStream *stream = NULL;
   AVFormatContext *format_ctx = NULL;
 
-  AVFrame *frame = NULL;
+  // frames are encoded and written on a worker thread so the camera thread
+  // never waits on the codec. the preallocated pool bounds the queue: when
+  // the encoder falls behind, frames are dropped instead of blocking.
+  std::vector<AVFrame *> frame_pool;
+  SafeQueue<AVFrame *> free_frames;
+  SafeQueue<AVFrame *> to_encode;  // nullptr is a flush marker
+  std::thread encode_thread;
+  std::mutex flush_lock;
+  std::condition_variable flush_cv;
+  bool flushed = false;
+  bool exit = false;
 };
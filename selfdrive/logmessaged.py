@@ -1,4 +1,6 @@
 #!/usr/bin/env python3
+import json
+import struct
 import zmq
 from typing import NoReturn
 
@@ -6,6 +8,13 @@ import cereal.messaging as messaging
 from common.logging_extra import SwagLogFileFormatter
 from selfdrive.swaglog import get_file_handler
 
+# C++ cloudlog sends fixed-layout binary records with interned string ids
+# (see selfdrive/common/swaglog.cc); the JSON is rendered here, at collection
+# time. Python processes still send the legacy JSON format, where the first
+# byte is the level (10..50).
+BINARY_RECORD = 0x01
+BINARY_STRING = 0x02
+
 
 def main() -> NoReturn:
   log_handler = get_file_handler()
@@ -19,10 +28,36 @@ def main() -> NoReturn:
   # and we publish them
   pub_sock = messaging.pub_sock('logMessage')
 
+  interned = {}  # pid -> {id: string}; id 0 is the process's bound context
+
   while True:
     dat = b''.join(sock.recv_multipart())
-    level = dat[0]
-    record = dat[1:].decode("utf-8")
+    kind = dat[0]
+    if kind == BINARY_STRING:
+      pid, sid, slen = struct.unpack_from("<IHH", dat, 1)
+      interned.setdefault(pid, {})[sid] = dat[9:9 + slen].decode("utf-8", "replace")
+      continue
+
+    if kind == BINARY_RECORD:
+      pid, level, file_id, func_id, lineno, created = struct.unpack_from("<IBHHid", dat, 1)
+      strings = interned.get(pid, {})
+      try:
+        log_ctx = json.loads(strings.get(0, "{}"))
+      except json.decoder.JSONDecodeError:
+        log_ctx = {}
+      record = json.dumps({
+        "msg": dat[22:].decode("utf-8", "replace"),
+        "ctx": log_ctx,
+        "levelnum": level,
+        "filename": strings.get(file_id, "<unknown>"),
+        "lineno": lineno,
+        "funcname": strings.get(func_id, "<unknown>"),
+        "created": created,
+      })
+    else:
+      level = kind
+      record = dat[1:].decode("utf-8")
+
     if level >= log_level:
       log_handler.emit(record)
 
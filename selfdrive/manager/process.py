@@ -1,6 +1,7 @@
 import importlib
 import os
 import signal
+import struct
 import time
 import subprocess
 from abc import ABC, abstractmethod
@@ -18,9 +19,27 @@ from selfdrive.hardware import HARDWARE
 from cereal import log
 
 WATCHDOG_FN = "/dev/shm/wd_"
+# shared table of kick timestamps and ready bits written by
+# selfdrive/common/watchdog.cc; slots are (pid, pad, last_kick_ns, name, ready, pad)
+WATCHDOG_TABLE_FN = "/dev/shm/op_watchdog"
+WATCHDOG_SLOT_FMT = "<iIQ16sII"
 ENABLE_WATCHDOG = os.getenv("NO_WATCHDOG") is None
 
 
+def watchdog_time_from_table(pid: int):
+  try:
+    with open(WATCHDOG_TABLE_FN, "rb") as f:
+      dat = f.read()
+  except OSError:
+    return None
+  slot_size = struct.calcsize(WATCHDOG_SLOT_FMT)
+  for off in range(0, len(dat) - slot_size + 1, slot_size):
+    slot_pid, _, last_kick_ns, _, _, _ = struct.unpack_from(WATCHDOG_SLOT_FMT, dat, off)
+    if slot_pid == pid:
+      return last_kick_ns
+  return None
+
+
 def launcher(proc):
   try:
     # import the process
@@ -87,8 +106,12 @@ class ManagerProcess(ABC):
       return
 
     try:
-      fn = WATCHDOG_FN + str(self.proc.pid)
-      self.last_watchdog_time = int(open(fn).read())
+      t = watchdog_time_from_table(self.proc.pid)
+      if t is None:
+        # file fallback, still used by python processes and full tables
+        fn = WATCHDOG_FN + str(self.proc.pid)
+        t = int(open(fn).read())
+      self.last_watchdog_time = t
     except Exception:
       pass
 
@@ -0,0 +1,39 @@
+#include <random>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/common/benchmark.h"
+#include "selfdrive/modeld/models/driving.h"
+
+// model post-processing cost (fill_* + capnp serialization + publish) over a
+// random network output, isolated from the runner so changes to the publish
+// path can be measured without a GPU or a recorded route.
+
+int main() {
+  PubMaster pm({"modelV2", "cameraOdometry"});
+
+  std::vector<float> output(NET_OUTPUT_SIZE);
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (auto &v : output) v = dist(gen);
+
+  ModelDataRaw net_outputs {
+    .plans = (ModelDataRawPlans*)&output[PLAN_IDX],
+    .lane_lines = (ModelDataRawLaneLines*)&output[LL_IDX],
+    .road_edges = (ModelDataRawRoadEdges*)&output[RE_IDX],
+    .leads = (ModelDataRawLeads*)&output[LEAD_IDX],
+    .meta = &output[DESIRE_STATE_IDX],
+    .pose = (ModelDataRawPose*)&output[POSE_IDX],
+  };
+
+  kj::ArrayPtr<const float> raw_pred(output.data(), output.size());
+  uint32_t frame_id = 0;
+  benchmark_run("model_publish", 5000, [&]() {
+    model_publish(pm, frame_id, frame_id, 0.0f, 0.05f, net_outputs, 0, 0.02f, raw_pred);
+    frame_id++;
+  });
+  benchmark_run("posenet_publish", 20000, [&]() {
+    posenet_publish(pm, frame_id, 0, net_outputs, 0);
+  });
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "cereal/visionipc/visionbuf.h"
+#include "selfdrive/common/clutil.h"
+#include "selfdrive/common/modeldata.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/modeld/models/driving.h"
+#include "selfdrive/ui/replay/framereader.h"
+
+// on-device model regression bench: decode a fixed recorded segment and run
+// the full prepare/execute/publish pipeline over it unthrottled, reporting
+// frames/sec, per-stage times and a checksum over the raw network output.
+// pass a different segment url as the first argument, and the expected
+// checksum as the second to use the run as a pass/fail gate when validating
+// thneed, transform or post-processing changes on real hardware.
+
+namespace {
+
+// same segment camera_replay streams, so results line up with replay runs
+const char *DEFAULT_URL =
+    "https://commadataci.blob.core.windows.net/openpilotci/0c94aa1e1296d7c6/2021-05-05--19-48-37/0/fcamera.hevc";
+
+uint64_t fnv1a(uint64_t h, const uint8_t *d, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    h = (h ^ d[i]) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+void print_stage(const char *name, std::vector<double> &ms) {
+  std::sort(ms.begin(), ms.end());
+  double sum = 0.0;
+  for (double v : ms) sum += v;
+  printf("{\"name\": \"bench_modeld_%s\", \"frames\": %zu, \"avg_ms\": %.2f, \"p99_ms\": %.2f}\n",
+         name, ms.size(), sum / ms.size(), ms[(size_t)((ms.size() - 1) * 0.99)]);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const std::string url = argc > 1 ? argv[1] : DEFAULT_URL;
+
+  FrameReader frame_reader(true);
+  if (!frame_reader.load(url)) {
+    printf("failed to load segment %s\n", url.c_str());
+    return 1;
+  }
+
+  cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
+  cl_context context = CL_CHECK_ERR(clCreateContext(NULL, 1, &device_id, NULL, NULL, &err));
+
+  ModelState model;
+  model_init(&model, device_id, context);
+
+  PubMaster pm({"modelV2", "cameraOdometry"});
+
+  VisionBuf yuv_buf;
+  yuv_buf.allocate(frame_reader.getYUVSize());
+  yuv_buf.init_cl(device_id, context);
+
+  std::unique_ptr<uint8_t[]> rgb(new uint8_t[frame_reader.getRGBSize()]);
+  std::unique_ptr<uint8_t[]> yuv(new uint8_t[frame_reader.getYUVSize()]);
+
+  // fixed uncalibrated warp so the output only depends on the segment and the
+  // model pipeline, which is what the checksum needs to be comparable
+  const mat3 transform = get_model_yuv_transform();
+  float vec_desire[DESIRE_LEN] = {};
+
+  std::vector<double> prepare_ms, execute_ms, publish_ms;
+  uint64_t checksum = 0xcbf29ce484222325ull;  // FNV-1a offset basis
+
+  const size_t frame_count = frame_reader.getFrameCount();
+  const double t_start = millis_since_boot();
+  for (size_t i = 0; i < frame_count; i++) {
+    if (!frame_reader.get(i, rgb.get(), yuv.get())) continue;
+    CL_CHECK(clEnqueueWriteBuffer(yuv_buf.copy_q, yuv_buf.buf_cl, CL_TRUE, 0,
+                                  frame_reader.getYUVSize(), yuv.get(), 0, NULL, NULL));
+
+    double t0 = millis_since_boot();
+    float *net_input_buf = model_prepare_frame(&model, yuv_buf.buf_cl,
+                                               frame_reader.width, frame_reader.height, transform);
+    double t1 = millis_since_boot();
+    ModelDataRaw model_buf = model_execute_frame(&model, net_input_buf, vec_desire);
+    double t2 = millis_since_boot();
+    model_publish(pm, i, i, 0.0f, 1.0f / MODEL_FREQ, model_buf, 0, 0, (t2 - t1) / 1000.0,
+                  kj::ArrayPtr<const float>(model.output.data(), model.output.size()));
+    posenet_publish(pm, i, 0, model_buf, 0);
+    double t3 = millis_since_boot();
+
+    prepare_ms.push_back(t1 - t0);
+    execute_ms.push_back(t2 - t1);
+    publish_ms.push_back(t3 - t2);
+    checksum = fnv1a(checksum, (const uint8_t *)model.output.data(),
+                     model.output.size() * sizeof(float));
+  }
+  const double elapsed = millis_since_boot() - t_start;
+
+  assert(!prepare_ms.empty());
+  printf("{\"name\": \"bench_modeld\", \"frames\": %zu, \"fps\": %.1f, \"checksum\": \"%016" PRIx64 "\"}\n",
+         prepare_ms.size(), prepare_ms.size() / (elapsed / 1000.0), checksum);
+  print_stage("prepare", prepare_ms);
+  print_stage("execute", execute_ms);
+  print_stage("publish", publish_ms);
+
+  if (argc > 2) {
+    char expected[17];
+    snprintf(expected, sizeof(expected), "%016" PRIx64, checksum);
+    if (std::string(argv[2]) != expected) {
+      printf("FAIL: checksum %s does not match golden %s\n", expected, argv[2]);
+      return 1;
+    }
+    printf("PASS: checksum matches golden\n");
+  }
+
+  model_free(&model);
+  yuv_buf.free();
+  CL_CHECK(clReleaseContext(context));
+  return 0;
+}
@@ -5,27 +5,66 @@
 #include <cstdlib>
 
 #include "cereal/visionipc/visionipc_client.h"
+#include "selfdrive/common/clutil.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/modeld/models/dmonitoring.h"
+#ifdef USE_THNEED
+#include "selfdrive/modeld/thneed/thneed.h"
+#endif
 
 ExitHandler do_exit;
 
+// evaluate every Nth frame while parked with a confidently attentive driver
+const int SKIP_DIVISOR = 4;  // 20Hz camera -> 5Hz
+
+// comfortably away from the decision thresholds in driver_monitor.py, so a
+// skipped frame can't flip dmonitoringd's distracted state
+static bool confidently_attentive(const DMonitoringResult &res) {
+  return res.face_prob > 0.995 &&
+         res.partial_face < 0.2 &&
+         res.left_eye_prob > 0.75 && res.right_eye_prob > 0.75 &&
+         res.left_blink_prob < 0.25 && res.right_blink_prob < 0.25 &&
+         res.distracted_pose < 0.5 && res.distracted_eyes < 0.5 &&
+         res.poor_vision < 0.25 && res.sg_prob < 0.25;
+}
+
 void run_model(DMonitoringModelState &model, VisionIpcClient &vipc_client) {
   PubMaster pm({"driverState"});
+  SubMaster sm({"carState"});
   double last = 0;
 
+  DMonitoringResult res = {};
+  bool res_valid = false;
+  int skipped_frames = 0;
+
   while (!do_exit) {
     VisionIpcBufExtra extra = {};
     VisionBuf *buf = vipc_client.recv(&extra);
     if (buf == nullptr) continue;
 
+    sm.update(0);
+
+    // parked with the last outputs far from any threshold, nothing is
+    // moving a decision: decimate evaluation and republish the last result.
+    // borderline or moving always runs full rate.
+    bool can_skip = res_valid && sm["carState"].getCarState().getStandstill() &&
+                    confidently_attentive(res);
+    bool skip = can_skip && (skipped_frames < SKIP_DIVISOR - 1);
+
     double t1 = millis_since_boot();
-    DMonitoringResult res = dmonitoring_eval_frame(&model, buf->addr, buf->width, buf->height);
+    if (!skip) {
+      buf->wait_sync_event();  // fence from the visionipc sync enqueued in recv
+      res = dmonitoring_eval_frame(&model, buf->buf_cl, buf->width, buf->height);
+      res_valid = true;
+      skipped_frames = 0;
+    } else {
+      skipped_frames++;
+    }
     double t2 = millis_since_boot();
 
     // send dm packet
-    dmonitoring_publish(pm, extra.frame_id, res, (t2 - t1) / 1000.0, model.output);
+    dmonitoring_publish(pm, extra.frame_id, res, (t2 - t1) / 1000.0, model.output, skip);
 
     //printf("dmonitoring process: %.2fms, from last %.2fms\n", t2 - t1, t1 - last);
     last = t1;
@@ -35,11 +74,21 @@ void run_model(DMonitoringModelState &model, VisionIpcClient &vipc_client) {
 int main(int argc, char **argv) {
   setpriority(PRIO_PROCESS, 0, -15);
 
+#ifdef USE_THNEED
+  // lower GPU lane than modeld, with a yield between kernels: the driving
+  // model's submissions preempt dmonitoring instead of queueing behind it
+  thneed_set_gpu_priority(7, true);
+#endif
+
+  // cl init
+  cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
+  cl_context context = CL_CHECK_ERR(clCreateContext(NULL, 1, &device_id, NULL, NULL, &err));
+
   // init the models
   DMonitoringModelState model;
-  dmonitoring_init(&model);
+  dmonitoring_init(&model, device_id, context);
 
-  VisionIpcClient vipc_client = VisionIpcClient("camerad", VISION_STREAM_YUV_FRONT, true);
+  VisionIpcClient vipc_client = VisionIpcClient("camerad", VISION_STREAM_YUV_FRONT, true, device_id, context);
   while (!do_exit && !vipc_client.connect(false)) {
     util::sleep_for(100);
   }
@@ -51,5 +100,6 @@ int main(int argc, char **argv) {
   }
 
   dmonitoring_free(&model);
+  CL_CHECK(clReleaseContext(context));
   return 0;
 }
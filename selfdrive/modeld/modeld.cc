@@ -1,23 +1,28 @@
 #include <cstdio>
 #include <cstdlib>
-#include <mutex>
+#include <thread>
 
 #include <eigen3/Eigen/Dense>
 
 #include "cereal/messaging/messaging.h"
 #include "cereal/visionipc/visionipc_client.h"
+#include "cereal/visionipc/visionipc_framesync.h"
 #include "selfdrive/common/clutil.h"
 #include "selfdrive/common/params.h"
+#include "selfdrive/common/queue.h"
 #include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/sched.h"
+#include "selfdrive/common/seqlock.h"
+#include "selfdrive/common/trace.h"
 #include "selfdrive/common/util.h"
+#include "selfdrive/common/watchdog.h"
 #include "selfdrive/hardware/hw.h"
 #include "selfdrive/modeld/models/driving.h"
 
 ExitHandler do_exit;
-// globals
-bool live_calib_seen;
-mat3 cur_transform;
-std::mutex transform_lock;
+// calibrated model input warp, published by the calibration thread and
+// read per frame with two loads instead of a mutex in the frame path
+SeqLock<mat3> cur_transform;
 
 void calibration_thread(bool wide_camera) {
   set_thread_name("calibration");
@@ -40,94 +45,168 @@ void calibration_thread(bool wide_camera) {
   Eigen::Matrix<float, 3, 3> cam_intrinsics = Eigen::Matrix<float, 3, 3, Eigen::RowMajor>(wide_camera ? ecam_intrinsic_matrix.v : fcam_intrinsic_matrix.v);
   const mat3 yuv_transform = get_model_yuv_transform();
 
+  auto update_extrinsics = [&](const capnp::List<float>::Reader &extrinsic_matrix) {
+    Eigen::Matrix<float, 3, 4> extrinsic_matrix_eigen;
+    for (int i = 0; i < 4*3; i++) {
+      extrinsic_matrix_eigen(i / 4, i % 4) = extrinsic_matrix[i];
+    }
+
+    auto camera_frame_from_road_frame = cam_intrinsics * extrinsic_matrix_eigen;
+    Eigen::Matrix<float, 3, 3> camera_frame_from_ground;
+    camera_frame_from_ground.col(0) = camera_frame_from_road_frame.col(0);
+    camera_frame_from_ground.col(1) = camera_frame_from_road_frame.col(1);
+    camera_frame_from_ground.col(2) = camera_frame_from_road_frame.col(3);
+
+    auto warp_matrix = camera_frame_from_ground * ground_from_medmodel_frame;
+    mat3 transform = {};
+    for (int i=0; i<3*3; i++) {
+      transform.v[i] = warp_matrix(i / 3, i % 3);
+    }
+    cur_transform.write(matmul3(yuv_transform, transform));
+  };
+
+  // seed from the calibration calibrationd persisted, so a restart while
+  // onroad starts running the model on the first frame instead of sitting
+  // blind until the next liveCalibration publish
+  if (const std::string cal = Params().get("CalibrationParams"); !cal.empty()) {
+    AlignedBuffer aligned_buf;
+    capnp::FlatArrayMessageReader cmsg(aligned_buf.align(cal.data(), cal.size()));
+    update_extrinsics(cmsg.getRoot<cereal::Event>().getLiveCalibration().getExtrinsicMatrix());
+  }
+
   while (!do_exit) {
     sm.update(100);
     if(sm.updated("liveCalibration")) {
-      auto extrinsic_matrix = sm["liveCalibration"].getLiveCalibration().getExtrinsicMatrix();
-      Eigen::Matrix<float, 3, 4> extrinsic_matrix_eigen;
-      for (int i = 0; i < 4*3; i++) {
-        extrinsic_matrix_eigen(i / 4, i % 4) = extrinsic_matrix[i];
-      }
-
-      auto camera_frame_from_road_frame = cam_intrinsics * extrinsic_matrix_eigen;
-      Eigen::Matrix<float, 3, 3> camera_frame_from_ground;
-      camera_frame_from_ground.col(0) = camera_frame_from_road_frame.col(0);
-      camera_frame_from_ground.col(1) = camera_frame_from_road_frame.col(1);
-      camera_frame_from_ground.col(2) = camera_frame_from_road_frame.col(3);
-
-      auto warp_matrix = camera_frame_from_ground * ground_from_medmodel_frame;
-      mat3 transform = {};
-      for (int i=0; i<3*3; i++) {
-        transform.v[i] = warp_matrix(i / 3, i % 3);
-      }
-      mat3 model_transform = matmul3(yuv_transform, transform);
-      std::lock_guard lk(transform_lock);
-      cur_transform = model_transform;
-      live_calib_seen = true;
+      update_extrinsics(sm["liveCalibration"].getLiveCalibration().getExtrinsicMatrix());
     }
   }
 }
 
+struct ModelPipelineJob {
+  float *net_input_buf;
+  VisionIpcBufExtra extra;
+  uint32_t frame_id;
+  float frame_drop_ratio;
+  float frame_cadence;
+  uint32_t vipc_dropped_frames;
+  float vec_desire[DESIRE_LEN];
+};
+
 void run_model(ModelState &model, VisionIpcClient &vipc_client) {
   // messaging
-  PubMaster pm({"modelV2", "cameraOdometry"});
-  SubMaster sm({"lateralPlan", "roadCameraState"});
+  SubMaster sm({"lateralPlan", "roadCameraState", "deviceState"});
 
   // setup filter to track dropped frames
   FirstOrderFilter frame_dropped_filter(0., 10., 1. / MODEL_FREQ);
 
+  // Two-deep pipeline: the main thread warps frame N+1 into a net input
+  // while the worker executes frame N, which is all the ordering the
+  // recurrent state needs. The thneed runner owns its single input buffer,
+  // so it runs at depth one (sequential).
+  const int pipeline_depth = (model.m->getInputBuf() == nullptr) ? 2 : 1;
+  SafeQueue<ModelPipelineJob> jobs;
+  SafeQueue<int> free_slots;
+  for (int i = 0; i < pipeline_depth; i++) {
+    free_slots.push(i);
+  }
+
+  std::thread execute_thread([&] {
+    set_thread_name("modeld_execute");
+    PubMaster pm({"modelV2", "cameraOdometry"});
+
+    // one frame period per cycle; overruns show up in procLog
+    SchedBudget budget("modeld", 1e9 / MODEL_FREQ);
+
+    while (!do_exit) {
+      ModelPipelineJob job;
+      if (!jobs.try_pop(job, 100)) continue;
+
+      budget.cycleStart();
+      double mt1 = millis_since_boot();
+      trace_event("model_execute", 'B');
+      ModelDataRaw model_buf = model_execute_frame(&model, job.net_input_buf, job.vec_desire);
+      trace_event("model_execute", 'E');
+      double mt2 = millis_since_boot();
+      float model_execution_time = (mt2 - mt1) / 1000.0;
+
+      trace_event("model_publish", 'B');
+      model_publish(pm, job.extra.frame_id, job.frame_id, job.frame_drop_ratio, job.frame_cadence, model_buf, job.extra.timestamp_sof, job.extra.timestamp_eof, model_execution_time,
+                    kj::ArrayPtr<const float>(model.output.data(), model.output.size()));
+      posenet_publish(pm, job.extra.frame_id, job.vipc_dropped_frames, model_buf, job.extra.timestamp_eof);
+      trace_event("model_publish", 'E');
+      budget.cycleEnd();
+
+      //printf("model process: %.2fms, vipc_frame_id %u, frame_id, %u, frame_drop %.3f\n", mt2 - mt1, job.extra.frame_id, job.frame_id, job.frame_drop_ratio);
+      free_slots.push(0);
+    }
+  });
+
   uint32_t frame_id = 0, last_vipc_frame_id = 0;
-  double last = 0;
   uint32_t run_count = 0;
 
+  // received frames stay addressable by id for frame-exact lookups
+  VisionIpcFrameSync frame_sync(&vipc_client);
+
   while (!do_exit) {
     VisionIpcBufExtra extra = {};
-    VisionBuf *buf = vipc_client.recv(&extra);
+    VisionBuf *buf = frame_sync.recv(&extra);
     if (buf == nullptr) continue;
 
-    transform_lock.lock();
-    mat3 model_transform = cur_transform;
-    const bool run_model_this_iter = live_calib_seen;
-    transform_lock.unlock();
+    mat3 model_transform;
+    const bool run_model_this_iter = cur_transform.read(&model_transform);
 
     // TODO: path planner timeout?
     sm.update(0);
     int desire = ((int)sm["lateralPlan"].getLateralPlan().getDesire());
     frame_id = sm["roadCameraState"].getRoadCameraState().getFrameId();
 
+    // proactive degradation under thermal throttle: a stable half cadence on
+    // even frame ids beats shedding frames erratically once we can't keep up.
+    // the active cadence goes out in modelV2 for plannerd's timestep.
+    const uint32_t cadence =
+        sm["deviceState"].getDeviceState().getThermalStatus() >= cereal::DeviceState::ThermalStatus::RED ? 2 : 1;
+    if ((extra.frame_id % cadence) != 0) continue;
+
     if (run_model_this_iter) {
       run_count++;
 
-      float vec_desire[DESIRE_LEN] = {0};
+      ModelPipelineJob job = {};
       if (desire >= 0 && desire < DESIRE_LEN) {
-        vec_desire[desire] = 1.0;
+        job.vec_desire[desire] = 1.0;
       }
 
-      double mt1 = millis_since_boot();
-      ModelDataRaw model_buf = model_eval_frame(&model, buf->buf_cl, buf->width, buf->height,
-                                                model_transform, vec_desire);
-      double mt2 = millis_since_boot();
-      float model_execution_time = (mt2 - mt1) / 1000.0;
+      // wait for a pipeline slot so the prepare never overwrites an input
+      // the runner is still reading
+      int slot;
+      while (!do_exit && !free_slots.try_pop(slot, 100));
+      if (do_exit) break;
+
+      buf->wait_sync_event();  // fence from the visionipc sync enqueued in recv
+      trace_event("model_prepare", 'B');
+      job.net_input_buf = model_prepare_frame(&model, buf->buf_cl, buf->width, buf->height, model_transform);
+      trace_event("model_prepare", 'E');
 
-      // tracked dropped frames
-      uint32_t vipc_dropped_frames = extra.frame_id - last_vipc_frame_id - 1;
+      // tracked dropped frames; the cadence gap is intentional, not a drop
+      uint32_t frame_gap = extra.frame_id - last_vipc_frame_id;
+      uint32_t vipc_dropped_frames = (frame_gap > cadence) ? (frame_gap - cadence) : 0;
       float frames_dropped = frame_dropped_filter.update((float)std::min(vipc_dropped_frames, 10U));
       if (run_count < 10) { // let frame drops warm up
         frame_dropped_filter.reset(0);
         frames_dropped = 0.;
       }
 
-      float frame_drop_ratio = frames_dropped / (1 + frames_dropped);
-
-      model_publish(pm, extra.frame_id, frame_id, frame_drop_ratio, model_buf, extra.timestamp_eof, model_execution_time,
-                    kj::ArrayPtr<const float>(model.output.data(), model.output.size()));
-      posenet_publish(pm, extra.frame_id, vipc_dropped_frames, model_buf, extra.timestamp_eof);
+      job.extra = extra;
+      job.frame_id = frame_id;
+      job.frame_drop_ratio = frames_dropped / (1 + frames_dropped);
+      job.frame_cadence = (float)cadence / MODEL_FREQ;
+      job.vipc_dropped_frames = vipc_dropped_frames;
+      jobs.push(job);
 
-      //printf("model process: %.2fms, from last %.2fms, vipc_frame_id %u, frame_id, %u, frame_drop %.3f\n", mt2 - mt1, mt1 - last, extra.frame_id, frame_id, frame_drop_ratio);
-      last = mt1;
       last_vipc_frame_id = extra.frame_id;
     }
   }
+
+  execute_thread.join();
 }
 
 int main(int argc, char **argv) {
@@ -148,15 +227,28 @@ int main(int argc, char **argv) {
   cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
   cl_context context = CL_CHECK_ERR(clCreateContext(NULL, 1, &device_id, NULL, NULL, &err));
 
-  // init the models
+  // init the models on a spare thread so the (slow) thneed/snpe load
+  // overlaps connecting to camerad; after a crash onroad this is part of
+  // the time controlsd spends without a model
   ModelState model;
-  model_init(&model, device_id, context);
-  LOGW("models loaded, modeld starting");
+  std::thread model_init_thread([&] {
+    set_thread_name("model_init");
+    model_init(&model, device_id, context);
+  });
 
-  VisionIpcClient vipc_client = VisionIpcClient("camerad", wide_camera ? VISION_STREAM_YUV_WIDE : VISION_STREAM_YUV_BACK, true, device_id, context);
+  VisionIpcClient vipc_client = VisionIpcClient("camerad", wide_camera ? VISION_STREAM_YUV_WIDE : VISION_STREAM_YUV_BACK, true, device_id, context, SUB_PRIO_HIGH);
+  // camerad's ready bit flips as soon as its buffers are up; spinning on the
+  // shared flag reacts faster than 100ms connect retries during boot. bounded
+  // so frame sources that never publish one (replay tools) still work
+  for (int i = 0; i < 500 && !do_exit && !process_is_ready("camerad"); i++) {
+    util::sleep_for(10);
+  }
   while (!do_exit && !vipc_client.connect(false)) {
     util::sleep_for(100);
   }
+  model_init_thread.join();
+  LOGW("models loaded, modeld starting");
+  process_set_ready("modeld");
 
   // run the models
   // vipc_client.connected is false only when do_exit is true
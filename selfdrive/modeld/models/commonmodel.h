@@ -14,7 +14,6 @@
 
 #include "selfdrive/common/mat.h"
 #include "selfdrive/modeld/transforms/loadyuv.h"
-#include "selfdrive/modeld/transforms/transform.h"
 
 constexpr int MODEL_WIDTH = 512;
 constexpr int MODEL_HEIGHT = 256;
@@ -35,9 +34,11 @@ class ModelFrame {
   const int buf_size = MODEL_FRAME_SIZE * 2;
 
  private:
-  Transform transform;
   LoadYUVState loadyuv;
   cl_command_queue q;
-  cl_mem y_cl, u_cl, v_cl, net_input_cl;
-  std::unique_ptr<float[]> input_frames;
+  cl_mem net_input_cl;
+  // two host-side buffers so the next frame can be prepared while the
+  // runner is still reading the previous one
+  std::unique_ptr<float[]> input_frames[2];
+  int cur_frame = 0;
 };
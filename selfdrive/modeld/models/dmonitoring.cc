@@ -1,7 +1,4 @@
-#include <cstring>
-
-#include "libyuv.h"
-
+#include "selfdrive/common/clutil.h"
 #include "selfdrive/common/mat.h"
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/timing.h"
@@ -13,11 +10,18 @@
 #define MODEL_HEIGHT 640
 #define FULL_W 852 // should get these numbers from camerad
 
-void dmonitoring_init(DMonitoringModelState* s) {
+void dmonitoring_init(DMonitoringModelState* s, cl_device_id device_id, cl_context context) {
   s->is_rhd = Params().getBool("IsRHD");
-  for (int x = 0; x < std::size(s->tensor); ++x) {
-    s->tensor[x] = (x - 128.f) * 0.0078125f;
-  }
+
+  s->q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
+  s->y_cl = cl_pool_alloc(context, MODEL_WIDTH * MODEL_HEIGHT);
+  s->u_cl = cl_pool_alloc(context, (MODEL_WIDTH / 2) * (MODEL_HEIGHT / 2));
+  s->v_cl = cl_pool_alloc(context, (MODEL_WIDTH / 2) * (MODEL_HEIGHT / 2));
+  s->net_input_cl = cl_pool_alloc(context, MODEL_WIDTH * MODEL_HEIGHT * 3 / 2 * sizeof(float));
+
+  transform_init(&s->transform, context, device_id);
+  // normalized: the net wants (x - 128) * 0.0078125, baked into the load
+  loadyuv_init(&s->loadyuv, context, device_id, MODEL_WIDTH, MODEL_HEIGHT, true);
 
 #ifdef USE_ONNX_MODEL
   s->m = new ONNXModel("../../models/dmonitoring_model.onnx", &s->output[0], OUTPUT_SIZE, USE_DSP_RUNTIME);
@@ -32,27 +36,9 @@ static inline T *get_buffer(std::vector<T> &buf, const size_t size) {
   return buf.data();
 }
 
-static inline auto get_yuv_buf(std::vector<uint8_t> &buf, const int width, int height) {
-  uint8_t *y = get_buffer(buf, width * height * 3 / 2);
-  uint8_t *u = y + width * height;
-  uint8_t *v = u + (width /2) * (height / 2);
-  return std::make_tuple(y, u, v);
-}
-
 struct Rect {int x, y, w, h;};
-void crop_yuv(uint8_t *raw, int width, int height, uint8_t *y, uint8_t *u, uint8_t *v, const Rect &rect) {
-  uint8_t *raw_y = raw;
-  uint8_t *raw_u = raw_y + (width * height);
-  uint8_t *raw_v = raw_u + ((width / 2) * (height / 2));
-  for (int r = 0; r < rect.h / 2; r++) {
-    memcpy(y + 2 * r * rect.w, raw_y + (2 * r + rect.y) * width + rect.x, rect.w);
-    memcpy(y + (2 * r + 1) * rect.w, raw_y + (2 * r + rect.y + 1) * width + rect.x, rect.w);
-    memcpy(u + r * (rect.w / 2), raw_u + (r + (rect.y / 2)) * width / 2 + (rect.x / 2), rect.w / 2);
-    memcpy(v + r * (rect.w / 2), raw_v + (r + (rect.y / 2)) * width / 2 + (rect.x / 2), rect.w / 2);
-  }
-}
 
-DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_buf, int width, int height) {
+DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, cl_mem yuv_cl, int width, int height) {
   Rect crop_rect;
   if (Hardware::TICI()) {
     const int full_width_tici = 1928;
@@ -74,57 +60,30 @@ DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_
     }
   }
 
-  int resized_width = MODEL_WIDTH;
-  int resized_height = MODEL_HEIGHT;
-
-  auto [cropped_y, cropped_u, cropped_v] = get_yuv_buf(s->cropped_buf, crop_rect.w, crop_rect.h);
-  if (!s->is_rhd) {
-    crop_yuv((uint8_t *)stream_buf, width, height, cropped_y, cropped_u, cropped_v, crop_rect);
-  } else {
-    auto [mirror_y, mirror_u, mirror_v] = get_yuv_buf(s->premirror_cropped_buf, crop_rect.w, crop_rect.h);
-    crop_yuv((uint8_t *)stream_buf, width, height, mirror_y, mirror_u, mirror_v, crop_rect);
-    libyuv::I420Mirror(mirror_y, crop_rect.w,
-                       mirror_u, crop_rect.w / 2,
-                       mirror_v, crop_rect.w / 2,
-                       cropped_y, crop_rect.w,
-                       cropped_u, crop_rect.w / 2,
-                       cropped_v, crop_rect.w / 2,
-                       crop_rect.w, crop_rect.h);
+  // warp does crop, scale and mirror in one pass; projection maps model
+  // pixel centers into the input frame
+  const float sx = (float)crop_rect.w / MODEL_WIDTH;
+  const float sy = (float)crop_rect.h / MODEL_HEIGHT;
+  mat3 projection = {{
+    sx, 0.f, crop_rect.x + 0.5f*sx - 0.5f,
+    0.f, sy, crop_rect.y + 0.5f*sy - 0.5f,
+    0.f, 0.f, 1.f,
+  }};
+  if (s->is_rhd) {
+    // mirrored: model x counts down from the right edge of the crop
+    projection.v[0] = -sx;
+    projection.v[2] = crop_rect.x + crop_rect.w - 0.5f*sx - 0.5f;
   }
 
-  auto [resized_buf, resized_u, resized_v] = get_yuv_buf(s->resized_buf, resized_width, resized_height);
-  uint8_t *resized_y = resized_buf;
-  libyuv::FilterMode mode = libyuv::FilterModeEnum::kFilterBilinear;
-  libyuv::I420Scale(cropped_y, crop_rect.w,
-                    cropped_u, crop_rect.w / 2,
-                    cropped_v, crop_rect.w / 2,
-                    crop_rect.w, crop_rect.h,
-                    resized_y, resized_width,
-                    resized_u, resized_width / 2,
-                    resized_v, resized_width / 2,
-                    resized_width, resized_height,
-                    mode);
+  transform_queue(&s->transform, s->q, yuv_cl, width, height,
+                  s->y_cl, s->u_cl, s->v_cl, MODEL_WIDTH, MODEL_HEIGHT, projection);
+  // loadys writes the same y|y|y|y|u|v half-res channel layout the net wants
+  loadyuv_queue(&s->loadyuv, s->q, s->y_cl, s->u_cl, s->v_cl, s->net_input_cl);
 
   int yuv_buf_len = (MODEL_WIDTH/2) * (MODEL_HEIGHT/2) * 6; // Y|u|v -> y|y|y|y|u|v
   float *net_input_buf = get_buffer(s->net_input_buf, yuv_buf_len);
-  // one shot conversion, O(n) anyway
-  // yuvframe2tensor, normalize
-  for (int r = 0; r < MODEL_HEIGHT/2; r++) {
-    for (int c = 0; c < MODEL_WIDTH/2; c++) {
-      // Y_ul
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (0*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r)*resized_width + 2*c]];
-      // Y_dl
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (1*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r+1)*resized_width + 2*c]];
-      // Y_ur
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (2*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r)*resized_width + 2*c+1]];
-      // Y_dr
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (3*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r+1)*resized_width + 2*c+1]];
-      // U
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (4*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_u[r*resized_width/2 + c]];
-      // V
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (5*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_v[r*resized_width/2 + c]];
-    }
-  }
+  CL_CHECK(clEnqueueReadBuffer(s->q, s->net_input_cl, CL_TRUE, 0, yuv_buf_len * sizeof(float), net_input_buf, 0, NULL, NULL));
+  clFinish(s->q);
 
   //printf("preprocess completed. %d \n", yuv_buf_len);
   //FILE *dump_yuv_file = fopen("/tmp/rawdump.yuv", "wb");
@@ -166,13 +125,14 @@ DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_
   return ret;
 }
 
-void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResult &res, float execution_time, kj::ArrayPtr<const float> raw_pred) {
+void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResult &res, float execution_time, kj::ArrayPtr<const float> raw_pred, bool model_skipped) {
   // make msg
   MessageBuilder msg;
   auto framed = msg.initEvent().initDriverState();
   framed.setFrameId(frame_id);
   framed.setModelExecutionTime(execution_time);
   framed.setDspExecutionTime(res.dsp_execution_time);
+  framed.setModelSkipped(model_skipped);
 
   framed.setFaceOrientation(res.face_orientation);
   framed.setFaceOrientationStd(res.face_orientation_meta);
@@ -196,5 +156,12 @@ void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResu
 }
 
 void dmonitoring_free(DMonitoringModelState* s) {
+  transform_destroy(&s->transform);
+  loadyuv_destroy(&s->loadyuv);
+  cl_pool_release(s->net_input_cl);
+  cl_pool_release(s->v_cl);
+  cl_pool_release(s->u_cl);
+  cl_pool_release(s->y_cl);
+  CL_CHECK(clReleaseCommandQueue(s->q));
   delete s->m;
 }
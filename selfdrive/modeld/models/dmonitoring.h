@@ -6,6 +6,7 @@
 #include "selfdrive/common/util.h"
 #include "selfdrive/modeld/models/commonmodel.h"
 #include "selfdrive/modeld/runners/run.h"
+#include "selfdrive/modeld/transforms/transform.h"
 
 #define OUTPUT_SIZE 38
 
@@ -31,15 +32,16 @@ typedef struct DMonitoringModelState {
   RunModel *m;
   bool is_rhd;
   float output[OUTPUT_SIZE];
-  std::vector<uint8_t> resized_buf;
-  std::vector<uint8_t> cropped_buf;
-  std::vector<uint8_t> premirror_cropped_buf;
+  // the crop, scale, mirror and tensor pack all run on the GPU
+  Transform transform;
+  LoadYUVState loadyuv;
+  cl_command_queue q;
+  cl_mem y_cl, u_cl, v_cl, net_input_cl;
   std::vector<float> net_input_buf;
-  float tensor[UINT8_MAX + 1];
 } DMonitoringModelState;
 
-void dmonitoring_init(DMonitoringModelState* s);
-DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_buf, int width, int height);
-void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResult &res, float execution_time, kj::ArrayPtr<const float> raw_pred);
+void dmonitoring_init(DMonitoringModelState* s, cl_device_id device_id, cl_context context);
+DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, cl_mem yuv_cl, int width, int height);
+void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResult &res, float execution_time, kj::ArrayPtr<const float> raw_pred, bool model_skipped = false);
 void dmonitoring_free(DMonitoringModelState* s);
 
@@ -1,6 +1,7 @@
 #include "selfdrive/modeld/models/driving.h"
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include <cassert>
@@ -26,6 +27,49 @@ constexpr const kj::ArrayPtr<const T> to_kj_array_ptr(const std::array<T, size>
   return kj::ArrayPtr(arr.data(), arr.size());
 }
 
+// Transpose one strided lane of the raw network output into a contiguous
+// array. Going through Eigen lets the exp/sigmoid variants run over the
+// whole lane at once with the platform's SIMD instead of a libm call per
+// element.
+template<size_t size>
+void gather(const float *in, int stride, std::array<float, size> &out) {
+  Eigen::Map<Eigen::ArrayXf>(out.data(), size) =
+      Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<>>(in, size, Eigen::InnerStride<>(stride));
+}
+
+template<size_t size>
+void gather_exp(const float *in, int stride, std::array<float, size> &out) {
+  Eigen::Map<Eigen::ArrayXf>(out.data(), size) =
+      Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<>>(in, size, Eigen::InnerStride<>(stride)).exp();
+}
+
+#ifdef TEMPORAL
+constexpr uint32_t MODEL_STATE_MAGIC = 0x3053444d;  // "MDS0"
+// a checkpoint older than this describes a scene the car has since left
+constexpr uint64_t MODEL_STATE_MAX_AGE_NS = 10ULL * 1000000000ULL;
+// how long restored state keeps being flagged in modelV2
+constexpr int WARM_START_FRAMES = 40;  // 2s at 20Hz
+
+static ModelStateShm *model_state_shm() {
+  int fd = open("/dev/shm/op_model_state", O_RDWR | O_CREAT, 0664);
+  if (fd < 0) return nullptr;
+  if (ftruncate(fd, sizeof(ModelStateShm)) < 0) {
+    close(fd);
+    return nullptr;
+  }
+  ModelStateShm *shm = (ModelStateShm *)mmap(nullptr, sizeof(ModelStateShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (shm == MAP_FAILED) return nullptr;
+  if (shm->magic != MODEL_STATE_MAGIC) {
+    memset(shm, 0, sizeof(ModelStateShm));
+    // magic last, so a restarting modeld never restores from a
+    // half-initialized table
+    shm->magic = MODEL_STATE_MAGIC;
+  }
+  return shm;
+}
+#endif
+
 void model_init(ModelState* s, cl_device_id device_id, cl_context context) {
   s->frame = new ModelFrame(device_id, context);
 
@@ -39,6 +83,18 @@ void model_init(ModelState* s, cl_device_id device_id, cl_context context) {
 
 #ifdef TEMPORAL
   s->m->addRecurrent(&s->output[OUTPUT_SIZE], TEMPORAL_SIZE);
+
+  // warm restore: pick up the previous instance's recurrent state if it's
+  // recent enough, instead of settling from zeros for several seconds
+  s->state_shm = model_state_shm();
+  if (s->state_shm != nullptr) {
+    ModelStateCheckpoint ckpt;
+    if (s->state_shm->state.read(&ckpt) &&
+        nanos_since_boot() - ckpt.mono_time < MODEL_STATE_MAX_AGE_NS) {
+      memcpy(&s->output[OUTPUT_SIZE], ckpt.temporal, sizeof(ckpt.temporal));
+      s->warm_start_frames = WARM_START_FRAMES;
+    }
+  }
 #endif
 
 #ifdef DESIRE
@@ -52,8 +108,13 @@ void model_init(ModelState* s, cl_device_id device_id, cl_context context) {
 #endif
 }
 
-ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int height,
-                           const mat3 &transform, float *desire_in) {
+float* model_prepare_frame(ModelState* s, cl_mem yuv_cl, int width, int height,
+                           const mat3 &transform) {
+  // if getInputBuf is not NULL, net_input_buf will be
+  return s->frame->prepare(yuv_cl, width, height, transform, static_cast<cl_mem*>(s->m->getInputBuf()));
+}
+
+ModelDataRaw model_execute_frame(ModelState* s, float *net_input_buf, float *desire_in) {
 #ifdef DESIRE
   if (desire_in != NULL) {
     for (int i = 1; i < DESIRE_LEN; i++) {
@@ -71,10 +132,25 @@ ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int heigh
 
   //for (int i = 0; i < NET_OUTPUT_SIZE; i++) { printf("%f ", s->output[i]); } printf("\n");
 
-  // if getInputBuf is not NULL, net_input_buf will be
-  auto net_input_buf = s->frame->prepare(yuv_cl, width, height, transform, static_cast<cl_mem*>(s->m->getInputBuf()));
   s->m->execute(net_input_buf, s->frame->buf_size);
 
+#ifdef TEMPORAL
+  // checkpoint the recurrent state a few times per second for the next
+  // instance's warm restore
+  if (s->state_shm != nullptr && (s->run_count++ % 5) == 0) {
+    ModelStateCheckpoint ckpt;
+    ckpt.mono_time = nanos_since_boot();
+    memcpy(ckpt.temporal, &s->output[OUTPUT_SIZE], sizeof(ckpt.temporal));
+    s->state_shm->state.write(ckpt);
+  }
+#endif
+
+  bool warm_start = false;
+#ifdef TEMPORAL
+  warm_start = s->warm_start_frames > 0;
+  if (warm_start) s->warm_start_frames--;
+#endif
+
   // net outputs
   ModelDataRaw net_outputs {
     .plans = (ModelDataRawPlans*)&s->output[PLAN_IDX],
@@ -83,6 +159,7 @@ ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int heigh
     .leads = (ModelDataRawLeads*)&s->output[LEAD_IDX],
     .meta = &s->output[DESIRE_STATE_IDX],
     .pose = (ModelDataRawPose*)&s->output[POSE_IDX],
+    .warm_start = warm_start,
   };
   return net_outputs;
 }
@@ -92,9 +169,8 @@ void model_free(ModelState* s) {
 }
 
 void fill_sigmoid(const float *input, float *output, int len, int stride) {
-  for (int i=0; i<len; i++) {
-    output[i] = sigmoid(input[i*stride]);
-  }
+  Eigen::Map<Eigen::ArrayXf> out(output, len);
+  out = 1.0f / (1.0f + (-Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<>>(input, len, Eigen::InnerStride<>(stride))).exp());
 }
 
 void fill_lead(cereal::ModelDataV2::LeadDataV3::Builder lead, const ModelDataRawLeads &leads, int t_idx, float prob_t) {
@@ -104,16 +180,17 @@ void fill_lead(cereal::ModelDataV2::LeadDataV3::Builder lead, const ModelDataRaw
   lead.setProbTime(prob_t);
   std::array<float, LEAD_TRAJ_LEN> lead_x, lead_y, lead_v, lead_a;
   std::array<float, LEAD_TRAJ_LEN> lead_x_std, lead_y_std, lead_v_std, lead_a_std;
-  for (int i=0; i<LEAD_TRAJ_LEN; i++) {
-    lead_x[i] = best_prediction.mean[i].x;
-    lead_y[i] = best_prediction.mean[i].y;
-    lead_v[i] = best_prediction.mean[i].velocity;
-    lead_a[i] = best_prediction.mean[i].acceleration;
-    lead_x_std[i] = exp(best_prediction.std[i].x);
-    lead_y_std[i] = exp(best_prediction.std[i].y);
-    lead_v_std[i] = exp(best_prediction.std[i].velocity);
-    lead_a_std[i] = exp(best_prediction.std[i].acceleration);
-  }
+  constexpr int stride = sizeof(ModelDataRawLeadElement) / sizeof(float);
+  const float *mean = &best_prediction.mean[0].x;
+  const float *std = &best_prediction.std[0].x;
+  gather(mean + 0, stride, lead_x);
+  gather(mean + 1, stride, lead_y);
+  gather(mean + 2, stride, lead_v);
+  gather(mean + 3, stride, lead_a);
+  gather_exp(std + 0, stride, lead_x_std);
+  gather_exp(std + 1, stride, lead_y_std);
+  gather_exp(std + 2, stride, lead_v_std);
+  gather_exp(std + 3, stride, lead_a_std);
   lead.setT(to_kj_array_ptr(lead_t));
   lead.setX(to_kj_array_ptr(lead_x));
   lead.setY(to_kj_array_ptr(lead_y));
@@ -204,23 +281,24 @@ void fill_plan(cereal::ModelDataV2::Builder &framed, const ModelDataRawPlanPredi
   std::array<float, TRAJECTORY_SIZE> rot_x, rot_y, rot_z;
   std::array<float, TRAJECTORY_SIZE> rot_rate_x, rot_rate_y, rot_rate_z;
 
-  for(int i=0; i<TRAJECTORY_SIZE; i++) {
-    pos_x[i] = plan.mean[i].position.x;
-    pos_y[i] = plan.mean[i].position.y;
-    pos_z[i] = plan.mean[i].position.z;
-    pos_x_std[i] = exp(plan.std[i].position.x);
-    pos_y_std[i] = exp(plan.std[i].position.y);
-    pos_z_std[i] = exp(plan.std[i].position.z);
-    vel_x[i] = plan.mean[i].velocity.x;
-    vel_y[i] = plan.mean[i].velocity.y;
-    vel_z[i] = plan.mean[i].velocity.z;
-    rot_x[i] = plan.mean[i].rotation.x;
-    rot_y[i] = plan.mean[i].rotation.y;
-    rot_z[i] = plan.mean[i].rotation.z;
-    rot_rate_x[i] = plan.mean[i].rotation_rate.x;
-    rot_rate_y[i] = plan.mean[i].rotation_rate.y;
-    rot_rate_z[i] = plan.mean[i].rotation_rate.z;
-  }
+  constexpr int stride = sizeof(ModelDataRawPlanElement) / sizeof(float);
+  const float *mean = &plan.mean[0].position.x;
+  const float *std = &plan.std[0].position.x;
+  gather(mean + 0, stride, pos_x);
+  gather(mean + 1, stride, pos_y);
+  gather(mean + 2, stride, pos_z);
+  gather_exp(std + 0, stride, pos_x_std);
+  gather_exp(std + 1, stride, pos_y_std);
+  gather_exp(std + 2, stride, pos_z_std);
+  gather(mean + 3, stride, vel_x);
+  gather(mean + 4, stride, vel_y);
+  gather(mean + 5, stride, vel_z);
+  gather(mean + 9, stride, rot_x);
+  gather(mean + 10, stride, rot_y);
+  gather(mean + 11, stride, rot_z);
+  gather(mean + 12, stride, rot_rate_x);
+  gather(mean + 13, stride, rot_rate_y);
+  gather(mean + 14, stride, rot_rate_z);
 
   fill_xyzt(framed.initPosition(), T_IDXS_FLOAT, pos_x, pos_y, pos_z, pos_x_std, pos_y_std, pos_z_std);
   fill_xyzt(framed.initVelocity(), T_IDXS_FLOAT, vel_x, vel_y, vel_z);
@@ -234,16 +312,15 @@ void fill_lane_lines(cereal::ModelDataV2::Builder &framed, const std::array<floa
   std::array<float, TRAJECTORY_SIZE> left_near_y, left_near_z;
   std::array<float, TRAJECTORY_SIZE> right_near_y, right_near_z;
   std::array<float, TRAJECTORY_SIZE> right_far_y, right_far_z;
-  for (int j=0; j<TRAJECTORY_SIZE; j++) {
-    left_far_y[j] = lanes.mean.left_far[j].y;
-    left_far_z[j] = lanes.mean.left_far[j].z;
-    left_near_y[j] = lanes.mean.left_near[j].y;
-    left_near_z[j] = lanes.mean.left_near[j].z;
-    right_near_y[j] = lanes.mean.right_near[j].y;
-    right_near_z[j] = lanes.mean.right_near[j].z;
-    right_far_y[j] = lanes.mean.right_far[j].y;
-    right_far_z[j] = lanes.mean.right_far[j].z;
-  }
+  constexpr int stride = sizeof(ModelDataRawYZ) / sizeof(float);
+  gather(&lanes.mean.left_far[0].y, stride, left_far_y);
+  gather(&lanes.mean.left_far[0].z, stride, left_far_z);
+  gather(&lanes.mean.left_near[0].y, stride, left_near_y);
+  gather(&lanes.mean.left_near[0].z, stride, left_near_z);
+  gather(&lanes.mean.right_near[0].y, stride, right_near_y);
+  gather(&lanes.mean.right_near[0].z, stride, right_near_z);
+  gather(&lanes.mean.right_far[0].y, stride, right_far_y);
+  gather(&lanes.mean.right_far[0].z, stride, right_far_z);
 
   auto lane_lines = framed.initLaneLines(4);
   fill_xyzt(lane_lines[0], plan_t, X_IDXS_FLOAT, left_far_y, left_far_z);
@@ -270,12 +347,11 @@ void fill_road_edges(cereal::ModelDataV2::Builder &framed, const std::array<floa
                      const ModelDataRawRoadEdges &edges) {
   std::array<float, TRAJECTORY_SIZE> left_y, left_z;
   std::array<float, TRAJECTORY_SIZE> right_y, right_z;
-  for (int j=0; j<TRAJECTORY_SIZE; j++) {
-    left_y[j] = edges.mean.left[j].y;
-    left_z[j] = edges.mean.left[j].z;
-    right_y[j] = edges.mean.right[j].y;
-    right_z[j] = edges.mean.right[j].z;
-  }
+  constexpr int stride = sizeof(ModelDataRawYZ) / sizeof(float);
+  gather(&edges.mean.left[0].y, stride, left_y);
+  gather(&edges.mean.left[0].z, stride, left_z);
+  gather(&edges.mean.right[0].y, stride, right_y);
+  gather(&edges.mean.right[0].z, stride, right_z);
 
   auto road_edges = framed.initRoadEdges(2);
   fill_xyzt(road_edges[0], plan_t, X_IDXS_FLOAT, left_y, left_z);
@@ -288,7 +364,28 @@ void fill_road_edges(cereal::ModelDataV2::Builder &framed, const std::array<floa
 }
 
 void fill_model(cereal::ModelDataV2::Builder &framed, const ModelDataRaw &net_outputs) {
-  const auto &best_plan = net_outputs.plans->get_best_prediction();
+  const int best_plan_idx = net_outputs.plans->get_best_prediction_idx();
+  const auto &best_plan = net_outputs.plans->prediction[best_plan_idx];
+
+  // warm-start hints for downstream MPCs: which hypothesis won, and how far
+  // its lateral trajectory moved since the previous frame. On a hypothesis
+  // switch (lane change) the delta jumps and consumers re-seed their solver
+  // instead of iterating from the stale trajectory.
+  static int prev_plan_idx = -1;
+  static std::array<float, TRAJECTORY_SIZE> prev_plan_y;
+  constexpr int stride = sizeof(ModelDataRawPlanElement) / sizeof(float);
+  Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<>> plan_y(
+      &best_plan.mean[0].position.y, TRAJECTORY_SIZE, Eigen::InnerStride<>(stride));
+  Eigen::Map<Eigen::ArrayXf> prev_y(prev_plan_y.data(), TRAJECTORY_SIZE);
+  float plan_delta = 0.0f;
+  if (prev_plan_idx >= 0) {
+    plan_delta = std::sqrt((plan_y - prev_y).square().mean());
+  }
+  prev_y = plan_y;
+  prev_plan_idx = best_plan_idx;
+  framed.setPlanHypothesisIdx(best_plan_idx);
+  framed.setPlanHypothesisDelta(plan_delta);
+
   std::array<float, TRAJECTORY_SIZE> plan_t;
   std::fill_n(plan_t.data(), plan_t.size(), NAN);
   plan_t[0] = 0.0;
@@ -326,16 +423,19 @@ void fill_model(cereal::ModelDataV2::Builder &framed, const ModelDataRaw &net_ou
 }
 
 void model_publish(PubMaster &pm, uint32_t vipc_frame_id, uint32_t frame_id, float frame_drop,
-                   const ModelDataRaw &net_outputs, uint64_t timestamp_eof,
-                   float model_execution_time, kj::ArrayPtr<const float> raw_pred) {
+                   float frame_cadence, const ModelDataRaw &net_outputs, uint64_t timestamp_sof,
+                   uint64_t timestamp_eof, float model_execution_time, kj::ArrayPtr<const float> raw_pred) {
   const uint32_t frame_age = (frame_id > vipc_frame_id) ? (frame_id - vipc_frame_id) : 0;
   MessageBuilder msg;
   auto framed = msg.initEvent().initModelV2();
   framed.setFrameId(vipc_frame_id);
   framed.setFrameAge(frame_age);
   framed.setFrameDropPerc(frame_drop * 100);
+  framed.setFrameCadence(frame_cadence);
   framed.setTimestampEof(timestamp_eof);
+  framed.setTimestampSof(timestamp_sof);
   framed.setModelExecutionTime(model_execution_time);
+  framed.setWarmStart(net_outputs.warm_start);
   if (send_raw_pred) {
     framed.setRawPredictions(raw_pred.asBytes());
   }
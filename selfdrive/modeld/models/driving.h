@@ -10,6 +10,7 @@
 
 #include "cereal/messaging/messaging.h"
 #include "selfdrive/common/mat.h"
+#include "selfdrive/common/seqlock.h"
 #include "selfdrive/common/modeldata.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/modeld/models/commonmodel.h"
@@ -87,14 +88,18 @@ static_assert(sizeof(ModelDataRawPlanPrediction) == (sizeof(ModelDataRawPlanElem
 struct ModelDataRawPlans {
   std::array<ModelDataRawPlanPrediction, PLAN_MHP_N> prediction;
 
-  constexpr const ModelDataRawPlanPrediction &get_best_prediction() const {
+  constexpr int get_best_prediction_idx() const {
     int max_idx = 0;
     for (int i = 1; i < prediction.size(); i++) {
       if (prediction[i].prob > prediction[max_idx].prob) {
         max_idx = i;
       }
     }
-    return prediction[max_idx];
+    return max_idx;
+  }
+
+  constexpr const ModelDataRawPlanPrediction &get_best_prediction() const {
+    return prediction[get_best_prediction_idx()];
   }
 };
 static_assert(sizeof(ModelDataRawPlans) == sizeof(ModelDataRawPlanPrediction)*PLAN_MHP_N);
@@ -179,6 +184,9 @@ struct ModelDataRawPose {
 };
 static_assert(sizeof(ModelDataRawPose) == sizeof(ModelDataRawXYZ)*4);
 
+// zero-copy views into ModelState::output: picking the best hypothesis only
+// reads the prob lanes, and the losing plan/lead groups are never touched,
+// so there is no per-frame gather of the full output to speak of
 struct ModelDataRaw {
   const ModelDataRawPlans *const plans;
   const ModelDataRawLaneLines *const lane_lines;
@@ -188,8 +196,26 @@ struct ModelDataRaw {
   const float *const meta;
   const float *const desire_pred;
   const ModelDataRawPose *const pose;
+  // outputs still derive from a recurrent state restored across a restart
+  bool warm_start;
 };
 
+#ifdef TEMPORAL
+// recurrent-state checkpoint in /dev/shm/op_model_state, written a few times
+// per second and restored (age-checked) on the next modeld start, so a
+// restart doesn't pay the multi-second hidden-state settling dip
+struct ModelStateCheckpoint {
+  uint64_t mono_time;
+  float temporal[TEMPORAL_SIZE];
+};
+
+struct ModelStateShm {
+  uint32_t magic;
+  uint32_t pad;
+  SeqLock<ModelStateCheckpoint> state;
+};
+#endif
+
 // TODO: convert remaining arrays to std::array and update model runners
 struct ModelState {
   ModelFrame *frame;
@@ -202,15 +228,23 @@ struct ModelState {
 #ifdef TRAFFIC_CONVENTION
   float traffic_convention[TRAFFIC_CONVENTION_LEN] = {};
 #endif
+#ifdef TEMPORAL
+  ModelStateShm *state_shm = nullptr;
+  int warm_start_frames = 0;
+  uint64_t run_count = 0;
+#endif
 };
 
 void model_init(ModelState* s, cl_device_id device_id, cl_context context);
-ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int height,
-                           const mat3 &transform, float *desire_in);
+// Eval is split in two so the next frame's input warp can run while the
+// runner is still executing the last frame; only the execute stages carry
+// the recurrent-state dependency and must stay ordered.
+float* model_prepare_frame(ModelState* s, cl_mem yuv_cl, int width, int height,
+                           const mat3 &transform);
+ModelDataRaw model_execute_frame(ModelState* s, float *net_input_buf, float *desire_in);
 void model_free(ModelState* s);
-void poly_fit(float *in_pts, float *in_stds, float *out);
 void model_publish(PubMaster &pm, uint32_t vipc_frame_id, uint32_t frame_id, float frame_drop,
-                   const ModelDataRaw &net_outputs, uint64_t timestamp_eof,
-                   float model_execution_time, kj::ArrayPtr<const float> raw_pred);
+                   float frame_cadence, const ModelDataRaw &net_outputs, uint64_t timestamp_sof,
+                   uint64_t timestamp_eof, float model_execution_time, kj::ArrayPtr<const float> raw_pred);
 void posenet_publish(PubMaster &pm, uint32_t vipc_frame_id, uint32_t vipc_dropped_frames,
                      const ModelDataRaw &net_outputs, uint64_t timestamp_eof);
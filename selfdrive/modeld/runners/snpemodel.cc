@@ -26,7 +26,9 @@ SNPEModel::SNPEModel(const char *path, float *loutput, size_t loutput_size, int
   }
   assert(zdl::SNPE::SNPEFactory::isRuntimeAvailable(Runtime));
 #endif
-  model_data = util::read_file(path);
+  // map instead of read: the container keeps referencing this for the
+  // process lifetime, and a copy would double peak RSS during startup
+  model_data = util::map_file(path);
   assert(model_data.size() > 0);
 
   // load model
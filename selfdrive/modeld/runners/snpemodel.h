@@ -2,8 +2,6 @@
 
 #include <DlContainer/IDlContainer.hpp>
 #include <DlSystem/DlError.hpp>
-#include <DlSystem/ITensor.hpp>
-#include <DlSystem/ITensorFactory.hpp>
 #include <DlSystem/IUserBuffer.hpp>
 #include <DlSystem/IUserBufferFactory.hpp>
 #include <SNPE/SNPE.hpp>
@@ -11,6 +9,7 @@
 #include <SNPE/SNPEFactory.hpp>
 
 #include "runmodel.h"
+#include "selfdrive/common/util.h"
 
 #define USE_CPU_RUNTIME 0
 #define USE_GPU_RUNTIME 1
@@ -33,7 +32,7 @@ public:
 #endif
 
 private:
-  std::string model_data;
+  util::MapFile model_data;
 
 #if defined(QCOM) || defined(QCOM2)
   zdl::DlSystem::Runtime_t Runtime;
@@ -1,6 +1,13 @@
 #include <cassert>
+#include <cstring>
+#include <map>
 #include <set>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "json11.hpp"
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/clutil.h"
@@ -9,13 +16,189 @@ using namespace json11;
 
 extern map<cl_program, string> g_program_source;
 
+// v2 cache format: a fixed-layout header and tables followed by one data
+// blob, so loading is a single mmap plus pointer walks. No JSON parse, and
+// weight buffers are faulted in from the page cache on first touch by
+// CL_MEM_COPY_HOST_PTR instead of being read up front.
+#define THNEED_CACHE_MAGIC "THNEED02"
+
+// the model runs in half precision: every image below is CL_HALF_FLOAT, so
+// the cached weight blobs are already fp16 texels and only the final
+// image2d_to_buffer_float output comes back as float. relaxed math lets the
+// compiler keep the generated kernels' arithmetic in half/mad form instead
+// of strict fp32.
+static const char *THNEED_CL_ARGS = "-cl-fast-relaxed-math -cl-denorms-are-zero";
+
+enum ThneedCacheArgType : uint32_t {
+  THNEED_ARG_BUFFER = 0,
+  THNEED_ARG_IMAGE2D = 1,
+  THNEED_ARG_IMAGE1D = 2,
+};
+
+struct ThneedCacheHeader {
+  char magic[8];
+  uint32_t num_objects;
+  uint32_t num_programs;
+  uint32_t num_kernels;
+  uint32_t num_args;
+  uint64_t data_size;
+};
+
+// all offsets are into the data blob that follows the tables
+struct ThneedCacheObject {
+  uint64_t id;         // cl_mem in the recording process, used as an opaque key
+  uint64_t buffer_id;  // backing buffer key for images, 0 otherwise
+  uint32_t arg_type;
+  uint32_t needs_load;
+  uint64_t size;
+  uint64_t width, height, row_pitch;
+  uint64_t data_offset;
+};
+
+struct ThneedCacheProgram {
+  uint64_t name_offset, name_length;
+  uint64_t data_offset, data_length;  // source text or device binary
+  uint32_t is_binary;
+  uint32_t pad;
+};
+
+struct ThneedCacheKernel {
+  uint64_t name_offset, name_length;
+  uint32_t program;  // index into the program table
+  uint32_t work_dim;
+  uint64_t global_work_size[3];
+  uint64_t local_work_size[3];
+  uint32_t first_arg;  // index into the arg table
+  uint32_t num_args;
+};
+
+struct ThneedCacheArg {
+  uint64_t size;
+  uint64_t data_offset;  // 8-byte args hold an object id, remapped on load
+};
+
 void Thneed::load(const char *filename) {
   printf("Thneed::load: loading from %s\n", filename);
 
-  string buf = util::read_file(filename);
-  int jsz = *(int *)buf.data();
+  int fd = open(filename, O_RDONLY);
+  assert(fd >= 0);
+  struct stat st;
+  assert(fstat(fd, &st) == 0);
+  char *mm = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  assert(mm != MAP_FAILED);
+  close(fd);
+
+  if ((size_t)st.st_size >= sizeof(ThneedCacheHeader) && memcmp(mm, THNEED_CACHE_MAGIC, 8) == 0) {
+    load_cache(mm, st.st_size);
+  } else {
+    load_json(mm, st.st_size);
+  }
+
+  // CL_MEM_COPY_HOST_PTR copies complete at create, so the mapping can go
+  munmap(mm, st.st_size);
+
+  clFinish(command_queue);
+}
+
+void Thneed::load_cache(const char *buf, size_t sz) {
+  const ThneedCacheHeader *hdr = (const ThneedCacheHeader *)buf;
+  const ThneedCacheObject *objs = (const ThneedCacheObject *)(hdr + 1);
+  const ThneedCacheProgram *progs = (const ThneedCacheProgram *)(objs + hdr->num_objects);
+  const ThneedCacheKernel *kerns = (const ThneedCacheKernel *)(progs + hdr->num_programs);
+  const ThneedCacheArg *cargs = (const ThneedCacheArg *)(kerns + hdr->num_kernels);
+  const char *data = (const char *)(cargs + hdr->num_args);
+  assert((size_t)(data - buf) + hdr->data_size <= sz);
+
+  map<uint64_t, cl_mem> real_mem;
+  real_mem[0] = NULL;
+
+  for (uint32_t i = 0; i < hdr->num_objects; i++) {
+    const ThneedCacheObject &o = objs[i];
+    cl_mem clbuf = NULL;
+
+    if (o.buffer_id != 0) {
+      // image buffer must already be allocated
+      clbuf = real_mem[o.buffer_id];
+      assert(o.needs_load == false);
+    } else {
+      if (o.needs_load) {
+        // weights are immutable after the create-time copy; READ_ONLY and
+        // HOST_NO_ACCESS let the driver place them in read-optimized memory
+        clbuf = clCreateBuffer(context, CL_MEM_COPY_HOST_PTR | CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS, o.size, (void *)(data + o.data_offset), NULL);
+      } else {
+        // scratch buffers come from the shared pool so model reloads reuse
+        // device memory instead of fragmenting the GPU heap
+        clbuf = cl_pool_alloc(context, o.size);
+      }
+    }
+    assert(clbuf != NULL);
+
+    if (o.arg_type == THNEED_ARG_IMAGE2D || o.arg_type == THNEED_ARG_IMAGE1D) {
+      cl_image_desc desc = {0};
+      desc.image_type = (o.arg_type == THNEED_ARG_IMAGE2D) ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE1D_BUFFER;
+      desc.image_width = o.width;
+      desc.image_height = o.height;
+      desc.image_row_pitch = o.row_pitch;
+      desc.buffer = clbuf;
+
+      cl_image_format format;
+      format.image_channel_order = CL_RGBA;
+      format.image_channel_data_type = CL_HALF_FLOAT;
+
+      // flags 0 inherits the backing buffer's access flags, so weight
+      // images stay read-only while intermediates stay read-write
+      clbuf = clCreateImage(context, 0, &format, &desc, NULL, NULL);
+      assert(clbuf != NULL);
+    }
+
+    real_mem[o.id] = clbuf;
+  }
+
+  vector<cl_program> programs;
+  for (uint32_t i = 0; i < hdr->num_programs; i++) {
+    const ThneedCacheProgram &p = progs[i];
+    if (record & THNEED_DEBUG) {
+      printf("%s %.*s with size %lu\n", p.is_binary ? "binary" : "building",
+             (int)p.name_length, data + p.name_offset, p.data_length);
+    }
+    if (p.is_binary) {
+      programs.push_back(cl_program_from_binary(context, device_id, (const uint8_t *)(data + p.data_offset), p.data_length));
+    } else {
+      programs.push_back(cl_program_from_source(context, device_id, string(data + p.data_offset, p.data_length), THNEED_CL_ARGS));
+    }
+  }
+
+  for (uint32_t i = 0; i < hdr->num_kernels; i++) {
+    const ThneedCacheKernel &k = kerns[i];
+    auto kk = shared_ptr<CLQueuedKernel>(new CLQueuedKernel(this));
+
+    kk->name = string(data + k.name_offset, k.name_length);
+    kk->program = programs[k.program];
+    kk->work_dim = k.work_dim;
+    for (int j = 0; j < kk->work_dim; j++) {
+      kk->global_work_size[j] = k.global_work_size[j];
+      kk->local_work_size[j] = k.local_work_size[j];
+    }
+    kk->num_args = k.num_args;
+    for (uint32_t j = 0; j < k.num_args; j++) {
+      const ThneedCacheArg &a = cargs[k.first_arg + j];
+      kk->args_size.push_back(a.size);
+      if (a.size == 8) {
+        cl_mem val = real_mem[*(const uint64_t *)(data + a.data_offset)];
+        kk->args.push_back(string((char *)&val, sizeof(val)));
+      } else {
+        kk->args.push_back(string(data + a.data_offset, a.size));
+      }
+    }
+    kq.push_back(kk);
+  }
+}
+
+// old JSON header format, kept so pre-v2 .thneed files still load
+void Thneed::load_json(const char *buf, size_t sz) {
+  int jsz = *(int *)buf;
   string err;
-  string jj(buf.data() + sizeof(int), jsz);
+  string jj(buf + sizeof(int), jsz);
   Json jdat = Json::parse(jj, err);
 
   map<cl_mem, cl_mem> real_mem;
@@ -34,10 +217,10 @@ void Thneed::load(const char *filename) {
     } else {
       if (mobj["needs_load"].bool_value()) {
         //printf("loading %p %d @ 0x%X\n", clbuf, sz, ptr);
-        clbuf = clCreateBuffer(context, CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE, sz, &buf[ptr], NULL);
+        clbuf = clCreateBuffer(context, CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE, sz, (void *)&buf[ptr], NULL);
         ptr += sz;
       } else {
-        clbuf = clCreateBuffer(context, CL_MEM_READ_WRITE, sz, NULL, NULL);
+        clbuf = cl_pool_alloc(context, sz);
       }
     }
     assert(clbuf != NULL);
@@ -64,7 +247,7 @@ void Thneed::load(const char *filename) {
   map<string, cl_program> g_programs;
   for (const auto &[name, source] : jdat["programs"].object_items()) {
     if (record & THNEED_DEBUG) printf("building %s with size %zu\n", name.c_str(), source.string_value().size());
-    g_programs[name] = cl_program_from_source(context, device_id, source.string_value());
+    g_programs[name] = cl_program_from_source(context, device_id, source.string_value(), THNEED_CL_ARGS);
   }
 
   for (auto &obj : jdat["binaries"].array_items()) {
@@ -102,23 +285,42 @@ void Thneed::load(const char *filename) {
     }
     kq.push_back(kk);
   }
-
-  clFinish(command_queue);
 }
 
 void Thneed::save(const char *filename, bool save_binaries) {
   printf("Thneed::save: saving to %s\n", filename);
 
-  // get kernels
-  std::vector<Json> kernels;
+  vector<ThneedCacheObject> objects;
+  vector<ThneedCacheProgram> programs;
+  vector<ThneedCacheKernel> kernels;
+  vector<ThneedCacheArg> cargs;
+  string blob;
+
+  auto blob_add = [&blob](const void *p, size_t len) -> uint64_t {
+    uint64_t offset = blob.size();
+    blob.append((const char *)p, len);
+    return offset;
+  };
+
+  // reads back a needs_load buffer into the blob
+  auto read_buffer = [&](cl_mem val, size_t sz) -> uint64_t {
+    char *tmp = (char *)malloc(sz);
+    // buffers allocated with CL_MEM_HOST_WRITE_ONLY, hence this hack
+    //hexdump((uint32_t*)val, 0x100);
+
+    // the worst hack in thneed, the flags are at 0x14
+    ((uint32_t*)val)[0x14] &= ~CL_MEM_HOST_WRITE_ONLY;
+    cl_int ret = clEnqueueReadBuffer(command_queue, val, CL_TRUE, 0, sz, tmp, 0, NULL, NULL);
+    assert(ret == CL_SUCCESS);
+    uint64_t offset = blob_add(tmp, sz);
+    free(tmp);
+    return offset;
+  };
+
   std::set<string> saved_objects;
-  std::vector<Json> objects;
-  std::map<string, string> programs;
-  std::map<string, string> binaries;
+  std::map<string, uint32_t> program_index;
 
   for (auto &k : kq) {
-    kernels.push_back(k->to_json());
-
     // check args for objects
     int i = 0;
     for (auto &a : k->args) {
@@ -129,130 +331,123 @@ void Thneed::save(const char *filename, bool save_binaries) {
           if (val != NULL) {
             bool needs_load = k->arg_names[i] == "weights" || k->arg_names[i] == "biases";
 
-            auto jj = Json::object({
-              {"id", a},
-              {"arg_type", k->arg_types[i]},
-            });
+            ThneedCacheObject o = {};
+            o.id = (uint64_t)val;
 
             if (k->arg_types[i] == "image2d_t" || k->arg_types[i] == "image1d_t") {
+              o.arg_type = (k->arg_types[i] == "image2d_t") ? THNEED_ARG_IMAGE2D : THNEED_ARG_IMAGE1D;
+
               cl_mem buf;
               clGetImageInfo(val, CL_IMAGE_BUFFER, sizeof(buf), &buf, NULL);
-              string aa = string((char *)&buf, sizeof(buf));
-              jj["buffer_id"] = aa;
+              o.buffer_id = (uint64_t)buf;
 
               size_t width, height, row_pitch;
               clGetImageInfo(val, CL_IMAGE_WIDTH, sizeof(width), &width, NULL);
               clGetImageInfo(val, CL_IMAGE_HEIGHT, sizeof(height), &height, NULL);
               clGetImageInfo(val, CL_IMAGE_ROW_PITCH, sizeof(row_pitch), &row_pitch, NULL);
-              jj["width"] = (int)width;
-              jj["height"] = (int)height;
-              jj["row_pitch"] = (int)row_pitch;
-              jj["size"] = (int)(height * row_pitch);
-              jj["needs_load"] = false;
+              o.width = width;
+              o.height = height;
+              o.row_pitch = row_pitch;
+              o.size = height * row_pitch;
 
+              string aa = string((char *)&buf, sizeof(buf));
               if (saved_objects.find(aa) == saved_objects.end()) {
                 saved_objects.insert(aa);
                 size_t sz;
                 clGetMemObjectInfo(buf, CL_MEM_SIZE, sizeof(sz), &sz, NULL);
-                // save the buffer
-                objects.push_back(Json::object({
-                  {"id", aa},
-                  {"arg_type", "<image buffer>"},
-                  {"needs_load", needs_load},
-                  {"size", (int)sz}
-                }));
-                if (needs_load) assert(sz == height * row_pitch);
+                // save the backing buffer; it must precede the image
+                ThneedCacheObject ob = {};
+                ob.id = (uint64_t)buf;
+                ob.arg_type = THNEED_ARG_BUFFER;
+                ob.size = sz;
+                ob.needs_load = needs_load;
+                if (needs_load) {
+                  assert(sz == height * row_pitch);
+                  ob.data_offset = read_buffer(buf, sz);
+                }
+                objects.push_back(ob);
               }
             } else {
               size_t sz = 0;
               clGetMemObjectInfo(val, CL_MEM_SIZE, sizeof(sz), &sz, NULL);
-              jj["size"] = (int)sz;
-              jj["needs_load"] = needs_load;
+              o.arg_type = THNEED_ARG_BUFFER;
+              o.size = sz;
+              o.needs_load = needs_load;
+              if (needs_load) o.data_offset = read_buffer(val, sz);
             }
 
-            objects.push_back(jj);
+            objects.push_back(o);
           }
         }
       }
       i++;
     }
 
-    if (save_binaries) {
-      int err;
-      size_t binary_size = 0;
-      err = clGetProgramInfo(k->program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL);
-      assert(err == 0);
-      assert(binary_size > 0);
-      string sv(binary_size, '\x00');
-
-      uint8_t* bufs[1] = { (uint8_t*)sv.data(), };
-      err = clGetProgramInfo(k->program, CL_PROGRAM_BINARIES, sizeof(bufs), &bufs, NULL);
-      assert(err == 0);
-
-      binaries[k->name] = sv;
-    } else {
-      programs[k->name] = g_program_source[k->program];
-    }
-  }
-
-  vector<string> saved_buffers;
-  for (auto &obj : objects) {
-    auto mobj = obj.object_items();
-    cl_mem val = *(cl_mem*)(mobj["id"].string_value().data());
-    int sz = mobj["size"].int_value();
-    if (mobj["needs_load"].bool_value()) {
-      char *buf = (char *)malloc(sz);
-      if (mobj["arg_type"] == "image2d_t" || mobj["arg_type"] == "image1d_t") {
-        assert(false);
+    // one program per unique kernel name, like the programs it was built from
+    if (program_index.find(k->name) == program_index.end()) {
+      program_index[k->name] = programs.size();
+
+      ThneedCacheProgram p = {};
+      p.name_offset = blob_add(k->name.data(), k->name.size());
+      p.name_length = k->name.size();
+
+      if (save_binaries) {
+        int err;
+        size_t binary_size = 0;
+        err = clGetProgramInfo(k->program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL);
+        assert(err == 0);
+        assert(binary_size > 0);
+        string sv(binary_size, '\x00');
+
+        uint8_t* bufs[1] = { (uint8_t*)sv.data(), };
+        err = clGetProgramInfo(k->program, CL_PROGRAM_BINARIES, sizeof(bufs), &bufs, NULL);
+        assert(err == 0);
+
+        p.is_binary = true;
+        p.data_offset = blob_add(sv.data(), sv.size());
+        p.data_length = sv.size();
       } else {
-        // buffers allocated with CL_MEM_HOST_WRITE_ONLY, hence this hack
-        //hexdump((uint32_t*)val, 0x100);
-
-        // the worst hack in thneed, the flags are at 0x14
-        ((uint32_t*)val)[0x14] &= ~CL_MEM_HOST_WRITE_ONLY;
-        cl_int ret = clEnqueueReadBuffer(command_queue, val, CL_TRUE, 0, sz, buf, 0, NULL, NULL);
-        assert(ret == CL_SUCCESS);
+        const string &src = g_program_source[k->program];
+        p.data_offset = blob_add(src.data(), src.size());
+        p.data_length = src.size();
       }
-      //printf("saving buffer: %d %p %s\n", sz, buf, mobj["arg_type"].string_value().c_str());
-      saved_buffers.push_back(string(buf, sz));
-      free(buf);
+      programs.push_back(p);
     }
-  }
 
-  std::vector<Json> jbinaries;
-  for (auto &obj : binaries) {
-    jbinaries.push_back(Json::object({{"name", obj.first}, {"length", (int)obj.second.size()}}));
-    saved_buffers.push_back(obj.second);
+    ThneedCacheKernel kk = {};
+    kk.name_offset = blob_add(k->name.data(), k->name.size());
+    kk.name_length = k->name.size();
+    kk.program = program_index[k->name];
+    kk.work_dim = k->work_dim;
+    for (int j = 0; j < 3; j++) {
+      kk.global_work_size[j] = k->global_work_size[j];
+      kk.local_work_size[j] = k->local_work_size[j];
+    }
+    kk.first_arg = cargs.size();
+    kk.num_args = k->num_args;
+    for (uint32_t j = 0; j < k->num_args; j++) {
+      ThneedCacheArg a = {};
+      a.size = k->args_size[j];
+      a.data_offset = blob_add(k->args[j].data(), k->args[j].size());
+      cargs.push_back(a);
+    }
+    kernels.push_back(kk);
   }
 
-  Json jdat = Json::object({
-    {"kernels", kernels},
-    {"objects", objects},
-    {"programs", programs},
-    {"binaries", jbinaries},
-  });
-
-  string str = jdat.dump();
-  int jsz = str.length();
+  ThneedCacheHeader hdr = {};
+  memcpy(hdr.magic, THNEED_CACHE_MAGIC, 8);
+  hdr.num_objects = objects.size();
+  hdr.num_programs = programs.size();
+  hdr.num_kernels = kernels.size();
+  hdr.num_args = cargs.size();
+  hdr.data_size = blob.size();
 
   FILE *f = fopen(filename, "wb");
-  fwrite(&jsz, 1, sizeof(jsz), f);
-  fwrite(str.data(), 1, jsz, f);
-  for (auto &s : saved_buffers) {
-    fwrite(s.data(), 1, s.length(), f);
-  }
+  fwrite(&hdr, 1, sizeof(hdr), f);
+  fwrite(objects.data(), sizeof(ThneedCacheObject), objects.size(), f);
+  fwrite(programs.data(), sizeof(ThneedCacheProgram), programs.size(), f);
+  fwrite(kernels.data(), sizeof(ThneedCacheKernel), kernels.size(), f);
+  fwrite(cargs.data(), sizeof(ThneedCacheArg), cargs.size(), f);
+  fwrite(blob.data(), 1, blob.size(), f);
   fclose(f);
 }
-
-Json CLQueuedKernel::to_json() const {
-  return Json::object {
-    { "name", name },
-    { "work_dim", (int)work_dim },
-    { "global_work_size", Json::array { (int)global_work_size[0], (int)global_work_size[1], (int)global_work_size[2] } },
-    { "local_work_size", Json::array { (int)local_work_size[0], (int)local_work_size[1], (int)local_work_size[2] } },
-    { "num_args", (int)num_args },
-    { "args", args },
-    { "args_size", args_size },
-  };
-}
-
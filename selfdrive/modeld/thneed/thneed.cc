@@ -32,6 +32,14 @@ void hexdump(uint8_t *d, int len) {
 
 // *********** ioctl interceptor ***********
 
+static int g_gpu_priority = 1;
+static bool g_gpu_yield = false;
+
+void thneed_set_gpu_priority(int priority, bool yield) {
+  g_gpu_priority = priority;
+  g_gpu_yield = yield;
+}
+
 extern "C" {
 
 int (*my_ioctl)(int filedes, unsigned long request, void *argp) = NULL;
@@ -48,7 +56,7 @@ int ioctl(int filedes, unsigned long request, void *argp) {
   if (request == IOCTL_KGSL_DRAWCTXT_CREATE) {
     struct kgsl_drawctxt_create *create = (struct kgsl_drawctxt_create *)argp;
     create->flags &= ~KGSL_CONTEXT_PRIORITY_MASK;
-    create->flags |= 1 << KGSL_CONTEXT_PRIORITY_SHIFT;   // priority from 1-15, 1 is max priority
+    create->flags |= g_gpu_priority << KGSL_CONTEXT_PRIORITY_SHIFT;   // priority from 1-15, 1 is max priority
     printf("IOCTL_KGSL_DRAWCTXT_CREATE: creating context with flags 0x%x\n", create->flags);
   }
 
@@ -113,6 +121,19 @@ int ioctl(int filedes, unsigned long request, void *argp) {
 
   int ret = my_ioctl(filedes, request, argp);
   if (ret != 0) printf("ioctl returned %d with errno %d\n", ret, errno);
+
+  // cooperative yield point: block until this batch retires before the next
+  // submit, so the higher-priority driving model ring preempts between
+  // kernels instead of behind a deep queue
+  if (ret == 0 && g_gpu_yield && request == IOCTL_KGSL_GPU_COMMAND) {
+    struct kgsl_gpu_command *cmd = (struct kgsl_gpu_command *)argp;
+    struct kgsl_device_waittimestamp_ctxtid wait = {
+      .context_id = cmd->context_id,
+      .timestamp = cmd->timestamp,
+      .timeout = 100,  // ms; a stuck GPU shouldn't wedge the process
+    };
+    my_ioctl(filedes, IOCTL_KGSL_DEVICE_WAITTIMESTAMP_CTXTID, &wait);
+  }
   return ret;
 }
 
@@ -159,6 +180,13 @@ void CachedSync::exec() {
   assert(ret == 0);
 }
 
+bool CachedSync::merge(CachedIoctl *other) {
+  CachedSync *sync = dynamic_cast<CachedSync *>(other);
+  if (sync == NULL) return false;
+  data += sync->data;
+  return true;
+}
+
 // *********** CachedCommand, at the ioctl layer ***********
 
 CachedCommand::CachedCommand(Thneed *lthneed, struct kgsl_gpu_command *cmd) {
@@ -193,6 +221,35 @@ CachedCommand::CachedCommand(Thneed *lthneed, struct kgsl_gpu_command *cmd) {
   thneed->ckq.clear();
 }
 
+bool CachedCommand::merge(CachedIoctl *other) {
+  CachedCommand *cmd = dynamic_cast<CachedCommand *>(other);
+  if (cmd == NULL) return false;
+  // IBs on the same context run in submission order, so compatible
+  // back-to-back commands can share one ioctl
+  if (cache.flags != cmd->cache.flags || cache.context_id != cmd->cache.context_id) return false;
+
+  if (cmd->cache.numcmds > 0) {
+    auto ncmds = make_unique<struct kgsl_command_object[]>(cache.numcmds + cmd->cache.numcmds);
+    memcpy(ncmds.get(), cmds.get(), sizeof(struct kgsl_command_object)*cache.numcmds);
+    memcpy(ncmds.get() + cache.numcmds, cmd->cmds.get(), sizeof(struct kgsl_command_object)*cmd->cache.numcmds);
+    cmds = std::move(ncmds);
+    cache.numcmds += cmd->cache.numcmds;
+    cache.cmdlist = (uint64_t)cmds.get();
+  }
+
+  if (cmd->cache.numobjs > 0) {
+    auto nobjs = make_unique<struct kgsl_command_object[]>(cache.numobjs + cmd->cache.numobjs);
+    memcpy(nobjs.get(), objs.get(), sizeof(struct kgsl_command_object)*cache.numobjs);
+    memcpy(nobjs.get() + cache.numobjs, cmd->objs.get(), sizeof(struct kgsl_command_object)*cmd->cache.numobjs);
+    objs = std::move(nobjs);
+    cache.numobjs += cmd->cache.numobjs;
+    cache.objlist = (uint64_t)objs.get();
+  }
+
+  kq.insert(kq.end(), cmd->kq.begin(), cmd->kq.end());
+  return true;
+}
+
 void CachedCommand::exec() {
   cache.timestamp = ++thneed->timestamp;
   int ret = ioctl(thneed->fd, IOCTL_KGSL_GPU_COMMAND, &cache);
@@ -228,6 +285,18 @@ Thneed::Thneed(bool do_clinit) {
 void Thneed::stop() {
   find_inputs_outputs();
   printf("Thneed::stop: recorded %lu commands\n", cmds.size());
+
+  // fold adjacent compatible submissions together once here, so every
+  // execute replays the recording with a handful of ioctls instead of
+  // one per kernel
+  vector<unique_ptr<CachedIoctl> > batched;
+  for (auto &c : cmds) {
+    if (!batched.empty() && batched.back()->merge(c.get())) continue;
+    batched.push_back(std::move(c));
+  }
+  cmds.swap(batched);
+  printf("Thneed::stop: batched into %lu submissions\n", cmds.size());
+
   record = 0;
 }
 
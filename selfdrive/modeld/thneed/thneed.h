@@ -18,11 +18,16 @@
 #define THNEED_DEBUG 2
 #define THNEED_VERBOSE_DEBUG 4
 
+// per-process GPU submission lane, applied by the ioctl interceptor in
+// thneed.cc to every KGSL context this process creates. priority is the
+// kgsl per-context range, 1 (max) to 15. with yield enabled, every GPU
+// command is waited on before the next one is submitted, so a process on
+// a lower lane never has more than one batch queued ahead of the driving
+// model's ring. defaults: priority 1, no yield (modeld's lane).
+void thneed_set_gpu_priority(int priority, bool yield);
+
 using namespace std;
 
-namespace json11 {
-  class Json;
-}
 class Thneed;
 
 class GPUMalloc {
@@ -54,7 +59,6 @@ class CLQueuedKernel {
     vector<string> args;
     vector<int> args_size;
     cl_kernel kernel = NULL;
-    json11::Json to_json() const;
 
     cl_uint work_dim;
     size_t global_work_size[3] = {0};
@@ -66,12 +70,15 @@ class CLQueuedKernel {
 class CachedIoctl {
   public:
     virtual void exec() {}
+    // true if other was folded into this submission
+    virtual bool merge(CachedIoctl *other) { return false; }
 };
 
 class CachedSync: public CachedIoctl {
   public:
     CachedSync(Thneed *lthneed, string ldata) { thneed = lthneed; data = ldata; }
     void exec();
+    bool merge(CachedIoctl *other);
   private:
     Thneed *thneed;
     string data;
@@ -81,6 +88,7 @@ class CachedCommand: public CachedIoctl {
   public:
     CachedCommand(Thneed *lthneed, struct kgsl_gpu_command *cmd);
     void exec();
+    bool merge(CachedIoctl *other);
   private:
     void disassemble(int cmd_index);
     struct kgsl_gpu_command cache;
@@ -129,6 +137,8 @@ class Thneed {
     void load(const char *filename);
     void save(const char *filename, bool save_binaries=false);
   private:
+    void load_cache(const char *buf, size_t sz);
+    void load_json(const char *buf, size_t sz);
     void clinit();
 };
 
@@ -0,0 +1,104 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "selfdrive/common/timing.h"
+#include "selfdrive/modeld/models/driving.h"
+#include "selfdrive/modeld/runners/snpemodel.h"
+#include "selfdrive/modeld/thneed/thneed.h"
+
+// Validates a thneed cache against the SNPE model it was compiled from, so
+// shipping a patched cache is a pass/fail gate instead of a leap of faith.
+// Both runners get the same deterministic inputs and the max abs output
+// difference is checked against the tolerance. Every cached kernel is also
+// timed individually, so a cache that is numerically fine but compiled badly
+// still shows up.
+//
+//   ./thneed/validate ../../models/supercombo.dlc ../../models/supercombo.thneed [tolerance]
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    printf("usage: %s <model.dlc> <model.thneed> [tolerance]\n", argv[0]);
+    return 1;
+  }
+  // the cache runs fp16, the CPU reference fp32, so exact match isn't expected
+  const float tolerance = (argc > 3) ? atof(argv[3]) : 0.1f;
+  const int iters = 20;
+
+  std::vector<float> ref_output(NET_OUTPUT_SIZE), thneed_output(NET_OUTPUT_SIZE);
+
+  // CPU runtime: full fp32 reference, and no thneed recording side effects
+  SNPEModel ref(argv[1], ref_output.data(), NET_OUTPUT_SIZE, USE_CPU_RUNTIME);
+  float ref_recurrent[TEMPORAL_SIZE] = {};
+  float desire[DESIRE_LEN] = {};
+  float traffic_convention[TRAFFIC_CONVENTION_LEN] = {};
+  ref.addRecurrent(ref_recurrent, TEMPORAL_SIZE);
+  ref.addDesire(desire, DESIRE_LEN);
+  ref.addTrafficConvention(traffic_convention, TRAFFIC_CONVENTION_LEN);
+
+  Thneed *thneed = new Thneed(true);
+  thneed->record = 0;
+  thneed->load(argv[2]);
+  thneed->clexec();
+  thneed->find_inputs_outputs();
+  float thneed_recurrent[TEMPORAL_SIZE] = {};
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> input(MODEL_FRAME_SIZE * 2);
+  float *inputs[4] = {thneed_recurrent, traffic_convention, desire, input.data()};
+
+  float max_err = 0;
+  int max_err_idx = 0;
+  double ref_ms = 0, thneed_ms = 0;
+  for (int i = 0; i < iters; i++) {
+    for (auto &v : input) v = dist(gen);
+    // zeroed recurrent state every pass keeps the runners in lockstep
+    // instead of compounding fp16 drift through the feedback
+    memset(ref_recurrent, 0, sizeof(ref_recurrent));
+    memset(thneed_recurrent, 0, sizeof(thneed_recurrent));
+
+    double t1 = millis_since_boot();
+    ref.execute(input.data(), input.size());
+    double t2 = millis_since_boot();
+    thneed->copy_inputs(inputs);
+    thneed->clexec();
+    thneed->copy_output(thneed_output.data());
+    double t3 = millis_since_boot();
+    ref_ms += t2 - t1;
+    thneed_ms += t3 - t2;
+
+    for (int j = 0; j < NET_OUTPUT_SIZE; j++) {
+      float err = fabsf(thneed_output[j] - ref_output[j]);
+      if (err > max_err) {
+        max_err = err;
+        max_err_idx = j;
+      }
+    }
+  }
+
+  // serialized per-kernel timing: each kernel waits for the queue, so the
+  // total here runs over the pipelined clexec time above. use it to compare
+  // kernels against each other and against a previous cache.
+  printf("\nper-kernel timing, avg over %d runs:\n", iters);
+  std::vector<uint64_t> kernel_ns(thneed->kq.size(), 0);
+  for (int i = 0; i < iters; i++) {
+    for (size_t j = 0; j < thneed->kq.size(); j++) {
+      uint64_t start = nanos_since_boot();
+      thneed->kq[j]->exec();
+      clFinish(thneed->command_queue);
+      kernel_ns[j] += nanos_since_boot() - start;
+    }
+  }
+  for (size_t j = 0; j < thneed->kq.size(); j++) {
+    printf("%4zu %-48s %8.1f us\n", j, thneed->kq[j]->name.c_str(), kernel_ns[j] / (double)iters / 1000.);
+  }
+
+  printf("\navg exec: snpe cpu %.2f ms, thneed %.2f ms\n", ref_ms / iters, thneed_ms / iters);
+  printf("max abs err %f at output %d, tolerance %f\n", max_err, max_err_idx, tolerance);
+  const bool ok = max_err <= tolerance;
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -4,7 +4,8 @@
 #include <cstdio>
 #include <cstring>
 
-void loadyuv_init(LoadYUVState* s, cl_context ctx, cl_device_id device_id, int width, int height) {
+void loadyuv_init(LoadYUVState* s, cl_context ctx, cl_device_id device_id, int width, int height,
+                  bool normalized) {
   memset(s, 0, sizeof(*s));
 
   s->width = width;
@@ -13,22 +14,29 @@ void loadyuv_init(LoadYUVState* s, cl_context ctx, cl_device_id device_id, int w
   char args[1024];
   snprintf(args, sizeof(args),
            "-cl-fast-relaxed-math -cl-denorms-are-zero "
-           "-DTRANSFORMED_WIDTH=%d -DTRANSFORMED_HEIGHT=%d",
-           width, height);
+           "-DTRANSFORMED_WIDTH=%d -DTRANSFORMED_HEIGHT=%d%s",
+           width, height, normalized ? " -DNORMALIZE" : "");
   cl_program prg = cl_program_from_file(ctx, device_id, "transforms/loadyuv.cl", args);
 
   s->loadys_krnl = CL_CHECK_ERR(clCreateKernel(prg, "loadys", &err));
   s->loaduv_krnl = CL_CHECK_ERR(clCreateKernel(prg, "loaduv", &err));
   s->copy_krnl = CL_CHECK_ERR(clCreateKernel(prg, "copy", &err));
+  s->warp_krnl = CL_CHECK_ERR(clCreateKernel(prg, "loadyuv_warp", &err));
+
+  s->m_y_cl = cl_pool_alloc(ctx, 3*3*sizeof(float));
+  s->m_uv_cl = cl_pool_alloc(ctx, 3*3*sizeof(float));
 
   // done with this
   CL_CHECK(clReleaseProgram(prg));
 }
 
 void loadyuv_destroy(LoadYUVState* s) {
+  cl_pool_release(s->m_uv_cl);
+  cl_pool_release(s->m_y_cl);
   CL_CHECK(clReleaseKernel(s->loadys_krnl));
   CL_CHECK(clReleaseKernel(s->loaduv_krnl));
   CL_CHECK(clReleaseKernel(s->copy_krnl));
+  CL_CHECK(clReleaseKernel(s->warp_krnl));
 }
 
 void loadyuv_queue(LoadYUVState* s, cl_command_queue q,
@@ -72,3 +80,38 @@ void loadyuv_queue(LoadYUVState* s, cl_command_queue q,
   CL_CHECK(clEnqueueNDRangeKernel(q, s->loaduv_krnl, 1, NULL,
                                &loaduv_work_size, NULL, 0, 0, NULL));
 }
+
+void loadyuv_warp_queue(LoadYUVState* s, cl_command_queue q,
+                        cl_mem in_yuv, int in_width, int in_height,
+                        const mat3& projection,
+                        cl_mem out_cl, bool do_shift) {
+  cl_int global_out_off = 0;
+  if (do_shift) {
+    // shift the image in slot 1 to slot 0, then place the new image in slot 1
+    global_out_off += (s->width*s->height) + (s->width/2)*(s->height/2)*2;
+    CL_CHECK(clSetKernelArg(s->copy_krnl, 0, sizeof(cl_mem), &out_cl));
+    CL_CHECK(clSetKernelArg(s->copy_krnl, 1, sizeof(cl_int), &global_out_off));
+    const size_t copy_work_size = global_out_off/8;
+    CL_CHECK(clEnqueueNDRangeKernel(q, s->copy_krnl, 1, NULL,
+                                &copy_work_size, NULL, 0, 0, NULL));
+  }
+
+  // sampled using pixel center origin, like transform_queue. in and out uv
+  // is half the size of y.
+  mat3 projection_y = projection;
+  mat3 projection_uv = transform_scale_buffer(projection, 0.5);
+  CL_CHECK(clEnqueueWriteBuffer(q, s->m_y_cl, CL_TRUE, 0, 3*3*sizeof(float), (void*)projection_y.v, 0, NULL, NULL));
+  CL_CHECK(clEnqueueWriteBuffer(q, s->m_uv_cl, CL_TRUE, 0, 3*3*sizeof(float), (void*)projection_uv.v, 0, NULL, NULL));
+
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 0, sizeof(cl_mem), &in_yuv));
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 1, sizeof(cl_int), &in_width));
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 2, sizeof(cl_int), &in_height));
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 3, sizeof(cl_mem), &s->m_y_cl));
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 4, sizeof(cl_mem), &s->m_uv_cl));
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 5, sizeof(cl_mem), &out_cl));
+  CL_CHECK(clSetKernelArg(s->warp_krnl, 6, sizeof(cl_int), &global_out_off));
+
+  const size_t warp_work_size[2] = {(size_t)(s->width/2), (size_t)(s->height/2)};
+  CL_CHECK(clEnqueueNDRangeKernel(q, s->warp_krnl, 2, NULL,
+                               (const size_t*)&warp_work_size, NULL, 0, 0, NULL));
+}
@@ -1,5 +1,13 @@
 #define UV_SIZE ((TRANSFORMED_WIDTH/2)*(TRANSFORMED_HEIGHT/2))
 
+#ifdef NORMALIZE
+#define CONVERT(v) ((convert_float8(v) - 128.f) * 0.0078125f)
+#define CONVERT1(v) ((convert_float(v) - 128.f) * 0.0078125f)
+#else
+#define CONVERT(v) convert_float8(v)
+#define CONVERT1(v) convert_float(v)
+#endif
+
 __kernel void loadys(__global uchar8 const * const Y,
                      __global float * out,
                      int out_offset)
@@ -10,7 +18,7 @@ __kernel void loadys(__global uchar8 const * const Y,
     const int ox = ois % TRANSFORMED_WIDTH;
 
     const uchar8 ys = Y[gid];
-    const float8 ysf = convert_float8(ys);
+    const float8 ysf = CONVERT(ys);
 
     // 02
     // 13
@@ -35,7 +43,7 @@ __kernel void loaduv(__global uchar8 const * const in,
 {
   const int gid = get_global_id(0);
   const uchar8 inv = in[gid];
-  const float8 outv  = convert_float8(inv);
+  const float8 outv  = CONVERT(inv);
   out[gid + out_offset / 8] = outv;
 }
 
@@ -45,3 +53,77 @@ __kernel void copy(__global float8 * inout,
   const int gid = get_global_id(0);
   inout[gid] = inout[gid + in_offset / 8];
 }
+
+// fused warpPerspective + tensor load. Same fixed point bilinear math as
+// transforms/transform.cl, but each sample goes straight into its tensor
+// slot, so the warped y/u/v planes never exist.
+#define INTER_BITS 5
+#define INTER_TAB_SIZE (1 << INTER_BITS)
+
+#define INTER_REMAP_COEF_BITS 15
+#define INTER_REMAP_COEF_SCALE (1 << INTER_REMAP_COEF_BITS)
+
+float sample_warped(__global const uchar * src,
+                    int src_step, int src_offset, int src_rows, int src_cols,
+                    int dx, int dy, __constant float * M)
+{
+    float X0 = M[0] * dx + M[1] * dy + M[2];
+    float Y0 = M[3] * dx + M[4] * dy + M[5];
+    float W = M[6] * dx + M[7] * dy + M[8];
+    W = W != 0.0f ? INTER_TAB_SIZE / W : 0.0f;
+    int X = rint(X0 * W), Y = rint(Y0 * W);
+
+    short sx = convert_short_sat(X >> INTER_BITS);
+    short sy = convert_short_sat(Y >> INTER_BITS);
+    short ay = (short)(Y & (INTER_TAB_SIZE - 1));
+    short ax = (short)(X & (INTER_TAB_SIZE - 1));
+
+    int v0 = (sx >= 0 && sx < src_cols && sy >= 0 && sy < src_rows) ?
+        convert_int(src[mad24(sy, src_step, src_offset + sx)]) : 0;
+    int v1 = (sx+1 >= 0 && sx+1 < src_cols && sy >= 0 && sy < src_rows) ?
+        convert_int(src[mad24(sy, src_step, src_offset + (sx+1))]) : 0;
+    int v2 = (sx >= 0 && sx < src_cols && sy+1 >= 0 && sy+1 < src_rows) ?
+        convert_int(src[mad24(sy+1, src_step, src_offset + sx)]) : 0;
+    int v3 = (sx+1 >= 0 && sx+1 < src_cols && sy+1 >= 0 && sy+1 < src_rows) ?
+        convert_int(src[mad24(sy+1, src_step, src_offset + (sx+1))]) : 0;
+
+    float taby = 1.f/INTER_TAB_SIZE*ay;
+    float tabx = 1.f/INTER_TAB_SIZE*ax;
+
+    int itab0 = convert_short_sat_rte( (1.0f-taby)*(1.0f-tabx) * INTER_REMAP_COEF_SCALE );
+    int itab1 = convert_short_sat_rte( (1.0f-taby)*tabx * INTER_REMAP_COEF_SCALE );
+    int itab2 = convert_short_sat_rte( taby*(1.0f-tabx) * INTER_REMAP_COEF_SCALE );
+    int itab3 = convert_short_sat_rte( taby*tabx * INTER_REMAP_COEF_SCALE );
+
+    int val = v0 * itab0 +  v1 * itab1 + v2 * itab2 + v3 * itab3;
+
+    uchar pix = convert_uchar_sat((val + (1 << (INTER_REMAP_COEF_BITS-1))) >> INTER_REMAP_COEF_BITS);
+    return CONVERT1(pix);
+}
+
+// one work item per 2x2 y block: the four y phase channels plus the u and v
+// samples that share its tensor index
+__kernel void loadyuv_warp(__global const uchar * src,
+                           int src_width, int src_height,
+                           __constant float * M_y, __constant float * M_uv,
+                           __global float * out,
+                           int out_offset)
+{
+    const int dx = get_global_id(0);
+    const int dy = get_global_id(1);
+
+    const int uv_cols = src_width / 2;
+    const int uv_rows = src_height / 2;
+    const int u_offset = src_width * src_height;
+    const int v_offset = u_offset + uv_cols * uv_rows;
+    const int idx = dy * (TRANSFORMED_WIDTH/2) + dx;
+
+    // 02
+    // 13
+    out[out_offset + 0*UV_SIZE + idx] = sample_warped(src, src_width, 0, src_height, src_width, 2*dx,   2*dy,   M_y);
+    out[out_offset + 1*UV_SIZE + idx] = sample_warped(src, src_width, 0, src_height, src_width, 2*dx,   2*dy+1, M_y);
+    out[out_offset + 2*UV_SIZE + idx] = sample_warped(src, src_width, 0, src_height, src_width, 2*dx+1, 2*dy,   M_y);
+    out[out_offset + 3*UV_SIZE + idx] = sample_warped(src, src_width, 0, src_height, src_width, 2*dx+1, 2*dy+1, M_y);
+    out[out_offset + 4*UV_SIZE + idx] = sample_warped(src, uv_cols, u_offset, uv_rows, uv_cols, dx, dy, M_uv);
+    out[out_offset + 5*UV_SIZE + idx] = sample_warped(src, uv_cols, v_offset, uv_rows, uv_cols, dx, dy, M_uv);
+}
@@ -5,21 +5,21 @@
 
 #include "selfdrive/common/clutil.h"
 
-void transform_init(Transform* s, cl_context ctx, cl_device_id device_id) {
+void transform_init(Transform* s, cl_context ctx, cl_device_id device_id, const char* cl_path) {
   memset(s, 0, sizeof(*s));
 
-  cl_program prg = cl_program_from_file(ctx, device_id, "transforms/transform.cl", "");
+  cl_program prg = cl_program_from_file(ctx, device_id, cl_path, "");
   s->krnl = CL_CHECK_ERR(clCreateKernel(prg, "warpPerspective", &err));
   // done with this
   CL_CHECK(clReleaseProgram(prg));
 
-  s->m_y_cl = CL_CHECK_ERR(clCreateBuffer(ctx, CL_MEM_READ_WRITE, 3*3*sizeof(float), NULL, &err));
-  s->m_uv_cl = CL_CHECK_ERR(clCreateBuffer(ctx, CL_MEM_READ_WRITE, 3*3*sizeof(float), NULL, &err));
+  s->m_y_cl = cl_pool_alloc(ctx, 3*3*sizeof(float));
+  s->m_uv_cl = cl_pool_alloc(ctx, 3*3*sizeof(float));
 }
 
 void transform_destroy(Transform* s) {
-  CL_CHECK(clReleaseMemObject(s->m_y_cl));
-  CL_CHECK(clReleaseMemObject(s->m_uv_cl));
+  cl_pool_release(s->m_y_cl);
+  cl_pool_release(s->m_uv_cl);
   CL_CHECK(clReleaseKernel(s->krnl));
 }
 
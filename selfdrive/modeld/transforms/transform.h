@@ -14,7 +14,8 @@ typedef struct {
   cl_mem m_y_cl, m_uv_cl;
 } Transform;
 
-void transform_init(Transform* s, cl_context ctx, cl_device_id device_id);
+void transform_init(Transform* s, cl_context ctx, cl_device_id device_id,
+                    const char* cl_path = "transforms/transform.cl");
 
 void transform_destroy(Transform* transform);
 
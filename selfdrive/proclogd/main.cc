@@ -1,21 +1,63 @@
 
 #include <sys/resource.h>
 
+#include "selfdrive/common/metrics.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/proclogd/proclog.h"
 
+static void buildMetricsMessage(MessageBuilder &msg) {
+  auto snaps = metrics_snapshot_all();
+  auto procs = msg.initEvent().initMetrics().initProcesses(snaps.size());
+  for (size_t i = 0; i < snaps.size(); i++) {
+    auto proc = procs[i];
+    proc.setName(snaps[i].process_name);
+    proc.setPid(snaps[i].pid);
+    auto entries = proc.initEntries(snaps[i].entries.size());
+    for (size_t j = 0; j < snaps[i].entries.size(); j++) {
+      const MetricsEntry &e = snaps[i].entries[j];
+      auto entry = entries[j];
+      entry.setName(e.name);
+      entry.setCount(e.count);
+      if (e.type == METRIC_GAUGE) {
+        entry.setType(cereal::Metrics::Type::GAUGE);
+        double v;
+        memcpy(&v, &e.value, sizeof(v));
+        entry.setValue(v);
+      } else if (e.type == METRIC_HISTOGRAM) {
+        entry.setType(cereal::Metrics::Type::HISTOGRAM);
+        entry.setValue(e.value);
+        auto buckets = entry.initBuckets(METRICS_HIST_BUCKETS);
+        for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+          buckets.set(b, e.buckets[b]);
+        }
+      } else {
+        entry.setType(cereal::Metrics::Type::COUNTER);
+      }
+    }
+  }
+}
+
 ExitHandler do_exit;
 
 int main(int argc, char **argv) {
   setpriority(PRIO_PROCESS, 0, -15);
 
-  PubMaster publisher({"procLog"});
-  while (!do_exit) {
-    MessageBuilder msg;
-    buildProcLogMessage(msg);
-    publisher.send("procLog", msg);
+  PubMaster publisher({"procLog", "metrics"});
+  for (uint64_t cnt = 0; !do_exit; cnt++) {
+    // metrics is 1Hz, procLog keeps its 0.5Hz rate on the same loop
+    if (cnt % 2 == 0) {
+      // the pooled builder keeps the segment sized for the previous tick's
+      // message, which is almost always big enough for the next one
+      auto msg = publisher.makeBuilder("procLog");
+      buildProcLogMessage(*msg);
+      publisher.send("procLog", *msg);
+    }
+
+    auto msg = publisher.makeBuilder("metrics");
+    buildMetricsMessage(*msg);
+    publisher.send("metrics", *msg);
 
-    util::sleep_for(2000);  // 2 secs
+    util::sleep_for(1000);
   }
 
   return 0;
@@ -1,12 +1,16 @@
 #include "selfdrive/proclogd/proclog.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <cassert>
+#include <cstdio>
 #include <fstream>
 #include <iterator>
 #include <sstream>
 
+#include "selfdrive/common/sched.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 
@@ -29,6 +33,31 @@ std::vector<CPUTime> cpuTimes(std::istream &stream) {
   return cpu_times;
 }
 
+// parse /proc/schedstat cpu lines (field 8 is run-queue delay, field 9 is timeslice count)
+std::vector<CPUSchedStat> schedStat(std::istream &stream) {
+  std::vector<CPUSchedStat> stats;
+  std::string line;
+  unsigned long long dummy;
+  while (std::getline(stream, line)) {
+    if (line.compare(0, 3, "cpu") != 0) continue;
+
+    CPUSchedStat s = {};
+    std::istringstream iss(line);
+    if (iss.ignore(3) >> s.id >> dummy >> dummy >> dummy >> dummy >> dummy >> dummy >> s.run_ns >> s.wait_ns >> s.pcount)
+      stats.push_back(s);
+  }
+  return stats;
+}
+
+// parse /proc/<pid>/schedstat
+std::optional<PidSchedStat> pidSchedStat(const std::string &stat) {
+  PidSchedStat s = {};
+  if (sscanf(stat.c_str(), "%llu %llu %llu", &s.run_ns, &s.wait_ns, &s.pcount) != 3) {
+    return std::nullopt;
+  }
+  return s;
+}
+
 // parse /proc/meminfo
 std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream) {
   std::unordered_map<std::string, uint64_t> mem_info;
@@ -138,20 +167,32 @@ std::vector<std::string> cmdline(std::istream &stream) {
   return ret;
 }
 
-const ProcCache &getProcExtraInfo(int pid, const std::string &name) {
-  static std::unordered_map<pid_t, ProcCache> proc_cache;
-  ProcCache &cache = proc_cache[pid];
-  if (cache.pid != pid || cache.name != name) {
-    cache.pid = pid;
-    cache.name = name;
-    std::string proc_path = "/proc/" + std::to_string(pid);
+// per-pid cache of exe and cmdline, which only change when a pid is reused.
+// entries not refreshed for a tick belong to exited processes and get pruned.
+static std::unordered_map<pid_t, ProcCache> proc_cache;
+static uint64_t proc_cache_tick = 0;
+
+const ProcCache &getProcExtraInfo(const ProcStat &stat) {
+  ProcCache &cache = proc_cache[stat.pid];
+  if (cache.pid != stat.pid || cache.start_time != stat.starttime) {
+    cache.pid = stat.pid;
+    cache.start_time = stat.starttime;
+    std::string proc_path = "/proc/" + std::to_string(stat.pid);
     cache.exe = util::readlink(proc_path + "/exe");
     std::ifstream stream(proc_path + "/cmdline");
     cache.cmdline = cmdline(stream);
   }
+  cache.last_seen = proc_cache_tick;
   return cache;
 }
 
+void pruneProcCache() {
+  for (auto it = proc_cache.begin(); it != proc_cache.end();) {
+    it = (it->second.last_seen != proc_cache_tick) ? proc_cache.erase(it) : std::next(it);
+  }
+  ++proc_cache_tick;
+}
+
 }  // namespace Parser
 
 const double jiffy = sysconf(_SC_CLK_TCK);
@@ -191,14 +232,49 @@ void buildMemInfo(cereal::ProcLog::Builder &builder) {
   mem.setShared(mem_info["Shmem:"]);
 }
 
-void buildProcs(cereal::ProcLog::Builder &builder) {
+// read a small /proc file into a reusable buffer
+static bool readProcFile(const char *path, std::string &buf) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  size_t n = 0;
+  for (;;) {
+    if (buf.size() < n + 1024) buf.resize(n + 1024);
+    ssize_t r = HANDLE_EINTR(read(fd, &buf[n], buf.size() - n));
+    if (r <= 0) break;
+    n += r;
+  }
+  close(fd);
+  buf.resize(n);
+  return n > 0;
+}
+
+static std::vector<ProcStat> procStats() {
   auto pids = Parser::pids();
   std::vector<ProcStat> proc_stats;
   proc_stats.reserve(pids.size());
+  std::string buf;
   for (int pid : pids) {
-    std::string path = "/proc/" + std::to_string(pid) + "/stat";
-    if (auto stat = Parser::procStat(util::read_file(path))) {
-      proc_stats.push_back(*stat);
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    if (readProcFile(path, buf)) {
+      if (auto stat = Parser::procStat(buf)) {
+        proc_stats.push_back(*stat);
+      }
+    }
+  }
+  return proc_stats;
+}
+
+void buildProcs(cereal::ProcLog::Builder &builder, const std::vector<ProcStat> &proc_stats) {
+  // budget overruns self-reported into the shared table by SchedBudget
+  std::unordered_map<int, uint64_t> sched_overruns;
+  if (SchedBudgetTable *table = sched_budget_table()) {
+    for (auto &slot : table->slots) {
+      int pid = slot.pid.load(std::memory_order_relaxed);
+      if (pid != 0) {
+        sched_overruns[pid] = slot.overruns.load(std::memory_order_relaxed);
+      }
     }
   }
 
@@ -207,6 +283,9 @@ void buildProcs(cereal::ProcLog::Builder &builder) {
     auto l = procs[i];
     const ProcStat &r = proc_stats[i];
     l.setPid(r.pid);
+    if (auto it = sched_overruns.find(r.pid); it != sched_overruns.end()) {
+      l.setSchedOverruns(it->second);
+    }
     l.setState(r.state);
     l.setPpid(r.ppid);
     l.setCpuUser(r.utime / jiffy);
@@ -222,18 +301,81 @@ void buildProcs(cereal::ProcLog::Builder &builder) {
     l.setProcessor(r.processor);
     l.setName(r.name);
 
-    const ProcCache &extra_info = Parser::getProcExtraInfo(r.pid, r.name);
+    const ProcCache &extra_info = Parser::getProcExtraInfo(r);
     l.setExe(extra_info.exe);
     auto lcmdline = l.initCmdline(extra_info.cmdline.size());
     for (size_t j = 0; j < lcmdline.size(); j++) {
       lcmdline.set(j, extra_info.cmdline[j]);
     }
   }
+
+  Parser::pruneProcCache();
+}
+
+// RT processes whose run-queue delay we track. "runnable but not scheduled"
+// is the leading indicator for controls hiccups that per-process CPU totals miss.
+static bool isSchedLatencyProc(const std::string &name) {
+  return name == "boardd" || name == "camerad" || name == "modeld";
+}
+
+void buildSchedLatency(cereal::ProcLog::Builder &builder, const std::vector<ProcStat> &proc_stats) {
+  // per-cpu deltas from /proc/schedstat
+  {
+    static std::unordered_map<int, CPUSchedStat> prev;
+    std::ifstream stream("/proc/schedstat");
+    std::vector<CPUSchedStat> stats = Parser::schedStat(stream);
+
+    auto log_cpus = builder.initCpuSchedLatency(stats.size());
+    for (int i = 0; i < stats.size(); ++i) {
+      auto l = log_cpus[i];
+      const CPUSchedStat &cur = stats[i];
+      l.setCpuNum(cur.id);
+      if (auto it = prev.find(cur.id); it != prev.end() && cur.wait_ns >= it->second.wait_ns) {
+        l.setRunDelayMillis((cur.wait_ns - it->second.wait_ns) * 1e-6f);
+        l.setSchedCount(cur.pcount - it->second.pcount);
+      }
+      prev[cur.id] = cur;
+    }
+  }
+
+  // per-process deltas from /proc/<pid>/schedstat, keyed on (pid, starttime)
+  // so a restarted daemon reusing a pid starts a fresh baseline
+  struct PrevSched { unsigned long long starttime; PidSchedStat stat; };
+  static std::unordered_map<int, PrevSched> prev;
+
+  std::vector<std::pair<const ProcStat *, PidSchedStat>> cur;
+  std::string buf;
+  for (const ProcStat &p : proc_stats) {
+    if (!isSchedLatencyProc(p.name)) continue;
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/schedstat", p.pid);
+    if (readProcFile(path, buf)) {
+      if (auto stat = Parser::pidSchedStat(buf)) {
+        cur.push_back({&p, *stat});
+      }
+    }
+  }
+
+  auto log_procs = builder.initProcSchedLatency(cur.size());
+  for (size_t i = 0; i < cur.size(); ++i) {
+    auto l = log_procs[i];
+    const auto &[p, stat] = cur[i];
+    l.setPid(p->pid);
+    l.setName(p->name);
+    if (auto it = prev.find(p->pid);
+        it != prev.end() && it->second.starttime == p->starttime && stat.wait_ns >= it->second.stat.wait_ns) {
+      l.setRunDelayMillis((stat.wait_ns - it->second.stat.wait_ns) * 1e-6f);
+      l.setSchedCount(stat.pcount - it->second.stat.pcount);
+    }
+    prev[p->pid] = {p->starttime, stat};
+  }
 }
 
 void buildProcLogMessage(MessageBuilder &msg) {
   auto procLog = msg.initEvent().initProcLog();
-  buildProcs(procLog);
+  std::vector<ProcStat> proc_stats = procStats();
+  buildProcs(procLog, proc_stats);
   buildCPUTimes(procLog);
   buildMemInfo(procLog);
+  buildSchedLatency(procLog, proc_stats);
 }
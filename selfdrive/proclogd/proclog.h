@@ -11,12 +11,6 @@ struct CPUTime {
   unsigned long iowtime, irqtime, sirqtime;
 };
 
-struct ProcCache {
-  int pid;
-  std::string name, exe;
-  std::vector<std::string> cmdline;
-};
-
 struct ProcStat {
   int pid, ppid, processor;
   char state;
@@ -26,14 +20,34 @@ struct ProcStat {
   std::string name;
 };
 
+struct CPUSchedStat {
+  int id;
+  unsigned long long run_ns, wait_ns, pcount;
+};
+
+struct PidSchedStat {
+  unsigned long long run_ns, wait_ns, pcount;
+};
+
+struct ProcCache {
+  int pid;
+  unsigned long long start_time = 0;
+  uint64_t last_seen = 0;
+  std::string exe;
+  std::vector<std::string> cmdline;
+};
+
 namespace Parser {
 
 std::vector<int> pids();
 std::optional<ProcStat> procStat(std::string stat);
 std::vector<std::string> cmdline(std::istream &stream);
 std::vector<CPUTime> cpuTimes(std::istream &stream);
+std::vector<CPUSchedStat> schedStat(std::istream &stream);
+std::optional<PidSchedStat> pidSchedStat(const std::string &stat);
 std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream);
-const ProcCache &getProcExtraInfo(int pid, const std::string &name);
+const ProcCache &getProcExtraInfo(const ProcStat &stat);
+void pruneProcCache();
 
 };  // namespace Parser
 
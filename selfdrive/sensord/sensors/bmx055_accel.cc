@@ -1,6 +1,7 @@
 #include "bmx055_accel.h"
 
 #include <cassert>
+#include <cstring>
 
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
@@ -39,15 +40,63 @@ int BMX055_Accel::init() {
     goto fail;
   }
 
+  // stream samples into the FIFO, drained in batches in available()
+  ret = set_register(BMX055_ACCEL_I2C_REG_FIFO_CONFIG, BMX055_ACCEL_FIFO_MODE_STREAM);
+  if (ret < 0) {
+    goto fail;
+  }
+
 fail:
   return ret;
 }
 
+int BMX055_Accel::available() {
+  fifo_frames.clear();
+  fifo_idx = 0;
+
+  uint8_t status = 0;
+  int len = read_register(BMX055_ACCEL_I2C_REG_FIFO_STATUS, &status, 1);
+  if (len != 1) {
+    return 1;  // fall back to a direct register read in get_event
+  }
+
+  if (status & BMX055_ACCEL_FIFO_OVERRUN) {
+    // writing the config register clears the FIFO and the overrun flag
+    LOGE("bmx055 accel FIFO overrun");
+    set_register(BMX055_ACCEL_I2C_REG_FIFO_CONFIG, BMX055_ACCEL_FIFO_MODE_STREAM);
+    return 0;
+  }
+
+  int frames = status & 0x7F;
+  if (frames > BMX055_ACCEL_FIFO_MAX_FRAMES) frames = BMX055_ACCEL_FIFO_MAX_FRAMES;
+  if (frames == 0) {
+    return 0;
+  }
+
+  uint8_t data[BMX055_ACCEL_FIFO_MAX_FRAMES * 6];
+  if (read_fifo(BMX055_ACCEL_I2C_REG_FIFO, data, frames * 6, 6) < 0) {
+    return 0;
+  }
+
+  uint64_t now = nanos_since_boot();
+  for (int i = 0; i < frames; i++) {
+    queue_frame(now - (uint64_t)(frames - 1 - i) * BMX055_ACCEL_SAMPLE_PERIOD_NS, &data[i * 6]);
+  }
+  return frames;
+}
+
 void BMX055_Accel::get_event(cereal::SensorEventData::Builder &event) {
-  uint64_t start_time = nanos_since_boot();
+  uint64_t start_time;
   uint8_t buffer[6];
-  int len = read_register(BMX055_ACCEL_I2C_REG_X_LSB, buffer, sizeof(buffer));
-  assert(len == 6);
+  FifoFrame frame;
+  if (next_frame(&frame)) {
+    start_time = frame.ts;
+    memcpy(buffer, frame.data, sizeof(buffer));
+  } else {
+    start_time = nanos_since_boot();
+    int len = read_register(BMX055_ACCEL_I2C_REG_X_LSB, buffer, sizeof(buffer));
+    assert(len == 6);
+  }
 
   // 12 bit = +-2g
   float scale = 9.81 * 2.0f / (1 << 11);
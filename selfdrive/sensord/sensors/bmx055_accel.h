@@ -6,12 +6,14 @@
 #define BMX055_ACCEL_I2C_ADDR       0x18
 
 // Registers of the chip
-#define BMX055_ACCEL_I2C_REG_ID     0x00
-#define BMX055_ACCEL_I2C_REG_X_LSB  0x02
-#define BMX055_ACCEL_I2C_REG_TEMP   0x08
-#define BMX055_ACCEL_I2C_REG_BW     0x10
-#define BMX055_ACCEL_I2C_REG_HBW    0x13
-#define BMX055_ACCEL_I2C_REG_FIFO   0x3F
+#define BMX055_ACCEL_I2C_REG_ID          0x00
+#define BMX055_ACCEL_I2C_REG_X_LSB       0x02
+#define BMX055_ACCEL_I2C_REG_TEMP        0x08
+#define BMX055_ACCEL_I2C_REG_FIFO_STATUS 0x0E
+#define BMX055_ACCEL_I2C_REG_BW          0x10
+#define BMX055_ACCEL_I2C_REG_HBW         0x13
+#define BMX055_ACCEL_I2C_REG_FIFO_CONFIG 0x3E
+#define BMX055_ACCEL_I2C_REG_FIFO        0x3F
 
 // Constants
 #define BMX055_ACCEL_CHIP_ID        0xFA
@@ -19,6 +21,12 @@
 #define BMX055_ACCEL_HBW_ENABLE       0b10000000
 #define BMX055_ACCEL_HBW_DISABLE      0b00000000
 
+#define BMX055_ACCEL_FIFO_MODE_STREAM 0b10000000
+#define BMX055_ACCEL_FIFO_OVERRUN     0b10000000
+#define BMX055_ACCEL_FIFO_MAX_FRAMES  32
+// data rate is twice the 125 Hz filter bandwidth
+#define BMX055_ACCEL_SAMPLE_PERIOD_NS (1000000000ULL / 250)
+
 #define BMX055_ACCEL_BW_7_81HZ  0b01000
 #define BMX055_ACCEL_BW_15_63HZ 0b01001
 #define BMX055_ACCEL_BW_31_25HZ 0b01010
@@ -33,5 +41,6 @@ class BMX055_Accel : public I2CSensor {
 public:
   BMX055_Accel(I2CBus *bus);
   int init();
+  int available();
   void get_event(cereal::SensorEventData::Builder &event);
 };
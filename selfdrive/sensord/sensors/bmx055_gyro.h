@@ -6,12 +6,14 @@
 #define BMX055_GYRO_I2C_ADDR        0x68
 
 // Registers of the chip
-#define BMX055_GYRO_I2C_REG_ID         0x00
-#define BMX055_GYRO_I2C_REG_RATE_X_LSB 0x02
-#define BMX055_GYRO_I2C_REG_RANGE      0x0F
-#define BMX055_GYRO_I2C_REG_BW         0x10
-#define BMX055_GYRO_I2C_REG_HBW        0x13
-#define BMX055_GYRO_I2C_REG_FIFO       0x3F
+#define BMX055_GYRO_I2C_REG_ID          0x00
+#define BMX055_GYRO_I2C_REG_RATE_X_LSB  0x02
+#define BMX055_GYRO_I2C_REG_FIFO_STATUS 0x0E
+#define BMX055_GYRO_I2C_REG_RANGE       0x0F
+#define BMX055_GYRO_I2C_REG_BW          0x10
+#define BMX055_GYRO_I2C_REG_HBW         0x13
+#define BMX055_GYRO_I2C_REG_FIFO_CONFIG 0x3E
+#define BMX055_GYRO_I2C_REG_FIFO        0x3F
 
 // Constants
 #define BMX055_GYRO_CHIP_ID         0x0F
@@ -27,11 +29,17 @@
 
 #define BMX055_GYRO_BW_116HZ 0b0010
 
+#define BMX055_GYRO_FIFO_MODE_STREAM 0b10000000
+#define BMX055_GYRO_FIFO_OVERRUN     0b10000000
+#define BMX055_GYRO_FIFO_MAX_FRAMES  32
+// the 116 Hz filter bandwidth runs the gyro at 1 kHz
+#define BMX055_GYRO_SAMPLE_PERIOD_NS (1000000000ULL / 1000)
 
 class BMX055_Gyro : public I2CSensor {
   uint8_t get_device_address() {return BMX055_GYRO_I2C_ADDR;}
 public:
   BMX055_Gyro(I2CBus *bus);
   int init();
+  int available();
   void get_event(cereal::SensorEventData::Builder &event);
 };
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <iterator>
 
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
@@ -97,23 +98,21 @@ int BMX055_Magn::init() {
     return -1;
   }
 
-  // Load magnetometer trim
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_X1, trim_x1y1, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_X2, trim_x2y2, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_XY2, trim_xy1xy2, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_Z1_LSB, trim_z1, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_Z2_LSB, trim_z2, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_Z3_LSB, trim_z3, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_Z4_LSB, trim_z4, 2);
-  if(ret < 0) goto fail;
-  ret = read_register(BMX055_MAGN_I2C_REG_DIG_XYZ1_LSB, trim_xyz1, 2);
-  if(ret < 0) goto fail;
+  // Load magnetometer trim, all registers in one bus transaction
+  {
+    I2CReadOp trim_ops[] = {
+      {BMX055_MAGN_I2C_REG_DIG_X1, trim_x1y1, 2},
+      {BMX055_MAGN_I2C_REG_DIG_X2, trim_x2y2, 2},
+      {BMX055_MAGN_I2C_REG_DIG_XY2, trim_xy1xy2, 2},
+      {BMX055_MAGN_I2C_REG_DIG_Z1_LSB, trim_z1, 2},
+      {BMX055_MAGN_I2C_REG_DIG_Z2_LSB, trim_z2, 2},
+      {BMX055_MAGN_I2C_REG_DIG_Z3_LSB, trim_z3, 2},
+      {BMX055_MAGN_I2C_REG_DIG_Z4_LSB, trim_z4, 2},
+      {BMX055_MAGN_I2C_REG_DIG_XYZ1_LSB, trim_xyz1, 2},
+    };
+    ret = read_registers(trim_ops, std::size(trim_ops));
+    if(ret < 0) goto fail;
+  }
 
   // Read trim data
   trim_data.dig_x1 = trim_x1y1[0];
@@ -1,5 +1,7 @@
 #include "i2c_sensor.h"
 
+#include <cstring>
+
 int16_t read_12_bit(uint8_t lsb, uint8_t msb) {
   uint16_t combined = (uint16_t(msb) << 8) | uint16_t(lsb & 0xF0);
   return int16_t(combined) / (1 << 4);
@@ -23,6 +25,38 @@ int I2CSensor::read_register(uint register_address, uint8_t *buffer, uint8_t len
   return bus->read_register(get_device_address(), register_address, buffer, len);
 }
 
+int I2CSensor::read_registers(I2CReadOp *ops, int count) {
+  return bus->read_registers(get_device_address(), ops, count);
+}
+
 int I2CSensor::set_register(uint register_address, uint8_t data) {
   return bus->set_register(get_device_address(), register_address, data);
 }
+
+// SMBus block reads top out at 32 bytes, so a FIFO drain is split into
+// transactions of as many whole frames as fit
+int I2CSensor::read_fifo(uint register_address, uint8_t *buffer, int len, int frame_size) {
+  const int chunk = (32 / frame_size) * frame_size;
+  for (int pos = 0; pos < len; pos += chunk) {
+    int n = len - pos < chunk ? len - pos : chunk;
+    int ret = read_register(register_address, buffer + pos, n);
+    if (ret != n) {
+      return -1;
+    }
+  }
+  return len;
+}
+
+void I2CSensor::queue_frame(uint64_t ts, const uint8_t *data) {
+  FifoFrame &frame = fifo_frames.emplace_back();
+  frame.ts = ts;
+  memcpy(frame.data, data, sizeof(frame.data));
+}
+
+bool I2CSensor::next_frame(FifoFrame *frame) {
+  if (fifo_idx >= fifo_frames.size()) {
+    return false;
+  }
+  *frame = fifo_frames[fifo_idx++];
+  return true;
+}
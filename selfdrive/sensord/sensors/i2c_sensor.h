@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "cereal/gen/cpp/log.capnp.h"
 #include "selfdrive/common/i2c.h"
@@ -17,9 +18,25 @@ private:
   I2CBus *bus;
   virtual uint8_t get_device_address() = 0;
 
+protected:
+  // one timestamped x/y/z sample drained from a chip FIFO, in chip byte order
+  struct FifoFrame {
+    uint64_t ts;
+    uint8_t data[6];
+  };
+  // frames drained in available(), consumed in order by get_event
+  std::vector<FifoFrame> fifo_frames;
+  size_t fifo_idx = 0;
+
+  int read_fifo(uint register_address, uint8_t *buffer, int len, int frame_size);
+  void queue_frame(uint64_t ts, const uint8_t *data);
+  bool next_frame(FifoFrame *frame);
+
 public:
   I2CSensor(I2CBus *bus);
   int read_register(uint register_address, uint8_t *buffer, uint8_t len);
+  // batched multi-register read in one bus transaction
+  int read_registers(I2CReadOp *ops, int count);
   int set_register(uint register_address, uint8_t data);
   virtual int init() = 0;
   virtual void get_event(cereal::SensorEventData::Builder &event) = 0;
@@ -1,11 +1,13 @@
 #include "lsm6ds3_accel.h"
 
 #include <cassert>
+#include <cstring>
 
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_gyro.h"
 
-LSM6DS3_Accel::LSM6DS3_Accel(I2CBus *bus) : I2CSensor(bus) {}
+LSM6DS3_Accel::LSM6DS3_Accel(I2CBus *bus, LSM6DS3_Gyro *gyro) : I2CSensor(bus), gyro(gyro) {}
 
 int LSM6DS3_Accel::init() {
   int ret = 0;
@@ -33,17 +35,88 @@ int LSM6DS3_Accel::init() {
     goto fail;
   }
 
+  // stream gyro + accel into the shared FIFO, drained in batches in available()
+  ret = set_register(LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL3, LSM6DS3_FIFO_DEC_NONE);
+  if (ret < 0) {
+    goto fail;
+  }
+  ret = set_register(LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_ODR_104HZ | LSM6DS3_FIFO_MODE_CONT);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // raise INT1 when the FIFO crosses one sample set, so sensord can sleep
+  // on the interrupt line instead of a timer
+  ret = set_register(LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL1, LSM6DS3_FIFO_THRESHOLD_WORDS);
+  if (ret < 0) {
+    goto fail;
+  }
+  ret = set_register(LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL2, 0);
+  if (ret < 0) {
+    goto fail;
+  }
+  ret = set_register(LSM6DS3_ACCEL_I2C_REG_INT1_CTRL, LSM6DS3_INT1_FTH);
+  if (ret < 0) {
+    goto fail;
+  }
 
 fail:
   return ret;
 }
 
+int LSM6DS3_Accel::available() {
+  fifo_frames.clear();
+  fifo_idx = 0;
+  gyro->clear_samples();
+
+  uint8_t status[2];
+  int len = read_register(LSM6DS3_ACCEL_I2C_REG_FIFO_STATUS1, status, sizeof(status));
+  if (len != sizeof(status)) {
+    return 1;  // fall back to a direct register read in get_event
+  }
+
+  if (status[1] & LSM6DS3_FIFO_OVERRUN) {
+    // pattern alignment is lost once the FIFO overruns, restart it
+    LOGE("lsm6ds3 FIFO overrun");
+    set_register(LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL5, 0);
+    set_register(LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_ODR_104HZ | LSM6DS3_FIFO_MODE_CONT);
+    return 0;
+  }
+
+  // unread 16 bit words, six per sample set
+  int sets = (((status[1] & 0x07) << 8) | status[0]) / 6;
+  if (sets > LSM6DS3_FIFO_MAX_SETS) sets = LSM6DS3_FIFO_MAX_SETS;
+  if (sets == 0) {
+    return 0;
+  }
+
+  uint8_t data[LSM6DS3_FIFO_MAX_SETS * LSM6DS3_FIFO_SET_SIZE];
+  if (read_fifo(LSM6DS3_ACCEL_I2C_REG_FIFO_DATA_L, data, sets * LSM6DS3_FIFO_SET_SIZE, LSM6DS3_FIFO_SET_SIZE) < 0) {
+    return 0;
+  }
+
+  uint64_t now = nanos_since_boot();
+  for (int i = 0; i < sets; i++) {
+    uint64_t ts = now - (uint64_t)(sets - 1 - i) * LSM6DS3_FIFO_SAMPLE_PERIOD_NS;
+    gyro->queue_sample(ts, &data[i * LSM6DS3_FIFO_SET_SIZE]);
+    queue_frame(ts, &data[i * LSM6DS3_FIFO_SET_SIZE + 6]);
+  }
+  return sets;
+}
+
 void LSM6DS3_Accel::get_event(cereal::SensorEventData::Builder &event) {
 
-  uint64_t start_time = nanos_since_boot();
+  uint64_t start_time;
   uint8_t buffer[6];
-  int len = read_register(LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL, buffer, sizeof(buffer));
-  assert(len == sizeof(buffer));
+  FifoFrame frame;
+  if (next_frame(&frame)) {
+    start_time = frame.ts;
+    memcpy(buffer, frame.data, sizeof(buffer));
+  } else {
+    start_time = nanos_since_boot();
+    int len = read_register(LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL, buffer, sizeof(buffer));
+    assert(len == sizeof(buffer));
+  }
 
   float scale = 9.81 * 2.0f / (1 << 15);
   float x = read_16_bit(buffer[0], buffer[1]) * scale;
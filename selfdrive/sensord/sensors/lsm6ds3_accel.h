@@ -6,21 +6,43 @@
 #define LSM6DS3_ACCEL_I2C_ADDR       0x6A
 
 // Registers of the chip
-#define LSM6DS3_ACCEL_I2C_REG_ID        0x0F
-#define LSM6DS3_ACCEL_I2C_REG_CTRL1_XL  0x10
-#define LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL 0x28
+#define LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL1   0x06
+#define LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL2   0x07
+#define LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL3   0x08
+#define LSM6DS3_ACCEL_I2C_REG_FIFO_CTRL5   0x0A
+#define LSM6DS3_ACCEL_I2C_REG_INT1_CTRL    0x0D
+#define LSM6DS3_ACCEL_I2C_REG_ID           0x0F
+#define LSM6DS3_ACCEL_I2C_REG_CTRL1_XL     0x10
+#define LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL    0x28
+#define LSM6DS3_ACCEL_I2C_REG_FIFO_STATUS1 0x3A
+#define LSM6DS3_ACCEL_I2C_REG_FIFO_DATA_L  0x3E
 
 // Constants
 #define LSM6DS3_ACCEL_CHIP_ID        0x69
 #define LSM6DS3TRC_ACCEL_CHIP_ID     0x6A
 #define LSM6DS3_ACCEL_ODR_104HZ      (0b0100 << 4)
+#define LSM6DS3_FIFO_DEC_NONE        0b00001001  // gyro + accel, no decimation
+#define LSM6DS3_FIFO_ODR_104HZ       (0b0100 << 3)
+#define LSM6DS3_FIFO_MODE_CONT       0b110
+#define LSM6DS3_FIFO_OVERRUN         0b01000000
+#define LSM6DS3_INT1_FTH             0b00001000
+// FIFO threshold for the INT1 data-ready edge, in 16 bit words: one full
+// gyro + accel sample set
+#define LSM6DS3_FIFO_THRESHOLD_WORDS 6
+// one FIFO sample set: gyro x/y/z then accel x/y/z, 16 bit each
+#define LSM6DS3_FIFO_SET_SIZE        12
+#define LSM6DS3_FIFO_MAX_SETS        32
+#define LSM6DS3_FIFO_SAMPLE_PERIOD_NS (1000000000ULL / 104)
 
+class LSM6DS3_Gyro;
 
 class LSM6DS3_Accel : public I2CSensor {
   uint8_t get_device_address() {return LSM6DS3_ACCEL_I2C_ADDR;}
   cereal::SensorEventData::SensorSource source = cereal::SensorEventData::SensorSource::LSM6DS3;
+  LSM6DS3_Gyro *gyro;
 public:
-  LSM6DS3_Accel(I2CBus *bus);
+  LSM6DS3_Accel(I2CBus *bus, LSM6DS3_Gyro *gyro);
   int init();
+  int available();
   void get_event(cereal::SensorEventData::Builder &event);
 };
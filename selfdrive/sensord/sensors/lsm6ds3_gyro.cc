@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
@@ -44,10 +45,17 @@ fail:
 
 void LSM6DS3_Gyro::get_event(cereal::SensorEventData::Builder &event) {
 
-  uint64_t start_time = nanos_since_boot();
+  uint64_t start_time;
   uint8_t buffer[6];
-  int len = read_register(LSM6DS3_GYRO_I2C_REG_OUTX_L_G, buffer, sizeof(buffer));
-  assert(len == sizeof(buffer));
+  FifoFrame frame;
+  if (next_frame(&frame)) {
+    start_time = frame.ts;
+    memcpy(buffer, frame.data, sizeof(buffer));
+  } else {
+    start_time = nanos_since_boot();
+    int len = read_register(LSM6DS3_GYRO_I2C_REG_OUTX_L_G, buffer, sizeof(buffer));
+    assert(len == sizeof(buffer));
+  }
 
   float scale = 8.75 / 1000.0;
   float x = DEG2RAD(read_16_bit(buffer[0], buffer[1]) * scale);
@@ -22,5 +22,10 @@ class LSM6DS3_Gyro : public I2CSensor {
 public:
   LSM6DS3_Gyro(I2CBus *bus);
   int init();
+  int available() { return fifo_frames.size() - fifo_idx; }
   void get_event(cereal::SensorEventData::Builder &event);
+
+  // the accel object owns the shared LSM6DS3 FIFO and feeds gyro samples here
+  void clear_samples() { fifo_frames.clear(); fifo_idx = 0; }
+  void queue_sample(uint64_t ts, const uint8_t *data) { queue_frame(ts, data); }
 };
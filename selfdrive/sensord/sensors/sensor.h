@@ -6,5 +6,9 @@ class Sensor {
 public:
   virtual ~Sensor() {};
   virtual int init() = 0;
+  // number of events the following get_event calls will fill this tick.
+  // FIFO-backed sensors drain their hardware FIFO here and return the batch
+  // size; the default is one register read per tick.
+  virtual int available() { return 1; }
   virtual void get_event(cereal::SensorEventData::Builder &event) = 0;
 };
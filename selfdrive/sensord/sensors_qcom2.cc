@@ -1,10 +1,14 @@
+#include <linux/gpio.h>
+#include <poll.h>
 #include <sys/resource.h>
+#include <unistd.h>
 
 #include <chrono>
 #include <thread>
 #include <vector>
 
 #include "cereal/messaging/messaging.h"
+#include "selfdrive/common/gpio.h"
 #include "selfdrive/common/i2c.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
@@ -40,8 +44,9 @@ int sensor_loop() {
   BMX055_Magn bmx055_magn(i2c_bus_imu);
   BMX055_Temp bmx055_temp(i2c_bus_imu);
 
-  LSM6DS3_Accel lsm6ds3_accel(i2c_bus_imu);
   LSM6DS3_Gyro lsm6ds3_gyro(i2c_bus_imu);
+  // the accel object owns the shared LSM6DS3 FIFO and feeds the gyro
+  LSM6DS3_Accel lsm6ds3_accel(i2c_bus_imu, &lsm6ds3_gyro);
   LSM6DS3_Temp lsm6ds3_temp(i2c_bus_imu);
 
   MMC5603NJ_Magn mmc5603nj_magn(i2c_bus_imu);
@@ -90,23 +95,56 @@ int sensor_loop() {
 
   PubMaster pm({"sensorEvents"});
 
+  // the LSM6DS3's INT1 is wired to a SoC GPIO and raised on FIFO threshold;
+  // pacing the loop off that edge removes the timer's sampling jitter and
+  // skips wakeups when no data is pending. Falls back to timed polling when
+  // the line isn't available (older hw, missing permissions).
+  int lsm_irq_fd = gpiochip_get_ro_value_fd("sensord", 0, GPIO_LSM_INT);
+  if (lsm_irq_fd < 0) {
+    LOGW("lsm6ds3 interrupt line unavailable, falling back to timed polling");
+  }
+
+  // FIFO-backed sensors return a batch of samples per tick. note that the
+  // sensors vector keeps the LSM6DS3 accel ahead of the gyro, so the shared
+  // FIFO is drained before the gyro's count is read
+  std::vector<int> counts(sensors.size());
+
   while (!do_exit) {
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-    const int num_events = sensors.size();
+    int num_events = 0;
+    for (int i = 0; i < sensors.size(); i++) {
+      counts[i] = sensors[i]->available();
+      num_events += counts[i];
+    }
+
     MessageBuilder msg;
     auto sensor_events = msg.initEvent().initSensorEvents(num_events);
 
-    for (int i = 0; i < num_events; i++) {
-      auto event = sensor_events[i];
-      sensors[i]->get_event(event);
+    int event_idx = 0;
+    for (int i = 0; i < sensors.size(); i++) {
+      for (int j = 0; j < counts[i]; j++) {
+        auto event = sensor_events[event_idx++];
+        sensors[i]->get_event(event);
+      }
     }
 
     pm.send("sensorEvents", msg);
 
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    std::this_thread::sleep_for(std::chrono::milliseconds(10) - (end - begin));
+    if (lsm_irq_fd >= 0) {
+      // the timeout is a watchdog: a wedged interrupt line degrades to the
+      // old polling cadence instead of stalling the loop
+      struct pollfd fds = {.fd = lsm_irq_fd, .events = POLLIN};
+      if (poll(&fds, 1, 20) > 0) {
+        struct gpioevent_data evdata[16];
+        read(lsm_irq_fd, evdata, sizeof(evdata));  // drain queued edges
+      }
+    } else {
+      std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10) - (end - begin));
+    }
   }
+  if (lsm_irq_fd >= 0) close(lsm_irq_fd);
   return 0;
 }
 
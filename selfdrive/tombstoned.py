@@ -4,6 +4,7 @@ import os
 import re
 import shutil
 import signal
+import struct
 import subprocess
 import time
 import glob
@@ -25,6 +26,64 @@ MAX_TOMBSTONE_FN_LEN = 62  # 85 - 23 ("<dongle id>/crash/")
 TOMBSTONE_DIR = "/data/tombstones/"
 APPORT_DIR = "/var/crash/"
 
+# flight recorder ring layout, must match selfdrive/common/ringlog.h
+RINGLOG_MAGIC = 0x304c464f
+RINGLOG_SLOTS = 4096
+RINGLOG_SLOT_SIZE = 256
+RINGLOG_SLOT_DATA = 246
+RINGLOG_HEADER_SIZE = 40
+
+
+def read_flight_ring(pid):
+  """Decode a crashed process's /dev/shm flight recorder into ordered text lines."""
+  try:
+    with open(f"/dev/shm/op_flight_{pid}", "rb") as f:
+      dat = f.read()
+  except OSError:
+    return ""
+
+  if len(dat) < RINGLOG_HEADER_SIZE + RINGLOG_SLOTS * RINGLOG_SLOT_SIZE:
+    return ""
+  magic, ring_pid = struct.unpack_from("<Ii", dat, 0)
+  if magic != RINGLOG_MAGIC or ring_pid != pid:
+    return ""
+
+  slots = []
+  for i in range(RINGLOG_SLOTS):
+    off = RINGLOG_HEADER_SIZE + i * RINGLOG_SLOT_SIZE
+    seq, length = struct.unpack_from("<QH", dat, off)
+    if seq > 0:
+      slots.append((seq, dat[off + 10:off + 10 + min(length, RINGLOG_SLOT_DATA)]))
+  slots.sort()
+  return "\n".join(s[1].decode(errors='replace') for s in slots)
+
+
+def dump_flight_recording(contents, pid_re, crashlog_path):
+  """Append the crashed process's flight ring to its crash log and save the
+     trace ring alongside, while the /dev/shm files still exist."""
+  m = re.search(pid_re, contents)
+  if m is None:
+    return
+  pid = int(m.group(1))
+
+  recording = read_flight_ring(pid)
+  if recording:
+    with open(crashlog_path, "a", encoding='ISO-8859-1') as f:
+      f.write("\n\n----- flight recorder: last events before crash -----\n")
+      f.write(recording + "\n")
+
+  trace_fn = f"/dev/shm/op_trace_{pid}"
+  if os.path.exists(trace_fn):
+    try:
+      shutil.copy(trace_fn, crashlog_path + ".trace")  # decode with common/tracedump
+    except OSError:
+      pass
+
+  try:
+    os.remove(f"/dev/shm/op_flight_{pid}")
+  except OSError:
+    pass
+
 
 def safe_fn(s):
   extra = ['_']
@@ -114,7 +173,9 @@ def report_tombstone_android(fn):
   crashlog_dir = os.path.join(ROOT, "crash")
   mkdirs_exists_ok(crashlog_dir)
 
-  shutil.copy(fn, os.path.join(crashlog_dir, new_fn))
+  crashlog_path = os.path.join(crashlog_dir, new_fn)
+  shutil.copy(fn, crashlog_path)
+  dump_flight_recording(contents, r"pid:\s*(\d+)", crashlog_path)
 
 
 def report_tombstone_apport(fn):
@@ -189,7 +250,9 @@ def report_tombstone_apport(fn):
   mkdirs_exists_ok(crashlog_dir)
 
   # Files could be on different filesystems, copy, then delete
-  shutil.copy(fn, os.path.join(crashlog_dir, new_fn))
+  crashlog_path = os.path.join(crashlog_dir, new_fn)
+  shutil.copy(fn, crashlog_path)
+  dump_flight_recording(contents, r"Pid:\s*(\d+)", crashlog_path)
 
   try:
     os.remove(fn)
@@ -0,0 +1,171 @@
+#include "selfdrive/ui/navd/ch_router.h"
+
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+#include "selfdrive/common/util.h"
+
+const uint32_t CH_MAGIC = 0x31474843;  // "CHG1"
+const uint32_t CH_NO_SKIP = UINT32_MAX;
+const uint32_t CH_FLAG_FWD = 1;
+const uint32_t CH_FLAG_BWD = 2;
+const double MAX_SNAP_DISTANCE = 200.0;  // meters from graph to accept an endpoint
+
+// equirectangular approximation, plenty for snapping and fine at city scale
+static double approx_dist(double lat1, double lon1, double lat2, double lon2) {
+  const double m_per_deg = 111320.0;
+  double dx = (lon2 - lon1) * m_per_deg * std::cos((lat1 + lat2) / 2.0 * M_PI / 180.0);
+  double dy = (lat2 - lat1) * m_per_deg;
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+bool CHRouter::load(const std::string &path) {
+  std::string dat = util::read_file(path);
+  if (dat.size() < 3 * sizeof(uint32_t)) return false;
+
+  const char *p = dat.data(), *end = dat.data() + dat.size();
+  auto read = [&p, end](void *dst, size_t n) {
+    if (p + n > end) return false;
+    memcpy(dst, p, n);
+    p += n;
+    return true;
+  };
+
+  uint32_t magic = 0, num_nodes = 0, num_edges = 0;
+  if (!read(&magic, 4) || magic != CH_MAGIC || !read(&num_nodes, 4) || !read(&num_edges, 4)) {
+    return false;
+  }
+
+  nodes_.resize(num_nodes);
+  edge_offsets_.resize(num_nodes + 1);
+  edges_.resize(num_edges);
+  geo_offsets_.resize(num_edges + 1);
+  bool ok = read(nodes_.data(), num_nodes * sizeof(Coord)) &&
+            read(edge_offsets_.data(), (num_nodes + 1) * sizeof(uint32_t)) &&
+            read(edges_.data(), num_edges * sizeof(CHEdge)) &&
+            read(geo_offsets_.data(), (num_edges + 1) * sizeof(uint32_t));
+  if (ok) {
+    geo_.resize(geo_offsets_[num_edges]);
+    ok = read(geo_.data(), geo_.size() * sizeof(Coord));
+  }
+  if (!ok) {
+    nodes_.clear();
+  }
+  return ok;
+}
+
+uint32_t CHRouter::nearestNode(const QGeoCoordinate &c) const {
+  uint32_t best = UINT32_MAX;
+  double best_d = MAX_SNAP_DISTANCE;
+  for (uint32_t i = 0; i < nodes_.size(); i++) {
+    double d = approx_dist(c.latitude(), c.longitude(), nodes_[i].lat, nodes_[i].lon);
+    if (d < best_d) {
+      best_d = d;
+      best = i;
+    }
+  }
+  return best;
+}
+
+void CHRouter::unpackEdge(uint32_t edge_idx, bool reverse, QList<QGeoCoordinate> &out) const {
+  const CHEdge &e = edges_[edge_idx];
+  if (e.skip1 != CH_NO_SKIP) {
+    // shortcut: children run middle->source and middle->target, so the
+    // traversal order and orientation of both flip with the parent's
+    if (!reverse) {
+      unpackEdge(e.skip1, true, out);
+      unpackEdge(e.skip2, false, out);
+    } else {
+      unpackEdge(e.skip2, true, out);
+      unpackEdge(e.skip1, false, out);
+    }
+    return;
+  }
+  uint32_t begin = geo_offsets_[edge_idx], end = geo_offsets_[edge_idx + 1];
+  for (uint32_t i = begin; i < end; i++) {
+    const Coord &c = geo_[reverse ? (end - 1 - (i - begin)) : i];
+    QGeoCoordinate pt(c.lat, c.lon);
+    if (out.empty() || out.back() != pt) {
+      out.push_back(pt);
+    }
+  }
+}
+
+std::optional<QList<QGeoCoordinate>> CHRouter::query(const QGeoCoordinate &from, const QGeoCoordinate &to) const {
+  if (!valid()) return std::nullopt;
+  uint32_t s = nearestNode(from), t = nearestNode(to);
+  if (s == UINT32_MAX || t == UINT32_MAX) return std::nullopt;
+
+  // bidirectional upward Dijkstra: nodes are stored in contraction order, so
+  // both searches only relax edges toward higher node ids
+  struct Search {
+    std::unordered_map<uint32_t, uint64_t> dist;
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> parent;  // node -> (prev node, edge idx)
+    std::priority_queue<std::pair<uint64_t, uint32_t>,
+                        std::vector<std::pair<uint64_t, uint32_t>>,
+                        std::greater<>> pq;
+  } fwd, bwd;
+  fwd.dist[s] = 0;
+  fwd.pq.push({0, s});
+  bwd.dist[t] = 0;
+  bwd.pq.push({0, t});
+
+  uint64_t best = UINT64_MAX;
+  uint32_t meet = UINT32_MAX;
+  auto step = [this, &best, &meet](Search &self, Search &other, uint32_t dir_flag) {
+    auto [d, u] = self.pq.top();
+    self.pq.pop();
+    if (d > self.dist[u]) return;  // stale entry
+    if (auto it = other.dist.find(u); it != other.dist.end() && d + it->second < best) {
+      best = d + it->second;
+      meet = u;
+    }
+    for (uint32_t i = edge_offsets_[u]; i < edge_offsets_[u + 1]; i++) {
+      const CHEdge &e = edges_[i];
+      if (!(e.flags & dir_flag) || e.target < u) continue;
+      uint64_t nd = d + e.weight;
+      auto it = self.dist.find(e.target);
+      if (it == self.dist.end() || nd < it->second) {
+        self.dist[e.target] = nd;
+        self.parent[e.target] = {u, i};
+        self.pq.push({nd, e.target});
+      }
+    }
+  };
+
+  while (!fwd.pq.empty() || !bwd.pq.empty()) {
+    uint64_t f_min = fwd.pq.empty() ? UINT64_MAX : fwd.pq.top().first;
+    uint64_t b_min = bwd.pq.empty() ? UINT64_MAX : bwd.pq.top().first;
+    if (std::min(f_min, b_min) >= best) break;
+    if (f_min <= b_min) {
+      step(fwd, bwd, CH_FLAG_FWD);
+    } else {
+      step(bwd, fwd, CH_FLAG_BWD);
+    }
+  }
+  if (meet == UINT32_MAX) return std::nullopt;
+
+  // edges on the up path s->meet (walked backwards), then down path meet->t.
+  // forward-search edges are traversed in stored orientation, backward-search
+  // edges against it
+  std::vector<std::pair<uint32_t, bool>> path;  // (edge idx, reverse)
+  for (uint32_t v = meet; v != s;) {
+    auto [u, e] = fwd.parent.at(v);
+    path.emplace_back(e, false);
+    v = u;
+  }
+  std::reverse(path.begin(), path.end());
+  for (uint32_t v = meet; v != t;) {
+    auto [u, e] = bwd.parent.at(v);
+    path.emplace_back(e, true);
+    v = u;
+  }
+
+  QList<QGeoCoordinate> out;
+  for (auto [e, reverse] : path) {
+    unpackEdge(e, reverse, out);
+  }
+  return out;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <QGeoCoordinate>
+
+// On-device router over a preprocessed contraction-hierarchy graph, built
+// offline from OSM extracts. A query is a bidirectional upward Dijkstra plus
+// shortcut unpacking and runs in milliseconds on metro-sized graphs, so a
+// reroute doesn't need a network round trip.
+//
+// Graph file layout (little-endian, nodes stored in contraction order so the
+// node id is its rank):
+//   u32 magic "CHG1", u32 num_nodes, u32 num_edges
+//   num_nodes   x { float lat, float lon }
+//   num_nodes+1 x u32 edge_offset            (CSR adjacency)
+//   num_edges   x CHEdge
+//   num_edges+1 x u32 geo_offset             (per-edge shape points)
+//   geo_offset[num_edges] x { float lat, float lon }
+class CHRouter {
+public:
+  struct CHEdge {
+    uint32_t target;
+    uint32_t weight;   // travel time, milliseconds
+    uint32_t flags;    // bit 0: usable forward, bit 1: usable backward
+    // shortcut children as edge indices: skip1 runs middle->source, skip2
+    // runs middle->target (in stored orientation). UINT32_MAX on original
+    // edges, whose shape lives in the geo section instead.
+    uint32_t skip1;
+    uint32_t skip2;
+  };
+
+  bool load(const std::string &path);
+  bool valid() const { return !nodes_.empty(); }
+
+  // shortest path as a polyline; nullopt when either endpoint is too far
+  // from the graph or the endpoints are not connected
+  std::optional<QList<QGeoCoordinate>> query(const QGeoCoordinate &from, const QGeoCoordinate &to) const;
+
+private:
+  struct Coord {
+    float lat, lon;
+  };
+
+  uint32_t nearestNode(const QGeoCoordinate &c) const;
+  void unpackEdge(uint32_t edge_idx, bool reverse, QList<QGeoCoordinate> &out) const;
+
+  std::vector<Coord> nodes_;
+  std::vector<uint32_t> edge_offsets_;
+  std::vector<CHEdge> edges_;
+  std::vector<uint32_t> geo_offsets_;
+  std::vector<Coord> geo_;
+};
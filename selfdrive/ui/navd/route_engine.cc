@@ -122,6 +122,16 @@ RouteEngine::RouteEngine() {
   if (last_gps_position) {
     last_position = *last_gps_position;
   }
+
+  // warm up the directions host right away so the first route request only
+  // pays the server time, not DNS + TLS handshake
+  HttpRequest::prewarm(MAPS_HOST);
+
+  // On-device routing graph, built offline from OSM extracts
+  std::string graph_file = util::getenv("NAV_GRAPH_FILE", "/data/nav/graph.ch");
+  if (ch_router.load(graph_file)) {
+    qWarning() << "Loaded routing graph" << QString::fromStdString(graph_file);
+  }
 }
 
 void RouteEngine::timerUpdate() {
@@ -218,6 +228,7 @@ void RouteEngine::timerUpdate() {
 void RouteEngine::clearRoute() {
   segment = QGeoRouteSegment();
   nav_destination = QMapbox::Coordinate();
+  local_route_active = false;
 }
 
 bool RouteEngine::shouldRecompute() {
@@ -271,10 +282,41 @@ void RouteEngine::recomputeRoute() {
   }
 }
 
+void RouteEngine::publishRoute(const QList<QGeoCoordinate> &path) {
+  // one-pixel tolerance at the deepest driving zoom: a long motorway route
+  // goes from thousands of points to a few hundred before it hits consumers
+  QList<QGeoCoordinate> decimated = simplify_geometry(path, 2.0);
+
+  MessageBuilder msg;
+  cereal::Event::Builder evt = msg.initEvent();
+  cereal::NavRoute::Builder nav_route = evt.initNavRoute();
+
+  auto coordinates = nav_route.initCoordinates(decimated.size());
+  size_t i = 0;
+  for (auto const &c : decimated) {
+    coordinates[i].setLatitude(c.latitude());
+    coordinates[i].setLongitude(c.longitude());
+    i++;
+  }
+
+  pm->send("navRoute", msg);
+}
+
 void RouteEngine::calculateRoute(QMapbox::Coordinate destination) {
   qWarning() << "Calculating route" << *last_position << "->" << destination;
 
   nav_destination = destination;
+
+  // answer from the local graph first: the route line and the reroute are
+  // instant, and the remote reply upgrades it with banner instructions
+  if (ch_router.valid()) {
+    auto path = ch_router.query(to_QGeoCoordinate(*last_position), to_QGeoCoordinate(destination));
+    if (path) {
+      qWarning() << "Got local route," << path->size() << "points";
+      publishRoute(*path);
+      local_route_active = true;
+    }
+  }
   QGeoRouteRequest request(to_QGeoCoordinate(*last_position), to_QGeoCoordinate(destination));
   request.setFeatureWeight(QGeoRouteRequest::TrafficFeature, QGeoRouteRequest::AvoidFeatureWeight);
 
@@ -289,27 +331,15 @@ void RouteEngine::calculateRoute(QMapbox::Coordinate destination) {
 }
 
 void RouteEngine::routeCalculated(QGeoRouteReply *reply) {
-  MessageBuilder msg;
-  cereal::Event::Builder evt = msg.initEvent();
-  cereal::NavRoute::Builder nav_route = evt.initNavRoute();
-
+  QList<QGeoCoordinate> path;
   if (reply->error() == QGeoRouteReply::NoError) {
     if (reply->routes().size() != 0) {
       qWarning() << "Got route response";
 
       route = reply->routes().at(0);
       segment = route.firstRouteSegment();
-
-      auto path = route.path();
-      auto coordinates = nav_route.initCoordinates(path.size());
-
-      size_t i = 0;
-      for (auto const &c : route.path()) {
-        coordinates[i].setLatitude(c.latitude());
-        coordinates[i].setLongitude(c.longitude());
-        i++;
-      }
-
+      path = route.path();
+      local_route_active = false;
     } else {
       qWarning() << "Got empty route response";
     }
@@ -317,7 +347,10 @@ void RouteEngine::routeCalculated(QGeoRouteReply *reply) {
     qWarning() << "Got error in route reply" << reply->errorString();
   }
 
-  pm->send("navRoute", msg);
+  // a failed remote query must not clear a route the local graph answered
+  if (!path.empty() || !local_route_active) {
+    publishRoute(path);
+  }
 
   reply->deleteLater();
 }
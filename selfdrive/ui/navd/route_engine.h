@@ -11,6 +11,7 @@
 #include <QMapboxGL>
 
 #include "cereal/messaging/messaging.h"
+#include "selfdrive/ui/navd/ch_router.h"
 
 class RouteEngine : public QObject {
   Q_OBJECT
@@ -43,6 +44,13 @@ public:
   void clearRoute();
   bool shouldRecompute();
 
+  // On-device routing over a preprocessed contraction-hierarchy graph;
+  // gives the UI a fresh route line immediately while the remote query
+  // (which carries the turn-by-turn banners) is still in flight
+  CHRouter ch_router;
+  bool local_route_active = false;
+  void publishRoute(const QList<QGeoCoordinate> &path);
+
 private slots:
   void timerUpdate();
   void routeCalculated(QGeoRouteReply *reply);
@@ -16,6 +16,7 @@
 #include <nanovg_gl.h>
 #include <nanovg_gl_utils.h>
 
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
 #include "selfdrive/ui/ui.h"
@@ -32,14 +33,15 @@ static void ui_print(UIState *s, int x, int y,  const char* fmt, ... )
   va_start(args, fmt);
   vasprintf( &msg_buf, fmt, args);
   va_end(args);
-  nvgText(s->vg, x, y, msg_buf, NULL);
+  nvgTextCached(s->vg, x, y, msg_buf, NULL);
+  free(msg_buf);
 }
 
 static void ui_draw_text(const UIState *s, float x, float y, const char *string, float size, NVGcolor color, const char *font_name) {
   nvgFontFace(s->vg, font_name);
   nvgFontSize(s->vg, size);
   nvgFillColor(s->vg, color);
-  nvgText(s->vg, x, y, string, NULL);
+  nvgTextCached(s->vg, x, y, string, NULL);
 }
 
 // static void draw_chevron(UIState *s, float x, float y, float sz, NVGcolor fillColor, NVGcolor glowColor) {
@@ -94,11 +96,9 @@ static void ui_draw_circle_image(const UIState *s, int center_x, int center_y, i
   }
 }
 
-static void draw_lead(UIState *s, const cereal::ModelDataV2::LeadDataV3::Reader &lead_data, const vertex_data &vd) {
+static void draw_lead(UIState *s, float d_rel, const vertex_data &vd) {
   // Draw lead car indicator
   auto [x, y] = vd;
-
-  float d_rel = lead_data.getX()[0];
   // float v_rel = lead_data.getV()[0];
   // float speedBuff = 10.;
   // float leadBuff = 40.;  
@@ -146,6 +146,46 @@ static void draw_lead(UIState *s, const cereal::ModelDataV2::LeadDataV3::Reader
   }
 }
 
+static void lerp_line(const line_vertices_data &a, const line_vertices_data &b, float t, line_vertices_data *out) {
+  // a changed vertex count means the path length changed, blending point i
+  // of one polygon with point i of a differently-shaped one just wobbles
+  if (t >= 1.0f || a.cnt != b.cnt) {
+    *out = b;
+    return;
+  }
+  out->cnt = b.cnt;
+  for (int i = 0; i < b.cnt; i++) {
+    out->v[i].x = a.v[i].x + t * (b.v[i].x - a.v[i].x);
+    out->v[i].y = a.v[i].y + t * (b.v[i].y - a.v[i].y);
+  }
+}
+
+// The scene keeps the last two projected model geometries; blend them every
+// paint so the 20Hz model output doesn't step on the 60Hz display. Rendering
+// sits one model period behind, which interpolates instead of extrapolating.
+static void interpolate_scene_geometry(UIState *s) {
+  UIScene &scene = s->scene;
+  const model_geometry &prev = scene.model_geom[0], &cur = scene.model_geom[1];
+
+  float t = 1.0f;
+  if (prev.t > 0 && cur.t > prev.t) {
+    const double period = cur.t - prev.t;
+    t = std::clamp((nanos_since_boot() - period - prev.t) / period, 0.0, 1.0);
+  }
+
+  lerp_line(prev.track_vertices, cur.track_vertices, t, &scene.track_vertices);
+  for (int i = 0; i < std::size(scene.lane_line_vertices); i++) {
+    lerp_line(prev.lane_line_vertices[i], cur.lane_line_vertices[i], t, &scene.lane_line_vertices[i]);
+  }
+  for (int i = 0; i < std::size(scene.road_edge_vertices); i++) {
+    lerp_line(prev.road_edge_vertices[i], cur.road_edge_vertices[i], t, &scene.road_edge_vertices[i]);
+  }
+  for (int i = 0; i < std::size(scene.lead_vertices); i++) {
+    scene.lead_vertices[i].x = prev.lead_vertices[i].x + t * (cur.lead_vertices[i].x - prev.lead_vertices[i].x);
+    scene.lead_vertices[i].y = prev.lead_vertices[i].y + t * (cur.lead_vertices[i].y - prev.lead_vertices[i].y);
+  }
+}
+
 static void ui_draw_line(UIState *s, const line_vertices_data &vd, NVGcolor *color, NVGpaint *paint) {
   if (vd.cnt == 0) return;
 
@@ -223,19 +263,21 @@ static void ui_draw_vision_lane_lines(UIState *s) {
 static void ui_draw_world(UIState *s) {
   nvgScissor(s->vg, 0, 0, s->fb_w, s->fb_h);
 
+  interpolate_scene_geometry(s);
+
   // Draw lane edges and vision/mpc tracks
   ui_draw_vision_lane_lines(s);
 
   // Draw lead indicators if openpilot is handling longitudinal
   //if (s->scene.longitudinal_control) {
   if (true) {
-    auto lead_one = (*s->sm)["modelV2"].getModelV2().getLeadsV3()[0];
-    auto lead_two = (*s->sm)["modelV2"].getModelV2().getLeadsV3()[1];
-    if (lead_one.getProb() > .5) {
-      draw_lead(s, lead_one, s->scene.lead_vertices[0]);
+    // lead state is cached at model rate in update_leads
+    const UIScene &scene = s->scene;
+    if (scene.lead_probs[0] > .5) {
+      draw_lead(s, scene.lead_x[0], scene.lead_vertices[0]);
     }
-    if (lead_two.getProb() > .5 && (std::abs(lead_one.getX()[0] - lead_two.getX()[0]) > 3.0)) {
-      draw_lead(s, lead_two, s->scene.lead_vertices[1]);
+    if (scene.lead_probs[1] > .5 && (std::abs(scene.lead_x[0] - scene.lead_x[1]) > 3.0)) {
+      draw_lead(s, scene.lead_x[1], scene.lead_vertices[1]);
     }
   }
   nvgResetScissor(s->vg);
@@ -342,13 +384,66 @@ static void ui_draw_standstill(UIState *s) {
   }
 }
 
+// debug overlay text, re-formatted only when a source message updates
+struct DebugTextItem {
+  int x, y, font_size;
+  std::string text;
+};
+
+static void debug_text(std::vector<DebugTextItem> &items, int x, int y, int font_size, const char *fmt, ...) {
+  char *msg_buf = NULL;
+  va_list args;
+  va_start(args, fmt);
+  vasprintf(&msg_buf, fmt, args);
+  va_end(args);
+  items.push_back({x, y, font_size, msg_buf});
+  free(msg_buf);
+}
+
+static void ui_build_debug(UIState *s, std::vector<DebugTextItem> &items) {
+  const UIScene &scene = s->scene;
+
+  int ui_viz_rx = bdr_s + 190;
+  int ui_viz_ry = bdr_s;
+  int fs = scene.mapbox_running ? 40 : 50;
+
+  items.clear();
+  debug_text(items, ui_viz_rx, ui_viz_ry+240, fs, "SR:%.2f", scene.liveParams.steerRatio);
+  debug_text(items, ui_viz_rx, ui_viz_ry+280, fs, "AA:%.2f", scene.liveParams.angleOffsetAverage);
+  debug_text(items, ui_viz_rx, ui_viz_ry+320, fs, "SF:%.2f", scene.liveParams.stiffnessFactor);
+
+  debug_text(items, ui_viz_rx, ui_viz_ry+360, fs, "AD:%.2f", scene.steer_actuator_delay);
+  debug_text(items, ui_viz_rx, ui_viz_ry+400, fs, "SC:%.2f", scene.lateralPlan.steerRateCost);
+  debug_text(items, ui_viz_rx, ui_viz_ry+440, fs, "OS:%.2f", abs(scene.output_scale));
+  debug_text(items, ui_viz_rx, ui_viz_ry+480, fs, "%.2f|%.2f", scene.lateralPlan.lProb, scene.lateralPlan.rProb);
+  const std::string stateStrings[] = {"disabled", "preEnabled", "enabled", "softDisabling"};
+  debug_text(items, ui_viz_rx, ui_viz_ry+520, fs, "%s", stateStrings[(int)(*s->sm)["controlsState"].getControlsState().getState()].c_str());
+  if (scene.map_is_running) {
+    if (scene.liveNaviData.opkrspeedsign) debug_text(items, ui_viz_rx, ui_viz_ry+560, fs, "SS:%d", scene.liveNaviData.opkrspeedsign);
+    if (scene.liveNaviData.opkrspeedlimit) debug_text(items, ui_viz_rx, ui_viz_ry+600, fs, "SL:%d", scene.liveNaviData.opkrspeedlimit);
+    if (scene.liveNaviData.opkrspeedlimitdist) debug_text(items, ui_viz_rx, ui_viz_ry+640, fs, "DS:%.0f", scene.liveNaviData.opkrspeedlimitdist);
+    if (scene.liveNaviData.opkrturninfo) debug_text(items, ui_viz_rx, ui_viz_ry+680, fs, "TI:%d", scene.liveNaviData.opkrturninfo);
+    if (scene.liveNaviData.opkrdisttoturn) debug_text(items, ui_viz_rx, ui_viz_ry+720, fs, "DT:%.0f", scene.liveNaviData.opkrdisttoturn);
+  } else if (!scene.map_is_running && (*s->sm)["carState"].getCarState().getSafetySign() > 19) {
+    debug_text(items, ui_viz_rx, ui_viz_ry+560, fs, "SL:%.0f", (*s->sm)["carState"].getCarState().getSafetySign());
+    debug_text(items, ui_viz_rx, ui_viz_ry+600, fs, "DS:%.0f", (*s->sm)["carState"].getCarState().getSafetyDist());
+  }
+  int col2_x = ui_viz_rx + (scene.mapbox_running ? 150 : 200);
+  debug_text(items, col2_x, ui_viz_ry+360, fs, "SL:%.0f", scene.liveMapData.ospeedLimit);
+  debug_text(items, col2_x, ui_viz_ry+400, fs, "SLA:%.0f", scene.liveMapData.ospeedLimitAhead);
+  debug_text(items, col2_x, ui_viz_ry+440, fs, "SLAD:%.0f", scene.liveMapData.ospeedLimitAheadDistance);
+  debug_text(items, col2_x, ui_viz_ry+480, fs, "TSL:%.0f", scene.liveMapData.oturnSpeedLimit);
+  debug_text(items, col2_x, ui_viz_ry+520, fs, "TSLED:%.0f", scene.liveMapData.oturnSpeedLimitEndDistance);
+  debug_text(items, col2_x, ui_viz_ry+560, fs, "TSLS:%d", scene.liveMapData.oturnSpeedLimitSign);
+}
+
 static void ui_draw_debug(UIState *s) {
   const UIScene &scene = s->scene;
 
   int ui_viz_rx = bdr_s + 190;
   int ui_viz_ry = bdr_s;
   int ui_viz_rx_center = s->fb_w/2;
-  
+
   nvgTextAlign(s->vg, NVG_ALIGN_MIDDLE | NVG_ALIGN_MIDDLE);
 
   if (scene.nDebugUi1 & !scene.mapbox_running) {
@@ -356,47 +451,21 @@ static void ui_draw_debug(UIState *s) {
     ui_draw_text(s, ui_viz_rx, ui_viz_ry+860+(scene.mapbox_running ? 3:0), scene.alertTextMsg2.c_str(), scene.mapbox_running?34:45, COLOR_WHITE_ALPHA(125), "sans-semibold");
   }
 
-  
   nvgFillColor(s->vg, COLOR_WHITE_ALPHA(130));
   if (scene.nDebugUi2 & !scene.mapbox_running) {
-    //if (scene.gpsAccuracyUblox != 0.00) {
-    //  nvgFontSize(s->vg, 34);
-    //  ui_print(s, 28, 28, "LAT／LON: %.5f／%.5f", scene.latitudeUblox, scene.longitudeUblox);
-    //}
-    if (scene.mapbox_running) {
-      nvgFontSize(s->vg, 40);
-    } else {
-      nvgFontSize(s->vg, 50);
+    // the source fields only change at message rate (2-20Hz), so keep the
+    // formatted strings until one of their channels updates; rendering goes
+    // through the layout cache, so unchanged strings cost no shaping either
+    static std::vector<DebugTextItem> items;
+    const SubMaster &sm = *(s->sm);
+    if (items.empty() || sm.updated("liveParameters") || sm.updated("lateralPlan") || sm.updated("controlsState") ||
+        sm.updated("carState") || sm.updated("liveNaviData") || sm.updated("liveMapData") || sm.updated("carParams")) {
+      ui_build_debug(s, items);
     }
-    //ui_print(s, ui_viz_rx, ui_viz_ry, "Live Parameters");
-    ui_print(s, ui_viz_rx, ui_viz_ry+240, "SR:%.2f", scene.liveParams.steerRatio);
-    //ui_print(s, ui_viz_rx, ui_viz_ry+100, "AOfs:%.2f", scene.liveParams.angleOffset);
-    ui_print(s, ui_viz_rx, ui_viz_ry+280, "AA:%.2f", scene.liveParams.angleOffsetAverage);
-    ui_print(s, ui_viz_rx, ui_viz_ry+320, "SF:%.2f", scene.liveParams.stiffnessFactor);
-
-    ui_print(s, ui_viz_rx, ui_viz_ry+360, "AD:%.2f", scene.steer_actuator_delay);
-    ui_print(s, ui_viz_rx, ui_viz_ry+400, "SC:%.2f", scene.lateralPlan.steerRateCost);
-    ui_print(s, ui_viz_rx, ui_viz_ry+440, "OS:%.2f", abs(scene.output_scale));
-    ui_print(s, ui_viz_rx, ui_viz_ry+480, "%.2f|%.2f", scene.lateralPlan.lProb, scene.lateralPlan.rProb);
-    const std::string stateStrings[] = {"disabled", "preEnabled", "enabled", "softDisabling"};
-    ui_print(s, ui_viz_rx, ui_viz_ry+520, "%s", stateStrings[(int)(*s->sm)["controlsState"].getControlsState().getState()].c_str());
-    //ui_print(s, ui_viz_rx, ui_viz_ry+800, "A:%.5f", scene.accel_sensor2);
-    if (scene.map_is_running) {
-      if (scene.liveNaviData.opkrspeedsign) ui_print(s, ui_viz_rx, ui_viz_ry+560, "SS:%d", scene.liveNaviData.opkrspeedsign);
-      if (scene.liveNaviData.opkrspeedlimit) ui_print(s, ui_viz_rx, ui_viz_ry+600, "SL:%d", scene.liveNaviData.opkrspeedlimit);
-      if (scene.liveNaviData.opkrspeedlimitdist) ui_print(s, ui_viz_rx, ui_viz_ry+640, "DS:%.0f", scene.liveNaviData.opkrspeedlimitdist);
-      if (scene.liveNaviData.opkrturninfo) ui_print(s, ui_viz_rx, ui_viz_ry+680, "TI:%d", scene.liveNaviData.opkrturninfo);
-      if (scene.liveNaviData.opkrdisttoturn) ui_print(s, ui_viz_rx, ui_viz_ry+720, "DT:%.0f", scene.liveNaviData.opkrdisttoturn);
-    } else if (!scene.map_is_running && (*s->sm)["carState"].getCarState().getSafetySign() > 19) {
-      ui_print(s, ui_viz_rx, ui_viz_ry+560, "SL:%.0f", (*s->sm)["carState"].getCarState().getSafetySign());
-      ui_print(s, ui_viz_rx, ui_viz_ry+600, "DS:%.0f", (*s->sm)["carState"].getCarState().getSafetyDist());
+    for (const DebugTextItem &item : items) {
+      nvgFontSize(s->vg, item.font_size);
+      nvgTextCached(s->vg, item.x, item.y, item.text.c_str(), NULL);
     }
-    ui_print(s, ui_viz_rx+(scene.mapbox_running ? 150:200), ui_viz_ry+360, "SL:%.0f", scene.liveMapData.ospeedLimit);
-    ui_print(s, ui_viz_rx+(scene.mapbox_running ? 150:200), ui_viz_ry+400, "SLA:%.0f", scene.liveMapData.ospeedLimitAhead);
-    ui_print(s, ui_viz_rx+(scene.mapbox_running ? 150:200), ui_viz_ry+440, "SLAD:%.0f", scene.liveMapData.ospeedLimitAheadDistance);
-    ui_print(s, ui_viz_rx+(scene.mapbox_running ? 150:200), ui_viz_ry+480, "TSL:%.0f", scene.liveMapData.oturnSpeedLimit);
-    ui_print(s, ui_viz_rx+(scene.mapbox_running ? 150:200), ui_viz_ry+520, "TSLED:%.0f", scene.liveMapData.oturnSpeedLimitEndDistance);
-    ui_print(s, ui_viz_rx+(scene.mapbox_running ? 150:200), ui_viz_ry+560, "TSLS:%d", scene.liveMapData.oturnSpeedLimitSign);
     nvgFontSize(s->vg, 50);
     nvgTextAlign(s->vg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
     if (scene.lateralControlMethod == 0) {
@@ -1494,11 +1563,47 @@ void ui_draw(UIState *s, int w, int h) {
   // Update intrinsics matrix after possible wide camera toggle change
   if (s->fb_w != w || s->fb_h != h) {
     ui_resize(s, w, h);
+    if (s->hud_fb) {
+      nvgluDeleteFramebuffer(s->hud_fb);
+      s->hud_fb = nullptr;
+    }
   }
+  if (!s->hud_fb) {
+    s->hud_fb = nvgluCreateFramebuffer(s->vg, s->fb_w, s->fb_h, NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED);
+    s->hud_valid = false;
+  }
+
+  // re-render the HUD layer only when new SubMaster data arrived; paints in
+  // between composite the cached layer instead of re-issuing every widget
+  if (s->hud_fb && (!s->hud_valid || s->hud_frame != s->sm->frame)) {
+    GLint prev_fbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+    nvgluBindFramebuffer(s->hud_fb);
+    glViewport(0, 0, s->fb_w, s->fb_h);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    nvgBeginFrame(s->vg, s->fb_w, s->fb_h, 1.0f);
+    ui_draw_vision(s);
+    nvgEndFrame(s->vg);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
+    s->hud_frame = s->sm->frame;
+    s->hud_valid = true;
+  }
+
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   nvgBeginFrame(s->vg, s->fb_w, s->fb_h, 1.0f);
-  ui_draw_vision(s);
+  if (s->hud_fb) {
+    nvgBeginPath(s->vg);
+    NVGpaint hud = nvgImagePattern(s->vg, 0, 0, s->fb_w, s->fb_h, 0, s->hud_fb->image, 1.0f);
+    nvgRect(s->vg, 0, 0, s->fb_w, s->fb_h);
+    nvgFillPaint(s->vg, hud);
+    nvgFill(s->vg);
+  } else {
+    ui_draw_vision(s);
+  }
   dashcam(s);
   nvgEndFrame(s->vg);
   glDisable(GL_BLEND);
@@ -1550,6 +1655,25 @@ void ui_nvg_init(UIState *s) {
     assert(font_id >= 0);
   }
 
+  // pre-rasterize the glyph atlas for every face/size the UI draws so the
+  // fontstash work and texture uploads happen here instead of hitching the
+  // first frames. drawn inside a cancelled frame: glyph bitmaps are flushed
+  // to the GL atlas texture during nvgText() itself, only the (offscreen)
+  // draw calls are dropped.
+  static const int font_sizes[] = {37, 40, 45, 50, 54, 55, 75, 80, 100, 120, 125, 150, 160, 170, 200};
+  static const char glyphs[] = " !\"#$%&'()*+,-./0123456789:;<=>?@"
+                               "ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+                               "abcdefghijklmnopqrstuvwxyz{|}~";
+  nvgBeginFrame(s->vg, 1920, 1080, 1.0f);
+  for (auto [name, file] : fonts) {
+    nvgFontFace(s->vg, name);
+    for (int size : font_sizes) {
+      nvgFontSize(s->vg, size);
+      nvgText(s->vg, 0, 0, glyphs, nullptr);
+    }
+  }
+  nvgCancelFrame(s->vg);
+
   // init images
   std::vector<std::pair<const char *, const char *>> images = {
     {"wheel", "../assets/img_chffr_wheel.png"},
@@ -9,6 +9,7 @@
 #include <QDebug>
 #include <QFile>
 #include <QJsonDocument>
+#include <QNetworkAccessManager>
 #include <QNetworkRequest>
 
 #include "selfdrive/common/params.h"
@@ -61,9 +62,17 @@ QString create_jwt(const QJsonObject &payloads, int expiry) {
 
 }  // namespace CommaApi
 
-HttpRequest::HttpRequest(QObject *parent, bool create_jwt, int timeout) : create_jwt(create_jwt), QObject(parent) {
-  networkAccessManager = new QNetworkAccessManager(this);
+QNetworkAccessManager *HttpRequest::nam() {
+  static QNetworkAccessManager *networkAccessManager = new QNetworkAccessManager();
+  return networkAccessManager;
+}
+
+void HttpRequest::prewarm(const QString &url) {
+  QUrl u(url);
+  nam()->connectToHostEncrypted(u.host(), u.port(443));
+}
 
+HttpRequest::HttpRequest(QObject *parent, bool create_jwt, int timeout) : create_jwt(create_jwt), QObject(parent) {
   networkTimer = new QTimer(this);
   networkTimer->setSingleShot(true);
   networkTimer->setInterval(timeout);
@@ -95,10 +104,14 @@ void HttpRequest::sendRequest(const QString &requestURL, const HttpRequest::Meth
     request.setRawHeader(QByteArray("Authorization"), ("JWT " + token).toUtf8());
   }
 
+  if (!etag.isEmpty()) {
+    request.setRawHeader(QByteArray("If-None-Match"), etag.toUtf8());
+  }
+
   if (method == HttpRequest::Method::GET) {
-    reply = networkAccessManager->get(request);
+    reply = nam()->get(request);
   } else if (method == HttpRequest::Method::DELETE) {
-    reply = networkAccessManager->deleteResource(request);
+    reply = nam()->deleteResource(request);
   }
 
   networkTimer->start();
@@ -116,8 +129,14 @@ void HttpRequest::requestFinished() {
     networkTimer->stop();
     QString response = reply->readAll();
 
-    if (reply->error() == QNetworkReply::NoError) {
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 304) {
+      // Not Modified: the consumer's parsed state is still current
+      success = true;
+      emit responseUnchanged();
+    } else if (reply->error() == QNetworkReply::NoError) {
       success = true;
+      etag = QString::fromUtf8(reply->rawHeader("ETag"));
       emit receivedResponse(response);
     } else {
       emit failedResponse(reply->errorString());
@@ -127,8 +146,8 @@ void HttpRequest::requestFinished() {
       }
     }
   } else {
-    networkAccessManager->clearAccessCache();
-    networkAccessManager->clearConnectionCache();
+    nam()->clearAccessCache();
+    nam()->clearConnectionCache();
     emit timeoutResponse("timeout");
   }
   emit requestDone(success);
@@ -31,13 +31,22 @@ public:
   void sendRequest(const QString &requestURL, const Method method = Method::GET);
   bool active();
 
+  // network manager shared by all requests, so pre-warmed keep-alive
+  // connections are reused instead of paying a TLS handshake per request
+  static QNetworkAccessManager *nam();
+  // kick off async DNS + TLS handshake to a host ahead of its first request.
+  // Fully non-blocking: a dead link just leaves the connection cache cold.
+  static void prewarm(const QString &url);
+
 protected:
   QNetworkReply *reply = nullptr;
 
 private:
-  QNetworkAccessManager *networkAccessManager = nullptr;
   QTimer *networkTimer = nullptr;
   bool create_jwt;
+  // last ETag seen per URL; sent back as If-None-Match so an unchanged
+  // payload costs one header exchange and no body download or JSON parsing
+  QString etag;
 
 private slots:
   void requestTimeout();
@@ -46,6 +55,8 @@ private slots:
 signals:
   void requestDone(bool success);
   void receivedResponse(const QString &response);
+  // 304 Not Modified: the cached response is still current, no body was sent
+  void responseUnchanged();
   void failedResponse(const QString &errorString);
   void timeoutResponse(const QString &errorString);
 };
@@ -498,7 +498,10 @@ void OffroadHome::hideEvent(QHideEvent *event) {
 }
 
 void OffroadHome::refresh() {
-  date->setText(QDateTime::currentDateTime().toString("dddd, MMMM d, hh:mm"));
+  const QString now = QDateTime::currentDateTime().toString("dddd, MMMM d, hh:mm");
+  if (date->text() != now) {
+    date->setText(now);  // setText repaints even when the text is identical
+  }
 
   bool updateAvailable = update_widget->refresh();
   int alerts = alerts_widget->refresh();
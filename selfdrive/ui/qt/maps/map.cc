@@ -73,6 +73,10 @@ MapWindow::MapWindow(const QMapboxGLSettings &settings) :
     last_position = *last_gps_position;
   }
 
+  // Route corridor tile prefetch into the shared ambient cache
+  prefetcher = new MapTilePrefetcher(m_settings.cacheDatabasePath(), MAPS_HOST,
+                                     m_settings.accessToken(), m_settings.cacheDatabaseMaximumSize(), this);
+
   grabGesture(Qt::GestureType::PinchGesture);
 }
 
@@ -367,15 +371,25 @@ void MapWindow::routeCalculated(QGeoRouteReply *reply) {
       route = reply->routes().at(0);
       segment = route.firstRouteSegment();
 
-      auto route_points = coordinate_list_to_collection(route.path());
-      QMapbox::Feature feature(QMapbox::Feature::LineStringType, route_points, {}, {});
-      QVariantMap navSource;
-      navSource["type"] = "geojson";
-      navSource["data"] = QVariant::fromValue<QMapbox::Feature>(feature);
-      m_map->updateSource("navSource", navSource);
+      // only push geometry through QMapbox when the line actually changed;
+      // recalculations that land on the same road otherwise rebuild the
+      // full polyline annotation for nothing
+      auto path = simplify_geometry(route.path(), 2.0);
+      if (path != last_route_path) {
+        last_route_path = path;
+        auto route_points = coordinate_list_to_collection(path);
+        QMapbox::Feature feature(QMapbox::Feature::LineStringType, route_points, {}, {});
+        QVariantMap navSource;
+        navSource["type"] = "geojson";
+        navSource["data"] = QVariant::fromValue<QMapbox::Feature>(feature);
+        m_map->updateSource("navSource", navSource);
+      }
       m_map->setLayoutProperty("navLayer", "visibility", "visible");
       got_route = true;
 
+      // warm the tile cache for the corridor ahead of the car
+      prefetcher->updateRoute(route.path());
+
       updateETA();
     } else {
       qWarning() << "Got empty route response";
@@ -394,6 +408,7 @@ void MapWindow::routeCalculated(QGeoRouteReply *reply) {
 void MapWindow::clearRoute() {
   segment = QGeoRouteSegment();
   nav_destination = QMapbox::Coordinate();
+  last_route_path.clear();
 
   if (!m_map.isNull()) {
     m_map->setLayoutProperty("navLayer", "visibility", "none");
@@ -497,6 +512,11 @@ void MapWindow::offroadTransition(bool offroad) {
   if (!offroad) {
     auto dest = coordinate_from_param("NavDestination");
     setVisible(dest.has_value());
+    if (dest.has_value()) {
+      // resolve the tile/directions host and hold a keep-alive connection
+      // before the first fetch, instead of stalling it on DNS + TLS
+      HttpRequest::prewarm(MAPS_HOST);
+    }
   }
   last_bearing = {};
 }
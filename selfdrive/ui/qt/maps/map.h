@@ -25,6 +25,7 @@
 
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/util.h"
+#include "selfdrive/ui/qt/maps/map_prefetch.h"
 #include "cereal/messaging/messaging.h"
 
 //const QString MAPBOX_TOKEN = util::getenv("MAPBOX_TOKEN").c_str();
@@ -100,6 +101,7 @@ private:
   bool m_sourceAdded = false;
   SubMaster *sm;
   QTimer* timer;
+  MapTilePrefetcher *prefetcher;
 
   bool loaded_once = false;
 
@@ -117,6 +119,7 @@ private:
   // Route
   bool allow_open = true;
   bool gps_ok = false;
+  QList<QGeoCoordinate> last_route_path;
   QGeoServiceProvider *geoservice_provider;
   QGeoRoutingManager *routing_manager;
   QGeoRoute route;
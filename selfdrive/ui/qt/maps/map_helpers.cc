@@ -90,6 +90,40 @@ float minimum_distance(QGeoCoordinate a, QGeoCoordinate b, QGeoCoordinate p) {
   return projection.distanceTo(p);
 }
 
+QList<QGeoCoordinate> simplify_geometry(const QList<QGeoCoordinate> &geometry, double epsilon) {
+  if (geometry.size() < 3) return geometry;
+
+  // iterative Douglas-Peucker: keep the endpoints, recurse on the point
+  // farthest from the chord whenever it deviates by more than epsilon
+  std::vector<bool> keep(geometry.size(), false);
+  keep.front() = keep.back() = true;
+  std::vector<std::pair<int, int>> stack = {{0, (int)geometry.size() - 1}};
+  while (!stack.empty()) {
+    auto [first, last] = stack.back();
+    stack.pop_back();
+    double max_d = 0;
+    int max_i = first;
+    for (int i = first + 1; i < last; i++) {
+      double d = minimum_distance(geometry[first], geometry[last], geometry[i]);
+      if (d > max_d) {
+        max_d = d;
+        max_i = i;
+      }
+    }
+    if (max_d > epsilon) {
+      keep[max_i] = true;
+      stack.push_back({first, max_i});
+      stack.push_back({max_i, last});
+    }
+  }
+
+  QList<QGeoCoordinate> out;
+  for (int i = 0; i < geometry.size(); i++) {
+    if (keep[i]) out.push_back(geometry[i]);
+  }
+  return out;
+}
+
 float distance_along_geometry(QList<QGeoCoordinate> geometry, QGeoCoordinate pos) {
   if (geometry.size() <= 2) {
     return geometry[0].distanceTo(pos);
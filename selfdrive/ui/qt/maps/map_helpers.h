@@ -22,5 +22,8 @@ QMapbox::CoordinatesCollections coordinate_to_collection(QMapbox::Coordinate c);
 QMapbox::CoordinatesCollections coordinate_list_to_collection(QList<QGeoCoordinate> coordinate_list);
 
 float minimum_distance(QGeoCoordinate a, QGeoCoordinate b, QGeoCoordinate p);
+// Douglas-Peucker polyline decimation; epsilon in meters. An epsilon below
+// one pixel at the deepest driving zoom is visually lossless.
+QList<QGeoCoordinate> simplify_geometry(const QList<QGeoCoordinate> &geometry, double epsilon);
 std::optional<QMapbox::Coordinate> coordinate_from_param(std::string param);
 float distance_along_geometry(QList<QGeoCoordinate> geometry, QGeoCoordinate pos);
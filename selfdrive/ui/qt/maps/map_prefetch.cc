@@ -0,0 +1,185 @@
+#include "selfdrive/ui/qt/maps/map_prefetch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QDebug>
+#include <QNetworkRequest>
+#include <sqlite3.h>
+
+// the two zoom levels the map actually drives at: MIN_ZOOM at speed and the
+// source maxzoom (the engine overzooms past it, so deeper tiles don't exist)
+const int PREFETCH_ZOOMS[] = {14, 16};
+const int MAX_PENDING_TILES = 512;
+const int MAX_INFLIGHT = 4;
+
+static std::pair<int, int> tile_for(const QGeoCoordinate &c, int z) {
+  double lat_rad = c.latitude() * M_PI / 180.0;
+  int n = 1 << z;
+  int x = (int)((c.longitude() + 180.0) / 360.0 * n);
+  int y = (int)((1.0 - std::asinh(std::tan(lat_rad)) / M_PI) / 2.0 * n);
+  return {std::clamp(x, 0, n - 1), std::clamp(y, 0, n - 1)};
+}
+
+MapTilePrefetcher::MapTilePrefetcher(const QString &db_path, const QString &maps_host,
+                                     const QString &token, uint64_t max_cache_bytes, QObject *parent)
+    : QObject(parent), db_path_(db_path), maps_host_(maps_host), token_(token), max_cache_bytes_(max_cache_bytes) {
+  nam_ = new QNetworkAccessManager(this);
+  timer_ = new QTimer(this);
+  QObject::connect(timer_, &QTimer::timeout, this, &MapTilePrefetcher::step);
+}
+
+MapTilePrefetcher::~MapTilePrefetcher() {
+  if (db_ != nullptr) {
+    sqlite3_close(db_);
+  }
+}
+
+bool MapTilePrefetcher::openDb() {
+  if (db_ != nullptr) return true;
+  if (sqlite3_open(db_path_.toStdString().c_str(), &db_) != SQLITE_OK) {
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+  // the map engine writes to this database too; back off instead of failing
+  sqlite3_busy_timeout(db_, 100);
+  return true;
+}
+
+void MapTilePrefetcher::updateRoute(const QList<QGeoCoordinate> &path) {
+  if (!openDb()) return;
+
+  // templates the engine has cached tiles under; empty until the map has
+  // loaded its style at least once
+  std::vector<std::pair<QString, int>> templates;
+  sqlite3_stmt *stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, "SELECT DISTINCT url_template, pixel_ratio FROM tiles", -1, &stmt, nullptr) != SQLITE_OK) {
+    return;
+  }
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    templates.emplace_back(QString::fromUtf8((const char *)sqlite3_column_text(stmt, 0)), sqlite3_column_int(stmt, 1));
+  }
+  sqlite3_finalize(stmt);
+  if (templates.empty()) return;
+
+  // 3x3 tile neighborhood around every route point covers the corridor
+  std::set<Tile> wanted;
+  for (auto &[tmpl, ratio] : templates) {
+    for (int z : PREFETCH_ZOOMS) {
+      for (const QGeoCoordinate &c : path) {
+        auto [x, y] = tile_for(c, z);
+        int n = 1 << z;
+        for (int dx = -1; dx <= 1; dx++) {
+          for (int dy = -1; dy <= 1; dy++) {
+            if (y + dy < 0 || y + dy >= n) continue;
+            wanted.insert(Tile{tmpl, ratio, z, (x + dx + n) % n, y + dy});
+          }
+        }
+      }
+    }
+  }
+
+  pending_.clear();
+  for (const Tile &t : wanted) {
+    if (!haveTile(t)) {
+      pending_.push_back(t);
+      if (pending_.size() >= MAX_PENDING_TILES) break;
+    }
+  }
+  if (!pending_.empty()) {
+    timer_->start(250);
+  }
+}
+
+QString MapTilePrefetcher::tileUrl(const Tile &t) const {
+  QString url = t.url_template;
+  // mbgl stores mapbox tiles under the canonical scheme
+  if (url.startsWith("mapbox://tiles/")) {
+    url = maps_host_ + "/v4/" + url.mid(strlen("mapbox://tiles/"));
+  }
+  url.replace("{z}", QString::number(t.z));
+  url.replace("{x}", QString::number(t.x));
+  url.replace("{y}", QString::number(t.y));
+  if (t.pixel_ratio > 1) {
+    url.replace("{ratio}", QString("@%1x").arg(t.pixel_ratio));
+  } else {
+    url.replace("{ratio}", "");
+  }
+  url += (url.contains('?') ? "&" : "?") + QString("access_token=") + token_;
+  return url;
+}
+
+void MapTilePrefetcher::step() {
+  if (pending_.empty() && inflight_ == 0) {
+    timer_->stop();
+    return;
+  }
+  while (!pending_.empty() && inflight_ < MAX_INFLIGHT) {
+    Tile t = pending_.back();
+    pending_.pop_back();
+    inflight_++;
+    QNetworkReply *reply = nam_->get(QNetworkRequest(QUrl(tileUrl(t))));
+    QObject::connect(reply, &QNetworkReply::finished, [this, t, reply]() {
+      inflight_--;
+      if (reply->error() == QNetworkReply::NoError) {
+        storeTile(t, reply->readAll());
+      }
+      reply->deleteLater();
+    });
+  }
+}
+
+bool MapTilePrefetcher::haveTile(const Tile &t) {
+  sqlite3_stmt *stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, "SELECT 1 FROM tiles WHERE url_template = ? AND pixel_ratio = ? AND z = ? AND x = ? AND y = ?",
+                         -1, &stmt, nullptr) != SQLITE_OK) {
+    return true;  // if we can't ask, don't fetch
+  }
+  sqlite3_bind_text(stmt, 1, t.url_template.toStdString().c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, t.pixel_ratio);
+  sqlite3_bind_int(stmt, 3, t.z);
+  sqlite3_bind_int(stmt, 4, t.x);
+  sqlite3_bind_int(stmt, 5, t.y);
+  bool have = sqlite3_step(stmt) == SQLITE_ROW;
+  sqlite3_finalize(stmt);
+  return have;
+}
+
+void MapTilePrefetcher::storeTile(const Tile &t, const QByteArray &data) {
+  // Qt already decoded the transfer encoding, so compressed = 0. a week of
+  // freshness; the engine revalidates with etags on its own fetches anyway
+  sqlite3_stmt *stmt = nullptr;
+  if (sqlite3_prepare_v2(db_,
+        "INSERT OR IGNORE INTO tiles (url_template, pixel_ratio, z, x, y, expires, modified, etag, data, compressed, accessed, must_revalidate) "
+        "VALUES (?, ?, ?, ?, ?, strftime('%s','now') + 604800, NULL, NULL, ?, 0, strftime('%s','now'), 0)",
+        -1, &stmt, nullptr) != SQLITE_OK) {
+    return;
+  }
+  sqlite3_bind_text(stmt, 1, t.url_template.toStdString().c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, t.pixel_ratio);
+  sqlite3_bind_int(stmt, 3, t.z);
+  sqlite3_bind_int(stmt, 4, t.x);
+  sqlite3_bind_int(stmt, 5, t.y);
+  sqlite3_bind_blob(stmt, 6, data.constData(), data.size(), SQLITE_TRANSIENT);
+  sqlite3_step(stmt);
+  sqlite3_finalize(stmt);
+
+  enforceCacheBound();
+}
+
+void MapTilePrefetcher::enforceCacheBound() {
+  // the engine enforces its cache budget on its own writes; mirror that for
+  // prefetched rows by evicting least-recently-accessed tiles past the bound
+  sqlite3_stmt *stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, "SELECT SUM(LENGTH(data)) FROM tiles", -1, &stmt, nullptr) != SQLITE_OK) {
+    return;
+  }
+  uint64_t total = (sqlite3_step(stmt) == SQLITE_ROW) ? (uint64_t)sqlite3_column_int64(stmt, 0) : 0;
+  sqlite3_finalize(stmt);
+
+  if (total > max_cache_bytes_) {
+    sqlite3_exec(db_, "DELETE FROM tiles WHERE id IN (SELECT id FROM tiles ORDER BY accessed ASC LIMIT 50)", nullptr, nullptr, nullptr);
+  }
+}
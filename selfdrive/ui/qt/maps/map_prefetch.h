@@ -0,0 +1,58 @@
+#pragma once
+
+#include <set>
+#include <vector>
+
+#include <QGeoCoordinate>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QString>
+#include <QTimer>
+
+struct sqlite3;
+
+// Prefetches map tiles for the corridor along the active route into the
+// Mapbox GL ambient cache database, so driving into a new area renders from
+// disk instead of stuttering on LTE fetches at pan time. The tile URL
+// templates are learned from rows the map engine itself has written, which
+// keeps the prefetcher in lockstep with whatever style/sources are in use;
+// on a completely cold cache it stays idle until the map has run once.
+// MapWindow::initializeGL already renders from this database before the
+// network is up, so prefetched corridors warm-start the map.
+class MapTilePrefetcher : public QObject {
+  Q_OBJECT
+
+public:
+  MapTilePrefetcher(const QString &db_path, const QString &maps_host,
+                    const QString &token, uint64_t max_cache_bytes, QObject *parent = nullptr);
+  ~MapTilePrefetcher();
+
+public slots:
+  void updateRoute(const QList<QGeoCoordinate> &path);
+
+private slots:
+  void step();
+
+private:
+  struct Tile {
+    QString url_template;
+    int pixel_ratio, z, x, y;
+    bool operator<(const Tile &o) const {
+      return std::tie(url_template, pixel_ratio, z, x, y) < std::tie(o.url_template, o.pixel_ratio, o.z, o.x, o.y);
+    }
+  };
+
+  bool openDb();
+  bool haveTile(const Tile &t);
+  void storeTile(const Tile &t, const QByteArray &data);
+  void enforceCacheBound();
+  QString tileUrl(const Tile &t) const;
+
+  QString db_path_, maps_host_, token_;
+  uint64_t max_cache_bytes_;
+  sqlite3 *db_ = nullptr;
+  QNetworkAccessManager *nam_;
+  QTimer *timer_;
+  std::vector<Tile> pending_;
+  int inflight_ = 0;
+};
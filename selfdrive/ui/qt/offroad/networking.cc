@@ -322,7 +322,7 @@ void WifiUI::refresh() {
 
     // Strength indicator
     QLabel *strength = new QLabel();
-    strength->setPixmap(strengths[std::clamp((int)round(network.strength / 33.), 0, 3)]);
+    strength->setPixmap(strengths[strength_bar(network.strength)]);
     hlayout->addWidget(strength, 0, Qt::AlignRight);
 
     list->addItem(hlayout);
@@ -1,6 +1,7 @@
 #include "selfdrive/ui/qt/offroad/settings.h"
 
 #include <cassert>
+#include <functional>
 #include <string>
 
 #include <QDebug>
@@ -634,6 +635,36 @@ TuningPanel::TuningPanel(QWidget *parent) : QFrame(parent) {
   layout->addWidget(new E2ELongToggle());
 }
 
+// Defers construction of a settings panel until it is first shown. The panel
+// content comes from a factory and gets wrapped in a ScrollView; only the
+// Device panel pays its construction cost when settings open.
+class LazyPanel : public QWidget {
+public:
+  LazyPanel(const QString &name, std::function<QWidget *()> factory, QWidget *parent) : QWidget(parent), factory_(factory) {
+    layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    const int lr_margin = name != "Network" ? 50 : 0;  // Network panel handles its own margins
+    margins = QMargins(lr_margin, 25, lr_margin, 25);
+  }
+
+protected:
+  void showEvent(QShowEvent *event) override {
+    if (factory_) {
+      QWidget *panel = factory_();
+      factory_ = nullptr;
+      panel->setContentsMargins(margins);
+      layout->addWidget(new ScrollView(panel, this));
+    }
+    QWidget::showEvent(event);
+  }
+
+private:
+  std::function<QWidget *()> factory_;
+  QVBoxLayout *layout;
+  QMargins margins;
+};
+
 void SettingsWindow::showEvent(QShowEvent *event) {
   panel_widget->setCurrentIndex(0);
   nav_btns->buttons()[0]->setChecked(true);
@@ -672,28 +703,35 @@ SettingsWindow::SettingsWindow(QWidget *parent) : QFrame(parent) {
   sidebar_layout->addWidget(close_btn, 0, Qt::AlignCenter);
   QObject::connect(close_btn, &QPushButton::clicked, this, &SettingsWindow::closeSettings);
 
-  // setup panels
-  DevicePanel *device = new DevicePanel(this);
-  UserPanel *user = new UserPanel(this);
-  QObject::connect(device, &DevicePanel::reviewTrainingGuide, this, &SettingsWindow::reviewTrainingGuide);
-  QObject::connect(device, &DevicePanel::showDriverView, this, &SettingsWindow::showDriverView);
-  QObject::connect(user, &UserPanel::closeSettings, this, &SettingsWindow::closeSettings);
-
-  QList<QPair<QString, QWidget *>> panels = {
-    {"Device", device},
-    {"Network", network_panel(this)},
-    {"Toggles", new TogglesPanel(this)},
-    {"Software", new SoftwarePanel(this)},
-    {"UserMenu", user},
-    {"Tuning", new TuningPanel(this)},
+  // setup panels. built lazily on first open: constructing every control
+  // up front (hundreds of ParamControls across the OPKR menus, each reading
+  // params) is what made opening settings take seconds on device
+  QList<QPair<QString, std::function<QWidget *()>>> panels = {
+    {"Device", [=]() -> QWidget * {
+      DevicePanel *device = new DevicePanel(this);
+      QObject::connect(device, &DevicePanel::reviewTrainingGuide, this, &SettingsWindow::reviewTrainingGuide);
+      QObject::connect(device, &DevicePanel::showDriverView, this, &SettingsWindow::showDriverView);
+      return device;
+    }},
+    {"Network", [=]() -> QWidget * { return network_panel(this); }},
+    {"Toggles", [=]() -> QWidget * { return new TogglesPanel(this); }},
+    {"Software", [=]() -> QWidget * { return new SoftwarePanel(this); }},
+    {"UserMenu", [=]() -> QWidget * {
+      UserPanel *user = new UserPanel(this);
+      QObject::connect(user, &UserPanel::closeSettings, this, &SettingsWindow::closeSettings);
+      return user;
+    }},
+    {"Tuning", [=]() -> QWidget * { return new TuningPanel(this); }},
   };
 
   sidebar_layout->addSpacing(35);
 
 #ifdef ENABLE_MAPS
-  auto map_panel = new MapPanel(this);
-  panels.push_back({"Navigation", map_panel});
-  QObject::connect(map_panel, &MapPanel::closeSettings, this, &SettingsWindow::closeSettings);
+  panels.push_back({"Navigation", [=]() -> QWidget * {
+    auto map_panel = new MapPanel(this);
+    QObject::connect(map_panel, &MapPanel::closeSettings, this, &SettingsWindow::closeSettings);
+    return map_panel;
+  }});
 #endif
 
   const int padding = panels.size() > 3 ? 8 : 18;
@@ -724,10 +762,7 @@ SettingsWindow::SettingsWindow(QWidget *parent) : QFrame(parent) {
     nav_btns->addButton(btn);
     sidebar_layout->addWidget(btn, 0, Qt::AlignRight);
 
-    const int lr_margin = name != "Network" ? 50 : 0;  // Network panel handles its own margins
-    panel->setContentsMargins(lr_margin, 25, lr_margin, 25);
-
-    ScrollView *panel_frame = new ScrollView(panel, this);
+    LazyPanel *panel_frame = new LazyPanel(name, panel, this);
     panel_widget->addWidget(panel_frame);
 
     QObject::connect(btn, &QPushButton::clicked, [=, w = panel_frame]() {
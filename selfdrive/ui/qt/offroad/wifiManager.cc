@@ -1,6 +1,7 @@
 #include "selfdrive/ui/qt/offroad/wifiManager.h"
 
 #include <algorithm>
+#include <cmath>
 #include <set>
 #include <cstdlib>
 
@@ -29,6 +30,10 @@ bool compare_by_strength(const Network &a, const Network &b) {
   return a.strength > b.strength;
 }
 
+int strength_bar(unsigned int strength) {
+  return std::clamp((int)std::round(strength / 33.), 0, 3);
+}
+
 WifiManager::WifiManager(QWidget* parent) : QWidget(parent) {
   qDBusRegisterMetaType<Connection>();
   qDBusRegisterMetaType<IpConfig>();
@@ -54,6 +59,16 @@ WifiManager::WifiManager(QWidget* parent) : QWidget(parent) {
     }
   });
   timer->start(5000);
+
+  // coalesces bursts of access point signals into one UI refresh
+  refresh_timer = new QTimer(this);
+  refresh_timer->setSingleShot(true);
+  refresh_timer->setInterval(300);
+  QObject::connect(refresh_timer, &QTimer::timeout, this, [=]() {
+    if (rebuildSeenNetworks()) {
+      emit refreshSignal();
+    }
+  });
 }
 
 void WifiManager::setup() {
@@ -61,6 +76,12 @@ void WifiManager::setup() {
   bus.connect(NM_DBUS_SERVICE, adapter, NM_DBUS_INTERFACE_DEVICE, "StateChanged", this, SLOT(stateChange(unsigned int, unsigned int, unsigned int)));
   bus.connect(NM_DBUS_SERVICE, adapter, NM_DBUS_INTERFACE_PROPERTIES, "PropertiesChanged", this, SLOT(propertyChange(QString, QVariantMap, QStringList)));
 
+  // incremental scan results: track individual access points instead of
+  // re-enumerating the full list on every scan tick
+  bus.connect(NM_DBUS_SERVICE, adapter, NM_DBUS_INTERFACE_DEVICE_WIRELESS, "AccessPointAdded", this, SLOT(accessPointAdded(QDBusObjectPath)));
+  bus.connect(NM_DBUS_SERVICE, adapter, NM_DBUS_INTERFACE_DEVICE_WIRELESS, "AccessPointRemoved", this, SLOT(accessPointRemoved(QDBusObjectPath)));
+  bus.connect(NM_DBUS_SERVICE, "", NM_DBUS_INTERFACE_PROPERTIES, "PropertiesChanged", this, SLOT(apPropertiesChanged(QString, QVariantMap, QStringList, QDBusMessage)));
+
   bus.connect(NM_DBUS_SERVICE, NM_DBUS_PATH_SETTINGS, NM_DBUS_INTERFACE_SETTINGS, "ConnectionRemoved", this, SLOT(connectionRemoved(QDBusObjectPath)));
   bus.connect(NM_DBUS_SERVICE, NM_DBUS_PATH_SETTINGS, NM_DBUS_INTERFACE_SETTINGS, "NewConnection", this, SLOT(newConnection(QDBusObjectPath)));
 
@@ -78,7 +99,7 @@ void WifiManager::refreshNetworks() {
   if (adapter.isEmpty()) {
     return;
   }
-  seenNetworks.clear();
+  accessPoints.clear();
   ipv4_address = get_ipv4_address();
 
   QDBusInterface nm(NM_DBUS_SERVICE, adapter, NM_DBUS_INTERFACE_DEVICE_WIRELESS, bus);
@@ -86,26 +107,69 @@ void WifiManager::refreshNetworks() {
 
   const QDBusReply<QList<QDBusObjectPath>> &response = nm.call("GetAllAccessPoints");
   for (const QDBusObjectPath &path : response.value()) {
-    const QByteArray &ssid = get_property(path.path(), "Ssid");
-    unsigned int strength = get_ap_strength(path.path());
-    if (ssid.isEmpty() || (seenNetworks.contains(ssid) &&
-        strength <= seenNetworks.value(ssid).strength)) {
+    addAccessPoint(path.path());
+  }
+  rebuildSeenNetworks();
+}
+
+// one GetAll round-trip per access point instead of a Get per property
+void WifiManager::addAccessPoint(const QString &path) {
+  QDBusInterface ap_props(NM_DBUS_SERVICE, path, NM_DBUS_INTERFACE_PROPERTIES, bus);
+  ap_props.setTimeout(DBUS_TIMEOUT);
+
+  const QDBusReply<QVariantMap> response = ap_props.call("GetAll", NM_DBUS_INTERFACE_ACCESS_POINT);
+  const QVariantMap &properties = response.value();
+  const QByteArray &ssid = properties.value("Ssid").toByteArray();
+  if (ssid.isEmpty()) {
+    return;
+  }
+  unsigned int strength = properties.value("Strength").toUInt();
+  accessPoints[path] = {ssid, strength, ConnectedType::DISCONNECTED, getSecurityType(properties)};
+}
+
+// rebuilds seenNetworks from the access point cache without any DBus
+// traffic. Returns whether anything user-visible changed, so strength
+// jitter within a signal bar doesn't force a list rebuild.
+bool WifiManager::rebuildSeenNetworks() {
+  QString activeSsid;
+  if (activeAp != "" && activeAp != "/") {
+    activeSsid = accessPoints.contains(activeAp) ? accessPoints[activeAp].ssid : get_property(activeAp, "Ssid");
+  }
+
+  QMap<QString, Network> networks;
+  for (auto it = accessPoints.cbegin(); it != accessPoints.cend(); ++it) {
+    Network network = it.value();
+    if (networks.contains(network.ssid) && network.strength <= networks.value(network.ssid).strength) {
       continue;
     }
-    SecurityType security = getSecurityType(path.path());
-    ConnectedType ctype;
-    QString activeSsid = (activeAp != "" && activeAp != "/") ? get_property(activeAp, "Ssid") : "";
-    if (ssid != activeSsid) {
-      ctype = ConnectedType::DISCONNECTED;
+    if (network.ssid != activeSsid) {
+      network.connected = ConnectedType::DISCONNECTED;
+    } else if (network.ssid == connecting_to_network) {
+      network.connected = ConnectedType::CONNECTING;
     } else {
-      if (ssid == connecting_to_network) {
-        ctype = ConnectedType::CONNECTING;
-      } else {
-        ctype = ConnectedType::CONNECTED;
+      network.connected = ConnectedType::CONNECTED;
+    }
+    networks[network.ssid] = network;
+  }
+
+  bool changed = networks.size() != seenNetworks.size();
+  if (!changed) {
+    for (auto it = networks.cbegin(); it != networks.cend(); ++it) {
+      auto prev = seenNetworks.constFind(it.key());
+      if (prev == seenNetworks.cend() || prev->connected != it->connected || prev->security_type != it->security_type ||
+          strength_bar(prev->strength) != strength_bar(it->strength)) {
+        changed = true;
+        break;
       }
     }
-    Network network = {ssid, strength, ctype, security};
-    seenNetworks[ssid] = network;
+  }
+  seenNetworks = networks;
+  return changed;
+}
+
+void WifiManager::scheduleRefresh() {
+  if (!refresh_timer->isActive()) {
+    refresh_timer->start();
   }
 }
 
@@ -142,10 +206,10 @@ QString WifiManager::get_ipv4_address() {
   return "";
 }
 
-SecurityType WifiManager::getSecurityType(const QString &path) {
-  int sflag = get_property(path, "Flags").toInt();
-  int wpaflag = get_property(path, "WpaFlags").toInt();
-  int rsnflag = get_property(path, "RsnFlags").toInt();
+SecurityType WifiManager::getSecurityType(const QVariantMap &properties) {
+  int sflag = properties.value("Flags").toInt();
+  int wpaflag = properties.value("WpaFlags").toInt();
+  int rsnflag = properties.value("RsnFlags").toInt();
   int wpa_props = wpaflag | rsnflag;
 
   // obtained by looking at flags of networks in the office as reported by an Android phone
@@ -287,14 +351,6 @@ QByteArray WifiManager::get_property(const QString &network_path , const QString
   return get_response<QByteArray>(response);
 }
 
-unsigned int WifiManager::get_ap_strength(const QString &network_path) {
-  QDBusInterface device_props(NM_DBUS_SERVICE, network_path, NM_DBUS_INTERFACE_PROPERTIES, bus);
-  device_props.setTimeout(DBUS_TIMEOUT);
-
-  QDBusMessage response = device_props.call("Get", NM_DBUS_INTERFACE_ACCESS_POINT, "Strength");
-  return get_response<unsigned int>(response);
-}
-
 QString WifiManager::getAdapter(const uint adapter_type) {
   QDBusInterface nm(NM_DBUS_SERVICE, NM_DBUS_PATH, NM_DBUS_INTERFACE, bus);
   nm.setTimeout(DBUS_TIMEOUT);
@@ -326,13 +382,40 @@ void WifiManager::stateChange(unsigned int new_state, unsigned int previous_stat
 void WifiManager::propertyChange(const QString &interface, const QVariantMap &props, const QStringList &invalidated_props) {
   if (interface == NM_DBUS_INTERFACE_DEVICE_WIRELESS && props.contains("LastScan")) {
     if (this->isVisible() || firstScan) {
-      refreshNetworks();
-      emit refreshSignal();
+      // the access point cache was kept up to date by the added/removed
+      // signals while the scan ran, so there is nothing left to enumerate
+      scheduleRefresh();
       firstScan = false;
     }
   } else if (interface == NM_DBUS_INTERFACE_DEVICE_WIRELESS && props.contains("ActiveAccessPoint")) {
     const QDBusObjectPath &path = props.value("ActiveAccessPoint").value<QDBusObjectPath>();
     activeAp = path.path();
+    scheduleRefresh();
+  }
+}
+
+void WifiManager::accessPointAdded(const QDBusObjectPath &path) {
+  if (!this->isVisible() && !firstScan) {
+    return;  // showEvent does a full refresh, no need to track while hidden
+  }
+  addAccessPoint(path.path());
+  scheduleRefresh();
+}
+
+void WifiManager::accessPointRemoved(const QDBusObjectPath &path) {
+  if (accessPoints.remove(path.path())) {
+    scheduleRefresh();
+  }
+}
+
+void WifiManager::apPropertiesChanged(const QString &interface, const QVariantMap &props, const QStringList &invalidated_props, const QDBusMessage &msg) {
+  if (interface != NM_DBUS_INTERFACE_ACCESS_POINT) {
+    return;
+  }
+  auto ap = accessPoints.find(msg.path());
+  if (ap != accessPoints.end() && props.contains("Strength")) {
+    ap->strength = props.value("Strength").toUInt();
+    scheduleRefresh();
   }
 }
 
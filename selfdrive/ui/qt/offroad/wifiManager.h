@@ -32,6 +32,7 @@ struct Network {
   SecurityType security_type;
 };
 bool compare_by_strength(const Network &a, const Network &b);
+int strength_bar(unsigned int strength);  // 0-3, matches the strength icons
 
 class WifiManager : public QWidget {
   Q_OBJECT
@@ -86,13 +87,20 @@ private:
   QVector<QDBusObjectPath> get_active_connections();
   uint get_wifi_device_state();
   QByteArray get_property(const QString &network_path, const QString &property);
-  unsigned int get_ap_strength(const QString &network_path);
-  SecurityType getSecurityType(const QString &path);
+  SecurityType getSecurityType(const QVariantMap &properties);
   QDBusObjectPath getConnectionPath(const QString &ssid);
   Connection getConnectionSettings(const QDBusObjectPath &path);
   void initConnections();
   void setup();
 
+  // access points cached by object path (one path per BSSID), kept up to
+  // date from NetworkManager signals instead of re-enumerating every scan
+  QMap<QString, Network> accessPoints;
+  QTimer* refresh_timer;
+  void addAccessPoint(const QString &path);
+  bool rebuildSeenNetworks();
+  void scheduleRefresh();
+
 signals:
   void wrongPassword(const QString &ssid);
   void refreshSignal();
@@ -100,6 +108,9 @@ signals:
 private slots:
   void stateChange(unsigned int new_state, unsigned int previous_state, unsigned int change_reason);
   void propertyChange(const QString &interface, const QVariantMap &props, const QStringList &invalidated_props);
+  void accessPointAdded(const QDBusObjectPath &path);
+  void accessPointRemoved(const QDBusObjectPath &path);
+  void apPropertiesChanged(const QString &interface, const QVariantMap &props, const QStringList &invalidated_props, const QDBusMessage &msg);
   void deviceAdded(const QDBusObjectPath &path);
   void connectionRemoved(const QDBusObjectPath &path);
   void newConnection(const QDBusObjectPath &path);
@@ -4,6 +4,7 @@
 #include <QFileInfo>
 #include <QDateTime>
 
+#include "selfdrive/common/metrics.h"
 #include "selfdrive/common/timing.h"
 #include "selfdrive/ui/paint.h"
 #include "selfdrive/ui/qt/util.h"
@@ -45,6 +46,10 @@ OnroadWindow::OnroadWindow(QWidget *parent) : QWidget(parent) {
 void OnroadWindow::updateState(const UIState &s) {
   SubMaster &sm = *(s.sm);
   QColor bgColor = bg_colors[s.status];
+  if (sm.updated("modelV2")) {
+    // keep the drawn frame in sync with the model overlay
+    nvg->setFrameId(sm["modelV2"].getModelV2().getFrameId());
+  }
   if (sm.updated("controlsState")) {
     const cereal::ControlsState::Reader &cs = sm["controlsState"].getControlsState();
     alerts->updateAlert({QString::fromStdString(cs.getAlertText1()),
@@ -128,7 +133,8 @@ void OnroadWindow::offroadTransition(bool offroad) {
         settings.setCacheDatabasePath("/data/mbgl-cache.db");
       }
       settings.setApiBaseUrl(MAPS_HOST);
-      settings.setCacheDatabaseMaximumSize(20 * 1024 * 1024);
+      // large enough for the prefetched route corridor plus the home area
+      settings.setCacheDatabaseMaximumSize(256 * 1024 * 1024);
       settings.setAccessToken(token.trimmed());
 
       MapWindow * m = new MapWindow(settings);
@@ -158,6 +164,8 @@ void OnroadAlerts::updateAlert(const Alert &a, const QColor &color) {
   if (!alert.equal(a) || color != bg) {
     alert = a;
     bg = color;
+    // drop the cached surface; it is re-rendered on the next paint
+    surface = QPixmap();
     update();
   }
 }
@@ -166,15 +174,30 @@ void OnroadAlerts::paintEvent(QPaintEvent *event) {
   if (alert.size == cereal::ControlsState::AlertSize::NONE) {
     return;
   }
-  static std::map<cereal::ControlsState::AlertSize, const int> alert_sizes = {
+  // the alert content only changes through updateAlert, but this widget is
+  // repainted every camera frame while stacked over the GL view. rendering
+  // the background, gradient and text once into a pixmap leaves the
+  // per-frame cost at a single composite — exactly when the UI needs the
+  // headroom most.
+  std::map<cereal::ControlsState::AlertSize, const int> alert_sizes = {
     {cereal::ControlsState::AlertSize::SMALL, 271},
     {cereal::ControlsState::AlertSize::MID, 420},
     {cereal::ControlsState::AlertSize::FULL, height()},
   };
-  int h = alert_sizes[alert.size];
-  QRect r = QRect(0, height() - h, width(), h);
+  QRect r = QRect(0, height() - alert_sizes[alert.size], width(), alert_sizes[alert.size]);
+  if (surface.isNull() || r != surface_rect) {
+    surface_rect = r;
+    renderSurface();
+  }
+  QPainter(this).drawPixmap(surface_rect.topLeft(), surface);
+}
 
-  QPainter p(this);
+void OnroadAlerts::renderSurface() {
+  QRect r = QRect(0, 0, surface_rect.width(), surface_rect.height());
+
+  surface = QPixmap(r.size());
+  surface.fill(Qt::transparent);
+  QPainter p(&surface);
 
   // draw background + gradient
   p.setPen(Qt::NoPen);
@@ -223,6 +246,25 @@ void NvgWindow::initializeGL() {
   ui_nvg_init(&QUIState::ui_state);
   prev_draw_t = millis_since_boot();
   setBackgroundColor(bg_colors[STATUS_DISENGAGED]);
+
+  // request-to-photon instrumentation: event() stamps the update request,
+  // frameSwapped fires once the swap completes — the earliest the frame can
+  // scan out. exported through the metrics table so alert display latency
+  // shows up in the 1Hz metrics message instead of being unmeasurable.
+  connect(this, &QOpenGLWidget::frameSwapped, this, [this]() {
+    static MetricSlot *swap_hist = metric_histogram("ui.request_to_swap_us");
+    if (draw_request_t > 0) {
+      metric_observe(swap_hist, (uint64_t)((millis_since_boot() - draw_request_t) * 1000.0));
+      draw_request_t = 0;
+    }
+  });
+}
+
+bool NvgWindow::event(QEvent *e) {
+  if (e->type() == QEvent::UpdateRequest && draw_request_t == 0) {
+    draw_request_t = millis_since_boot();
+  }
+  return CameraViewWidget::event(e);
 }
 
 void NvgWindow::paintGL() {
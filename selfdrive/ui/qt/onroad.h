@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QPixmap>
 #include <QStackedLayout>
 #include <QWidget>
 
@@ -20,8 +21,13 @@ protected:
   void paintEvent(QPaintEvent*) override;
 
 private:
+  void renderSurface();
+
   QColor bg;
   Alert alert = {};
+  // alert rendering cached at updateAlert time; paintEvent only composites
+  QPixmap surface;
+  QRect surface_rect;
 };
 
 // container window for the NVG UI
@@ -34,7 +40,11 @@ public:
 protected:
   void paintGL() override;
   void initializeGL() override;
+  bool event(QEvent *e) override;
   double prev_draw_t = 0;
+  // timestamp of the update request currently being drawn, for the
+  // request-to-swap latency histogram (see initializeGL)
+  double draw_request_t = 0;
 };
 
 // container for all onroad widgets
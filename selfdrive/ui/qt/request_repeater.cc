@@ -1,10 +1,14 @@
 #include "selfdrive/ui/qt/request_repeater.h"
 
+#include <algorithm>
+
 RequestRepeater::RequestRepeater(QObject *parent, const QString &requestURL, const QString &cacheKey,
                                  int period, bool while_onroad) : HttpRequest(parent) {
   timer = new QTimer(this);
   timer->setTimerType(Qt::VeryCoarseTimer);
   QObject::connect(timer, &QTimer::timeout, [=]() {
+    if (++ticks < backoff) return;
+    ticks = 0;
     if ((!QUIState::ui_state.scene.started || while_onroad) && QUIState::ui_state.awake && !active()) {
       sendRequest(requestURL);
     }
@@ -12,6 +16,15 @@ RequestRepeater::RequestRepeater(QObject *parent, const QString &requestURL, con
 
   timer->start(period * 1000);
 
+  // back off while the server keeps answering 304 Not Modified, and snap
+  // back to the base period as soon as the content changes
+  QObject::connect(this, &HttpRequest::responseUnchanged, [=]() {
+    backoff = std::min(backoff * 2, MAX_BACKOFF);
+  });
+  QObject::connect(this, &HttpRequest::receivedResponse, [=](const QString &) {
+    backoff = 1;
+  });
+
   if (!cacheKey.isEmpty()) {
     prevResp = QString::fromStdString(params.get(cacheKey.toStdString()));
     if (!prevResp.isEmpty()) {
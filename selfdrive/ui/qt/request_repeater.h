@@ -9,7 +9,13 @@ public:
   RequestRepeater(QObject *parent, const QString &requestURL, const QString &cacheKey = "", int period = 0, bool while_onroad=false);
 
 private:
+  // longest effective poll period while content is static, in base periods
+  static constexpr int MAX_BACKOFF = 8;
+
   Params params;
   QTimer *timer;
   QString prevResp;
+  // timer ticks at the base period; a poll goes out every `backoff` ticks
+  int backoff = 1;
+  int ticks = 0;
 };
@@ -40,7 +40,15 @@ Sidebar::Sidebar(QWidget *parent) : QFrame(parent) {
   home_img = QImage("../assets/images/button_home.png").scaled(180, 180, Qt::KeepAspectRatio, Qt::SmoothTransformation);
   settings_img = QImage("../assets/images/button_settings.png").scaled(settings_btn.width(), settings_btn.height(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 
-  connect(this, &Sidebar::valueChanged, [=] { update(); });
+  // repaint only the region whose content changed; the rects mirror the
+  // layout in paintEvent
+  connect(this, &Sidebar::netChanged, [=] { update(30, 190, 240, 110); });
+  connect(this, &Sidebar::batteryChanged, [=] { update(150, 240, 110, 50); });
+  connect(this, &Sidebar::ipChanged, [=] { update(35, 295, 230, 50); });
+  connect(this, &Sidebar::ssidChanged, [=] { update(35, 335, 230, 45); });
+  connect(this, &Sidebar::tempStatusChanged, [=] { update(30, 378, 240, 148); });
+  connect(this, &Sidebar::pandaStatusChanged, [=] { update(30, 558, 240, 148); });
+  connect(this, &Sidebar::connectStatusChanged, [=] { update(30, 716, 240, 148); });
 
   setAttribute(Qt::WA_OpaquePaintEvent);
   setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
@@ -85,6 +93,13 @@ void Sidebar::mouseReleaseEvent(QMouseEvent *event) {
 void Sidebar::updateState(const UIState &s) {
   auto &sm = *(s.sm);
 
+  // everything drawn here comes from these services; skip the 20Hz ticks in
+  // between their updates instead of re-deriving identical values
+  if (!sm.updated("deviceState") && !sm.updated("pandaState") &&
+      !sm.updated("ubloxGnss") && !sm.updated("liveLocationKalman")) {
+    return;
+  }
+
   auto deviceState = sm["deviceState"].getDeviceState();
   setProperty("netType", network_type[deviceState.getNetworkType()]);
   int strength = (int)deviceState.getNetworkStrength();
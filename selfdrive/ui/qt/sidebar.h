@@ -12,22 +12,30 @@ Q_DECLARE_METATYPE(ItemStatus);
 
 class Sidebar : public QFrame {
   Q_OBJECT
-  Q_PROPERTY(ItemStatus connectStatus MEMBER connect_status NOTIFY valueChanged);
-  Q_PROPERTY(ItemStatus pandaStatus MEMBER panda_status NOTIFY valueChanged);
-  Q_PROPERTY(ItemStatus tempStatus MEMBER temp_status NOTIFY valueChanged);
-  Q_PROPERTY(QString netType MEMBER net_type NOTIFY valueChanged);
-  Q_PROPERTY(int netStrength MEMBER net_strength NOTIFY valueChanged);
-  Q_PROPERTY(QString iPAddress MEMBER wifi_IPAddress NOTIFY valueChanged);
-  Q_PROPERTY(QString sSID MEMBER wifi_SSID NOTIFY valueChanged);
-  Q_PROPERTY(QString bATStatus MEMBER bat_Status NOTIFY valueChanged);
-  Q_PROPERTY(int bATPercent MEMBER bat_Percent NOTIFY valueChanged);
+  // each NOTIFY only fires when the value actually changed (moc compares
+  // MEMBER properties), and each signal repaints just its own region
+  Q_PROPERTY(ItemStatus connectStatus MEMBER connect_status NOTIFY connectStatusChanged);
+  Q_PROPERTY(ItemStatus pandaStatus MEMBER panda_status NOTIFY pandaStatusChanged);
+  Q_PROPERTY(ItemStatus tempStatus MEMBER temp_status NOTIFY tempStatusChanged);
+  Q_PROPERTY(QString netType MEMBER net_type NOTIFY netChanged);
+  Q_PROPERTY(int netStrength MEMBER net_strength NOTIFY netChanged);
+  Q_PROPERTY(QString iPAddress MEMBER wifi_IPAddress NOTIFY ipChanged);
+  Q_PROPERTY(QString sSID MEMBER wifi_SSID NOTIFY ssidChanged);
+  Q_PROPERTY(QString bATStatus MEMBER bat_Status NOTIFY batteryChanged);
+  Q_PROPERTY(int bATPercent MEMBER bat_Percent NOTIFY batteryChanged);
 
 public:
   explicit Sidebar(QWidget* parent = 0);
 
 signals:
   void openSettings();
-  void valueChanged();
+  void connectStatusChanged();
+  void pandaStatusChanged();
+  void tempStatusChanged();
+  void netChanged();
+  void ipChanged();
+  void ssidChanged();
+  void batteryChanged();
 
 public slots:
   void updateState(const UIState &s);
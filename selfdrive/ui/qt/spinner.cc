@@ -18,22 +18,8 @@ TrackWidget::TrackWidget(QWidget *parent) : QWidget(parent) {
   setAttribute(Qt::WA_OpaquePaintEvent);
   setFixedSize(spinner_size);
 
-  // pre-compute all the track imgs. make this a gif instead?
-  QPixmap comma_img = QPixmap("../assets/img_spinner_comma.png").scaled(spinner_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  QPixmap track_img = QPixmap("../assets/img_spinner_track.png").scaled(spinner_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-  QTransform transform(1, 0, 0, 1, width() / 2, height() / 2);
-  QPixmap pm(spinner_size);
-  QPainter p(&pm);
-  p.setRenderHint(QPainter::SmoothPixmapTransform);
-  for (int i = 0; i < track_imgs.size(); ++i) {
-    p.resetTransform();
-    p.fillRect(0, 0, spinner_size.width(), spinner_size.height(), Qt::black);
-    p.drawPixmap(0, 0, comma_img);
-    p.setTransform(transform.rotate(360 / spinner_fps));
-    p.drawPixmap(-width() / 2, -height() / 2, track_img);
-    track_imgs[i] = pm.copy();
-  }
+  comma_img = QPixmap("../assets/img_spinner_comma.png").scaled(spinner_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  track_img = QPixmap("../assets/img_spinner_track.png").scaled(spinner_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
 
   m_anim.setDuration(1000);
   m_anim.setStartValue(0);
@@ -43,9 +29,27 @@ TrackWidget::TrackWidget(QWidget *parent) : QWidget(parent) {
   connect(&m_anim, SIGNAL(valueChanged(QVariant)), SLOT(update()));
 }
 
+// compositing all the rotations up front cost most of the time to first
+// pixel; instead each frame is rendered the first time the animation hits
+// it, so the spinner is fully pre-rendered after one revolution
+QPixmap &TrackWidget::frame(int i) {
+  if (track_imgs[i].isNull()) {
+    QTransform transform(1, 0, 0, 1, width() / 2, height() / 2);
+    QPixmap pm(spinner_size);
+    QPainter p(&pm);
+    p.setRenderHint(QPainter::SmoothPixmapTransform);
+    p.fillRect(0, 0, spinner_size.width(), spinner_size.height(), Qt::black);
+    p.drawPixmap(0, 0, comma_img);
+    p.setTransform(transform.rotate(i * 360 / spinner_fps));
+    p.drawPixmap(-width() / 2, -height() / 2, track_img);
+    track_imgs[i] = pm;
+  }
+  return track_imgs[i];
+}
+
 void TrackWidget::paintEvent(QPaintEvent *event) {
   QPainter painter(this);
-  painter.drawPixmap(0, 0, track_imgs[m_anim.currentValue().toInt()]);
+  painter.drawPixmap(0, 0, frame(m_anim.currentValue().toInt()));
 }
 
 // Spinner
@@ -17,6 +17,10 @@ public:
 
 private:
   void paintEvent(QPaintEvent *event) override;
+  QPixmap &frame(int i);
+  QPixmap comma_img, track_img;
+  // composited frames, rendered on first use so showing the window never
+  // waits on the whole revolution
   std::array<QPixmap, spinner_fps> track_imgs;
   QVariantAnimation m_anim;
 };
@@ -1,11 +1,15 @@
 #include "selfdrive/ui/qt/util.h"
 
+#include <sys/inotify.h>
+#include <unistd.h>
+
 #include <QApplication>
 #include <QLayoutItem>
 #include <QStyleOption>
 
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
 
 QString getBrand() {
@@ -76,6 +80,10 @@ void setQtSurfaceFormat() {
 #else
   fmt.setRenderableType(QSurfaceFormat::OpenGLES);
 #endif
+  // explicit swap pacing: default stays vsync-locked. UI_SWAP_INTERVAL=0
+  // lets a late swap tear instead of sliding a whole frame, which trims the
+  // worst-case alert photon latency on compositors that honor it.
+  fmt.setSwapInterval(util::getenv("UI_SWAP_INTERVAL", 1));
   QSurfaceFormat::setDefaultFormat(fmt);
 }
 
@@ -83,9 +91,9 @@ void initApp() {
   Hardware::set_display_power(true);
   Hardware::set_brightness(65);
   setQtSurfaceFormat();
-  if (Hardware::EON()) {
-    QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
-  }
+  // one context group for all the GL widgets, so compiled programs and
+  // textures are shared instead of rebuilt per widget
+  QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 }
 
 ClickableWidget::ClickableWidget(QWidget *parent) : QWidget(parent) { }
@@ -126,3 +134,36 @@ QWidget* topWidget (QWidget* widget) {
   while (widget->parentWidget() != nullptr) widget=widget->parentWidget();
   return widget;
 }
+
+ParamWatcher::ParamWatcher(QObject *parent) : QObject(parent) {
+  inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd < 0 ||
+      inotify_add_watch(inotify_fd, params.getParamPath().c_str(), IN_MOVED_TO | IN_CLOSE_WRITE) < 0) {
+    LOGE("ParamWatcher: inotify setup failed");
+    return;
+  }
+  notifier = new QSocketNotifier(inotify_fd, QSocketNotifier::Read, this);
+  QObject::connect(notifier, &QSocketNotifier::activated, this, &ParamWatcher::handleEvents);
+}
+
+ParamWatcher::~ParamWatcher() {
+  if (inotify_fd >= 0) close(inotify_fd);
+}
+
+void ParamWatcher::handleEvents() {
+  char buf[4096] __attribute__((aligned(alignof(struct inotify_event))));
+  ssize_t n;
+  while ((n = read(inotify_fd, buf, sizeof(buf))) > 0) {
+    for (char *ptr = buf; ptr < buf + n;) {
+      auto *event = (struct inotify_event *)ptr;
+      // skip in-flight temp files; only completed writes of known keys fan out
+      if (event->len > 0 && event->name[0] != '.') {
+        std::string key = event->name;
+        if (params.checkKey(key)) {
+          emit paramChanged(QString::fromStdString(key), QString::fromStdString(params.get(key)));
+        }
+      }
+      ptr += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
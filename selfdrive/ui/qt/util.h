@@ -6,9 +6,12 @@
 #include <QLayout>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QSocketNotifier>
 #include <QSurfaceFormat>
 #include <QWidget>
 
+#include "selfdrive/common/params.h"
+
 QString getBrand();
 QString getBrandVersion();
 std::optional<QString> getDongleId();
@@ -31,6 +34,28 @@ public:
   };
 };
 
+// one inotify watch on the params dir, fanned out as a Qt signal keyed by
+// param name. params.cc writes through an atomic rename, so IN_MOVED_TO fires
+// exactly once per completed put() and the value read here is never partial.
+// replaces per-widget QTimer polling of Params.
+class ParamWatcher : public QObject {
+  Q_OBJECT
+
+public:
+  ParamWatcher(QObject *parent = nullptr);
+  ~ParamWatcher();
+
+signals:
+  void paramChanged(const QString &param_name, const QString &param_value);
+
+private:
+  void handleEvents();
+
+  int inotify_fd = -1;
+  QSocketNotifier *notifier = nullptr;
+  Params params;
+};
+
 class ClickableWidget : public QWidget {
   Q_OBJECT
 
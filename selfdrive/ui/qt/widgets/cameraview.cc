@@ -1,5 +1,7 @@
 #include "selfdrive/ui/qt/widgets/cameraview.h"
 
+#include <cstring>
+
 namespace {
 
 const char frame_vertex_shader[] =
@@ -106,6 +108,7 @@ CameraViewWidget::~CameraViewWidget() {
     glDeleteVertexArrays(1, &frame_vao);
     glDeleteBuffers(1, &frame_vbo);
     glDeleteBuffers(1, &frame_ibo);
+    glDeleteBuffers(2, frame_pbo);
   }
   doneCurrent();
 }
@@ -114,9 +117,12 @@ void CameraViewWidget::initializeGL() {
   initializeOpenGLFunctions();
 
   program = new QOpenGLShaderProgram(context());
-  bool ret = program->addShaderFromSourceCode(QOpenGLShader::Vertex, frame_vertex_shader);
+  // cacheable shaders are backed by Qt's program binary disk cache (keyed by
+  // the driver version), so only the very first context ever pays compile+link;
+  // with AA_ShareOpenGLContexts the binary is also shared between the widgets
+  bool ret = program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, frame_vertex_shader);
   assert(ret);
-  ret = program->addShaderFromSourceCode(QOpenGLShader::Fragment, frame_fragment_shader);
+  ret = program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, frame_fragment_shader);
   assert(ret);
 
   program->link();
@@ -149,6 +155,8 @@ void CameraViewWidget::initializeGL() {
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
+  glGenBuffers(2, frame_pbo);
+
   setStreamType(stream_type);
 }
 
@@ -156,6 +164,8 @@ void CameraViewWidget::initializeGL() {
 void CameraViewWidget::hideEvent(QHideEvent *event) {
   vipc_client->connected = false;
   latest_frame = nullptr;
+  uploading_frame = nullptr;
+  ready_frame = nullptr;
 }
 
 void CameraViewWidget::mouseReleaseEvent(QMouseEvent *event) {
@@ -170,6 +180,7 @@ void CameraViewWidget::setStreamType(VisionStreamType type) {
   if (!vipc_client || type != stream_type) {
     stream_type = type;
     vipc_client.reset(new VisionIpcClient("camerad", stream_type, true));
+    frame_sync.reset(new VisionIpcFrameSync(vipc_client.get()));
     updateFrameMat(width(), height());
   }
 }
@@ -219,13 +230,41 @@ void CameraViewWidget::paintGL() {
   glBindVertexArray(frame_vao);
   glActiveTexture(GL_TEXTURE0);
 
-  glBindTexture(GL_TEXTURE_2D, texture[latest_frame->idx]->frame_tex);
+  VisionBuf *draw_frame = latest_frame;
   if (!Hardware::EON()) {
-    // this is handled in ion on QCOM
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, latest_frame->width, latest_frame->height,
-                  0, GL_RGB, GL_UNSIGNED_BYTE, latest_frame->addr);
+    // on QCOM the ION buffer is imported zero-copy. elsewhere, stage the new
+    // frame through a PBO so the DMA into the texture overlaps with drawing
+    // the previous one instead of stalling the render thread
+    if (latest_frame != uploading_frame) {
+      const GLsizeiptr frame_size = (GLsizeiptr)latest_frame->width * latest_frame->height * 3;
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame_pbo[pbo_idx]);
+      // orphan the previous storage so mapping doesn't wait on an in-flight transfer
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, frame_size, nullptr, GL_STREAM_DRAW);
+      void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frame_size,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+      if (dst) {
+        memcpy(dst, latest_frame->addr, frame_size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindTexture(GL_TEXTURE_2D, texture[latest_frame->idx]->frame_tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, latest_frame->width, latest_frame->height,
+                     0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        ready_frame = uploading_frame ? uploading_frame : latest_frame;
+        uploading_frame = latest_frame;
+        pbo_idx = !pbo_idx;
+      } else {
+        // mapping failed, fall back to a synchronous upload
+        glBindTexture(GL_TEXTURE_2D, texture[latest_frame->idx]->frame_tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, latest_frame->width, latest_frame->height,
+                     0, GL_RGB, GL_UNSIGNED_BYTE, latest_frame->addr);
+        ready_frame = uploading_frame = latest_frame;
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    draw_frame = ready_frame;
   }
 
+  glBindTexture(GL_TEXTURE_2D, texture[draw_frame->idx]->frame_tex);
+
   glUseProgram(program->programId());
   glUniform1i(program->uniformLocation("uTexture"), 0);
   glUniformMatrix4fv(program->uniformLocation("uTransform"), 1, GL_TRUE, frame_mat.v);
@@ -260,15 +299,22 @@ void CameraViewWidget::updateFrame() {
         assert(glGetError() == GL_NO_ERROR);
       }
       latest_frame = nullptr;
+      uploading_frame = nullptr;
+      ready_frame = nullptr;
+      // the old ring points into freed buffers after a reconnect
+      frame_sync.reset(new VisionIpcFrameSync(vipc_client.get()));
       resizeGL(width(), height());
     }
   }
 
   VisionBuf *buf = nullptr;
   if (vipc_client->connected) {
-    buf = vipc_client->recv(nullptr, 0);
+    buf = frame_sync->recv(nullptr, 0);
     if (buf != nullptr) {
-      latest_frame = buf;
+      // draw the exact frame the latest model output was computed from while
+      // it is still in the pool, instead of whatever arrived last
+      VisionBuf *synced = (draw_frame_id > 0) ? frame_sync->get(draw_frame_id, nullptr, 0) : nullptr;
+      latest_frame = (synced != nullptr) ? synced : buf;
       update();
       emit frameUpdated();
     }
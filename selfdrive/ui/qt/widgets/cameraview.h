@@ -2,16 +2,17 @@
 
 #include <memory>
 
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLWidget>
 
 #include "cereal/visionipc/visionipc_client.h"
+#include "cereal/visionipc/visionipc_framesync.h"
 #include "selfdrive/common/mat.h"
 #include "selfdrive/common/visionimg.h"
 #include "selfdrive/ui/ui.h"
 
-class CameraViewWidget : public QOpenGLWidget, protected QOpenGLFunctions {
+class CameraViewWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions {
   Q_OBJECT
 
 public:
@@ -20,6 +21,8 @@ public:
   ~CameraViewWidget();
   void setStreamType(VisionStreamType type);
   void setBackgroundColor(QColor color);
+  // frame id to draw (from the latest modelV2), 0 draws the newest arrival
+  void setFrameId(uint32_t frame_id) { draw_frame_id = frame_id; }
 
 signals:
   void clicked();
@@ -33,6 +36,7 @@ protected:
   void mouseReleaseEvent(QMouseEvent *event) override;
   void updateFrameMat(int w, int h);
   std::unique_ptr<VisionIpcClient> vipc_client;
+  std::unique_ptr<VisionIpcFrameSync> frame_sync;
 
 protected slots:
   void updateFrame();
@@ -45,6 +49,15 @@ private:
   std::unique_ptr<EGLImageTexture> texture[UI_BUF_COUNT];
   QOpenGLShaderProgram *program;
 
+  // PBO ring for asynchronous texture uploads off the EON (where the ION
+  // buffer is already imported zero-copy). paintGL draws the last frame
+  // whose upload has completed while the newest one is DMA'd in.
+  GLuint frame_pbo[2] = {0, 0};
+  int pbo_idx = 0;
+  VisionBuf *uploading_frame = nullptr;
+  VisionBuf *ready_frame = nullptr;
+
   VisionStreamType stream_type;
+  uint32_t draw_frame_id = 0;
   QColor bg = QColor("#000000");
 };
@@ -0,0 +1,128 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+
+#include <atomic>
+#include <cinttypes>
+#include <thread>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/ui/replay/replay.h"
+
+// feeds a recorded route through Replay's publish path at full speed and
+// measures the cycle time of each listed output service, so controls-stack
+// latency regressions show up as shifted histograms instead of in the car.
+// run the processes under test (controlsd, plannerd, locationd, ...)
+// separately; their output services must be blocked from replay, which
+// main() does for every measured service.
+
+struct ServiceStats {
+  std::string name;
+  uint64_t count = 0;
+  uint64_t last_t = 0;
+  uint64_t sum_ns = 0;
+  uint64_t max_ns = 0;
+  // bucket i counts cycles with log2(microseconds) == i, same convention as
+  // messaging/latency_stats
+  uint64_t hist[32] = {};
+
+  void sample(uint64_t t) {
+    if (last_t > 0) {
+      const uint64_t dt = t - last_t;
+      int b = 0;
+      for (uint64_t us = dt / 1000; us > 1; us >>= 1) b++;
+      hist[std::min(b, 31)]++;
+      count++;
+      sum_ns += dt;
+      if (dt > max_ns) max_ns = dt;
+    }
+    last_t = t;
+  }
+
+  // upper bound in microseconds of the bucket holding the p-quantile
+  uint64_t percentile_us(double p) const {
+    uint64_t threshold = count * p;
+    uint64_t seen = 0;
+    for (int i = 0; i < 32; ++i) {
+      seen += hist[i];
+      if (seen >= threshold) return 1ULL << (i + 1);
+    }
+    return 0;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Replay a route at full speed and report per-service cycle-time histograms.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("route", "the drive to replay");
+  parser.addOption({{"s", "services"}, "comma-separated output services to measure", "services",
+                    "controlsState,lateralPlan,longitudinalPlan,liveLocationKalman"});
+  parser.addOption({"duration", "measurement duration in seconds", "seconds", "60"});
+  parser.addOption({"data_dir", "local directory with routes", "data_dir"});
+  parser.process(app);
+
+  const QStringList args = parser.positionalArguments();
+  if (args.empty()) {
+    parser.showHelp();
+  }
+  const QStringList services = parser.value("services").split(",");
+
+  // the processes under test own the measured services
+  Replay replay(args.first(), {}, services, nullptr,
+                REPLAY_FLAG_FULL_SPEED | REPLAY_FLAG_NO_LOOP, parser.value("data_dir"), &app);
+  if (!replay.load()) {
+    return 1;
+  }
+  replay.start();
+
+  std::vector<ServiceStats> stats(services.size());
+  std::atomic<bool> do_exit = false;
+  std::thread poll_thread([&]() {
+    Context *ctx = Context::create();
+    Poller *poller = Poller::create();
+    std::map<SubSocket *, ServiceStats *> socks;
+    for (int i = 0; i < services.size(); ++i) {
+      stats[i].name = services[i].toStdString();
+      SubSocket *sock = SubSocket::create(ctx, stats[i].name);
+      assert(sock != nullptr);
+      poller->registerSocket(sock);
+      socks[sock] = &stats[i];
+    }
+    while (!do_exit) {
+      for (auto sock : poller->poll(100)) {
+        Message *msg;
+        while ((msg = sock->receive(true))) {
+          socks[sock]->sample(nanos_since_boot());
+          delete msg;
+        }
+      }
+    }
+    for (auto &[sock, _] : socks) delete sock;
+    delete poller;
+    delete ctx;
+  });
+
+  QTimer::singleShot(parser.value("duration").toInt() * 1000, &app, &QCoreApplication::quit);
+  app.exec();
+
+  do_exit = true;
+  poll_thread.join();
+  replay.stop();
+
+  printf("%-24s %8s %10s %10s %10s %10s %10s\n", "service", "cycles", "mean us", "p50 us", "p95 us", "p99 us", "max us");
+  for (const auto &s : stats) {
+    if (s.count == 0) {
+      printf("%-24s %8s\n", s.name.c_str(), "-");
+      continue;
+    }
+    printf("%-24s %8" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+           s.name.c_str(), s.count, s.sum_ns / s.count / 1000,
+           s.percentile_us(0.5), s.percentile_us(0.95), s.percentile_us(0.99), s.max_ns / 1000);
+  }
+  return 0;
+}
@@ -4,7 +4,7 @@
 
 #include <cassert>
 #include <cmath>
-#include <fstream>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 
@@ -29,15 +29,38 @@ std::string FileReader::read(const std::string &file, std::atomic<bool> *abort)
   if ((!is_remote || cache_to_local_) && util::file_exists(local_file)) {
     result = util::read_file(local_file);
   } else if (is_remote) {
-    result = download(file, abort);
-    if (cache_to_local_ && !result.empty()) {
-      std::ofstream fs(local_file, fs.binary | fs.out);
-      fs.write(result.data(), result.size());
+    if (cache_to_local_) {
+      // download straight into the cache so interrupted transfers resume
+      if (downloadToCache(file, local_file, abort)) {
+        result = util::read_file(local_file);
+      }
+    } else {
+      result = download(file, abort);
     }
   }
   return result;
 }
 
+bool FileReader::downloadToCache(const std::string &url, const std::string &local_file, std::atomic<bool> *abort) {
+  const std::string tmp_file = local_file + ".tmp";
+  size_t remote_file_size = 0;
+  for (int i = 0; i <= max_retries_ && !(abort && *abort); ++i) {
+    if (i > 0) {
+      std::cout << "download failed, retrying" << i << std::endl;
+    }
+    if (remote_file_size <= 0) {
+      remote_file_size = getRemoteFileSize(url);
+    }
+    if (remote_file_size > 0 && !(abort && *abort)) {
+      int chunks = chunk_size_ > 0 ? std::max(1, (int)std::nearbyint(remote_file_size / (float)chunk_size_)) : 1;
+      if (httpDownloadToFile(url, tmp_file, chunks, remote_file_size, abort)) {
+        return ::rename(tmp_file.c_str(), local_file.c_str()) == 0;
+      }
+    }
+  }
+  return false;
+}
+
 std::string FileReader::download(const std::string &url, std::atomic<bool> *abort) {
   std::string result;
   size_t remote_file_size = 0;
@@ -10,11 +10,14 @@ public:
   virtual ~FileReader() {}
   std::string read(const std::string &file, std::atomic<bool> *abort = nullptr);
 
+protected:
+  bool cache_to_local_;
+
 private:
   std::string download(const std::string &url, std::atomic<bool> *abort);
+  bool downloadToCache(const std::string &url, const std::string &local_file, std::atomic<bool> *abort);
   int chunk_size_;
   int max_retries_;
-  bool cache_to_local_;
 };
 
 std::string cacheFilePath(const std::string &url);
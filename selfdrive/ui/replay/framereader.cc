@@ -7,6 +7,13 @@
 
 namespace {
 
+// how many decoder contexts/threads share the packet stream
+const int DECODE_THREADS = 2;
+// frames decoded behind a seek target that are kept for backward scrubbing
+const int CACHE_WINDOW = 16;
+// total decoded frames kept across all GOPs (~50-170MB depending on camera)
+const int CACHE_SIZE = 48;
+
 int ffmpeg_lockmgr_cb(void **arg, enum AVLockOp op) {
   std::mutex *mutex = (std::mutex *)*arg;
   switch (op) {
@@ -41,18 +48,24 @@ FrameReader::FrameReader(bool local_cache, int chunk_size, int retries) : FileRe
   });
 
   pFormatCtx_ = avformat_alloc_context();
-  av_frame_ = av_frame_alloc();
   rgb_frame_ = av_frame_alloc();
-  yuv_frame_ = av_frame_alloc();;
+  yuv_frame_ = av_frame_alloc();
 }
 
 FrameReader::~FrameReader() {
+  exit_ = true;
+  for (size_t i = 0; i < decode_threads_.size(); ++i) {
+    decode_jobs_.push(-1);
+  }
+  for (auto &t : decode_threads_) {
+    t.join();
+  }
+
   for (auto &f : frames_) {
     av_free_packet(&f.pkt);
   }
-  if (pCodecCtx_) avcodec_free_context(&pCodecCtx_);
+  yuv_cache_.clear();
   if (pFormatCtx_) avformat_close_input(&pFormatCtx_);
-  if (av_frame_) av_frame_free(&av_frame_);
   if (rgb_frame_) av_frame_free(&rgb_frame_);
   if (yuv_frame_) av_frame_free(&yuv_frame_);
   if (rgb_sws_ctx_) sws_freeContext(rgb_sws_ctx_);
@@ -86,31 +99,27 @@ bool FrameReader::load(const std::string &url, std::atomic<bool> *abort) {
   // av_dump_format(pFormatCtx_, 0, url.c_str(), 0);
 
   auto pCodecCtxOrig = pFormatCtx_->streams[0]->codec;
-  auto pCodec = avcodec_find_decoder(pCodecCtxOrig->codec_id);
-  if (!pCodec) return false;
-
-  pCodecCtx_ = avcodec_alloc_context3(pCodec);
-  int ret = avcodec_copy_context(pCodecCtx_, pCodecCtxOrig);
-  if (ret != 0) return false;
-
-  // pCodecCtx_->thread_count = 0;
-  // pCodecCtx_->thread_type = FF_THREAD_FRAME;
-  ret = avcodec_open2(pCodecCtx_, pCodec, NULL);
-  if (ret < 0) return false;
-
-  width = (pCodecCtxOrig->width + 3) & ~3;
-  height = pCodecCtxOrig->height;
-  rgb_sws_ctx_ = sws_getContext(pCodecCtxOrig->width, pCodecCtxOrig->height, AV_PIX_FMT_YUV420P,
+  pCodec_ = avcodec_find_decoder(pCodecCtxOrig->codec_id);
+  if (!pCodec_) return false;
+
+  orig_width_ = pCodecCtxOrig->width;
+  orig_height_ = pCodecCtxOrig->height;
+  width = (orig_width_ + 3) & ~3;
+  height = orig_height_;
+  rgb_sws_ctx_ = sws_getContext(width, height, AV_PIX_FMT_YUV420P,
                             width, height, AV_PIX_FMT_BGR24,
                             SWS_FAST_BILINEAR, NULL, NULL, NULL);
   if (!rgb_sws_ctx_) return false;
-
-  yuv_sws_ctx_ = sws_getContext(pCodecCtxOrig->width, pCodecCtxOrig->height, AV_PIX_FMT_YUV420P,
+  // scales a cached decoder frame straight into the caller's VisionBuf. For
+  // our cameras the aligned size equals the decoded size, so this hits the
+  // swscale memcpy fast path instead of a resample.
+  yuv_sws_ctx_ = sws_getContext(orig_width_, orig_height_, AV_PIX_FMT_YUV420P,
                             width, height, AV_PIX_FMT_YUV420P,
                             SWS_FAST_BILINEAR, NULL, NULL, NULL);
   if (!yuv_sws_ctx_) return false;
 
   frames_.reserve(60 * 20);  // 20fps, one minute
+  int gop = 0;
   while (!(abort && *abort)) {
     Frame &frame = frames_.emplace_back();
     err = av_read_frame(pFormatCtx_, &frame.pkt);
@@ -120,7 +129,17 @@ bool FrameReader::load(const std::string &url, std::atomic<bool> *abort) {
       break;
     }
     // some stream seems to contian no keyframes
-    key_frames_count_ += frame.pkt.flags & AV_PKT_FLAG_KEY;
+    if (frame.pkt.flags & AV_PKT_FLAG_KEY) {
+      gop = frames_.size() - 1;
+      ++key_frames_count_;
+    }
+    frame.gop_start = gop;
+  }
+
+  if (valid_) {
+    for (int i = 0; i < DECODE_THREADS; ++i) {
+      decode_threads_.emplace_back(&FrameReader::decodeThread, this);
+    }
   }
   return valid_;
 }
@@ -130,43 +149,107 @@ bool FrameReader::get(int idx, uint8_t *rgb, uint8_t *yuv) {
   if (!valid_ || idx < 0 || idx >= frames_.size()) {
     return false;
   }
-  return decode(idx, rgb, yuv);
-}
-
-bool FrameReader::decode(int idx, uint8_t *rgb, uint8_t *yuv) {
-  auto get_keyframe = [=](int idx) {
-    for (int i = idx; i >= 0 && key_frames_count_ > 1; --i) {
-      if (frames_[i].pkt.flags & AV_PKT_FLAG_KEY) return i;
-    }
-    return idx;
-  };
 
-  int from_idx = idx;
-  if (idx > 0 && !frames_[idx].decoded && !frames_[idx - 1].decoded) {
-    // find the previous keyframe
-    from_idx = get_keyframe(idx);
-  }
-
-  for (int i = from_idx; i <= idx; ++i) {
-    Frame &frame = frames_[i];
-    if ((!frame.decoded || i == idx) && !frame.failed) {
-      avcodec_decode_video2(pCodecCtx_, av_frame_, &frame.decoded, &(frame.pkt));
-      frame.failed = !frame.decoded;
-      if (frame.decoded && i == idx) {
-        return decodeFrame(av_frame_, rgb, yuv);
+  AVFrame *f = nullptr;
+  {
+    std::unique_lock lk(cache_lock_);
+    auto it = yuv_cache_.find(idx);
+    if (it == yuv_cache_.end() || it->second.failed) {
+      lk.unlock();
+      decode_jobs_.push(idx);
+      // scrubbing backwards: decode the previous GOP on the other context
+      // so the next step back lands in the cache
+      const int gop = frames_[idx].gop_start;
+      if (idx <= last_requested_ && gop > 0) {
+        decode_jobs_.push(gop - 1);
       }
+      lk.lock();
+      bool decoded = cache_cv_.wait_for(lk, std::chrono::seconds(20), [&] {
+        auto it2 = yuv_cache_.find(idx);
+        return it2 != yuv_cache_.end() && (it2->second.frame || it2->second.failed);
+      });
+      if (!decoded) return false;
+      it = yuv_cache_.find(idx);
     }
+    last_requested_ = idx;
+    if (it->second.failed || !it->second.frame) return false;
+    it->second.last_use = ++cache_use_;
+    // another ref on the decoder buffer, so eviction can't pull it out from
+    // under the scale below
+    f = av_frame_clone(it->second.frame.get());
   }
-  return false;
-}
+  if (!f) return false;
 
-bool FrameReader::decodeFrame(AVFrame *f, uint8_t *rgb, uint8_t *yuv) {
-  // images is going to be written to output buffers, no alignment (align = 1)
+  // single plane copy left on the publish path: decoder buffer -> VisionBuf
   av_image_fill_arrays(yuv_frame_->data, yuv_frame_->linesize, yuv, AV_PIX_FMT_YUV420P, width, height, 1);
   int ret = sws_scale(yuv_sws_ctx_, (const uint8_t **)f->data, f->linesize, 0, f->height, yuv_frame_->data, yuv_frame_->linesize);
+  av_frame_free(&f);
   if (ret < 0) return false;
 
+  // convert to rgb from the caller's yuv buffer
   av_image_fill_arrays(rgb_frame_->data, rgb_frame_->linesize, rgb, AV_PIX_FMT_BGR24, width, height, 1);
-  ret = sws_scale(rgb_sws_ctx_, (const uint8_t **)f->data, f->linesize, 0, f->height, rgb_frame_->data, rgb_frame_->linesize);
+  ret = sws_scale(rgb_sws_ctx_, (const uint8_t **)yuv_frame_->data, yuv_frame_->linesize, 0, height, rgb_frame_->data, rgb_frame_->linesize);
   return ret >= 0;
 }
+
+void FrameReader::decodeThread() {
+  AVCodecContext *ctx = avcodec_alloc_context3(pCodec_);
+  assert(ctx != nullptr);
+  int ret = avcodec_copy_context(ctx, pFormatCtx_->streams[0]->codec);
+  assert(ret == 0);
+  // refcounted output frames, so the cache can hold views of the decoder's
+  // buffers instead of copying every decoded frame out
+  ctx->refcounted_frames = 1;
+  ret = avcodec_open2(ctx, pCodec_, NULL);
+  assert(ret >= 0);
+  AVFrame *f = av_frame_alloc();
+
+  int pos = -1;  // next packet this context would decode
+  while (!exit_) {
+    int target = decode_jobs_.pop();
+    if (target < 0) break;
+    {
+      std::unique_lock lk(cache_lock_);
+      auto it = yuv_cache_.find(target);
+      if (it != yuv_cache_.end() && it->second.frame) continue;
+    }
+
+    // continue from this context's position when it's inside the target's
+    // GOP, otherwise restart from the keyframe
+    int from = pos;
+    if (pos < frames_[target].gop_start || pos > target) {
+      from = frames_[target].gop_start;
+      avcodec_flush_buffers(ctx);
+    }
+    for (int i = from; i <= target && !exit_; ++i) {
+      int got = 0;
+      avcodec_decode_video2(ctx, f, &got, &frames_[i].pkt);
+      pos = i + 1;
+      if (i == target || target - i < CACHE_WINDOW) {
+        cacheFrame(i, got ? f : nullptr);
+      }
+    }
+  }
+
+  av_frame_free(&f);
+  avcodec_free_context(&ctx);
+}
+
+void FrameReader::cacheFrame(int idx, AVFrame *f) {
+  AVFrame *ref = f ? av_frame_clone(f) : nullptr;
+  {
+    std::unique_lock lk(cache_lock_);
+    CachedFrame &cf = yuv_cache_[idx];
+    cf.frame.reset(ref);
+    cf.failed = (ref == nullptr);
+    cf.last_use = ++cache_use_;
+    while (yuv_cache_.size() > CACHE_SIZE) {
+      auto oldest = yuv_cache_.begin();
+      for (auto it = yuv_cache_.begin(); it != yuv_cache_.end(); ++it) {
+        if (it->second.last_use < oldest->second.last_use) oldest = it;
+      }
+      yuv_cache_.erase(oldest);
+    }
+  }
+  cache_cv_.notify_all();
+}
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
+
+#include "selfdrive/common/queue.h"
 #include "selfdrive/ui/replay/filereader.h"
 
 extern "C" {
@@ -25,19 +32,42 @@ public:
   int width = 0, height = 0;
 
 private:
-  bool decode(int idx, uint8_t *rgb, uint8_t *yuv);
-  bool decodeFrame(AVFrame *f, uint8_t *rgb, uint8_t *yuv);
+  void decodeThread();
+  void cacheFrame(int idx, AVFrame *f);
 
   struct Frame {
     AVPacket pkt = {};
-    int decoded = false;
+    int gop_start = 0;  // packet index of the keyframe this frame's GOP starts at
+  };
+  struct AVFrameDeleter {
+    void operator()(AVFrame *frame) const { av_frame_free(&frame); }
+  };
+  // cached frames are refcounted views of the decoder's own buffers; the
+  // only plane copy left is the scale pass into the caller's VisionBuf
+  struct CachedFrame {
+    std::unique_ptr<AVFrame, AVFrameDeleter> frame;
+    uint64_t last_use = 0;
     bool failed = false;
   };
   std::vector<Frame> frames_;
+
+  // LRU of decoded & scaled frames, filled by the decoder pool
+  std::mutex cache_lock_;
+  std::condition_variable cache_cv_;
+  std::map<int, CachedFrame> yuv_cache_;
+  uint64_t cache_use_ = 0;
+  int last_requested_ = -1;
+
+  // each thread owns an AVCodecContext, so independent GOPs decode in parallel
+  std::vector<std::thread> decode_threads_;
+  SafeQueue<int> decode_jobs_;  // target frame index, -1 = exit
+  std::atomic<bool> exit_ = false;
+
   SwsContext *rgb_sws_ctx_ = nullptr, *yuv_sws_ctx_ = nullptr;
-  AVFrame *av_frame_, *rgb_frame_, *yuv_frame_ = nullptr;
+  AVFrame *rgb_frame_ = nullptr, *yuv_frame_ = nullptr;
   AVFormatContext *pFormatCtx_ = nullptr;
-  AVCodecContext *pCodecCtx_ = nullptr;
+  AVCodec *pCodec_ = nullptr;
+  int orig_width_ = 0, orig_height_ = 0;
   int key_frames_count_ = 0;
   bool valid_ = false;
   AVIOContext *avio_ctx_ = nullptr;
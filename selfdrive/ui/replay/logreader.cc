@@ -1,6 +1,11 @@
 #include "selfdrive/ui/replay/logreader.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "selfdrive/common/util.h"
+#include "selfdrive/loggerd/logger.h"
 #include "selfdrive/ui/replay/util.h"
 
 Event::Event(const kj::ArrayPtr<const capnp::word> &amsg, bool frame) : reader(amsg), frame(frame) {
@@ -46,33 +51,63 @@ LogReader::~LogReader() {
 #endif
 }
 
-bool LogReader::load(const std::string &file, std::atomic<bool> *abort) {
-  raw_ = decompressBZ2(read(file, abort));
-  if (raw_.empty()) return false;
-
-  kj::ArrayPtr<const capnp::word> words((const capnp::word *)raw_.data(), raw_.size() / sizeof(capnp::word));
-  while (words.size() > 0) {
-    try {
+Event *LogReader::addEvent(const kj::ArrayPtr<const capnp::word> &words) {
 #ifdef HAS_MEMORY_RESOURCE
-      Event *evt = new (mbr_) Event(words);
+  Event *evt = new (mbr_) Event(words);
 #else
-      Event *evt = new Event(words);
+  Event *evt = new Event(words);
 #endif
 
-      // Add encodeIdx packet again as a frame packet for the video stream
-      if (evt->which == cereal::Event::ROAD_ENCODE_IDX ||
-          evt->which == cereal::Event::DRIVER_ENCODE_IDX ||
-          evt->which == cereal::Event::WIDE_ROAD_ENCODE_IDX) {
+  // Add encodeIdx packet again as a frame packet for the video stream
+  if (evt->which == cereal::Event::ROAD_ENCODE_IDX ||
+      evt->which == cereal::Event::DRIVER_ENCODE_IDX ||
+      evt->which == cereal::Event::WIDE_ROAD_ENCODE_IDX) {
 #ifdef HAS_MEMORY_RESOURCE
-        Event *frame_evt = new (mbr_) Event(words, true);
+    Event *frame_evt = new (mbr_) Event(words, true);
 #else
-        Event *frame_evt = new Event(words, true);
+    Event *frame_evt = new Event(words, true);
 #endif
-        events.push_back(frame_evt);
+    events.push_back(frame_evt);
+  }
+
+  events.push_back(evt);
+  return evt;
+}
+
+bool LogReader::load(const std::string &file, std::atomic<bool> *abort,
+                     const std::vector<cereal::Event::Which> &filter) {
+  // re-opening a segment maps the decompressed log written by a previous run
+  // instead of paying for another bz2 decompress
+  const std::string cache_file = cache_to_local_ ? cacheFilePath(file) + "_decompressed" : "";
+  if (!cache_file.empty() && (map_ = util::map_file(cache_file))) {
+    data_ = map_.data();
+    data_size_ = map_.size();
+  } else {
+    raw_ = decompressBZ2Parallel(read(file, abort), abort);
+    if (raw_.empty()) return false;
+    if (!cache_file.empty()) {
+      const std::string tmp_file = cache_file + ".tmp";
+      std::ofstream fs(tmp_file, std::ios::binary | std::ios::trunc);
+      fs.write(raw_.data(), raw_.size());
+      fs.close();
+      if (fs.good()) {
+        ::rename(tmp_file.c_str(), cache_file.c_str());
       }
+    }
+    data_ = raw_.data();
+    data_size_ = raw_.size();
+  }
 
+  // without an index the whole log gets parsed; the filter is only a fast path
+  if (!filter.empty() && loadFromIndex(file, abort, filter)) {
+    return true;
+  }
+
+  kj::ArrayPtr<const capnp::word> words((const capnp::word *)data_, data_size_ / sizeof(capnp::word));
+  while (words.size() > 0) {
+    try {
+      Event *evt = addEvent(words);
       words = kj::arrayPtr(evt->reader.getEnd(), words.end());
-      events.push_back(evt);
     } catch (const kj::Exception &e) {
       return false;
     }
@@ -80,3 +115,33 @@ bool LogReader::load(const std::string &file, std::atomic<bool> *abort) {
   std::sort(events.begin(), events.end(), Event::lessThan());
   return true;
 }
+
+bool LogReader::loadFromIndex(const std::string &file, std::atomic<bool> *abort,
+                              const std::vector<cereal::Event::Which> &filter) {
+  // sidecar written by loggerd next to qlog.bz2, offsets are into the
+  // uncompressed stream
+  size_t ext = file.rfind(".bz2");
+  if (ext == std::string::npos) return false;
+  const std::string idx = read(file.substr(0, ext) + ".idx", abort);
+  if (idx.empty() || (idx.size() % sizeof(QlogIndexEntry)) != 0) return false;
+
+  auto entries = (const QlogIndexEntry *)idx.data();
+  for (size_t i = 0; i < idx.size() / sizeof(QlogIndexEntry); i++) {
+    const QlogIndexEntry &e = entries[i];
+    if (std::find(filter.begin(), filter.end(), (cereal::Event::Which)e.which) == filter.end()) continue;
+    if (e.offset >= data_size_ || (e.offset % sizeof(capnp::word)) != 0) {
+      events.clear();
+      return false;
+    }
+    kj::ArrayPtr<const capnp::word> words((const capnp::word *)(data_ + e.offset),
+                                          (data_size_ - e.offset) / sizeof(capnp::word));
+    try {
+      addEvent(words);
+    } catch (const kj::Exception &ex) {
+      events.clear();
+      return false;
+    }
+  }
+  std::sort(events.begin(), events.end(), Event::lessThan());
+  return true;
+}
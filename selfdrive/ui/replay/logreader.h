@@ -7,6 +7,7 @@
 
 #include "cereal/gen/cpp/log.capnp.h"
 #include "selfdrive/camerad/cameras/camera_common.h"
+#include "selfdrive/common/util.h"
 #include "selfdrive/ui/replay/filereader.h"
 
 const CameraType ALL_CAMERAS[] = {RoadCam, DriverCam, WideRoadCam};
@@ -50,12 +51,23 @@ class LogReader : protected FileReader {
 public:
   LogReader(bool local_cache = false, int chunk_size = -1, int retries = 0, size_t memory_pool_block_size = DEFAULT_EVENT_MEMORY_POOL_BLOCK_SIZE);
   ~LogReader();
-  bool load(const std::string &file, std::atomic<bool> *abort = nullptr);
+  // when a filter is given, only events of those types are loaded. if the
+  // segment has a qlog.idx sidecar, they are picked out of it by offset
+  // instead of parsing the entire log.
+  bool load(const std::string &file, std::atomic<bool> *abort = nullptr,
+            const std::vector<cereal::Event::Which> &filter = {});
 
   std::vector<Event*> events;
 
 private:
+  bool loadFromIndex(const std::string &file, std::atomic<bool> *abort,
+                     const std::vector<cereal::Event::Which> &filter);
+  Event *addEvent(const kj::ArrayPtr<const capnp::word> &words);
   std::string raw_;
+  // decompressed log cache shared across runs, mapped read-only
+  util::MapFile map_;
+  const char *data_ = nullptr;
+  size_t data_size_ = 0;
 #ifdef HAS_MEMORY_RESOURCE
   std::pmr::monotonic_buffer_resource *mbr_ = nullptr;
   void *pool_buffer_ = nullptr;
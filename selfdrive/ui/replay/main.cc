@@ -111,6 +111,7 @@ int main(int argc, char *argv[]) {
   parser.addOption({{"s", "start"}, "start from <seconds>", "seconds"});
   parser.addOption({"demo", "use a demo route instead of providing your own"});
   parser.addOption({"data_dir", "local directory with routes", "data_dir"});
+  parser.addOption({"budget", "memory budget for prefetched segments in MB", "MB"});
   for (auto &[name, _, desc] : flags) {
     parser.addOption({name, desc});
   }
@@ -132,6 +133,9 @@ int main(int argc, char *argv[]) {
     }
   }
   replay = new Replay(route, allow, block, nullptr, replay_flags, parser.value("data_dir"), &app);
+  if (int budget = parser.value("budget").toInt(); budget > 0) {
+    replay->setMemoryBudget(budget);
+  }
   if (!replay->load()) {
     return 0;
   }
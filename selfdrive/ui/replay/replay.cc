@@ -28,7 +28,7 @@ Replay::Replay(QString route, QStringList allow, QStringList block, SubMaster *s
     pm = new PubMaster(s);
   }
   route_ = std::make_unique<Route>(route, data_dir);
-  events_ = new std::vector<Event *>();
+  events_ = &event_buffers_[0];
 
   connect(this, &Replay::seekTo, this, &Replay::doSeek);
   connect(this, &Replay::segmentChanged, this, &Replay::queueSegment);
@@ -37,7 +37,6 @@ Replay::Replay(QString route, QStringList allow, QStringList block, SubMaster *s
 Replay::~Replay() {
   stop();
   delete pm;
-  delete events_;
 }
 
 void Replay::stop() {
@@ -107,6 +106,7 @@ void Replay::doSeek(int seconds, bool relative) {
     qInfo() << "seeking to" << seconds << "s, segment" << seg;
     current_segment_ = seg;
     cur_mono_time_ = route_start_ts_ + seconds * 1e9;
+    resend_state_ = true;
     return isSegmentMerged(seg);
   });
   queueSegment();
@@ -143,19 +143,21 @@ void Replay::queueSegment() {
 
   SegmentMap::iterator cur, end;
   cur = end = segments_.lower_bound(std::min(current_segment_.load(), segments_.rbegin()->first));
-  for (int i = 0; end != segments_.end() && i <= FORWARD_SEGS; ++i) {
+  for (int i = 0; end != segments_.end() && i <= forward_segs_; ++i) {
     ++end;
   }
-  // load one segment at a time
-  for (auto it = cur; it != end; ++it) {
+  // pipeline the prefetch: keep up to MAX_LOADING_SEGS in flight, nearest first,
+  // so the next segment downloads and parses while the current one plays
+  int loading = 0;
+  for (auto it = cur; it != end && loading < MAX_LOADING_SEGS; ++it) {
     if (!it->second) {
-      if (it == cur || std::prev(it)->second->isLoaded()) {
-        auto &[n, seg] = *it;
-        seg = std::make_unique<Segment>(n, route_->at(n), hasFlag(REPLAY_FLAG_DCAM), hasFlag(REPLAY_FLAG_ECAM), !hasFlag(REPLAY_FLAG_NO_FILE_CACHE));
-        QObject::connect(seg.get(), &Segment::loadFinished, this, &Replay::segmentLoadFinished);
-        qDebug() << "loading segment" << n << "...";
-      }
-      break;
+      auto &[n, seg] = *it;
+      seg = std::make_unique<Segment>(n, route_->at(n), hasFlag(REPLAY_FLAG_DCAM), hasFlag(REPLAY_FLAG_ECAM), !hasFlag(REPLAY_FLAG_NO_FILE_CACHE));
+      QObject::connect(seg.get(), &Segment::loadFinished, this, &Replay::segmentLoadFinished);
+      qDebug() << "loading segment" << n << "...";
+      ++loading;
+    } else if (!it->second->isLoaded()) {
+      ++loading;
     }
   }
   const auto &cur_segment = cur->second;
@@ -187,7 +189,11 @@ void Replay::mergeSegments(const SegmentMap::iterator &begin, const SegmentMap::
 
   if (segments_need_merge != segments_merged_) {
     qDebug() << "merge segments" << segments_need_merge;
-    std::vector<Event *> *new_events = new std::vector<Event *>();
+    // merge the per-segment sorted arrays into the buffer the stream thread
+    // isn't reading; events from segments staying in the window are not moved
+    // until the O(1) swap below
+    std::vector<Event *> *new_events = (events_ == &event_buffers_[0]) ? &event_buffers_[1] : &event_buffers_[0];
+    new_events->clear();
     new_events->reserve(std::accumulate(segments_need_merge.begin(), segments_need_merge.end(), 0,
                                         [=](int v, int n) { return v + segments_[n]->log->events.size(); }));
     for (int n : segments_need_merge) {
@@ -196,13 +202,21 @@ void Replay::mergeSegments(const SegmentMap::iterator &begin, const SegmentMap::
       std::inplace_merge(new_events->begin(), middle, new_events->end(), Event::lessThan());
     }
 
-    auto prev_events = events_;
+    // state-bearing services are resent after a seek from the snapshot
+    // preceding the seek point
+    std::map<cereal::Event::Which, std::vector<Event *>> new_state_events;
+    for (Event *e : *new_events) {
+      if (e->which == cereal::Event::Which::CAR_PARAMS || e->which == cereal::Event::Which::LIVE_CALIBRATION) {
+        new_state_events[e->which].push_back(e);
+      }
+    }
+
     updateEvents([&]() {
       events_ = new_events;
+      state_events_ = std::move(new_state_events);
       segments_merged_ = segments_need_merge;
       return true;
     });
-    delete prev_events;
   }
 }
 
@@ -287,6 +301,17 @@ void Replay::stream() {
       continue;
     }
 
+    if (resend_state_) {
+      resend_state_ = false;
+      for (auto &[which, evs] : state_events_) {
+        Event target(which, cur_mono_time_);
+        auto it = std::upper_bound(evs.begin(), evs.end(), &target, Event::lessThan());
+        if (it != evs.begin() && which < sockets_.size() && sockets_[which] != nullptr) {
+          publishMessage(*std::prev(it));
+        }
+      }
+    }
+
     uint64_t evt_start_ts = cur_mono_time_;
     uint64_t loop_start_ts = nanos_since_boot();
 
@@ -320,7 +345,7 @@ void Replay::stream() {
           // reset start times
           evt_start_ts = cur_mono_time_;
           loop_start_ts = nanos_since_boot();
-        } else if (behind_ns > 0) {
+        } else if (behind_ns > 0 && !hasFlag(REPLAY_FLAG_FULL_SPEED)) {
           precise_nano_sleep(behind_ns);
         }
 
@@ -6,7 +6,10 @@
 #include "selfdrive/ui/replay/route.h"
 
 // one segment uses about 100M of memory
+constexpr int SEGMENT_MEMORY_MB = 100;
 constexpr int FORWARD_SEGS = 5;
+// segments downloading/parsing concurrently while the current one plays
+constexpr int MAX_LOADING_SEGS = 2;
 
 enum REPLAY_FLAGS {
   REPLAY_FLAG_NONE = 0x0000,
@@ -14,6 +17,7 @@ enum REPLAY_FLAGS {
   REPLAY_FLAG_ECAM = 0x0004,
   REPLAY_FLAG_NO_LOOP = 0x0010,
   REPLAY_FLAG_NO_FILE_CACHE = 0x0020,
+  REPLAY_FLAG_FULL_SPEED = 0x0040,
 };
 
 class Replay : public QObject {
@@ -28,6 +32,8 @@ public:
   void stop();
   void pause(bool pause);
   bool isPaused() const { return paused_; }
+  // sizes the prefetch window; one segment is ~SEGMENT_MEMORY_MB
+  void setMemoryBudget(int mb) { forward_segs_ = std::clamp(mb / SEGMENT_MEMORY_MB - 1, 1, 20); }
   inline bool hasFlag(REPLAY_FLAGS flag) { return flags_ & flag; };
 
 signals:
@@ -60,14 +66,23 @@ protected:
   std::condition_variable stream_cv_;
   std::atomic<bool> updating_events_ = false;
   std::atomic<int> current_segment_ = 0;
+  int forward_segs_ = FORWARD_SEGS;
   SegmentMap segments_;
   // the following variables must be protected with stream_lock_
   bool exit_ = false;
   bool paused_ = false;
   bool events_updated_ = false;
+  bool resend_state_ = false;
   uint64_t route_start_ts_ = 0;
   uint64_t cur_mono_time_ = 0;
+  // double buffer: the window merge fills the spare vector off the stream
+  // lock and the swap under it is O(1), so the buffers' capacity is reused
+  // instead of reallocating ~100k pointers per segment boundary
+  std::vector<Event *> event_buffers_[2];
   std::vector<Event *> *events_ = nullptr;
+  // per-service sorted events for state-bearing services, so a seek can
+  // replay the latest snapshot instead of streaming from the segment start
+  std::map<cereal::Event::Which, std::vector<Event *>> state_events_;
   std::vector<int> segments_merged_;
 
   // messaging
@@ -1,12 +1,15 @@
 #include "selfdrive/ui/replay/route.h"
 
+#include <QDateTime>
 #include <QDir>
 #include <QEventLoop>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QRegExp>
 #include <QtConcurrent>
 
+#include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
 #include "selfdrive/ui/qt/api.h"
 #include "selfdrive/ui/replay/util.h"
@@ -23,12 +26,50 @@ RouteIdentifier Route::parseRoute(const QString &str) {
   return {list[1], list[3], list[5].toInt(), list[1] + "|" + list[3]};
 }
 
+// segment manifests are cached on disk: the signed URLs stay usable for a
+// while, so reopening a recent route can skip the API round trips entirely
+const int ROUTE_CACHE_TTL_SECS = 60 * 60;
+
 bool Route::load() {
   if (route_.str.isEmpty()) {
     qInfo() << "invalid route format";
     return false;
   }
-  return data_dir_.isEmpty() ? loadFromServer() : loadFromLocal();
+  if (!data_dir_.isEmpty()) {
+    return loadFromLocal();
+  }
+
+  QFileInfo cache(cacheFile());
+  if (cache.exists() && cache.lastModified().secsTo(QDateTime::currentDateTime()) < ROUTE_CACHE_TTL_SECS) {
+    const std::string json = util::read_file(cache.filePath().toStdString());
+    if (!json.empty() && loadFromJson(QString::fromStdString(json))) {
+      // playback starts from the cached manifest; renew it in the background
+      // so the next open of this route is just as fast
+      refreshManifest();
+      return true;
+    }
+    segments_.clear();
+  }
+  return loadFromServer();
+}
+
+QString Route::cacheFile() const {
+  return QString::fromStdString(cacheFilePath(route_.str.toStdString() + "/files"));
+}
+
+QString Route::manifestUrl() const {
+  return "https://api.commadotai.com/v1/route/" + route_.str + "/files";
+}
+
+void Route::refreshManifest() {
+  HttpRequest *http = new HttpRequest(nullptr, !Hardware::PC());
+  const QString cache_file = cacheFile();
+  QObject::connect(http, &HttpRequest::receivedResponse, [=](const QString &json) {
+    const QByteArray data = json.toUtf8();
+    util::write_file(cache_file.toStdString().c_str(), data.data(), data.size(), O_WRONLY | O_CREAT | O_TRUNC);
+  });
+  QObject::connect(http, &HttpRequest::requestDone, http, &HttpRequest::deleteLater);
+  http->sendRequest(manifestUrl());
 }
 
 bool Route::loadFromServer() {
@@ -37,9 +78,14 @@ bool Route::loadFromServer() {
   QObject::connect(&http, &HttpRequest::failedResponse, [&] { loop.exit(0); });
   QObject::connect(&http, &HttpRequest::timeoutResponse, [&] { loop.exit(0); });
   QObject::connect(&http, &HttpRequest::receivedResponse, [&](const QString &json) {
-    loop.exit(loadFromJson(json));
+    bool ret = loadFromJson(json);
+    if (ret) {
+      const QByteArray data = json.toUtf8();
+      util::write_file(cacheFile().toStdString().c_str(), data.data(), data.size(), O_WRONLY | O_CREAT | O_TRUNC);
+    }
+    loop.exit(ret);
   });
-  http.sendRequest("https://api.commadotai.com/v1/route/" + route_.str + "/files");
+  http.sendRequest(manifestUrl());
   return loop.exec();
 }
 
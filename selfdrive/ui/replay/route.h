@@ -35,6 +35,9 @@ protected:
   bool loadFromLocal();
   bool loadFromServer();
   bool loadFromJson(const QString &json);
+  QString cacheFile() const;
+  QString manifestUrl() const;
+  void refreshManifest();
   void addFileToSegment(int seg_num, const QString &file);
   RouteIdentifier route_ = {};
   QString data_dir_;
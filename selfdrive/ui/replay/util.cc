@@ -4,11 +4,17 @@
 #include <curl/curl.h>
 #include <openssl/sha.h>
 
+#include <unistd.h>
+
 #include <cassert>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <mutex>
 #include <numeric>
+#include <thread>
+#include <vector>
 
 #include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
@@ -26,9 +32,25 @@ struct MultiPartWriter {
   size_t offset;
   size_t end;
   size_t written;
+  int part;
   std::ostream *os;
 };
 
+// connections, DNS entries and TLS sessions are pooled across all transfers
+CURLSH *getCurlShare() {
+  static std::mutex locks[CURL_LOCK_DATA_LAST];
+  static CURLSH *share = [] {
+    CURLSH *sh = curl_share_init();
+    curl_share_setopt(sh, CURLSHOPT_LOCKFUNC, +[](CURL *, curl_lock_data data, curl_lock_access, void *) { locks[data].lock(); });
+    curl_share_setopt(sh, CURLSHOPT_UNLOCKFUNC, +[](CURL *, curl_lock_data data, void *) { locks[data].unlock(); });
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    return sh;
+  }();
+  return share;
+}
+
 size_t write_cb(char *data, size_t size, size_t count, void *userp) {
   MultiPartWriter *w = (MultiPartWriter *)userp;
   w->os->seekp(w->offset);
@@ -81,7 +103,8 @@ void enableHttpLogging(bool enable) {
   enable_http_logging = enable;
 }
 
-bool httpMultiPartDownload(const std::string &url, std::ostream &os, int parts, size_t content_length, std::atomic<bool> *abort) {
+static bool multiPartDownload(const std::string &url, std::ostream &os, int parts, size_t content_length,
+                              std::vector<size_t> *resume, std::atomic<bool> *abort) {
   static CURLGlobalInitializer curl_initializer;
   static std::mutex lock;
   static uint64_t total_written = 0, prev_total_written = 0;
@@ -94,26 +117,36 @@ bool httpMultiPartDownload(const std::string &url, std::ostream &os, int parts,
 
   std::map<CURL *, MultiPartWriter> writers;
   const int part_size = content_length / parts;
+  int active_parts = 0;
   for (int i = 0; i < parts; ++i) {
+    const size_t offset = (size_t)(i * part_size);
+    const size_t end = i == parts - 1 ? content_length - 1 : (i + 1) * part_size - 1;
+    const size_t done = resume ? (*resume)[i] : 0;
+    if (offset + done > end) continue;  // this part already finished in a previous run
+
     CURL *eh = curl_easy_init();
     writers[eh] = {
         .os = &os,
-        .offset = (size_t)(i * part_size),
-        .end = i == parts - 1 ? content_length - 1 : (i + 1) * part_size - 1,
+        .offset = offset + done,
+        .end = end,
+        .written = done,
+        .part = i,
     };
     curl_easy_setopt(eh, CURLOPT_WRITEFUNCTION, write_cb);
     curl_easy_setopt(eh, CURLOPT_WRITEDATA, (void *)(&writers[eh]));
     curl_easy_setopt(eh, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(eh, CURLOPT_RANGE, util::string_format("%d-%d", writers[eh].offset, writers[eh].end).c_str());
+    curl_easy_setopt(eh, CURLOPT_RANGE, util::string_format("%zu-%zu", writers[eh].offset, writers[eh].end).c_str());
     curl_easy_setopt(eh, CURLOPT_HTTPGET, 1);
     curl_easy_setopt(eh, CURLOPT_NOSIGNAL, 1);
     curl_easy_setopt(eh, CURLOPT_FOLLOWLOCATION, 1);
+    curl_easy_setopt(eh, CURLOPT_SHARE, getCurlShare());
 
     curl_multi_add_handle(cm, eh);
+    ++active_parts;
   }
 
-  int still_running = 1;
-  size_t prev_written = 0;
+  int still_running = active_parts > 0;
+  size_t prev_written = std::accumulate(writers.begin(), writers.end(), (size_t)0, [](size_t v, auto &w) { return v + w.second.written; });
   while (still_running > 0 && !(abort && *abort)) {
     curl_multi_wait(cm, nullptr, 0, 1000, nullptr);
     curl_multi_perform(cm, &still_running);
@@ -156,24 +189,68 @@ bool httpMultiPartDownload(const std::string &url, std::ostream &os, int parts,
   }
 
   for (auto &[e, w] : writers) {
+    if (resume) (*resume)[w.part] = w.written;
     curl_multi_remove_handle(cm, e);
     curl_easy_cleanup(e);
   }
 
   curl_multi_cleanup(cm);
-  return complete == parts;
+  return complete == active_parts;
+}
+
+bool httpMultiPartDownload(const std::string &url, std::ostream &os, int parts, size_t content_length, std::atomic<bool> *abort) {
+  return multiPartDownload(url, os, parts, content_length, nullptr, abort);
+}
+
+bool httpDownloadToFile(const std::string &url, const std::string &file, int parts, size_t content_length, std::atomic<bool> *abort) {
+  // per-part progress is persisted next to the file so an interrupted
+  // transfer resumes instead of restarting
+  const std::string progress_file = file + ".parts";
+  std::vector<size_t> resume(parts, 0);
+  if (util::file_exists(file) && util::file_exists(progress_file)) {
+    std::ifstream ps(progress_file);
+    int n = 0;
+    ps >> n;
+    if (n == parts) {
+      for (auto &p : resume) ps >> p;
+    }
+    if (n != parts || !ps) {  // part layout changed, start over
+      resume.assign(parts, 0);
+    }
+  }
+
+  std::fstream fs(file, std::ios::binary | std::ios::in | std::ios::out);
+  if (!fs.is_open()) {
+    fs.open(file, std::ios::binary | std::ios::out);
+  }
+  if (!fs.is_open()) return false;
+
+  bool ret = multiPartDownload(url, fs, parts, content_length, &resume, abort);
+  fs.close();
+  if (ret) {
+    ::unlink(progress_file.c_str());
+  } else {
+    std::ofstream ps(progress_file, std::ios::trunc);
+    ps << parts << "\n";
+    for (size_t p : resume) ps << p << "\n";
+  }
+  return ret;
 }
 
 std::string decompressBZ2(const std::string &in) {
-  if (in.empty()) return {};
+  return decompressBZ2(in.data(), in.size());
+}
+
+std::string decompressBZ2(const char *in, size_t size) {
+  if (size == 0) return {};
 
   bz_stream strm = {};
   int bzerror = BZ2_bzDecompressInit(&strm, 0, 0);
   assert(bzerror == BZ_OK);
 
-  strm.next_in = (char *)in.data();
-  strm.avail_in = in.size();
-  std::string out(in.size() * 5, '\0');
+  strm.next_in = (char *)in;
+  strm.avail_in = size;
+  std::string out(size * 5, '\0');
   do {
     strm.next_out = (char *)(&out[strm.total_out_lo32]);
     strm.avail_out = out.size() - strm.total_out_lo32;
@@ -191,6 +268,58 @@ std::string decompressBZ2(const std::string &in) {
   return {};
 }
 
+// byte offsets of bz2 stream headers ("BZh" + level + block magic). streams
+// in a concatenated archive are byte aligned, and a 10-byte match inside
+// compressed payload is practically impossible
+static std::vector<size_t> bz2StreamOffsets(const std::string &in) {
+  static const char block_magic[] = "\x31\x41\x59\x26\x53\x59";
+  std::vector<size_t> offsets;
+  for (size_t pos = 0; (pos = in.find("BZh", pos)) != std::string::npos; ++pos) {
+    if (pos + 10 <= in.size() && in[pos + 3] >= '1' && in[pos + 3] <= '9' &&
+        memcmp(&in[pos + 4], block_magic, 6) == 0) {
+      offsets.push_back(pos);
+    }
+  }
+  return offsets;
+}
+
+std::string decompressBZ2Parallel(const std::string &in, std::atomic<bool> *abort) {
+  std::vector<size_t> offsets = bz2StreamOffsets(in);
+  if (offsets.empty() || offsets[0] != 0) return {};
+  if (offsets.size() == 1) {
+    return decompressBZ2(in);
+  }
+
+  offsets.push_back(in.size());
+  std::vector<std::string> outs(offsets.size() - 1);
+  std::atomic<size_t> next_stream = 0;
+  std::atomic<bool> failed = false;
+
+  const size_t workers = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), outs.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workers; ++i) {
+    threads.emplace_back([&] {
+      size_t n;
+      while ((n = next_stream++) < outs.size() && !failed && !(abort && *abort)) {
+        outs[n] = decompressBZ2(in.data() + offsets[n], offsets[n + 1] - offsets[n]);
+        if (outs[n].empty()) failed = true;
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+  if (failed || (abort && *abort)) return {};
+
+  size_t total = std::accumulate(outs.begin(), outs.end(), (size_t)0, [](size_t v, auto &o) { return v + o.size(); });
+  std::string out;
+  out.reserve(total);
+  for (auto &o : outs) {
+    out.append(o);
+    o.clear();
+    o.shrink_to_fit();
+  }
+  return out;
+}
+
 void precise_nano_sleep(long sleep_ns) {
   const long estimate_ns = 1 * 1e6;  // 1ms
   struct timespec req = {.tv_nsec = estimate_ns};
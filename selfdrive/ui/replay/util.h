@@ -7,7 +7,12 @@
 std::string sha256(const std::string &str);
 void precise_nano_sleep(long sleep_ns);
 std::string decompressBZ2(const std::string &in);
+std::string decompressBZ2(const char *in, size_t size);
+// multi-stream archives are split at stream boundaries and inflated across
+// the host cores; single-stream files take the serial path
+std::string decompressBZ2Parallel(const std::string &in, std::atomic<bool> *abort = nullptr);
 void enableHttpLogging(bool enable);
 std::string getUrlWithoutQuery(const std::string &url);
 size_t getRemoteFileSize(const std::string &url);
 bool httpMultiPartDownload(const std::string &url, std::ostream &os, int parts, size_t content_length, std::atomic<bool> *abort = nullptr);
+bool httpDownloadToFile(const std::string &url, const std::string &file, int parts, size_t content_length, std::atomic<bool> *abort = nullptr);
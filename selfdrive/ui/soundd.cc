@@ -1,10 +1,15 @@
+#include <sys/mman.h>
 #include <sys/resource.h>
 
+#include <atomic>
+#include <cstdint>
 #include <map>
 
 #include <QApplication>
+#include <QAudioFormat>
+#include <QAudioOutput>
+#include <QIODevice>
 #include <QString>
-#include <QSoundEffect>
 #include <string>  //opkr
 
 #include "selfdrive/ui/qt/util.h"
@@ -21,6 +26,129 @@ void sigHandler(int s) {
   qApp->quit();
 }
 
+// all alerts are mixed into one persistent stream in this format
+const int MIXER_SAMPLE_RATE = 48000;
+// ~21ms of audio per period keeps alert onset latency low
+const int MIXER_BUFFER_SIZE = 2048;
+
+struct AlertSample {
+  std::vector<int16_t> pcm;  // mono, MIXER_SAMPLE_RATE
+  bool loop = false;
+};
+
+// decode a 16-bit PCM wav, downmix to mono and resample to the mixer rate
+static AlertSample loadAlertSample(const QString &fn, bool loop) {
+  AlertSample s;
+  s.loop = loop;
+
+  const std::string raw = util::read_file(fn.toStdString());
+  if (raw.size() < 44 || raw.compare(0, 4, "RIFF") != 0 || raw.compare(8, 4, "WAVE") != 0) return s;
+
+  int channels = 0, sample_rate = 0;
+  const int16_t *data = nullptr;
+  size_t data_frames = 0;
+  for (size_t pos = 12; pos + 8 <= raw.size();) {
+    const uint32_t chunk_size = *(const uint32_t *)&raw[pos + 4];
+    if (pos + 8 + chunk_size > raw.size()) break;
+    if (raw.compare(pos, 4, "fmt ") == 0 && chunk_size >= 16) {
+      const uint16_t format = *(const uint16_t *)&raw[pos + 8];
+      channels = *(const uint16_t *)&raw[pos + 10];
+      sample_rate = *(const uint32_t *)&raw[pos + 12];
+      const uint16_t bits = *(const uint16_t *)&raw[pos + 22];
+      if (format != 1 || bits != 16 || channels < 1) return s;
+    } else if (raw.compare(pos, 4, "data") == 0 && channels > 0) {
+      data = (const int16_t *)&raw[pos + 8];
+      data_frames = chunk_size / (channels * sizeof(int16_t));
+      break;
+    }
+    pos += 8 + chunk_size + (chunk_size & 1);
+  }
+  if (!data || data_frames == 0) return s;
+
+  const size_t out_frames = (size_t)((uint64_t)data_frames * MIXER_SAMPLE_RATE / sample_rate);
+  s.pcm.resize(out_frames);
+  for (size_t i = 0; i < out_frames; ++i) {
+    // linear interpolation is plenty for short chimes
+    const double t = (double)i * sample_rate / MIXER_SAMPLE_RATE;
+    const size_t f0 = std::min((size_t)t, data_frames - 1);
+    const size_t f1 = std::min(f0 + 1, data_frames - 1);
+    const double frac = t - f0;
+    int32_t a = 0, b = 0;
+    for (int c = 0; c < channels; ++c) {
+      a += data[f0 * channels + c];
+      b += data[f1 * channels + c];
+    }
+    s.pcm[i] = (int16_t)((a * (1.0 - frac) + b * frac) / channels);
+  }
+
+  // alert samples must not be paged out while we're driving
+  mlock(s.pcm.data(), s.pcm.size() * sizeof(int16_t));
+  return s;
+}
+
+// pull-mode source for the persistent output stream. the audio thread calls
+// readData every period; starting or stopping an alert is just a pointer and
+// gain change picked up on the next period instead of a new stream setup.
+class Mixer : public QIODevice {
+public:
+  Mixer() { open(QIODevice::ReadOnly); }
+
+  void play(const AlertSample *s, float vol) {
+    volume_ = vol;
+    cmd_.store((uintptr_t)s);
+  }
+  void stop() { cmd_.store(kStopCmd); }
+
+  qint64 readData(char *data, qint64 maxlen) override {
+    // consume a pending play/stop as one unit, so a play() landing while
+    // this runs can't have its position reset clobbered by the write-back
+    // of a stale offset below. sample_/pos_ are owned by this thread.
+    uintptr_t cmd = cmd_.exchange(kNoCmd);
+    if (cmd == kStopCmd) {
+      sample_ = nullptr;
+    } else if (cmd != kNoCmd) {
+      sample_ = (const AlertSample *)cmd;
+      pos_ = 0;
+    }
+
+    int16_t *out = (int16_t *)data;
+    const qint64 frames = maxlen / sizeof(int16_t);
+    const AlertSample *s = sample_;
+    const float vol = volume_.load();
+    size_t pos = pos_;
+    for (qint64 i = 0; i < frames; ++i) {
+      int16_t v = 0;
+      if (s) {
+        if (pos >= s->pcm.size()) {
+          if (!s->loop) {
+            sample_ = nullptr;
+            s = nullptr;
+          } else {
+            pos = 0;
+          }
+        }
+        if (s) v = (int16_t)(s->pcm[pos++] * vol);
+      }
+      out[i] = v;
+    }
+    pos_ = pos;
+    return frames * sizeof(int16_t);
+  }
+  qint64 writeData(const char *, qint64) override { return 0; }
+  bool isSequential() const override { return true; }
+
+private:
+  // pending command from the UI thread: a sample pointer starts it from the
+  // beginning, kStopCmd cuts playback, kNoCmd leaves the state alone
+  static constexpr uintptr_t kNoCmd = 0;
+  static constexpr uintptr_t kStopCmd = 1;
+  std::atomic<uintptr_t> cmd_ = kNoCmd;
+  std::atomic<float> volume_ = 0.;
+  // audio-thread state, only touched from readData
+  const AlertSample *sample_ = nullptr;
+  size_t pos_ = 0;
+};
+
 class Sound : public QObject {
 public:
   explicit Sound(QObject *parent = 0) {
@@ -37,12 +165,21 @@ public:
       {AudibleAlert::CHIME_PROMPT, sound_asset_path + "error.wav", false}
     };
     for (auto &[alert, fn, loops] : sound_list) {
-      QSoundEffect *s = new QSoundEffect(this);
-      QObject::connect(s, &QSoundEffect::statusChanged, this, &Sound::checkStatus);
-      s->setSource(QUrl::fromLocalFile(fn));
-      sounds[alert] = {s, loops ? QSoundEffect::Infinite : 0};
+      sounds[alert] = loadAlertSample(fn, loops);
+      assert(!sounds[alert].pcm.empty());
     }
 
+    QAudioFormat format;
+    format.setSampleRate(MIXER_SAMPLE_RATE);
+    format.setChannelCount(1);
+    format.setSampleSize(16);
+    format.setCodec("audio/pcm");
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setSampleType(QAudioFormat::SignedInt);
+    audio_out = new QAudioOutput(format, this);
+    audio_out->setBufferSize(MIXER_BUFFER_SIZE);
+    audio_out->start(&mixer);
+
     sm = new SubMaster({"carState", "controlsState"});
 
     QTimer *timer = new QTimer(this);
@@ -50,15 +187,11 @@ public:
     timer->start();
   };
   ~Sound() {
+    audio_out->stop();
     delete sm;
   };
 
 private slots:
-  void checkStatus() {
-    QSoundEffect *s = qobject_cast<QSoundEffect*>(sender());
-    assert(s->status() != QSoundEffect::Error);
-  }
-
   void update() {
     sm->update(100);
     if (sm->updated("carState")) {
@@ -81,26 +214,23 @@ private slots:
   void setAlert(Alert a) {
     if (!alert.equal(a)) {
       alert = a;
-      // stop sounds
-      for (auto &[s, loops] : sounds) {
-        // Only stop repeating sounds
-        if (s->loopsRemaining() == QSoundEffect::Infinite) {
-          s->stop();
-        }
+      // Only stop repeating sounds; an in-flight one-shot chime runs to
+      // completion instead of being cut off
+      if (playing != nullptr && playing->loop) {
+        mixer.stop();
       }
+      playing = nullptr;
 
       // play sound
       if (alert.sound != AudibleAlert::NONE) {
-        auto &[s, loops] = sounds[alert.sound];
-        s->setLoopCount(loops);
+        float vol = volume;
         if ((std::stof(Params().get("OpkrUIVolumeBoost")) * 0.01) < -0.03) {
-          s->setVolume(0.0);
+          vol = 0.0;
         } else if ((std::stof(Params().get("OpkrUIVolumeBoost")) * 0.01) > 0.03) {
-          s->setVolume(std::stof(Params().get("OpkrUIVolumeBoost")) * 0.01);
-        } else {
-          s->setVolume(volume);
+          vol = std::stof(Params().get("OpkrUIVolumeBoost")) * 0.01;
         }
-        s->play();
+        mixer.play(&sounds[alert.sound], vol);
+        playing = &sounds[alert.sound];
       }
     }
   }
@@ -108,7 +238,11 @@ private slots:
 private:
   Alert alert;
   float volume = Hardware::MIN_VOLUME;
-  QMap<AudibleAlert, QPair<QSoundEffect*, int>> sounds;
+  // sample handed to the mixer for the current alert, if any
+  const AlertSample *playing = nullptr;
+  std::map<AudibleAlert, AlertSample> sounds;
+  Mixer mixer;
+  QAudioOutput *audio_out;
   SubMaster *sm;
 };
 
@@ -8,6 +8,7 @@
 #include <cmath>
 #include <cstdio>
 
+#include "cereal/gen/cpp/hot_fields.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/watchdog.h"
 #include "selfdrive/hardware/hw.h"
@@ -22,8 +23,7 @@
 static bool calib_frame_to_full_frame(const UIState *s, float in_x, float in_y, float in_z, vertex_data *out) {
   const float margin = 500.0f;
   const vec3 pt = (vec3){{in_x, in_y, in_z}};
-  const vec3 Ep = matvecmul3(s->scene.view_from_calib, pt);
-  const vec3 KEp = matvecmul3(s->wide_camera ? ecam_intrinsic_matrix : fcam_intrinsic_matrix, Ep);
+  const vec3 KEp = matvecmul3(s->scene.calib_proj, pt);
 
   // Project.
   float x = KEp.v[0] / KEp.v[2];
@@ -46,9 +46,11 @@ static void update_leads(UIState *s, const cereal::ModelDataV2::Reader &model) {
   auto leads = model.getLeadsV3();
   auto model_position = model.getPosition();
   for (int i = 0; i < 2; ++i) {
+    s->scene.lead_probs[i] = leads[i].getProb();
+    s->scene.lead_x[i] = leads[i].getX()[0];
     if (leads[i].getProb() > 0.5) {
       float z = model_position.getZ()[get_path_length_idx(model_position, leads[i].getX()[0])];
-      calib_frame_to_full_frame(s, leads[i].getX()[0], leads[i].getY()[0], z + 1.22, &s->scene.lead_vertices[i]);
+      calib_frame_to_full_frame(s, leads[i].getX()[0], leads[i].getY()[0], z + 1.22, &s->scene.model_geom[1].lead_vertices[i]);
     }
   }
 }
@@ -56,12 +58,26 @@ static void update_leads(UIState *s, const cereal::ModelDataV2::Reader &model) {
 static void update_line_data(const UIState *s, const cereal::ModelDataV2::XYZTData::Reader &line,
                              float y_off, float z_off, line_vertices_data *pvd, int max_idx) {
   const auto line_x = line.getX(), line_y = line.getY(), line_z = line.getZ();
-  vertex_data *v = &pvd->v[0];
+
+  // the composed calib->image matrix is precomputed per calibration update
+  // and applied to all points in a batch (NEON on device)
+  const mat3 &proj = s->scene.calib_proj;
+  const int n = 2 * (max_idx + 1);
+  float x[2 * TRAJECTORY_SIZE], y[2 * TRAJECTORY_SIZE], z[2 * TRAJECTORY_SIZE];
   for (int i = 0; i <= max_idx; i++) {
-    v += calib_frame_to_full_frame(s, line_x[i], line_y[i] - y_off, line_z[i] + z_off, v);
+    x[i] = x[n - 1 - i] = line_x[i];
+    y[i] = line_y[i] - y_off;
+    y[n - 1 - i] = line_y[i] + y_off;
+    z[i] = z[n - 1 - i] = line_z[i] + z_off;
   }
-  for (int i = max_idx; i >= 0; i--) {
-    v += calib_frame_to_full_frame(s, line_x[i], line_y[i] + y_off, line_z[i] + z_off, v);
+  float ex[2 * TRAJECTORY_SIZE], ey[2 * TRAJECTORY_SIZE], ez[2 * TRAJECTORY_SIZE];
+  batch_matvecmul3(proj, x, y, z, ex, ey, ez, n);
+
+  const float margin = 500.0f;
+  vertex_data *v = &pvd->v[0];
+  for (int i = 0; i < n; i++) {
+    nvgTransformPoint(&v->x, &v->y, s->car_space_transform, ex[i] / ez[i], ey[i] / ez[i]);
+    v += (v->x >= -margin && v->x <= s->fb_w + margin && v->y >= -margin && v->y <= s->fb_h + margin);
   }
   pvd->cnt = v - pvd->v;
   assert(pvd->cnt <= std::size(pvd->v));
@@ -69,6 +85,7 @@ static void update_line_data(const UIState *s, const cereal::ModelDataV2::XYZTDa
 
 static void update_model(UIState *s, const cereal::ModelDataV2::Reader &model) {
   UIScene &scene = s->scene;
+  model_geometry &geom = scene.model_geom[1];
   auto model_position = model.getPosition();
   float max_distance = std::clamp(model_position.getX()[TRAJECTORY_SIZE - 1],
                                   MIN_DRAW_DISTANCE, MAX_DRAW_DISTANCE);
@@ -77,17 +94,17 @@ static void update_model(UIState *s, const cereal::ModelDataV2::Reader &model) {
   const auto lane_lines = model.getLaneLines();
   const auto lane_line_probs = model.getLaneLineProbs();
   int max_idx = get_path_length_idx(lane_lines[0], max_distance);
-  for (int i = 0; i < std::size(scene.lane_line_vertices); i++) {
+  for (int i = 0; i < std::size(geom.lane_line_vertices); i++) {
     scene.lane_line_probs[i] = lane_line_probs[i];
-    update_line_data(s, lane_lines[i], 0.025 * scene.lane_line_probs[i], 0, &scene.lane_line_vertices[i], max_idx);
+    update_line_data(s, lane_lines[i], 0.025 * scene.lane_line_probs[i], 0, &geom.lane_line_vertices[i], max_idx);
   }
 
   // update road edges
   const auto road_edges = model.getRoadEdges();
   const auto road_edge_stds = model.getRoadEdgeStds();
-  for (int i = 0; i < std::size(scene.road_edge_vertices); i++) {
+  for (int i = 0; i < std::size(geom.road_edge_vertices); i++) {
     scene.road_edge_stds[i] = road_edge_stds[i];
-    update_line_data(s, road_edges[i], 0.2, 0, &scene.road_edge_vertices[i], max_idx);
+    update_line_data(s, road_edges[i], 0.2, 0, &geom.road_edge_vertices[i], max_idx);
   }
 
   // update path
@@ -97,7 +114,7 @@ static void update_model(UIState *s, const cereal::ModelDataV2::Reader &model) {
     max_distance = std::clamp((float)(lead_d - fmin(lead_d * 0.35, 10.)), 0.0f, max_distance);
   }
   max_idx = get_path_length_idx(model_position, max_distance);
-  update_line_data(s, model_position, 1.0, 1.22, &scene.track_vertices, max_idx);
+  update_line_data(s, model_position, 1.0, 1.22, &geom.track_vertices, max_idx);
 }
 
 static void update_sockets(UIState *s) {
@@ -138,35 +155,38 @@ static void update_state(UIState *s) {
   }
   if (sm.updated("carState")) {
     scene.car_state = sm["carState"].getCarState();
-    auto cs_data = sm["carState"].getCarState();
+    // scalar extraction goes through the generated direct-offset accessors:
+    // one data-section bind per message instead of a bounds check per field
+    cereal_hot::CarState cs_data;
+    cs_data.bind(scene.car_state);
     auto cruiseState = scene.car_state.getCruiseState();
     scene.awake = cruiseState.getCruiseSwState();
 
-    if (scene.leftBlinker!=cs_data.getLeftBlinker() || scene.rightBlinker!=cs_data.getRightBlinker()) {
+    if (scene.leftBlinker!=cs_data.leftBlinker() || scene.rightBlinker!=cs_data.rightBlinker()) {
       scene.blinker_blinkingrate = 120;
     }
-    scene.brakePress = cs_data.getBrakePressed();
-    scene.brakeLights = cs_data.getBrakeLights();
-    scene.currentGear = cs_data.getCurrentGear();
-    scene.electGearStep = cs_data.getElectGearStep();
-    scene.getGearShifter = cs_data.getGearShifter();
-    scene.leftBlinker = cs_data.getLeftBlinker();
-    scene.rightBlinker = cs_data.getRightBlinker();
-    scene.leftblindspot = cs_data.getLeftBlindspot();
-    scene.rightblindspot = cs_data.getRightBlindspot();
-    scene.tpmsPressureFl = cs_data.getTpmsPressureFl();
-    scene.tpmsPressureFr = cs_data.getTpmsPressureFr();
-    scene.tpmsPressureRl = cs_data.getTpmsPressureRl();
-    scene.tpmsPressureRr = cs_data.getTpmsPressureRr();
-    scene.radarDistance = cs_data.getRadarDistance();
-    scene.standStill = cs_data.getStandStill();
-    scene.vSetDis = cs_data.getVSetDis();
-    scene.cruiseAccStatus = cs_data.getCruiseAccStatus();
-    scene.angleSteers = cs_data.getSteeringAngleDeg();
-    scene.cruise_gap = cs_data.getCruiseGapSet();
-    scene.brakeHold = cs_data.getBrakeHold();
-    scene.steer_warning = cs_data.getSteerWarning();
-    scene.stand_still = cs_data.getStandstill();
+    scene.brakePress = cs_data.brakePressed();
+    scene.brakeLights = cs_data.brakeLights();
+    scene.currentGear = cs_data.currentGear();
+    scene.electGearStep = cs_data.electGearStep();
+    scene.getGearShifter = scene.car_state.getGearShifter();
+    scene.leftBlinker = cs_data.leftBlinker();
+    scene.rightBlinker = cs_data.rightBlinker();
+    scene.leftblindspot = cs_data.leftBlindspot();
+    scene.rightblindspot = cs_data.rightBlindspot();
+    scene.tpmsPressureFl = cs_data.tpmsPressureFl();
+    scene.tpmsPressureFr = cs_data.tpmsPressureFr();
+    scene.tpmsPressureRl = cs_data.tpmsPressureRl();
+    scene.tpmsPressureRr = cs_data.tpmsPressureRr();
+    scene.radarDistance = cs_data.radarDistance();
+    scene.standStill = cs_data.standStill();
+    scene.vSetDis = cs_data.vSetDis();
+    scene.cruiseAccStatus = cs_data.cruiseAccStatus();
+    scene.angleSteers = cs_data.steeringAngleDeg();
+    scene.cruise_gap = cs_data.cruiseGapSet();
+    scene.brakeHold = cs_data.brakeHold();
+    scene.steer_warning = cs_data.steerWarning();
+    scene.stand_still = cs_data.standstill();
   }
 
   if (sm.updated("liveParameters")) {
@@ -179,8 +199,11 @@ static void update_state(UIState *s) {
   }
   if (sm.updated("modelV2") && s->vg) {
     auto model = sm["modelV2"].getModelV2();
+    // keep the previous frame's geometry around for display-rate blending
+    scene.model_geom[0] = scene.model_geom[1];
     update_model(s, model);
     update_leads(s, model);
+    scene.model_geom[1].t = sm.log_mono_time("modelV2");
   }
   if (sm.updated("liveCalibration")) {
     scene.world_objects_visible = true;
@@ -198,6 +221,19 @@ static void update_state(UIState *s) {
         scene.view_from_calib.v[i*3 + j] = view_from_calib(i,j);
       }
     }
+    scene.calib_proj = matmul3(s->wide_camera ? ecam_intrinsic_matrix : fcam_intrinsic_matrix,
+                               scene.view_from_calib);
+    // the projected geometry is cached at model rate, refresh it for the new
+    // extrinsics; the previous frame was projected with the old ones and
+    // can't be blended against, so collapse it onto the refreshed one.
+    // liveCalibration can arrive before the first modelV2 (startup, modeld
+    // restart, replay seek) and the default reader has empty lists
+    if (s->vg && sm.rcv_frame("modelV2") > 0) {
+      auto model = sm["modelV2"].getModelV2();
+      update_model(s, model);
+      update_leads(s, model);
+      scene.model_geom[0] = scene.model_geom[1];
+    }
   }
   if (sm.updated("deviceState")) {
     scene.deviceState = sm["deviceState"].getDeviceState();
@@ -307,10 +343,8 @@ static void update_params(UIState *s) {
   const uint64_t frame = s->sm->frame;
   UIScene &scene = s->scene;
   Params params;
-  if (frame % (5*UI_FREQ) == 0) {
-    scene.is_metric = params.getBool("IsMetric");
-    scene.is_OpenpilotViewEnabled = params.getBool("IsOpenpilotViewEnabled");
-  }
+  // IsMetric / IsOpenpilotViewEnabled arrive through the ParamWatcher in
+  // QUIState now instead of being re-read here every 5s
   //opkr navi on boot
   if (!scene.navi_on_boot && (frame - scene.started_frame > 5*UI_FREQ)) {
     if (params.getBool("OpkrRunNaviOnBoot") && params.getBool("ControlsReady") && (params.get("CarParams").size() > 0)) {
@@ -441,9 +475,27 @@ QUIState::QUIState(QObject *parent) : QObject(parent) {
     "ubloxGnss", "gpsLocationExternal", "liveParameters", "lateralPlan", "liveNaviData", "liveMapData",
   });
 
+  // receive and parse off the GUI thread; the update() below then only swaps
+  // pointers, so a burst of messages can't eat into the paint budget
+  ui_state.sm->startAsyncRecv();
+
   ui_state.wide_camera = Hardware::TICI() ? Params().getBool("EnableWideCamera") : false;
   ui_state.sidebar_view = false;
 
+  // read once here; external changes (settings, daemons) arrive through the
+  // inotify-backed watcher instead of a poll tick in update_params()
+  ui_state.scene.is_metric = Params().getBool("IsMetric");
+  ui_state.scene.is_OpenpilotViewEnabled = Params().getBool("IsOpenpilotViewEnabled");
+  param_watcher = new ParamWatcher(this);
+  QObject::connect(param_watcher, &ParamWatcher::paramChanged,
+                   [](const QString &name, const QString &value) {
+    if (name == "IsMetric") {
+      ui_state.scene.is_metric = (value == "1");
+    } else if (name == "IsOpenpilotViewEnabled") {
+      ui_state.scene.is_OpenpilotViewEnabled = (value == "1");
+    }
+  });
+
   // update timer
   timer = new QTimer(this);
   QObject::connect(timer, &QTimer::timeout, this, &QUIState::update);
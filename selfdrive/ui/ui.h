@@ -19,6 +19,7 @@
 #include "selfdrive/common/modeldata.h"
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/util.h"
+#include "selfdrive/ui/qt/util.h"
 
 #define UI_FEATURE_BRAKE 1
 #define UI_FEATURE_AUTOHOLD 1
@@ -125,9 +126,23 @@ typedef struct {
   int cnt;
 } line_vertices_data;
 
+// one model frame's projected world geometry, stamped with the model's
+// logMonoTime so paint.cc can blend consecutive frames at display rate
+typedef struct {
+  uint64_t t = 0;
+  line_vertices_data track_vertices;
+  line_vertices_data lane_line_vertices[4];
+  line_vertices_data road_edge_vertices[2];
+  vertex_data lead_vertices[2];
+} model_geometry;
+
 typedef struct UIScene {
 
   mat3 view_from_calib;
+  // intrinsics * view_from_calib, composed once per liveCalibration update
+  // (same precompute-on-update scheme as modeld's calibration thread) so
+  // per-vertex projection is a single matvecmul3
+  mat3 calib_proj;
   bool world_objects_visible;
 
   std::string alertTextMsg1;
@@ -240,7 +255,11 @@ typedef struct UIScene {
   int satelliteCount;
   float gpsAccuracy;
 
-  // modelV2
+  // modelV2: the last two projected geometries, written at model rate;
+  // [0] is the previous frame, [1] the latest
+  model_geometry model_geom[2];
+
+  // display-rate blend of model_geom, rebuilt every paint
   float lane_line_probs[4];
   float road_edge_stds[2];
   line_vertices_data track_vertices;
@@ -249,8 +268,10 @@ typedef struct UIScene {
 
   bool dm_active, engageable;
 
-  // lead
+  // lead, cached at model rate so painting doesn't re-read the capnp message
   vertex_data lead_vertices[2];
+  float lead_probs[2];
+  float lead_x[2];
 
   float light_sensor, accel_sensor, gyro_sensor;
   bool started, ignition, is_metric, longitudinal_control, end_to_end;
@@ -304,10 +325,19 @@ typedef struct UIScene {
   } liveMapData;
 } UIScene;
 
+struct NVGLUframebuffer;
+
 typedef struct UIState {
   int fb_w = 0, fb_h = 0;
   NVGcontext *vg;
 
+  // HUD layer cache: the nvg scene only depends on SubMaster data, so it is
+  // re-rendered into this framebuffer when new data arrives and composited
+  // on the paints in between
+  NVGLUframebuffer *hud_fb = nullptr;
+  uint64_t hud_frame = 0;
+  bool hud_valid = false;
+
   // images
   std::map<std::string, int> images;
 
@@ -343,6 +373,7 @@ private slots:
 
 private:
   QTimer *timer;
+  ParamWatcher *param_watcher;
   bool started_prev = true;
 };
 
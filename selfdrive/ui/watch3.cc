@@ -1,9 +1,190 @@
+#include <memory>
+
 #include <QApplication>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLWidget>
 #include <QtWidgets>
 
+#include "cereal/visionipc/visionipc_client.h"
 #include "selfdrive/ui/qt/qt_window.h"
 #include "selfdrive/ui/qt/util.h"
-#include "selfdrive/ui/qt/widgets/cameraview.h"
+
+namespace {
+
+const char watch_vertex_shader[] =
+  "#version 300 es\n"
+  "in vec4 aPosition;\n"
+  "in vec4 aTexCoord;\n"
+  "out vec4 vTexCoord;\n"
+  "void main() {\n"
+  "  gl_Position = aPosition;\n"
+  "  vTexCoord = aTexCoord;\n"
+  "}\n";
+
+const char watch_fragment_shader[] =
+  "#version 300 es\n"
+  "precision mediump float;\n"
+  "uniform sampler2D uTexture;\n"
+  "in vec4 vTexCoord;\n"
+  "out vec4 colorOut;\n"
+  "void main() {\n"
+  "  colorOut = texture(uTexture, vTexCoord.xy);\n"
+  "}\n";
+
+} // namespace
+
+// all three streams rendered from one GL context: one shared timer polls the
+// vipc connections and conflates each stream to its newest frame, one shader
+// draws every viewport, and each frame is uploaded exactly once
+class MultiCameraWidget : public QOpenGLWidget, protected QOpenGLFunctions {
+public:
+  MultiCameraWidget(QWidget *parent = nullptr) : QOpenGLWidget(parent) {
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    // placement mirrors the old layout: road on top, driver and wide below
+    streams[0] = {VISION_STREAM_RGB_BACK,  QRectF(0.0, 0.5, 1.0, 0.5)};
+    streams[1] = {VISION_STREAM_RGB_FRONT, QRectF(0.0, 0.0, 0.5, 0.5)};
+    streams[2] = {VISION_STREAM_RGB_WIDE,  QRectF(0.5, 0.0, 0.5, 0.5)};
+    for (auto &s : streams) {
+      s.client = std::make_unique<VisionIpcClient>("camerad", s.type, true);
+    }
+
+    QTimer *t = new QTimer(this);
+    connect(t, &QTimer::timeout, this, &MultiCameraWidget::updateFrames);
+    t->start(10);
+  }
+
+  ~MultiCameraWidget() {
+    makeCurrent();
+    if (isValid()) {
+      glDeleteVertexArrays(1, &frame_vao);
+      glDeleteBuffers(2, frame_vbo);
+      glDeleteBuffers(1, &frame_ibo);
+      for (auto &s : streams) {
+        if (s.tex) glDeleteTextures(1, &s.tex);
+      }
+    }
+    doneCurrent();
+  }
+
+protected:
+  struct Stream {
+    VisionStreamType type;
+    QRectF viewport;  // normalized, origin bottom-left
+    std::unique_ptr<VisionIpcClient> client;
+    VisionBuf *frame = nullptr;
+    VisionBuf *uploaded = nullptr;
+    GLuint tex = 0;
+  };
+
+  void initializeGL() override {
+    initializeOpenGLFunctions();
+
+    program = new QOpenGLShaderProgram(context());
+    bool ret = program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, watch_vertex_shader);
+    assert(ret);
+    ret = program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, watch_fragment_shader);
+    assert(ret);
+    program->link();
+    GLint pos_loc = program->attributeLocation("aPosition");
+    GLint tex_loc = program->attributeLocation("aTexCoord");
+
+    const uint8_t frame_indicies[] = {0, 1, 2, 0, 2, 3};
+    // the driver cam is mirrored, the road cams are flipped
+    const float coords[2][4][4] = {
+      {{-1., -1., 1., 1.}, {-1., 1., 1., 0.}, {1., 1., 0., 0.}, {1., -1., 0., 1.}},  // road
+      {{-1., -1., 0., 1.}, {-1., 1., 0., 0.}, {1., 1., 1., 0.}, {1., -1., 1., 1.}},  // driver
+    };
+
+    glGenVertexArrays(1, &frame_vao);
+    glBindVertexArray(frame_vao);
+    glGenBuffers(2, frame_vbo);
+    for (int i = 0; i < 2; i++) {
+      glBindBuffer(GL_ARRAY_BUFFER, frame_vbo[i]);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(coords[i]), coords[i], GL_STATIC_DRAW);
+    }
+    glGenBuffers(1, &frame_ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, frame_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(frame_indicies), frame_indicies, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    vertex_attribs[0] = pos_loc;
+    vertex_attribs[1] = tex_loc;
+  }
+
+  void paintGL() override {
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUseProgram(program->programId());
+    glUniform1i(program->uniformLocation("uTexture"), 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    const qreal dpr = devicePixelRatioF();
+    for (auto &s : streams) {
+      if (!s.frame) continue;
+
+      if (!s.tex) {
+        glGenTextures(1, &s.tex);
+        glBindTexture(GL_TEXTURE_2D, s.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        // BGR
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_GREEN);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+      }
+      glBindTexture(GL_TEXTURE_2D, s.tex);
+      if (s.frame != s.uploaded) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, s.frame->width, s.frame->height,
+                     0, GL_RGB, GL_UNSIGNED_BYTE, s.frame->addr);
+        s.uploaded = s.frame;
+      }
+
+      glViewport(s.viewport.x() * width() * dpr, s.viewport.y() * height() * dpr,
+                 s.viewport.width() * width() * dpr, s.viewport.height() * height() * dpr);
+
+      glBindVertexArray(frame_vao);
+      glBindBuffer(GL_ARRAY_BUFFER, frame_vbo[s.type == VISION_STREAM_RGB_FRONT ? 1 : 0]);
+      glEnableVertexAttribArray(vertex_attribs[0]);
+      glVertexAttribPointer(vertex_attribs[0], 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (const void *)0);
+      glEnableVertexAttribArray(vertex_attribs[1]);
+      glVertexAttribPointer(vertex_attribs[1], 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (const void *)(sizeof(float) * 2));
+      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, (const void *)0);
+      glBindVertexArray(0);
+    }
+  }
+
+private:
+  void updateFrames() {
+    bool got_frame = false;
+    for (auto &s : streams) {
+      if (!s.client->connected) {
+        if (!s.client->connect(false)) continue;
+        s.frame = s.uploaded = nullptr;
+      }
+      // conflate: drain the queue and keep only the newest frame
+      VisionBuf *buf = nullptr;
+      while (VisionBuf *b = s.client->recv(nullptr, 0)) {
+        buf = b;
+      }
+      if (buf) {
+        s.frame = buf;
+        got_frame = true;
+      }
+    }
+    if (got_frame) {
+      update();
+    }
+  }
+
+  Stream streams[3];
+  QOpenGLShaderProgram *program = nullptr;
+  GLuint frame_vao = 0, frame_vbo[2] = {}, frame_ibo = 0;
+  GLint vertex_attribs[2] = {};
+};
 
 int main(int argc, char *argv[]) {
   QSurfaceFormat fmt;
@@ -11,18 +192,8 @@ int main(int argc, char *argv[]) {
   QSurfaceFormat::setDefaultFormat(fmt);
 
   QApplication a(argc, argv);
-  QWidget w;
+  MultiCameraWidget w;
   setMainWindow(&w);
 
-  QVBoxLayout *layout = new QVBoxLayout(&w);
-  layout->setMargin(0);
-  layout->setSpacing(0);
-  layout->addWidget(new CameraViewWidget(VISION_STREAM_RGB_BACK, false));
-
-  QHBoxLayout *hlayout = new QHBoxLayout();
-  layout->addLayout(hlayout);
-  hlayout->addWidget(new CameraViewWidget(VISION_STREAM_RGB_FRONT, false));
-  hlayout->addWidget(new CameraViewWidget(VISION_STREAM_RGB_WIDE, false));
-
   return a.exec();
 }
@@ -26,16 +26,22 @@
 #include <vector>
 #include <stdexcept>
 
-kaitai::kstream::kstream(std::istream* io) {
+kaitai::kstream::kstream(std::istream* io): m_io_mem(&m_io_buf) {
     m_io = io;
     init();
 }
 
-kaitai::kstream::kstream(std::string& data): m_io_str(data) {
+kaitai::kstream::kstream(std::string& data): m_io_str(data), m_io_mem(&m_io_buf) {
     m_io = &m_io_str;
     init();
 }
 
+kaitai::kstream::kstream(const void* data, size_t size): m_io_mem(&m_io_buf) {
+    m_io_buf.borrow(data, size);
+    m_io = &m_io_mem;
+    init();
+}
+
 void kaitai::kstream::init() {
     exceptions_enable();
     align_to_byte();
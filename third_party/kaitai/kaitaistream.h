@@ -43,6 +43,17 @@ public:
      */
     kstream(std::string& data);
 
+    /**
+     * Constructs new Kaitai Stream object over a borrowed in-memory buffer.
+     * Unlike the std::string constructor, the bytes are not copied into an
+     * internal stringstream: the caller keeps ownership and the buffer must
+     * stay alive for the lifetime of the stream and of anything parsed from
+     * it.
+     * \param data start of the buffer
+     * \param size buffer length in bytes
+     */
+    kstream(const void* data, size_t size);
+
     void close();
 
     /** @name Stream positioning */
@@ -250,8 +261,37 @@ public:
     static uint8_t byte_array_max(const std::string val);
 
 private:
+    // seekable streambuf over borrowed memory, backing the zero-copy constructor
+    class membuf : public std::streambuf {
+    public:
+        membuf() {}
+        void borrow(const void* data, size_t size) {
+            char* p = const_cast<char*>(static_cast<const char*>(data));
+            setg(p, p, p + size);
+        }
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+            if (!(which & std::ios_base::in))
+                return pos_type(off_type(-1));
+            off_type npos = off;
+            if (dir == std::ios_base::cur)
+                npos += gptr() - eback();
+            else if (dir == std::ios_base::end)
+                npos += egptr() - eback();
+            if (npos < 0 || npos > egptr() - eback())
+                return pos_type(off_type(-1));
+            setg(eback(), eback() + npos, egptr());
+            return pos_type(npos);
+        }
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+            return seekoff(off_type(pos), std::ios_base::beg, which);
+        }
+    };
+
     std::istream* m_io;
     std::istringstream m_io_str;
+    membuf m_io_buf;
+    std::istream m_io_mem;
     int m_bits_left;
     uint64_t m_bits;
 
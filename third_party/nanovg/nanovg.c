@@ -108,6 +108,33 @@ struct NVGpathCache {
 };
 typedef struct NVGpathCache NVGpathCache;
 
+#define NVG_TEXT_CACHE_RUNS 128
+#define NVG_TEXT_CACHE_MAX_CHARS 64
+
+// A shaped text run cached in font-space at origin (0,0). Quads carry atlas
+// UVs, so a run is only valid for the atlas generation it was shaped against.
+struct NVGcachedRun {
+	char str[NVG_TEXT_CACHE_MAX_CHARS];
+	int len;
+	int fontId;
+	float size;
+	float blur;
+	float spacing;
+	int align;
+	int atlasGen;
+	int nquads;
+	float advance;
+	FONSquad quads[NVG_TEXT_CACHE_MAX_CHARS];
+	unsigned int lastUse;
+};
+typedef struct NVGcachedRun NVGcachedRun;
+
+struct NVGtextCache {
+	NVGcachedRun runs[NVG_TEXT_CACHE_RUNS];
+	unsigned int useCounter;
+};
+typedef struct NVGtextCache NVGtextCache;
+
 struct NVGcontext {
 	NVGparams params;
 	float* commands;
@@ -124,6 +151,8 @@ struct NVGcontext {
 	struct FONScontext* fs;
 	int fontImages[NVG_MAX_FONTIMAGES];
 	int fontImageIdx;
+	struct NVGtextCache* textCache;
+	int atlasGen;
 	int drawCallCount;
 	int fillTriCount;
 	int strokeTriCount;
@@ -297,6 +326,10 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	ctx->cache = nvg__allocPathCache();
 	if (ctx->cache == NULL) goto error;
 
+	ctx->textCache = (NVGtextCache*)malloc(sizeof(NVGtextCache));
+	if (ctx->textCache == NULL) goto error;
+	memset(ctx->textCache, 0, sizeof(NVGtextCache));
+
 	nvgSave(ctx);
 	nvgReset(ctx);
 
@@ -340,6 +373,7 @@ void nvgDeleteInternal(NVGcontext* ctx)
 	if (ctx == NULL) return;
 	if (ctx->commands != NULL) free(ctx->commands);
 	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
+	if (ctx->textCache != NULL) free(ctx->textCache);
 
 	if (ctx->fs)
 		fonsDeleteInternal(ctx->fs);
@@ -2381,6 +2415,9 @@ static int nvg__allocTextAtlas(NVGcontext* ctx)
 	}
 	++ctx->fontImageIdx;
 	fonsResetAtlas(ctx->fs, iw, ih);
+	// Any cached run shaped against the old atlas now has stale UVs. A bare
+	// fontImageIdx compare is not enough since nvgEndFrame resets it to 0.
+	ctx->atlasGen++;
 	return 1;
 }
 
@@ -2469,6 +2506,125 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	return iter.x;
 }
 
+static NVGcachedRun* nvg__findCachedRun(NVGtextCache* cache, const char* string, int len,
+										int fontId, float size, float blur, float spacing,
+										int align, int atlasGen)
+{
+	int i;
+	for (i = 0; i < NVG_TEXT_CACHE_RUNS; i++) {
+		NVGcachedRun* run = &cache->runs[i];
+		if (run->len == len && run->fontId == fontId && run->align == align &&
+			run->size == size && run->blur == blur && run->spacing == spacing &&
+			run->atlasGen == atlasGen && memcmp(run->str, string, len) == 0)
+			return run;
+	}
+	return NULL;
+}
+
+static NVGcachedRun* nvg__evictCachedRun(NVGtextCache* cache)
+{
+	NVGcachedRun* oldest = &cache->runs[0];
+	int i;
+	for (i = 1; i < NVG_TEXT_CACHE_RUNS; i++) {
+		if (cache->runs[i].lastUse < oldest->lastUse)
+			oldest = &cache->runs[i];
+	}
+	return oldest;
+}
+
+// Same as nvgText, but caches the shaped glyph quads keyed on
+// (string, font, size, blur, spacing, align). Repeated HUD strings skip the
+// fontstash iteration entirely and only pay for the vertex transform.
+float nvgTextCached(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGtextCache* cache = ctx->textCache;
+	NVGcachedRun* run;
+	NVGvertex* verts;
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+	float invscale = 1.0f / scale;
+	float size = state->fontSize*scale;
+	float blur = state->fontBlur*scale;
+	float spacing = state->letterSpacing*scale;
+	float tx = x*scale, ty = y*scale;
+	int len, i, nverts = 0;
+
+	if (end == NULL)
+		end = string + strlen(string);
+	len = (int)(end - string);
+
+	// Long or degenerate runs aren't worth a cache slot.
+	if (cache == NULL || len <= 0 || len > NVG_TEXT_CACHE_MAX_CHARS)
+		return nvgText(ctx, x, y, string, end);
+
+	if (state->fontId == FONS_INVALID) return x;
+
+	run = nvg__findCachedRun(cache, string, len, state->fontId, size, blur, spacing,
+							 state->textAlign, ctx->atlasGen);
+	if (run == NULL) {
+		FONStextIter iter;
+		FONSquad q;
+
+		fonsSetSize(ctx->fs, size);
+		fonsSetSpacing(ctx->fs, spacing);
+		fonsSetBlur(ctx->fs, blur);
+		fonsSetAlign(ctx->fs, state->textAlign);
+		fonsSetFont(ctx->fs, state->fontId);
+
+		run = nvg__evictCachedRun(cache);
+		run->len = 0; // invalid until fully shaped
+
+		// Shape at the origin; quads are translated to (x,y) at draw time.
+		fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end);
+		run->nquads = 0;
+		while (fonsTextIterNext(ctx->fs, &iter, &q)) {
+			if (iter.prevGlyphIndex == -1) {
+				// Atlas is full; let nvgText handle the grow-and-retry dance.
+				// The atlasGen bump it triggers invalidates this cache anyway.
+				return nvgText(ctx, x, y, string, end);
+			}
+			if (run->nquads < NVG_TEXT_CACHE_MAX_CHARS)
+				run->quads[run->nquads++] = q;
+		}
+		run->advance = iter.x;
+
+		memcpy(run->str, string, len);
+		run->len = len;
+		run->fontId = state->fontId;
+		run->size = size;
+		run->blur = blur;
+		run->spacing = spacing;
+		run->align = state->textAlign;
+		run->atlasGen = ctx->atlasGen;
+
+		// New glyphs may have been rasterized into the atlas.
+		nvg__flushTextTexture(ctx);
+	}
+	run->lastUse = ++cache->useCounter;
+
+	verts = nvg__allocTempVerts(ctx, nvg__maxi(2, run->nquads) * 6);
+	if (verts == NULL) return x;
+
+	for (i = 0; i < run->nquads; i++) {
+		const FONSquad* q = &run->quads[i];
+		float c[4*2];
+		nvgTransformPoint(&c[0],&c[1], state->xform, (q->x0+tx)*invscale, (q->y0+ty)*invscale);
+		nvgTransformPoint(&c[2],&c[3], state->xform, (q->x1+tx)*invscale, (q->y0+ty)*invscale);
+		nvgTransformPoint(&c[4],&c[5], state->xform, (q->x1+tx)*invscale, (q->y1+ty)*invscale);
+		nvgTransformPoint(&c[6],&c[7], state->xform, (q->x0+tx)*invscale, (q->y1+ty)*invscale);
+		nvg__vset(&verts[nverts], c[0], c[1], q->s0, q->t0); nverts++;
+		nvg__vset(&verts[nverts], c[4], c[5], q->s1, q->t1); nverts++;
+		nvg__vset(&verts[nverts], c[2], c[3], q->s1, q->t0); nverts++;
+		nvg__vset(&verts[nverts], c[0], c[1], q->s0, q->t0); nverts++;
+		nvg__vset(&verts[nverts], c[6], c[7], q->s0, q->t1); nverts++;
+		nvg__vset(&verts[nverts], c[4], c[5], q->s1, q->t1); nverts++;
+	}
+
+	nvg__renderText(ctx, verts, nverts);
+
+	return x + run->advance*invscale;
+}
+
 void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
 {
 	NVGstate* state = nvg__getState(ctx);
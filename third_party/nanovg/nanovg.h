@@ -579,6 +579,10 @@ void nvgFontFace(NVGcontext* ctx, const char* font);
 // Draws text string at specified location. If end is specified only the sub-string up to the end is drawn.
 float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end);
 
+// Like nvgText, but keeps the shaped glyph run in a small LRU cache so strings
+// redrawn every frame skip layout. Falls back to nvgText for long strings.
+float nvgTextCached(NVGcontext* ctx, float x, float y, const char* string, const char* end);
+
 // Draws multi-line text string at specified location wrapped at the specified width. If end is specified only the sub-string up to the end is drawn.
 // White space is stripped at the beginning of the rows, the text is split at word boundaries or when new-line characters are encountered.
 // Words longer than the max width are slit at nearest character (i.e. no hyphenation).
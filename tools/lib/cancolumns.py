@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# One-shot columnar export of a segment's parsed CAN signals.
+#
+# Runs the can events of a log through CANParser once and writes one
+# contiguous float32 array per signal, plus a shared time index per message,
+# as plain .npy files that numpy can mmap. Subsequent analyses load columns
+# in milliseconds instead of re-running the parser per study, and the
+# columnar form is an order of magnitude smaller than the can events it
+# derives from.
+#
+# Layout: <out_dir>/<msg_name>/t.npy          update times, seconds (logMonoTime)
+#         <out_dir>/<msg_name>/<signal>.npy   one value per update, aligned with t
+import argparse
+import os
+import re
+
+import numpy as np
+
+from common.basedir import BASEDIR
+from opendbc.can.dbc import dbc
+from opendbc.can.parser import CANParser
+from tools.lib.logreader import LogReader
+
+
+def _safe_name(name):
+  return re.sub(r"[^A-Za-z0-9_.-]", "_", name)
+
+
+def export_columns(lr, dbc_name, out_dir, bus=0):
+  dbc_path = os.path.join(BASEDIR, "opendbc", dbc_name + ".dbc")
+  defs = dbc(dbc_path)
+
+  # parse every signal of every message on the bus
+  signals = []
+  msg_signals = {}  # address -> (msg name, [signal names])
+  for address, ((name, _), sigs) in defs.msgs.items():
+    sig_names = [s.name for s in sigs]
+    if not sig_names:
+      continue
+    msg_signals[address] = (name, sig_names)
+    signals.extend((sig, address, 0) for sig in sig_names)
+
+  parser = CANParser(dbc_name, signals, bus=bus, enforce_checks=False)
+
+  times = {address: [] for address in msg_signals}
+  values = {address: [] for address in msg_signals}
+  for msg in lr:
+    if msg.which() != "can":
+      continue
+    t = msg.logMonoTime * 1e-9
+    for address in parser.update_string(msg.as_builder().to_bytes()):
+      if address not in msg_signals:
+        continue
+      vl = parser.vl[address]
+      times[address].append(t)
+      values[address].append([vl[sig] for sig in msg_signals[address][1]])
+
+  for address, (name, sig_names) in msg_signals.items():
+    if not times[address]:
+      continue
+    msg_dir = os.path.join(out_dir, _safe_name(name))
+    os.makedirs(msg_dir, exist_ok=True)
+    np.save(os.path.join(msg_dir, "t.npy"), np.asarray(times[address], dtype=np.float64))
+    cols = np.asarray(values[address], dtype=np.float32)
+    for i, sig in enumerate(sig_names):
+      np.save(os.path.join(msg_dir, _safe_name(sig) + ".npy"), np.ascontiguousarray(cols[:, i]))
+
+
+def load_columns(out_dir):
+  # mmap-backed view of a previous export: {msg: {"t": array, signal: array}}
+  columns = {}
+  for name in sorted(os.listdir(out_dir)):
+    msg_dir = os.path.join(out_dir, name)
+    if not os.path.isdir(msg_dir):
+      continue
+    columns[name] = {os.path.splitext(fn)[0]: np.load(os.path.join(msg_dir, fn), mmap_mode="r")
+                     for fn in sorted(os.listdir(msg_dir)) if fn.endswith(".npy")}
+  return columns
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser(description="export a log's CAN signals as mmap-able columnar arrays")
+  parser.add_argument("dbc_name", help="e.g. hyundai_kia_generic")
+  parser.add_argument("route_or_log", help="route name or path to an rlog")
+  parser.add_argument("out_dir")
+  parser.add_argument("--bus", type=int, default=0)
+  args = parser.parse_args()
+
+  export_columns(LogReader(args.route_or_log), args.dbc_name, args.out_dir, bus=args.bus)